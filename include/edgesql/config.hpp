@@ -38,6 +38,12 @@ struct MemoryConfig {
     size_t global_limit_bytes = 512 * 1024 * 1024;  // 512MB
     size_t default_query_limit_bytes = 64 * 1024 * 1024;  // 64MB
     size_t arena_block_size = 64 * 1024;  // 64KB
+    size_t arena_pool_size = 4;  // Idle arenas kept per worker
+    size_t arena_retain_bytes = 256 * 1024;  // 256KB kept per idle arena
+    std::chrono::seconds arena_idle_timeout{30};
+    uint32_t pressure_percent = 90;  // Throttle and reclaim above this
+    size_t result_cache_bytes = 16 * 1024 * 1024;  // 16MB, 0 = disabled
+    std::chrono::milliseconds result_cache_max_staleness{0};  // 0 = exact
 };
 
 /**
@@ -5,8 +5,10 @@
  * @brief Fixed-size thread pool for query execution
  */
 
+#include "../memory/slab_allocator.hpp"
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
 #include <memory>
@@ -92,7 +94,8 @@ private:
   void worker_loop();
 
   std::vector<std::thread> workers_;
-  std::queue<Task> tasks_;
+  // Queue blocks come from the slab allocator rather than the heap
+  std::queue<Task, std::deque<Task, memory::SlabStlAllocator<Task>>> tasks_;
 
   mutable std::mutex mutex_;
   std::condition_variable condition_;
@@ -106,7 +109,10 @@ auto ThreadPool::submit_with_result(F &&f, Args &&...args)
 
   using ReturnType = std::invoke_result_t<F, Args...>;
 
-  auto task = std::make_shared<std::packaged_task<ReturnType()>>(
+  // The shared state is slab-allocated, and the wrapping lambda only
+  // captures a shared_ptr, which fits std::function's inline storage.
+  auto task = std::allocate_shared<std::packaged_task<ReturnType()>>(
+      memory::SlabStlAllocator<std::packaged_task<ReturnType()>>(),
       std::bind(std::forward<F>(f), std::forward<Args>(args)...));
 
   std::future<ReturnType> result = task->get_future();
@@ -0,0 +1,432 @@
+/**
+ * @file aggregate.cpp
+ * @brief Aggregation operator implementation
+ */
+
+#include "aggregate.hpp"
+#include <cmath>
+#include <stdexcept>
+
+namespace edgesql {
+namespace executor {
+
+namespace {
+
+using planner::AggregateType;
+using Type = sql::Literal::Type;
+
+// Add a value to a running sum, which starts out NULL
+void add_to_sum(sql::Literal &sum, const Value &value) {
+  if (value.type != Type::INTEGER && value.type != Type::FLOAT) {
+    throw std::runtime_error("SUM and AVG need numeric values");
+  }
+  if (sum.type == Type::NULL_VAL) {
+    assign(sum, value);
+    return;
+  }
+
+  if (sum.type == Type::INTEGER && value.type == Type::INTEGER) {
+    if (__builtin_add_overflow(sum.int_value, value.int_value,
+                               &sum.int_value)) {
+      throw std::runtime_error("Integer overflow");
+    }
+    return;
+  }
+
+  double total = sum.type == Type::INTEGER
+                     ? static_cast<double>(sum.int_value)
+                     : sum.float_value;
+  total += value.type == Type::INTEGER ? static_cast<double>(value.int_value)
+                                       : value.float_value;
+  sum.type = Type::FLOAT;
+  sum.float_value = total;
+}
+
+// A sketch's state is an empty string until its first value
+void start_sketch(sql::Literal &slot) {
+  if (slot.type == Type::NULL_VAL) {
+    slot.type = Type::STRING;
+    slot.string_value.clear();
+  }
+}
+
+} // anonymous namespace
+
+// AggregateOperator implementation
+
+AggregateOperator::AggregateOperator(
+    std::unique_ptr<Operator> child,
+    std::vector<const sql::Expression *> group_by,
+    std::vector<planner::AggregateExpr> aggregates,
+    const planner::Bindings &bindings)
+    : child_(std::move(child)), group_by_(std::move(group_by)),
+      aggregates_(std::move(aggregates)), bindings_(bindings) {
+  width_ = group_by_.size() + aggregates_.size();
+  for (const auto &aggregate : aggregates_) {
+    bool average = aggregate.type == AggregateType::AVG;
+    count_slots_.push_back(average ? static_cast<int32_t>(width_++) : -1);
+  }
+  keys_.resize(group_by_.size());
+}
+
+void AggregateOperator::open(ExecutionContext &ctx) {
+  child_->open(ctx);
+  input_.emplace(ctx.memory_resource());
+}
+
+void AggregateOperator::close() {
+  child_->close();
+  input_.reset();
+}
+
+std::vector<std::string> AggregateOperator::column_names() const {
+  std::vector<std::string> names;
+  for (size_t i = 0; i < group_by_.size(); ++i) {
+    const sql::Expression &key = *group_by_[i];
+    names.push_back(key.type == sql::ExprType::COLUMN_REF
+                        ? std::string(key.name)
+                        : "group" + std::to_string(i + 1));
+  }
+  for (const auto &aggregate : aggregates_) {
+    names.push_back(aggregate.output_name);
+  }
+  return names;
+}
+
+void AggregateOperator::evaluate_keys(const ResultRow &input) {
+  for (size_t i = 0; i < group_by_.size(); ++i) {
+    keys_[i] = evaluate(*group_by_[i], input, bindings_);
+  }
+}
+
+void AggregateOperator::start_group(ResultRow &group) const {
+  group.values.resize(width_);
+  for (size_t i = 0; i < keys_.size(); ++i) {
+    assign(group.values[i], keys_[i]);
+  }
+  for (size_t i = 0; i < aggregates_.size(); ++i) {
+    sql::Literal &slot = group.values[keys_.size() + i];
+    slot.type = Type::NULL_VAL;
+    if (aggregates_[i].type == AggregateType::COUNT ||
+        aggregates_[i].type == AggregateType::SUM0) {
+      slot.type = Type::INTEGER;
+      slot.int_value = 0;
+    }
+    if (count_slots_[i] >= 0) {
+      sql::Literal &count = group.values[count_slots_[i]];
+      count.type = Type::INTEGER;
+      count.int_value = 0;
+    }
+  }
+}
+
+bool AggregateOperator::same_keys(const ResultRow &group) const {
+  for (size_t i = 0; i < keys_.size(); ++i) {
+    if (compare_values(Value::of(group.values[i]), keys_[i]) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void AggregateOperator::accumulate(ResultRow &group,
+                                   const ResultRow &input) const {
+  for (size_t i = 0; i < aggregates_.size(); ++i) {
+    const auto &aggregate = aggregates_[i];
+    sql::Literal &slot = group.values[keys_.size() + i];
+    if (!aggregate.arg) {
+      slot.int_value++; // COUNT(*)
+      continue;
+    }
+
+    Value value = evaluate(*aggregate.arg, input, bindings_);
+    if (value.is_null()) {
+      continue;
+    }
+
+    switch (aggregate.type) {
+    case AggregateType::COUNT:
+      slot.int_value++;
+      break;
+    case AggregateType::SUM:
+    case AggregateType::SUM0:
+      add_to_sum(slot, value);
+      break;
+    case AggregateType::AVG:
+      add_to_sum(slot, value);
+      group.values[count_slots_[i]].int_value++;
+      break;
+    case AggregateType::MIN:
+    case AggregateType::MAX: {
+      if (slot.type == Type::NULL_VAL) {
+        assign(slot, value);
+        break;
+      }
+      int order = compare_values(value, Value::of(slot));
+      if (aggregate.type == AggregateType::MIN ? order < 0 : order > 0) {
+        assign(slot, value);
+      }
+      break;
+    }
+    case AggregateType::APPROX_COUNT_DISTINCT:
+      start_sketch(slot);
+      DistinctSketch(slot.string_value).add(hash_value(value));
+      break;
+    case AggregateType::APPROX_PERCENTILE:
+      if (value.type != Type::INTEGER && value.type != Type::FLOAT) {
+        throw std::runtime_error("APPROX_PERCENTILE needs numeric values");
+      }
+      start_sketch(slot);
+      QuantileSketch(slot.string_value, sketch_scratch_)
+          .add(value.type == Type::INTEGER
+                   ? static_cast<double>(value.int_value)
+                   : value.float_value);
+      break;
+    }
+  }
+}
+
+void AggregateOperator::finish(ResultRow &group) const {
+  for (size_t i = 0; i < aggregates_.size(); ++i) {
+    sql::Literal &slot = group.values[keys_.size() + i];
+    switch (aggregates_[i].type) {
+    case AggregateType::AVG: {
+      int64_t count = group.values[count_slots_[i]].int_value;
+      if (count == 0) {
+        break; // NULL
+      }
+      double sum = slot.type == Type::INTEGER
+                       ? static_cast<double>(slot.int_value)
+                       : slot.float_value;
+      slot.type = Type::FLOAT;
+      slot.float_value = sum / static_cast<double>(count);
+      break;
+    }
+    case AggregateType::APPROX_COUNT_DISTINCT: {
+      double estimate = slot.type == Type::NULL_VAL
+                            ? 0.0
+                            : DistinctSketch(slot.string_value).estimate();
+      slot.type = Type::INTEGER;
+      slot.int_value = std::llround(estimate);
+      slot.string_value.clear();
+      break;
+    }
+    case AggregateType::APPROX_PERCENTILE:
+      if (slot.type == Type::NULL_VAL) {
+        break; // No values
+      }
+      slot.float_value = QuantileSketch(slot.string_value, sketch_scratch_)
+                             .quantile(aggregates_[i].fraction);
+      slot.type = Type::FLOAT;
+      slot.string_value.clear();
+      break;
+    default:
+      break;
+    }
+  }
+  group.values.resize(keys_.size() + aggregates_.size());
+}
+
+// HashAggregateOperator implementation
+
+void HashAggregateOperator::open(ExecutionContext &ctx) {
+  AggregateOperator::open(ctx);
+  groups_.emplace(ctx.memory_resource());
+  hashes_.emplace(ctx.memory_resource());
+  slots_.emplace(16, EMPTY, ctx.memory_resource());
+  current_group_ = 0;
+  materialized_ = false;
+}
+
+bool HashAggregateOperator::next(ExecutionContext &ctx, ResultRow &row) {
+  if (!materialized_) {
+    materialize(ctx);
+    materialized_ = true;
+  }
+
+  auto &groups = *groups_;
+  if (current_group_ >= groups.size()) {
+    return false;
+  }
+  row = std::move(groups[current_group_++]);
+  finish(row);
+  ctx.record_instructions(aggregates_.size());
+  return true;
+}
+
+void HashAggregateOperator::close() {
+  AggregateOperator::close();
+  slots_.reset();
+  hashes_.reset();
+  groups_.reset();
+}
+
+void HashAggregateOperator::materialize(ExecutionContext &ctx) {
+  auto &groups = *groups_;
+  ResultRow &input = *input_;
+  while (child_->next(ctx, input)) {
+    evaluate_keys(input);
+    uint64_t hash = 0;
+    for (const Value &key : keys_) {
+      hash = (hash ^ hash_value(key)) * 0x100000001B3ull;
+    }
+
+    size_t group = find_group(hash);
+    accumulate(groups[group], input);
+    ctx.record_instructions(2 + aggregates_.size());
+    ctx.check_budget();
+  }
+
+  if (groups.empty() && group_by_.empty()) {
+    groups.emplace_back();
+    start_group(groups.back());
+  }
+}
+
+size_t HashAggregateOperator::find_group(uint64_t hash) {
+  auto &groups = *groups_;
+  auto &slots = *slots_;
+  size_t mask = slots.size() - 1;
+  size_t at = hash & mask;
+  while (slots[at] != EMPTY) {
+    uint32_t group = slots[at];
+    if ((*hashes_)[group] == hash && same_keys(groups[group])) {
+      return group;
+    }
+    at = (at + 1) & mask;
+  }
+
+  uint32_t group = static_cast<uint32_t>(groups.size());
+  groups.emplace_back();
+  start_group(groups.back());
+  hashes_->push_back(hash);
+  slots[at] = group;
+
+  // Keep the table at most half full so probe chains stay short
+  if (groups.size() * 2 > slots.size()) {
+    grow();
+  }
+  return group;
+}
+
+void HashAggregateOperator::grow() {
+  auto &slots = *slots_;
+  slots.assign(slots.size() * 2, EMPTY);
+  size_t mask = slots.size() - 1;
+  const auto &hashes = *hashes_;
+  for (uint32_t group = 0; group < hashes.size(); ++group) {
+    size_t at = hashes[group] & mask;
+    while (slots[at] != EMPTY) {
+      at = (at + 1) & mask;
+    }
+    slots[at] = group;
+  }
+}
+
+// SortAggregateOperator implementation
+
+void SortAggregateOperator::open(ExecutionContext &ctx) {
+  AggregateOperator::open(ctx);
+  primed_ = false;
+  has_input_ = false;
+  emitted_ = false;
+}
+
+bool SortAggregateOperator::next(ExecutionContext &ctx, ResultRow &row) {
+  ResultRow &input = *input_;
+  if (!primed_) {
+    has_input_ = child_->next(ctx, input);
+    primed_ = true;
+  }
+
+  if (!has_input_) {
+    if (!group_by_.empty() || emitted_) {
+      return false;
+    }
+    start_group(row);
+    finish(row);
+    emitted_ = true;
+    return true;
+  }
+
+  // The input row opens the group; rows join it until the keys change
+  evaluate_keys(input);
+  start_group(row);
+  do {
+    accumulate(row, input);
+    ctx.record_instructions(1 + group_by_.size() + aggregates_.size());
+    has_input_ = child_->next(ctx, input);
+    if (has_input_) {
+      evaluate_keys(input);
+    }
+  } while (has_input_ && same_keys(row));
+
+  finish(row);
+  emitted_ = true;
+  return true;
+}
+
+// MetadataAggregateOperator implementation
+
+MetadataAggregateOperator::MetadataAggregateOperator(
+    std::vector<planner::AggregateExpr> aggregates,
+    const planner::Bindings &bindings, const planner::TableInfo *schema,
+    TableSummary summary)
+    : aggregates_(std::move(aggregates)), bindings_(bindings), schema_(schema),
+      summary_(std::move(summary)) {}
+
+void MetadataAggregateOperator::open(ExecutionContext &ctx) {
+  done_ = false;
+  ctx.record_instructions(10); // Opening cost
+}
+
+bool MetadataAggregateOperator::next(ExecutionContext &ctx, ResultRow &row) {
+  if (done_) {
+    return false;
+  }
+  done_ = true;
+
+  row.values.resize(aggregates_.size());
+  for (size_t i = 0; i < aggregates_.size(); ++i) {
+    const planner::AggregateExpr &aggregate = aggregates_[i];
+    sql::Literal &slot = row.values[i];
+    if (!aggregate.arg) {
+      slot = sql::Literal::integer(static_cast<int64_t>(summary_.rows));
+      continue;
+    }
+
+    size_t col = static_cast<size_t>(bindings_.position(*aggregate.arg));
+    ColumnSummary column =
+        col < summary_.columns.size() ? summary_.columns[col]
+                                      : ColumnSummary{};
+    if (aggregate.type == AggregateType::COUNT) {
+      slot = sql::Literal::integer(static_cast<int64_t>(column.values));
+      continue;
+    }
+
+    bool min = aggregate.type == AggregateType::MIN;
+    slot = sql::Literal::null();
+    if (column.values == 0 || !schema_ || col >= schema_->columns.size()) {
+      continue;
+    }
+    if (schema_->columns[col].type == storage::ColumnType::INTEGER) {
+      slot = sql::Literal::integer(min ? column.int_min : column.int_max);
+    } else {
+      slot = sql::Literal::floating(min ? column.float_min
+                                        : column.float_max);
+    }
+  }
+  ctx.record_instructions(aggregates_.size());
+  return true;
+}
+
+std::vector<std::string> MetadataAggregateOperator::column_names() const {
+  std::vector<std::string> names;
+  for (const auto &aggregate : aggregates_) {
+    names.push_back(aggregate.output_name);
+  }
+  return names;
+}
+
+} // namespace executor
+} // namespace edgesql
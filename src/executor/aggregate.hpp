@@ -0,0 +1,158 @@
+#pragma once
+
+/**
+ * @file aggregate.hpp
+ * @brief Grouping and aggregation operators
+ */
+
+#include "executor.hpp"
+#include "expression.hpp"
+#include "sketch.hpp"
+#include "table_summary.hpp"
+
+namespace edgesql {
+namespace executor {
+
+/**
+ * @brief Base of the aggregation operators
+ *
+ * Output rows hold the group keys followed by one value per aggregate.
+ * A group is built in place in its output row: COUNT and SUM accumulate
+ * in their slot, MIN and MAX keep the extreme so far, and AVG keeps its
+ * sum there with the count in a hidden slot past the end, dropped when
+ * the group is finished.
+ *
+ * APPROX_COUNT_DISTINCT and APPROX_PERCENTILE keep a sketch's state in
+ * their slot as a byte string of bounded size (see sketch.hpp), turned
+ * into the estimate when the group is finished.
+ *
+ * Without GROUP BY the input forms a single group, so even an empty
+ * input yields one row (COUNT and APPROX_COUNT_DISTINCT 0, other
+ * aggregates NULL).
+ */
+class AggregateOperator : public Operator {
+public:
+  AggregateOperator(std::unique_ptr<Operator> child,
+                    std::vector<const sql::Expression *> group_by,
+                    std::vector<planner::AggregateExpr> aggregates,
+                    const planner::Bindings &bindings);
+
+  void open(ExecutionContext &ctx) override;
+  void close() override;
+  std::vector<std::string> column_names() const override;
+
+protected:
+  /**
+   * @brief Evaluate the group keys of an input row into keys_
+   */
+  void evaluate_keys(const ResultRow &input);
+
+  /**
+   * @brief Start a group for the keys in keys_
+   */
+  void start_group(ResultRow &group) const;
+
+  /**
+   * @brief Check whether a group has the keys in keys_
+   */
+  bool same_keys(const ResultRow &group) const;
+
+  /**
+   * @brief Fold an input row into a group
+   */
+  void accumulate(ResultRow &group, const ResultRow &input) const;
+
+  /**
+   * @brief Turn a group into its output row
+   */
+  void finish(ResultRow &group) const;
+
+  std::unique_ptr<Operator> child_;
+  std::vector<const sql::Expression *> group_by_;
+  std::vector<planner::AggregateExpr> aggregates_;
+  const planner::Bindings &bindings_;
+  std::vector<int32_t> count_slots_; // Hidden AVG count slot, or -1
+  size_t width_;                     // Output columns plus hidden slots
+  std::vector<Value> keys_;          // Keys of the current input row
+  std::optional<ResultRow> input_;   // In the query arena, reused per row
+  mutable QuantileSketch::Scratch sketch_scratch_; // Reused by each fold
+};
+
+/**
+ * @brief Hash aggregation
+ *
+ * Groups live in an open-addressing hash table in the query arena, so
+ * their memory counts against the query budget. Input may come in any
+ * order; groups are returned in order of first appearance.
+ */
+class HashAggregateOperator : public AggregateOperator {
+public:
+  using AggregateOperator::AggregateOperator;
+
+  void open(ExecutionContext &ctx) override;
+  bool next(ExecutionContext &ctx, ResultRow &row) override;
+  void close() override;
+
+private:
+  void materialize(ExecutionContext &ctx);
+  size_t find_group(uint64_t hash);
+  void grow();
+
+  static constexpr uint32_t EMPTY = UINT32_MAX;
+
+  std::optional<std::pmr::vector<ResultRow>> groups_;
+  std::optional<std::pmr::vector<uint64_t>> hashes_; // By group
+  std::optional<std::pmr::vector<uint32_t>> slots_;  // Group or EMPTY
+  size_t current_group_{0};
+  bool materialized_{false};
+};
+
+/**
+ * @brief Streaming aggregation over input sorted by the group keys
+ *
+ * Holds one group at a time, so memory does not grow with the number
+ * of groups, and groups come out in the input's order.
+ */
+class SortAggregateOperator : public AggregateOperator {
+public:
+  using AggregateOperator::AggregateOperator;
+
+  void open(ExecutionContext &ctx) override;
+  bool next(ExecutionContext &ctx, ResultRow &row) override;
+
+private:
+  bool primed_{false};
+  bool has_input_{false};
+  bool emitted_{false};
+};
+
+/**
+ * @brief Aggregates of a whole table read from its summary
+ *
+ * Returns the one row an aggregation without GROUP BY would: COUNT(*)
+ * is the live row count, COUNT(column) the column's non-NULL values, and
+ * MIN and MAX the ends of its range, NULL if it holds no values. Nothing
+ * is scanned.
+ */
+class MetadataAggregateOperator : public Operator {
+public:
+  MetadataAggregateOperator(std::vector<planner::AggregateExpr> aggregates,
+                            const planner::Bindings &bindings,
+                            const planner::TableInfo *schema,
+                            TableSummary summary);
+
+  void open(ExecutionContext &ctx) override;
+  bool next(ExecutionContext &ctx, ResultRow &row) override;
+  void close() override {}
+  std::vector<std::string> column_names() const override;
+
+private:
+  std::vector<planner::AggregateExpr> aggregates_;
+  const planner::Bindings &bindings_;
+  const planner::TableInfo *schema_;
+  TableSummary summary_;
+  bool done_{false};
+};
+
+} // namespace executor
+} // namespace edgesql
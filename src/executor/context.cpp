@@ -11,7 +11,7 @@ namespace executor {
 
 ExecutionContext::ExecutionContext(const QueryBudget &budget,
                                    memory::QueryAllocator &allocator)
-    : budget_(budget), allocator_(allocator) {}
+    : budget_(budget), allocator_(allocator), resource_(allocator) {}
 
 void ExecutionContext::start() {
   start_time_ = std::chrono::steady_clock::now();
@@ -99,6 +99,11 @@ void *ExecutionContext::allocate(size_t size) {
   return allocator_.allocate(size);
 }
 
+void ExecutionContext::record_memory_exceeded() {
+  stats_.memory_used = allocator_.bytes_used();
+  violation_ = BudgetViolation::MEMORY_EXCEEDED;
+}
+
 void ExecutionContext::finalize() {
   if (started_) {
     auto elapsed = std::chrono::steady_clock::now() - start_time_;
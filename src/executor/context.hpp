@@ -6,6 +6,7 @@
  */
 
 #include "../memory/query_allocator.hpp"
+#include "../memory/query_resource.hpp"
 #include <chrono>
 #include <cstdint>
 #include <functional>
@@ -22,6 +23,13 @@ struct QueryBudget {
   uint64_t max_instructions = 10000000;       // 10M instructions
   std::chrono::milliseconds max_time{30000};  // 30 seconds
   size_t max_result_rows = 100000;            // 100K rows
+
+  /**
+   * @brief Memory a sort, hash aggregation or hash join may hold before
+   *        it spills, a quarter of max_memory_bytes; plans favour
+   *        operators that fit in it
+   */
+  size_t work_memory() const { return max_memory_bytes / 4; }
 };
 
 /**
@@ -130,11 +138,24 @@ public:
    */
   memory::QueryAllocator &allocator() { return allocator_; }
 
+  /**
+   * @brief Get the query's pmr memory resource
+   *
+   * Containers built on this resource allocate from the query arena and
+   * count against max_memory_bytes.
+   */
+  std::pmr::memory_resource *memory_resource() { return &resource_; }
+
   /**
    * @brief Allocate memory through context
    */
   void *allocate(size_t size);
 
+  /**
+   * @brief Record that an allocation exceeded the memory budget
+   */
+  void record_memory_exceeded();
+
   /**
    * @brief Finalize and update final stats
    */
@@ -147,6 +168,7 @@ private:
 
   QueryBudget budget_;
   memory::QueryAllocator &allocator_;
+  memory::QueryMemoryResource resource_;
   ExecutionStats stats_;
 
   std::chrono::steady_clock::time_point start_time_;
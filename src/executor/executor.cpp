@@ -4,25 +4,110 @@
  */
 
 #include "executor.hpp"
+#include "aggregate.hpp"
+#include "expression.hpp"
+#include "join.hpp"
+#include "spill.hpp"
+#include "view.hpp"
+#include "../memory/memory_tracker.hpp"
+#include "../observability/metrics.hpp"
+#include "../planner/statistics.hpp"
+#include "../storage/encoded_page.hpp"
+#include "../storage/pax_page.hpp"
 #include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <random>
 
 namespace edgesql {
 namespace executor {
 
+storage::PageGuard pin_table_page(storage::PageManager &page_manager,
+                                  uint32_t table_id, uint32_t page_id) {
+  storage::PinStatus status;
+  storage::PageGuard page = page_manager.pin_page(table_id, page_id, &status);
+  if (status == storage::PinStatus::NO_FRAME) {
+    throw std::bad_alloc();
+  }
+  return page;
+}
+
 // TableScanOperator implementation
 
+namespace {
+
+void set_null(sql::Literal &value) {
+  value.type = sql::Literal::Type::NULL_VAL;
+}
+
+} // anonymous namespace
+
 TableScanOperator::TableScanOperator(uint32_t table_id,
                                      const std::string &table_name,
                                      storage::PageManager &page_manager,
-                                     const planner::TableInfo *schema)
+                                     const planner::TableInfo *schema,
+                                     std::vector<uint32_t> column_indices,
+                                     storage::SegmentManager *segments,
+                                     int64_t time_lo, int64_t time_hi)
     : table_id_(table_id), table_name_(table_name), page_manager_(page_manager),
-      schema_(schema) {}
+      schema_(schema), column_indices_(std::move(column_indices)),
+      segments_(segments), time_lo_(time_lo), time_hi_(time_hi) {
+  if (column_indices_.empty() && schema_) {
+    for (uint32_t i = 0; i < schema_->columns.size(); ++i) {
+      column_indices_.push_back(i);
+    }
+  }
+
+  // Rows are checked against the time range, so the column is decoded
+  bool restricted = time_lo_ != INT64_MIN || time_hi_ != INT64_MAX;
+  if (segments_ && schema_ && schema_->partitioning.enabled() && restricted) {
+    time_column_ = schema_->partitioning.column;
+    uint32_t col = static_cast<uint32_t>(time_column_);
+    auto at =
+        std::lower_bound(column_indices_.begin(), column_indices_.end(), col);
+    if (at == column_indices_.end() || *at != col) {
+      column_indices_.insert(at, col);
+    }
+  }
+}
+
+void TableScanOperator::sample(sql::SampleMethod method, double fraction,
+                               uint64_t seed) {
+  sampled_ = fraction < 1.0;
+  sample_method_ = method;
+  sample_seed_ = planner::hash_integer(static_cast<int64_t>(seed));
+  sample_threshold_ =
+      sampled_ ? static_cast<uint64_t>(std::ldexp(std::max(fraction, 0.0), 64))
+               : UINT64_MAX;
+}
 
 void TableScanOperator::open(ExecutionContext &ctx) {
   current_page_ = 0;
   current_slot_ = 0;
-  page_ = page_manager_.get_page(table_id_, current_page_);
+  segment_index_ = 0;
+  pages_read_ = 0;
+  if (sampled_ && !segments_) {
+    page_limit_ = page_manager_.table_page_count(table_id_);
+  }
+
+  if (segments_) {
+    // An empty range (e.g. ts > 10 AND ts < 5) reads nothing
+    if (time_column_ >= 0) {
+      storage::SegmentManager::ColumnRange range{
+          static_cast<size_t>(time_column_), time_lo_, time_hi_};
+      snapshot_ = time_lo_ <= time_hi_ ? segments_->snapshot(table_id_, &range)
+                                       : storage::SegmentManager::Snapshot();
+    } else {
+      snapshot_ = segments_->snapshot(table_id_);
+    }
+    if (!scratch_) {
+      scratch_ = std::make_unique<storage::Page>();
+    }
+  }
+
+  page_ = fetch_page();
   ctx.record_instructions(10); // Opening cost
 }
 
@@ -30,42 +115,367 @@ bool TableScanOperator::next(ExecutionContext &ctx, ResultRow &row) {
   ctx.record_instructions(1);
 
   while (page_ != nullptr) {
-    // Try to read from current page
-    while (current_slot_ < page_->slot_count()) {
-      const uint8_t *data = nullptr;
-      uint16_t length = 0;
-
-      if (page_->get_record(current_slot_, &data, &length)) {
-        ctx.record_row_scanned();
-        ctx.record_instructions(5);
-
-        // Parse record into row
-        row.values.clear();
-        if (schema_) {
-          for (size_t i = 0; i < schema_->columns.size(); ++i) {
-            // Simplified: just add null values
-            // In real implementation, parse actual record data
-            row.values.push_back(sql::Literal::null());
-          }
-        }
-
-        current_slot_++;
-        return true;
+    if (read_row(ctx, row)) {
+      if (!in_time_range(row)) {
+        continue;
       }
-      current_slot_++;
+      if (row_ids_) {
+        // read_row has moved past the row
+        row.values.emplace_back();
+        row.values.back().type = sql::Literal::Type::INTEGER;
+        row.values.back().int_value = row_id_value(
+            {current_page_, static_cast<uint16_t>(current_slot_ - 1)});
+      }
+      return true;
     }
 
     // Move to next page
-    current_page_++;
+    current_page_ += page_stride_;
     current_slot_ = 0;
-    page_ = page_manager_.get_page(table_id_, current_page_);
+    page_ = fetch_page();
     ctx.record_instructions(10);
   }
 
   return false;
 }
 
-void TableScanOperator::close() { page_ = nullptr; }
+const storage::Page *TableScanOperator::fetch_page() {
+  if (!segments_) {
+    while (sampled_ && current_page_ < page_limit_ && !keep_page()) {
+      current_page_ += page_stride_;
+    }
+    pinned_ = pin_table_page(page_manager_, table_id_, current_page_);
+    pages_read_ += pinned_ ? 1 : 0;
+    return pinned_.get();
+  }
+
+  // Sealed segments are read from their mapping; only the active one is
+  // copied into the scratch page
+  const auto &segments = snapshot_.segments();
+  while (segment_index_ < segments.size()) {
+    storage::Segment *segment = segments[segment_index_];
+    if (current_page_ >= segment->page_count()) {
+      segment_index_++;
+      current_page_ = 0;
+      continue;
+    }
+    if (!keep_page()) {
+      current_page_ += page_stride_;
+      continue;
+    }
+
+    const storage::Page *page = segment->scan_page(current_page_, *scratch_);
+    if (page && page->header().is_valid()) {
+      page_ = page;
+      pages_read_++;
+      if (decode_page()) {
+        return page;
+      }
+    }
+    current_page_ += page_stride_;
+  }
+  return nullptr;
+}
+
+bool TableScanOperator::keep_page() {
+  if (!sampled_) {
+    return true;
+  }
+  uint64_t segment =
+      segments_ ? snapshot_.segments()[segment_index_]->segment_id() : 0;
+  page_hash_ = planner::hash_integer(
+      static_cast<int64_t>(sample_seed_ ^ (segment << 32 | current_page_)));
+  return sample_method_ != sql::SampleMethod::SYSTEM ||
+         page_hash_ < sample_threshold_;
+}
+
+bool TableScanOperator::keep_row() const {
+  return !sampled_ || sample_method_ != sql::SampleMethod::BERNOULLI ||
+         planner::hash_integer(static_cast<int64_t>(
+             page_hash_ ^ current_slot_)) < sample_threshold_;
+}
+
+bool TableScanOperator::decode_page() {
+  if (!storage::EncodedPage::is_encoded(*page_)) {
+    return true;
+  }
+
+  // The time range is tested on the encoded block first, so a page with
+  // no row in range is skipped without decoding any column
+  storage::EncodedPage encoded(*page_);
+  encoded_selected_.clear();
+  if (time_column_ >= 0 &&
+      static_cast<size_t>(time_column_) < encoded.column_count() &&
+      encoded.column_type(time_column_) == storage::ColumnType::INTEGER) {
+    encoded_selected_.resize(encoded.row_count());
+    if (encoded.select_range(time_column_, time_lo_, time_hi_,
+                             encoded_selected_.data()) == 0) {
+      return false;
+    }
+  }
+
+  // Decode each requested column once per page
+  encoded_ints_.resize(encoded.column_count());
+  encoded_texts_.resize(encoded.column_count());
+  for (uint32_t col : column_indices_) {
+    if (col >= encoded.column_count()) {
+      continue;
+    }
+    storage::ColumnType type = encoded.column_type(col);
+    if (type == storage::ColumnType::TEXT ||
+        type == storage::ColumnType::BLOB) {
+      encoded_texts_[col].resize(encoded.row_count());
+      encoded.decode_strings(col, encoded_texts_[col].data());
+    } else {
+      encoded_ints_[col].resize(encoded.row_count());
+      encoded.decode_ints(col, encoded_ints_[col].data());
+    }
+  }
+  return true;
+}
+
+bool TableScanOperator::read_row(ExecutionContext &ctx, ResultRow &row) {
+  // Table pages may be appended to meanwhile; segment pages are sealed or
+  // a private copy
+  std::shared_lock<std::shared_mutex> latch;
+  if (pinned_) {
+    latch = std::shared_lock<std::shared_mutex>(pinned_.latch());
+  }
+
+  // Rows left out of a sample or the time range are skipped before they
+  // are decoded
+  if (storage::EncodedPage::is_encoded(*page_)) {
+    uint32_t rows = storage::EncodedPage(*page_).row_count();
+    while (current_slot_ < rows &&
+           (!keep_row() || (!encoded_selected_.empty() &&
+                            !encoded_selected_[current_slot_]))) {
+      current_slot_++;
+    }
+    if (current_slot_ < rows) {
+      ctx.record_row_scanned();
+      ctx.record_instructions(column_indices_.size());
+      read_encoded_row(row);
+      current_slot_++;
+      return true;
+    }
+    return false;
+  }
+
+  if (storage::PaxPage::is_pax(*page_)) {
+    uint32_t rows = storage::PaxPage(*page_).row_count();
+    while (current_slot_ < rows && !keep_row()) {
+      current_slot_++;
+    }
+    if (current_slot_ < rows) {
+      ctx.record_row_scanned();
+      ctx.record_instructions(column_indices_.size());
+      read_pax_row(row);
+      current_slot_++;
+      return true;
+    }
+    return false;
+  }
+
+  // Try to read from current page
+  while (current_slot_ < page_->slot_count()) {
+    const uint8_t *data = nullptr;
+    uint16_t length = 0;
+
+    if (keep_row() &&
+        page_->get_record(static_cast<uint16_t>(current_slot_), &data,
+                          &length) &&
+        record_.deserialize(data, length)) {
+      ctx.record_row_scanned();
+      ctx.record_instructions(5);
+      read_record(row);
+      current_slot_++;
+      return true;
+    }
+    current_slot_++;
+  }
+  return false;
+}
+
+bool TableScanOperator::in_time_range(const ResultRow &row) const {
+  if (time_column_ < 0) {
+    return true;
+  }
+  const sql::Literal &value = row.values[time_column_];
+  return value.type == sql::Literal::Type::INTEGER &&
+         value.int_value >= time_lo_ && value.int_value <= time_hi_;
+}
+
+void TableScanOperator::read_record(ResultRow &row) {
+  size_t width = schema_ ? schema_->columns.size() : record_.column_count();
+  row.values.resize(width);
+  for (auto &value : row.values) {
+    set_null(value);
+  }
+
+  for (uint32_t col : column_indices_) {
+    if (col >= width || col >= record_.column_count() ||
+        record_.is_null(col)) {
+      continue;
+    }
+
+    sql::Literal &value = row.values[col];
+    switch (record_.get_type(col)) {
+    case storage::ColumnType::INTEGER:
+      value.type = sql::Literal::Type::INTEGER;
+      value.int_value = record_.get_integer(col);
+      break;
+    case storage::ColumnType::FLOAT:
+      value.type = sql::Literal::Type::FLOAT;
+      value.float_value = record_.get_float(col);
+      break;
+    case storage::ColumnType::BOOLEAN:
+      value.type = sql::Literal::Type::BOOLEAN;
+      value.bool_value = record_.get_boolean(col);
+      break;
+    case storage::ColumnType::TEXT:
+      value.type = sql::Literal::Type::STRING;
+      value.string_value.assign(record_.get_text(col));
+      break;
+    case storage::ColumnType::BLOB: {
+      const auto &blob = record_.get_blob(col);
+      value.type = sql::Literal::Type::STRING;
+      value.string_value.assign(blob.begin(), blob.end());
+      break;
+    }
+    case storage::ColumnType::NULLTYPE:
+      break;
+    }
+  }
+}
+
+void TableScanOperator::read_pax_row(ResultRow &row) {
+  storage::PaxPage pax(*page_);
+  size_t width = schema_ ? schema_->columns.size() : pax.column_count();
+  row.values.resize(width);
+  for (auto &value : row.values) {
+    set_null(value);
+  }
+
+  // Only the requested columns' bitmaps and minipages are read
+  uint16_t r = static_cast<uint16_t>(current_slot_);
+  for (uint32_t col : column_indices_) {
+    if (col >= width || col >= pax.column_count() || pax.is_null(col, r)) {
+      continue;
+    }
+
+    sql::Literal &value = row.values[col];
+    switch (pax.column_type(col)) {
+    case storage::ColumnType::INTEGER:
+      value.type = sql::Literal::Type::INTEGER;
+      value.int_value = pax.int_values(col)[r];
+      break;
+    case storage::ColumnType::FLOAT:
+      value.type = sql::Literal::Type::FLOAT;
+      value.float_value = pax.float_values(col)[r];
+      break;
+    case storage::ColumnType::BOOLEAN:
+      value.type = sql::Literal::Type::BOOLEAN;
+      value.bool_value = pax.bool_values(col)[r] != 0;
+      break;
+    case storage::ColumnType::TEXT:
+    case storage::ColumnType::BLOB:
+      value.type = sql::Literal::Type::STRING;
+      value.string_value.assign(pax.text(col, r));
+      break;
+    case storage::ColumnType::NULLTYPE:
+      break;
+    }
+  }
+}
+
+void TableScanOperator::read_encoded_row(ResultRow &row) {
+  storage::EncodedPage encoded(*page_);
+  size_t width = schema_ ? schema_->columns.size() : encoded.column_count();
+  row.values.resize(width);
+  for (auto &value : row.values) {
+    set_null(value);
+  }
+
+  uint32_t r = current_slot_;
+  for (uint32_t col : column_indices_) {
+    if (col >= width || col >= encoded.column_count() ||
+        encoded.is_null(col, r)) {
+      continue;
+    }
+
+    sql::Literal &value = row.values[col];
+    switch (encoded.column_type(col)) {
+    case storage::ColumnType::INTEGER:
+      value.type = sql::Literal::Type::INTEGER;
+      value.int_value = encoded_ints_[col][r];
+      break;
+    case storage::ColumnType::FLOAT:
+      // Stored as the double's bit pattern
+      value.type = sql::Literal::Type::FLOAT;
+      std::memcpy(&value.float_value, &encoded_ints_[col][r],
+                  sizeof(value.float_value));
+      break;
+    case storage::ColumnType::BOOLEAN:
+      value.type = sql::Literal::Type::BOOLEAN;
+      value.bool_value = encoded_ints_[col][r] != 0;
+      break;
+    case storage::ColumnType::TEXT:
+    case storage::ColumnType::BLOB:
+      value.type = sql::Literal::Type::STRING;
+      value.string_value.assign(encoded_texts_[col][r]);
+      break;
+    case storage::ColumnType::NULLTYPE:
+      break;
+    }
+  }
+}
+
+bool TableScanOperator::read_at(ExecutionContext &ctx, storage::RowId id,
+                                ResultRow &row) {
+  if (!page_ || id.page_id != current_page_) {
+    current_page_ = id.page_id;
+    pinned_ = pin_table_page(page_manager_, table_id_, current_page_);
+    page_ = pinned_.get();
+    pages_read_ += page_ != nullptr;
+    ctx.record_instructions(10);
+  }
+  if (!page_) {
+    return false;
+  }
+
+  std::shared_lock<std::shared_mutex> latch(pinned_.latch());
+  current_slot_ = id.slot_id;
+  if (storage::PaxPage::is_pax(*page_)) {
+    uint32_t rows = storage::PaxPage(*page_).row_count();
+    while (current_slot_ < rows && !keep_row()) {
+      current_slot_++;
+    }
+    if (current_slot_ < rows) {
+      ctx.record_row_scanned();
+      ctx.record_instructions(column_indices_.size());
+      read_pax_row(row);
+      return true;
+    }
+    return false;
+  }
+
+  const uint8_t *data = nullptr;
+  uint16_t length = 0;
+  if (page_->get_record(id.slot_id, &data, &length) &&
+      record_.deserialize(data, length)) {
+    ctx.record_row_scanned();
+    ctx.record_instructions(5);
+    read_record(row);
+    return true;
+  }
+  return false;
+}
+
+void TableScanOperator::close() {
+  page_ = nullptr;
+  pinned_.release();
+  snapshot_ = storage::SegmentManager::Snapshot();
+}
 
 std::vector<std::string> TableScanOperator::column_names() const {
   std::vector<std::string> names;
@@ -74,22 +484,192 @@ std::vector<std::string> TableScanOperator::column_names() const {
       names.push_back(col.name);
     }
   }
+  if (row_ids_) {
+    names.push_back("$row_id");
+  }
+  return names;
+}
+
+// IndexScanOperator implementation
+
+IndexScanOperator::IndexScanOperator(uint32_t table_id,
+                                     const std::string &table_name,
+                                     storage::PageManager &page_manager,
+                                     const planner::TableInfo *schema,
+                                     std::vector<uint32_t> column_indices,
+                                     std::vector<storage::RowId> rows)
+    : TableScanOperator(table_id, table_name, page_manager, schema,
+                        std::move(column_indices)),
+      rows_(std::move(rows)) {}
+
+void IndexScanOperator::open(ExecutionContext &ctx) {
+  next_row_ = 0;
+  pages_read_ = 0;
+  page_ = nullptr;
+  ctx.record_instructions(10); // Opening cost
+}
+
+bool IndexScanOperator::next(ExecutionContext &ctx, ResultRow &row) {
+  ctx.record_instructions(1);
+
+  while (next_row_ < rows_.size()) {
+    if (read_at(ctx, rows_[next_row_++], row)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// FetchOperator implementation
+
+FetchOperator::FetchOperator(std::unique_ptr<Operator> child,
+                             uint32_t table_id, const std::string &table_name,
+                             storage::PageManager &page_manager,
+                             const planner::TableInfo *schema,
+                             std::vector<uint32_t> column_indices)
+    : TableScanOperator(table_id, table_name, page_manager, schema,
+                        std::move(column_indices)),
+      child_(std::move(child)) {}
+
+void FetchOperator::open(ExecutionContext &ctx) {
+  child_->open(ctx);
+  fetched_.emplace(ctx.memory_resource());
+  pages_read_ = 0;
+  page_ = nullptr;
+}
+
+bool FetchOperator::next(ExecutionContext &ctx, ResultRow &row) {
+  if (!child_->next(ctx, row)) {
+    return false;
+  }
+
+  storage::RowId id = row_id_of(row.values.back());
+  row.values.pop_back();
+  if (!read_at(ctx, id, *fetched_)) {
+    throw std::runtime_error("Failed to fetch row of table: " + table_name_);
+  }
+  for (uint32_t col : column_indices_) {
+    if (col < row.values.size()) {
+      row.values[col] = std::move(fetched_->values[col]);
+    }
+  }
+  return true;
+}
+
+void FetchOperator::close() {
+  child_->close();
+  page_ = nullptr;
+  pinned_.release();
+}
+
+std::vector<std::string> FetchOperator::column_names() const {
+  std::vector<std::string> names = child_->column_names();
+  if (!names.empty()) {
+    names.pop_back();
+  }
   return names;
 }
 
 // FilterOperator implementation
 
+namespace {
+
+// Split an AND tree into its conjuncts, leftmost first
+void split_conjuncts(const sql::Expression *expr,
+                     const planner::Bindings &bindings,
+                     std::vector<const sql::Expression *> &out) {
+  if (expr->type == sql::ExprType::BINARY_OP &&
+      expr->binary_op == sql::BinaryOp::AND && bindings.position(*expr) < 0) {
+    split_conjuncts(expr->left, bindings, out);
+    split_conjuncts(expr->right, bindings, out);
+    return;
+  }
+  out.push_back(expr);
+}
+
+// Instructions to evaluate an expression, one per node evaluated
+uint32_t evaluation_cost(const sql::Expression &expr,
+                         const planner::Bindings &bindings) {
+  if (bindings.position(expr) >= 0) {
+    return 1;
+  }
+  uint32_t cost = 1;
+  switch (expr.type) {
+  case sql::ExprType::BINARY_OP:
+    cost += evaluation_cost(*expr.right, bindings);
+    [[fallthrough]];
+  case sql::ExprType::UNARY_OP:
+    cost += evaluation_cost(*expr.left, bindings);
+    break;
+  case sql::ExprType::FUNCTION_CALL:
+    for (const sql::Expression *arg : expr.args) {
+      cost += evaluation_cost(*arg, bindings);
+    }
+    break;
+  default:
+    break;
+  }
+  return cost;
+}
+
+// Whether evaluation may throw for some rows and not others: arithmetic
+// can overflow or divide by zero
+bool can_fail(const sql::Expression &expr, const planner::Bindings &bindings) {
+  if (bindings.position(expr) >= 0) {
+    return false;
+  }
+  switch (expr.type) {
+  case sql::ExprType::BINARY_OP:
+    if (expr.binary_op <= sql::BinaryOp::MOD) { // ADD through MOD
+      return true;
+    }
+    return can_fail(*expr.left, bindings) || can_fail(*expr.right, bindings);
+  case sql::ExprType::UNARY_OP:
+    return expr.unary_op == sql::UnaryOp::MINUS ||
+           can_fail(*expr.left, bindings);
+  case sql::ExprType::FUNCTION_CALL:
+    return true;
+  default:
+    return false;
+  }
+}
+
+} // anonymous namespace
+
 FilterOperator::FilterOperator(std::unique_ptr<Operator> child,
-                               const sql::Expression *predicate)
-    : child_(std::move(child)), predicate_(predicate) {}
+                               const sql::Expression *predicate,
+                               const planner::Bindings &bindings)
+    : child_(std::move(child)), bindings_(bindings) {
+  if (!predicate) {
+    return;
+  }
+  std::vector<const sql::Expression *> conjuncts;
+  split_conjuncts(predicate, bindings, conjuncts);
+  for (const sql::Expression *conjunct : conjuncts) {
+    conjuncts_.push_back({conjunct, evaluation_cost(*conjunct, bindings),
+                          can_fail(*conjunct, bindings), 0, 0});
+  }
+  auto failing = std::stable_partition(
+      conjuncts_.begin(), conjuncts_.end(),
+      [](const Conjunct &conjunct) { return !conjunct.can_fail; });
+  reorderable_ = static_cast<size_t>(failing - conjuncts_.begin());
+}
 
-void FilterOperator::open(ExecutionContext &ctx) { child_->open(ctx); }
+void FilterOperator::open(ExecutionContext &ctx) {
+  child_->open(ctx);
+  rows_until_reorder_ = REORDER_INTERVAL;
+}
 
 bool FilterOperator::next(ExecutionContext &ctx, ResultRow &row) {
   while (child_->next(ctx, row)) {
-    ctx.record_instructions(5); // Evaluation cost
+    ctx.record_instructions(1);
 
-    if (!predicate_ || evaluate_predicate(row)) {
+    bool keep = evaluate_predicate(ctx, row);
+    if (--rows_until_reorder_ == 0) {
+      reorder();
+      rows_until_reorder_ = REORDER_INTERVAL;
+    }
+    if (keep) {
       return true;
     }
   }
@@ -102,13 +682,83 @@ std::vector<std::string> FilterOperator::column_names() const {
   return child_->column_names();
 }
 
-bool FilterOperator::evaluate_predicate(const ResultRow &row) {
-  // Simplified: always return true
-  // In real implementation, evaluate the expression tree
-  (void)row;
+bool FilterOperator::evaluate_predicate(ExecutionContext &ctx,
+                                        const ResultRow &row) {
+  for (Conjunct &conjunct : conjuncts_) {
+    ctx.record_instructions(conjunct.cost);
+    conjunct.evaluated++;
+    if (!is_true(*conjunct.predicate, row, bindings_)) {
+      return false;
+    }
+    conjunct.passed++;
+  }
+  return true;
+}
+
+void FilterOperator::reorder() {
+  // Rank by expected cost per rejected row. Counts are smoothed so an
+  // unseen conjunct ranks by cost alone, and halved afterwards so the
+  // order follows changes in the data.
+  auto cost_per_reject = [](const Conjunct &conjunct) {
+    double rejected = static_cast<double>(conjunct.evaluated -
+                                          conjunct.passed) + 1.0;
+    double rate = rejected / (static_cast<double>(conjunct.evaluated) + 2.0);
+    return static_cast<double>(conjunct.cost) / rate;
+  };
+  std::stable_sort(conjuncts_.begin(), conjuncts_.begin() + reorderable_,
+                   [&](const Conjunct &a, const Conjunct &b) {
+                     return cost_per_reject(a) < cost_per_reject(b);
+                   });
+  for (Conjunct &conjunct : conjuncts_) {
+    conjunct.evaluated /= 2;
+    conjunct.passed /= 2;
+  }
+}
+
+// ProjectOperator implementation
+
+ProjectOperator::ProjectOperator(
+    std::unique_ptr<Operator> child,
+    std::vector<const sql::Expression *> expressions,
+    std::vector<int32_t> columns, std::vector<std::string> output_names,
+    const planner::Bindings &bindings)
+    : child_(std::move(child)), expressions_(std::move(expressions)),
+      columns_(std::move(columns)), output_names_(std::move(output_names)),
+      bindings_(bindings) {}
+
+void ProjectOperator::open(ExecutionContext &ctx) {
+  child_->open(ctx);
+  input_.emplace(ctx.memory_resource());
+}
+
+bool ProjectOperator::next(ExecutionContext &ctx, ResultRow &row) {
+  if (!child_->next(ctx, *input_)) {
+    return false;
+  }
+
+  const auto &input = input_->values;
+  row.values.resize(expressions_.size());
+  for (size_t i = 0; i < expressions_.size(); ++i) {
+    int32_t column = columns_[i];
+    if (column >= 0 && static_cast<size_t>(column) < input.size()) {
+      row.values[i] = input[column];
+    } else {
+      assign(row.values[i], evaluate(*expressions_[i], *input_, bindings_));
+    }
+  }
+  ctx.record_instructions(expressions_.size());
   return true;
 }
 
+void ProjectOperator::close() {
+  child_->close();
+  input_.reset();
+}
+
+std::vector<std::string> ProjectOperator::column_names() const {
+  return output_names_;
+}
+
 // LimitOperator implementation
 
 LimitOperator::LimitOperator(std::unique_ptr<Operator> child, int64_t limit,
@@ -153,76 +803,371 @@ std::vector<std::string> LimitOperator::column_names() const {
 
 // SortOperator implementation
 
+namespace {
+
+// Sort working memory: a quarter of the query budget, at least 256KB
+constexpr size_t MIN_SORT_RUN_BYTES = 256 * 1024;
+
+} // anonymous namespace
+
+RowComparator::RowComparator(std::vector<const sql::Expression *> keys,
+                             std::vector<int32_t> key_columns,
+                             std::vector<bool> ascending,
+                             const planner::Bindings &bindings)
+    : keys_(std::move(keys)), key_columns_(std::move(key_columns)),
+      ascending_(std::move(ascending)), bindings_(&bindings) {}
+
+bool RowComparator::operator()(const ResultRow &a, const ResultRow &b) const {
+  for (size_t i = 0; i < keys_.size(); ++i) {
+    int32_t column = key_columns_[i];
+    int order;
+    if (column >= 0 && static_cast<size_t>(column) < a.values.size() &&
+        static_cast<size_t>(column) < b.values.size()) {
+      order = compare_values(Value::of(a.values[column]),
+                             Value::of(b.values[column]));
+    } else {
+      order = compare_values(evaluate(*keys_[i], a, *bindings_),
+                             evaluate(*keys_[i], b, *bindings_));
+    }
+
+    if (order != 0) {
+      return ascending_[i] ? order < 0 : order > 0;
+    }
+  }
+  return false;
+}
+
 SortOperator::SortOperator(std::unique_ptr<Operator> child,
-                           std::vector<size_t> sort_columns,
-                           std::vector<bool> ascending)
-    : child_(std::move(child)), sort_columns_(std::move(sort_columns)),
-      ascending_(std::move(ascending)) {}
+                           std::vector<const sql::Expression *> keys,
+                           std::vector<int32_t> key_columns,
+                           std::vector<bool> ascending,
+                           const planner::Bindings &bindings,
+                           std::string spill_dir)
+    : child_(std::move(child)),
+      compare_(std::move(keys), std::move(key_columns), std::move(ascending),
+               bindings),
+      spill_dir_(std::move(spill_dir)) {}
+
+SortOperator::~SortOperator() { remove_runs(); }
 
 void SortOperator::open(ExecutionContext &ctx) {
   child_->open(ctx);
-  buffer_.clear();
+  remove_runs();
   current_row_ = 0;
   materialized_ = false;
+
+  size_t run_limit = std::max(ctx.budget().work_memory(), MIN_SORT_RUN_BYTES);
+  run_memory_ = std::make_unique<RunMemory>(run_limit);
 }
 
 bool SortOperator::next(ExecutionContext &ctx, ResultRow &row) {
   // Materialize all rows on first call
   if (!materialized_) {
-    ResultRow temp;
-    while (child_->next(ctx, temp)) {
-      buffer_.push_back(std::move(temp));
-      ctx.record_instructions(2);
-      ctx.check_budget(); // Check budget while materializing
-    }
-
-    // Sort the buffer
-    std::sort(buffer_.begin(), buffer_.end(),
-              [this](const ResultRow &a, const ResultRow &b) {
-                for (size_t i = 0; i < sort_columns_.size(); ++i) {
-                  size_t col = sort_columns_[i];
-                  if (col >= a.values.size() || col >= b.values.size())
-                    continue;
-
-                  // Simplified comparison (just compare as integers)
-                  const auto &va = a.values[col];
-                  const auto &vb = b.values[col];
-
-                  if (va.type == sql::Literal::Type::INTEGER &&
-                      vb.type == sql::Literal::Type::INTEGER) {
-                    if (va.int_value != vb.int_value) {
-                      return ascending_[i] ? (va.int_value < vb.int_value)
-                                           : (va.int_value > vb.int_value);
-                    }
-                  }
-                }
-                return false;
-              });
-
-    ctx.record_instructions(static_cast<uint64_t>(buffer_.size()) *
-                            10); // Sort cost
+    materialize(ctx);
     materialized_ = true;
   }
 
-  if (current_row_ < buffer_.size()) {
-    row = std::move(buffer_[current_row_]);
-    current_row_++;
-    return true;
+  if (runs_.empty()) {
+    auto &rows = run_memory_->rows;
+    if (current_row_ < rows.size()) {
+      row = std::move(rows[current_row_]);
+      current_row_++;
+      return true;
+    }
+    return false;
   }
 
-  return false;
+  // K-way merge of spilled runs; the run count is small, so a linear scan
+  // for the smallest head is cheaper than maintaining a heap
+  SpillRun *best = nullptr;
+  for (auto &run : runs_) {
+    if (run.has_row && (!best || compare_(run.head, best->head))) {
+      best = &run;
+    }
+  }
+  ctx.record_instructions(runs_.size());
+
+  if (!best) {
+    return false;
+  }
+
+  row = best->head;
+  best->has_row = read_row(best->in, best->head);
+  return true;
 }
 
 void SortOperator::close() {
   child_->close();
-  buffer_.clear();
+  remove_runs();
+  run_memory_.reset();
 }
 
 std::vector<std::string> SortOperator::column_names() const {
   return child_->column_names();
 }
 
-// Executor implementation
+void SortOperator::materialize(ExecutionContext &ctx) {
+  // Rows accumulate in the run arena; when the next row would not fit the
+  // buffer is sorted and written out as a run. temp lives in the query
+  // arena and keeps its storage, since push_back copies across resources.
+  auto &rows = run_memory_->rows;
+  ResultRow temp(ctx.memory_resource());
+  while (child_->next(ctx, temp)) {
+    if (!rows.empty() && must_spill(temp)) {
+      spill_buffer(ctx);
+    }
+    rows.push_back(std::move(temp));
+    ctx.record_instructions(2);
+    ctx.check_budget(); // Check budget while materializing
+  }
+
+  if (runs_.empty()) {
+    sort_buffer(ctx);
+    return;
+  }
+
+  // Spill the tail too so every row is merged the same way
+  if (!rows.empty()) {
+    spill_buffer(ctx);
+  }
+  start_merge();
+}
+
+bool SortOperator::must_spill(const ResultRow &row) const {
+  const auto &rows = run_memory_->rows;
+  size_t needed = row_footprint(row);
+  if (rows.size() == rows.capacity()) {
+    // Growing the buffer copies it into a block twice the size
+    needed += (rows.capacity() * 2 + 1) * sizeof(ResultRow);
+  }
+
+  const auto &allocator = run_memory_->allocator;
+  if (allocator.would_exceed(needed)) {
+    return true;
+  }
+
+  // Under global memory pressure give back memory early, but not so early
+  // that every few rows become a run of their own
+  return memory::MemoryTracker::instance().under_pressure() &&
+         allocator.bytes_used() >= allocator.memory_limit() / 8;
+}
+
+void SortOperator::sort_buffer(ExecutionContext &ctx) {
+  auto &rows = run_memory_->rows;
+  std::sort(rows.begin(), rows.end(), compare_);
+
+  ctx.record_instructions(static_cast<uint64_t>(rows.size()) *
+                          10); // Sort cost
+}
+
+void SortOperator::spill_buffer(ExecutionContext &ctx) {
+  sort_buffer(ctx);
+
+  if (runs_.empty()) {
+    std::error_code ec;
+    std::filesystem::create_directories(spill_dir_, ec);
+  }
+
+  auto &rows = run_memory_->rows;
+
+  // The merge head is allocated up front so it lives in the run arena
+  SpillRun run{spill_path(spill_dir_, "sort"), std::ifstream(),
+               ResultRow(&run_memory_->resource)};
+
+  std::ofstream out(run.path, std::ios::binary | std::ios::trunc);
+  for (const auto &buffered : rows) {
+    write_row(out, buffered);
+  }
+  out.close();
+
+  // Register before checking so a failed run is still cleaned up
+  runs_.push_back(std::move(run));
+  if (!out) {
+    throw std::runtime_error("Failed to write sort spill file");
+  }
+  ctx.record_instructions(static_cast<uint64_t>(rows.size()) * 2);
+  observability::Metrics::instance().increment("sort_spills");
+
+  // Drop the buffer's storage before the arena under it is reset
+  rows.clear();
+  rows.shrink_to_fit();
+  run_memory_->allocator.reset();
+  run_memory_->arena.reset();
+  if (memory::MemoryTracker::instance().under_pressure()) {
+    run_memory_->arena.trim(0);
+  }
+}
+
+void SortOperator::start_merge() {
+  // Heads are read in place, so the run arena holds at most one row per
+  // run (plus string regrowth)
+  for (auto &run : runs_) {
+    run.in.open(run.path, std::ios::binary);
+    run.has_row = read_row(run.in, run.head);
+  }
+}
+
+void SortOperator::remove_runs() {
+  for (auto &run : runs_) {
+    run.in.close();
+    std::error_code ec;
+    std::filesystem::remove(run.path, ec);
+  }
+  runs_.clear();
+}
+
+// TopNOperator implementation
+
+TopNOperator::TopNOperator(std::unique_ptr<Operator> child,
+                           std::vector<const sql::Expression *> keys,
+                           std::vector<int32_t> key_columns,
+                           std::vector<bool> ascending,
+                           const planner::Bindings &bindings, int64_t n)
+    : child_(std::move(child)),
+      compare_(std::move(keys), std::move(key_columns), std::move(ascending),
+               bindings),
+      n_(n > 0 ? static_cast<size_t>(n) : 0) {}
+
+void TopNOperator::open(ExecutionContext &ctx) {
+  child_->open(ctx);
+  heap_.emplace(ctx.memory_resource());
+  current_row_ = 0;
+  materialized_ = false;
+}
+
+bool TopNOperator::next(ExecutionContext &ctx, ResultRow &row) {
+  if (!materialized_) {
+    materialize(ctx);
+    materialized_ = true;
+  }
+
+  auto &rows = *heap_;
+  if (current_row_ < rows.size()) {
+    row = std::move(rows[current_row_]);
+    current_row_++;
+    return true;
+  }
+  return false;
+}
+
+void TopNOperator::materialize(ExecutionContext &ctx) {
+  // A max-heap of the n best rows so far: its root is the one to evict.
+  // Rows that lose to the root cost one comparison and no copy.
+  auto &rows = *heap_;
+  rows.reserve(std::min<size_t>(n_, 1024));
+  ResultRow temp(ctx.memory_resource());
+  while (n_ > 0 && child_->next(ctx, temp)) {
+    if (rows.size() < n_) {
+      rows.push_back(std::move(temp));
+      std::push_heap(rows.begin(), rows.end(), compare_);
+      ctx.check_budget();
+    } else if (compare_(temp, rows.front())) {
+      std::pop_heap(rows.begin(), rows.end(), compare_);
+      std::swap(rows.back(), temp);
+      std::push_heap(rows.begin(), rows.end(), compare_);
+    }
+    ctx.record_instructions(2);
+  }
+
+  std::sort_heap(rows.begin(), rows.end(), compare_);
+  ctx.record_instructions(static_cast<uint64_t>(rows.size()) * 10);
+}
+
+void TopNOperator::close() {
+  child_->close();
+  heap_.reset();
+}
+
+std::vector<std::string> TopNOperator::column_names() const {
+  return child_->column_names();
+}
+
+// Executor implementation
+
+namespace {
+
+// Pages ANALYZE reads from a table at most
+constexpr uint64_t ANALYZE_SAMPLE_PAGES = 256;
+
+// Evaluate a constant INSERT value: a literal, optionally negated
+bool constant_value(const sql::Expression &expr, sql::Literal &out) {
+  if (expr.type == sql::ExprType::LITERAL) {
+    out = expr.to_literal();
+    return true;
+  }
+
+  if (expr.type == sql::ExprType::UNARY_OP) {
+    if (expr.unary_op != sql::UnaryOp::MINUS ||
+        !constant_value(*expr.operand(), out)) {
+      return false;
+    }
+    if (out.type == sql::Literal::Type::INTEGER) {
+      out.int_value = -out.int_value;
+      return true;
+    }
+    if (out.type == sql::Literal::Type::FLOAT) {
+      out.float_value = -out.float_value;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Store a value into a record column, coercing INTEGER to FLOAT
+bool store_value(const sql::Literal &value, storage::ColumnType type,
+                 size_t index, storage::Record &record) {
+  using LT = sql::Literal::Type;
+
+  if (value.type == LT::NULL_VAL) {
+    record.set_null(index);
+    return true;
+  }
+
+  switch (type) {
+  case storage::ColumnType::INTEGER:
+    if (value.type != LT::INTEGER) {
+      return false;
+    }
+    record.set_integer(index, value.int_value);
+    return true;
+  case storage::ColumnType::FLOAT:
+    if (value.type == LT::INTEGER) {
+      record.set_float(index, static_cast<double>(value.int_value));
+      return true;
+    }
+    if (value.type != LT::FLOAT) {
+      return false;
+    }
+    record.set_float(index, value.float_value);
+    return true;
+  case storage::ColumnType::BOOLEAN:
+    if (value.type != LT::BOOLEAN) {
+      return false;
+    }
+    record.set_boolean(index, value.bool_value);
+    return true;
+  case storage::ColumnType::TEXT:
+    if (value.type != LT::STRING) {
+      return false;
+    }
+    record.set_text(index, std::string(value.string_value));
+    return true;
+  case storage::ColumnType::BLOB:
+    if (value.type != LT::STRING) {
+      return false;
+    }
+    record.set_blob(index, std::vector<uint8_t>(value.string_value.begin(),
+                                                value.string_value.end()));
+    return true;
+  case storage::ColumnType::NULLTYPE:
+    break;
+  }
+
+  return false;
+}
+
+} // anonymous namespace
 
 Executor::Executor(storage::PageManager &page_manager,
                    planner::Catalog &catalog)
@@ -232,17 +1177,23 @@ ExecutionResult Executor::execute(const planner::PlanNode &plan,
                                   ExecutionContext &ctx) {
   ctx.start();
 
-  ExecutionResult result;
+  ExecutionResult result(ctx.memory_resource());
   result.success = false;
 
   try {
     switch (plan.type) {
     case planner::PlanNodeType::TABLE_SCAN:
+    case planner::PlanNodeType::INDEX_SCAN:
+    case planner::PlanNodeType::EMPTY:
     case planner::PlanNodeType::FILTER:
     case planner::PlanNodeType::PROJECT:
     case planner::PlanNodeType::SORT:
     case planner::PlanNodeType::LIMIT:
     case planner::PlanNodeType::AGGREGATE:
+    case planner::PlanNodeType::METADATA_AGGREGATE:
+    case planner::PlanNodeType::HASH_JOIN:
+    case planner::PlanNodeType::INDEX_JOIN:
+    case planner::PlanNodeType::FETCH:
       result = execute_select(plan, ctx);
       break;
 
@@ -262,6 +1213,14 @@ ExecutionResult Executor::execute(const planner::PlanNode &plan,
       break;
     }
 
+    case planner::PlanNodeType::CREATE_VIEW: {
+      const auto *node = std::get_if<planner::CreateViewNode>(&plan.node);
+      if (node) {
+        result = execute_create_view(*node, ctx);
+      }
+      break;
+    }
+
     case planner::PlanNodeType::DROP_TABLE: {
       const auto *node = std::get_if<planner::DropTableNode>(&plan.node);
       if (node) {
@@ -270,10 +1229,28 @@ ExecutionResult Executor::execute(const planner::PlanNode &plan,
       break;
     }
 
+    case planner::PlanNodeType::ANALYZE: {
+      const auto *node = std::get_if<planner::AnalyzeNode>(&plan.node);
+      if (node) {
+        result = execute_analyze(*node, ctx);
+      }
+      break;
+    }
+
     default:
       result.error = "Unsupported plan type";
       break;
     }
+  } catch (const memory::MemoryBudgetExceeded &e) {
+    ctx.record_memory_exceeded();
+    result.success = false;
+    result.error = ctx.violation_message();
+  } catch (const std::bad_alloc &e) {
+    // An arena could not grow or no page frame could be freed: the
+    // global memory limit was reached
+    ctx.record_memory_exceeded();
+    result.success = false;
+    result.error = "Global memory limit reached";
   } catch (const std::exception &e) {
     result.success = false;
     result.error = e.what();
@@ -286,14 +1263,67 @@ ExecutionResult Executor::execute(const planner::PlanNode &plan,
 }
 
 std::unique_ptr<Operator>
-Executor::build_operator(const planner::PlanNode &plan) {
+Executor::build_operator(const planner::PlanNode &plan,
+                         const planner::Bindings &bindings,
+                         ExecutionContext &ctx) {
   switch (plan.type) {
   case planner::PlanNodeType::TABLE_SCAN: {
     const auto *node = std::get_if<planner::TableScanNode>(&plan.node);
     if (node) {
       const auto *schema = catalog_.get_table_by_id(node->table_id);
-      return std::make_unique<TableScanOperator>(
-          node->table_id, node->table_name, page_manager_, schema);
+      storage::SegmentManager *segments =
+          schema && schema->partitioning.enabled() ? &segment_manager()
+                                                   : nullptr;
+      auto scan = std::make_unique<TableScanOperator>(
+          node->table_id, node->table_name, page_manager_, schema,
+          node->column_indices, segments, node->time_lo, node->time_hi);
+      if (const sql::TableSample *sample = node->sample) {
+        // Without REPEATABLE each query draws a new sample
+        uint64_t seed = static_cast<uint64_t>(sample->seed);
+        if (!sample->repeatable) {
+          std::random_device device;
+          seed = static_cast<uint64_t>(device()) << 32 | device();
+        }
+        scan->sample(sample->method, sample->percent / 100.0, seed);
+      }
+      if (node->row_ids) {
+        scan->emit_row_ids();
+      }
+      return scan;
+    }
+    break;
+  }
+
+  case planner::PlanNodeType::INDEX_SCAN: {
+    const auto *node = std::get_if<planner::IndexScanNode>(&plan.node);
+    const auto *schema =
+        node ? catalog_.get_table_by_id(node->table_id) : nullptr;
+    if (schema) {
+      return std::make_unique<IndexScanOperator>(
+          node->table_id, node->table_name, page_manager_, schema,
+          node->column_indices,
+          primary_key_rows(*schema, node->key_lo, node->key_hi));
+    }
+    break;
+  }
+
+  case planner::PlanNodeType::FETCH: {
+    const auto *node = std::get_if<planner::FetchNode>(&plan.node);
+    const auto *schema =
+        node ? catalog_.get_table_by_id(node->table_id) : nullptr;
+    if (schema && node->child) {
+      auto child = build_operator(*node->child, bindings, ctx);
+      return std::make_unique<FetchOperator>(std::move(child), node->table_id,
+                                             node->table_name, page_manager_,
+                                             schema, node->column_indices);
+    }
+    break;
+  }
+
+  case planner::PlanNodeType::EMPTY: {
+    const auto *node = std::get_if<planner::EmptyNode>(&plan.node);
+    if (node) {
+      return std::make_unique<EmptyOperator>(node->column_names);
     }
     break;
   }
@@ -301,9 +1331,9 @@ Executor::build_operator(const planner::PlanNode &plan) {
   case planner::PlanNodeType::FILTER: {
     const auto *node = std::get_if<planner::FilterNode>(&plan.node);
     if (node && node->child) {
-      auto child = build_operator(*node->child);
+      auto child = build_operator(*node->child, bindings, ctx);
       return std::make_unique<FilterOperator>(std::move(child),
-                                              node->predicate.get());
+                                              node->predicate, bindings);
     }
     break;
   }
@@ -311,7 +1341,7 @@ Executor::build_operator(const planner::PlanNode &plan) {
   case planner::PlanNodeType::LIMIT: {
     const auto *node = std::get_if<planner::LimitNode>(&plan.node);
     if (node && node->child) {
-      auto child = build_operator(*node->child);
+      auto child = build_operator(*node->child, bindings, ctx);
       return std::make_unique<LimitOperator>(std::move(child), node->limit,
                                              node->offset);
     }
@@ -321,16 +1351,86 @@ Executor::build_operator(const planner::PlanNode &plan) {
   case planner::PlanNodeType::SORT: {
     const auto *node = std::get_if<planner::SortNode>(&plan.node);
     if (node && node->child) {
-      auto child = build_operator(*node->child);
-      // Extract sort columns (simplified)
-      std::vector<size_t> cols;
-      std::vector<bool> asc;
-      for (size_t i = 0; i < node->ascending.size(); ++i) {
-        cols.push_back(i);
-        asc.push_back(node->ascending[i]);
+      auto child = build_operator(*node->child, bindings, ctx);
+      if (node->top_n >= 0) {
+        return std::make_unique<TopNOperator>(
+            std::move(child), node->sort_keys, node->key_columns,
+            node->ascending, bindings, node->top_n);
+      }
+      return std::make_unique<SortOperator>(
+          std::move(child), node->sort_keys, node->key_columns,
+          node->ascending, bindings, page_manager_.data_dir() + "/spill");
+    }
+    break;
+  }
+
+  case planner::PlanNodeType::AGGREGATE: {
+    const auto *node = std::get_if<planner::AggregateNode>(&plan.node);
+    if (node && node->child) {
+      auto child = build_operator(*node->child, bindings, ctx);
+      if (node->strategy == planner::AggregateStrategy::SORT) {
+        return std::make_unique<SortAggregateOperator>(
+            std::move(child), node->group_by, node->aggregates, bindings);
       }
-      return std::make_unique<SortOperator>(std::move(child), std::move(cols),
-                                            std::move(asc));
+      return std::make_unique<HashAggregateOperator>(
+          std::move(child), node->group_by, node->aggregates, bindings);
+    }
+    break;
+  }
+
+  case planner::PlanNodeType::METADATA_AGGREGATE: {
+    const auto *node =
+        std::get_if<planner::MetadataAggregateNode>(&plan.node);
+    const auto *schema =
+        node ? catalog_.get_table_by_id(node->table_id) : nullptr;
+    if (schema) {
+      return std::make_unique<MetadataAggregateOperator>(
+          node->aggregates, bindings, schema, table_summary(*schema));
+    }
+    break;
+  }
+
+  case planner::PlanNodeType::HASH_JOIN: {
+    const auto *node = std::get_if<planner::HashJoinNode>(&plan.node);
+    if (node && node->left && node->right) {
+      auto left = build_operator(*node->left, bindings, ctx);
+      auto right = build_operator(*node->right, bindings, ctx);
+      return std::make_unique<HashJoinOperator>(
+          std::move(left), std::move(right), node->join_type,
+          node->left_keys, node->right_keys, node->residual, bindings,
+          node->left_width, node->right_width, node->build_left,
+          page_manager_.data_dir() + "/spill");
+    }
+    break;
+  }
+
+  case planner::PlanNodeType::INDEX_JOIN: {
+    const auto *node = std::get_if<planner::IndexJoinNode>(&plan.node);
+    const auto *schema =
+        node ? catalog_.get_table_by_id(node->table_id) : nullptr;
+    if (schema && node->left) {
+      auto left = build_operator(*node->left, bindings, ctx);
+      auto lookup = [this, schema](const std::vector<int64_t> &keys,
+                                   std::vector<PrimaryKeyIndex::Match> &out) {
+        primary_key_lookup(*schema, keys, out);
+      };
+      return std::make_unique<IndexJoinOperator>(
+          std::move(left), node->table_id, node->table_name, page_manager_,
+          schema, node->column_indices, std::move(lookup), node->join_type,
+          node->left_keys, node->right_keys, node->probe_key,
+          node->inner_filter, node->residual, bindings, node->left_width,
+          node->right_width, node->batch_size);
+    }
+    break;
+  }
+
+  case planner::PlanNodeType::PROJECT: {
+    const auto *node = std::get_if<planner::ProjectNode>(&plan.node);
+    if (node && node->child) {
+      auto child = build_operator(*node->child, bindings, ctx);
+      return std::make_unique<ProjectOperator>(
+          std::move(child), node->expressions, node->columns,
+          node->output_names, bindings);
     }
     break;
   }
@@ -344,9 +1444,10 @@ Executor::build_operator(const planner::PlanNode &plan) {
 
 ExecutionResult Executor::execute_select(const planner::PlanNode &plan,
                                          ExecutionContext &ctx) {
-  ExecutionResult result;
+  ExecutionResult result(ctx.memory_resource());
 
-  auto op = build_operator(plan);
+  static const planner::Bindings unbound;
+  auto op = build_operator(plan, plan.bindings ? *plan.bindings : unbound, ctx);
   if (!op) {
     result.error = "Failed to build operator tree";
     return result;
@@ -355,7 +1456,7 @@ ExecutionResult Executor::execute_select(const planner::PlanNode &plan,
   op->open(ctx);
   result.column_names = op->column_names();
 
-  ResultRow row;
+  ResultRow row(ctx.memory_resource());
   while (op->next(ctx, row)) {
     result.rows.push_back(std::move(row));
     ctx.check_budget();
@@ -368,7 +1469,7 @@ ExecutionResult Executor::execute_select(const planner::PlanNode &plan,
 
 ExecutionResult Executor::execute_insert(const planner::InsertNode &node,
                                          ExecutionContext &ctx) {
-  ExecutionResult result;
+  ExecutionResult result(ctx.memory_resource());
 
   // Get table schema
   const auto *table = catalog_.get_table(node.table_name);
@@ -377,18 +1478,308 @@ ExecutionResult Executor::execute_insert(const planner::InsertNode &node,
     return result;
   }
 
-  // Insert rows (simplified - just count them)
-  result.rows_affected = node.values.size();
-  ctx.record_instructions(static_cast<uint64_t>(node.values.size()) * 20);
+  // Map each value position to its table column
+  std::vector<uint32_t> targets;
+  if (node.column_names.empty()) {
+    for (uint32_t i = 0; i < table->columns.size(); ++i) {
+      targets.push_back(i);
+    }
+  } else {
+    for (const auto &name : node.column_names) {
+      int index = table->find_column(name);
+      if (index < 0) {
+        result.error = "Column not found: " + name;
+        return result;
+      }
+      targets.push_back(static_cast<uint32_t>(index));
+    }
+  }
+
+  std::vector<storage::ColumnType> types;
+  for (const auto &col : table->columns) {
+    types.push_back(col.type);
+  }
 
-  result.success = true;
+  // The table's materialized views fold the rows as they are stored,
+  // then take them in one write per group changed
+  std::vector<ViewDelta> deltas;
+  deltas.reserve(node.views.size());
+  for (const auto &view : node.views) {
+    const auto *view_table = catalog_.get_table_by_id(view.table_id);
+    if (!view_table) {
+      result.error = "Materialized view not found: " + view.table_name;
+      return result;
+    }
+    deltas.push_back(view_delta(view, *view_table));
+  }
+
+  // A failing row ends the statement; the rows before it stay stored
+  std::mutex &table_lock = write_lock(table->id);
+  std::vector<uint8_t> buffer(storage::PAGE_SIZE);
+  for (const sql::ExprList &values : node.values) {
+    if (values.size() != targets.size()) {
+      result.error = "Value count mismatch";
+      break;
+    }
+
+    storage::Record record(table->columns.size());
+    for (size_t i = 0; i < values.size() && result.error.empty(); ++i) {
+      const planner::ColumnInfo &col = table->columns[targets[i]];
+      sql::Literal value;
+      if (!constant_value(*values[i], value)) {
+        result.error = "Unsupported value for column: " + col.name;
+      } else if (!store_value(value, col.type, targets[i], record)) {
+        result.error = "Type mismatch for column: " + col.name;
+      }
+    }
+
+    for (const auto &col : table->columns) {
+      if (result.error.empty() && (col.not_null || col.primary_key) &&
+          record.is_null(col.index)) {
+        result.error = "NULL value in NOT NULL column: " + col.name;
+      }
+    }
+
+    // Every view evaluates the row before any takes it
+    try {
+      for (ViewDelta &delta : deltas) {
+        if (result.error.empty()) {
+          delta.prepare(record);
+        }
+      }
+    } catch (const std::runtime_error &e) {
+      result.error = e.what();
+    }
+    if (!result.error.empty()) {
+      break;
+    }
+
+    // Held over the append: a summary built meanwhile reads the table
+    // under the same lock, so it counts the row exactly once
+    std::unique_lock<std::mutex> appends(table_lock);
+    bool stored;
+    storage::RowId row = storage::RowId::invalid();
+    uint32_t segment_id = UINT32_MAX;
+    if (table->partitioning.enabled()) {
+      const auto &col = table->columns[table->partitioning.column];
+      if (record.is_null(col.index)) {
+        result.error = "NULL value in partition column: " + col.name;
+        break;
+      }
+      if (segment_manager().is_expired(table->id,
+                                       record.get_integer(col.index))) {
+        result.error = "Row is older than the retention window: " + col.name;
+        break;
+      }
+      stored = append_partitioned(*table, types, record, buffer, segment_id);
+    } else if (table->layout == storage::PageLayout::PAX) {
+      stored = append_pax(table->id, types, record, row);
+    } else {
+      stored = append_row(table->id, record, buffer, row);
+    }
+    if (!stored) {
+      result.error = "Row does not fit in a page";
+      break;
+    }
+    summarize_row(*table, record, segment_id);
+    appends.unlock();
+
+    if (row.is_valid()) {
+      index_row(*table, record, row);
+    }
+    for (ViewDelta &delta : deltas) {
+      delta.apply();
+    }
+
+    result.rows_affected++;
+    ctx.record_instructions(20);
+  }
+
+  if (!deltas.empty()) {
+    try {
+      write_views(deltas);
+    } catch (const std::runtime_error &e) {
+      if (result.error.empty()) {
+        result.error = e.what();
+      }
+    }
+  }
+
+  catalog_.update_row_count(table->id,
+                            table->row_count + result.rows_affected);
+  bump_version(table->id);
+
+  result.success = result.error.empty();
   return result;
 }
 
+bool Executor::append_row(uint32_t table_id, const storage::Record &record,
+                          std::vector<uint8_t> &buffer, storage::RowId &row) {
+  size_t length = record.serialize(buffer.data(), buffer.size());
+  if (length == 0) {
+    return false;
+  }
+
+  uint32_t page_count = page_manager_.table_page_count(table_id);
+  uint16_t slot;
+  if (page_count > 0) {
+    uint32_t page_id = page_count - 1;
+    storage::PageGuard page =
+        pin_table_page(page_manager_, table_id, page_id);
+    std::unique_lock<std::shared_mutex> latch;
+    if (page) {
+      latch = std::unique_lock<std::shared_mutex>(page.latch());
+    }
+    if (page && !page->header().is_pax() &&
+        page->insert_record(buffer.data(), static_cast<uint16_t>(length),
+                            &slot)) {
+      latch.unlock();
+      page_manager_.mark_dirty(table_id, page_id);
+      row = storage::RowId{page_id, slot};
+      return true;
+    }
+  }
+
+  uint32_t page_id = page_manager_.allocate_page(table_id);
+  if (page_id == UINT32_MAX) {
+    throw std::bad_alloc(); // No frame for the new page
+  }
+  storage::PageGuard page = pin_table_page(page_manager_, table_id, page_id);
+  if (!page) {
+    return false;
+  }
+  {
+    std::unique_lock<std::shared_mutex> latch(page.latch());
+    if (!page->insert_record(buffer.data(), static_cast<uint16_t>(length),
+                             &slot)) {
+      return false;
+    }
+  }
+  page_manager_.mark_dirty(table_id, page_id);
+  row = storage::RowId{page_id, slot};
+  return true;
+}
+
+bool Executor::append_pax(uint32_t table_id,
+                          const std::vector<storage::ColumnType> &types,
+                          const storage::Record &record,
+                          storage::RowId &row) {
+  uint32_t page_count = page_manager_.table_page_count(table_id);
+  if (page_count > 0) {
+    uint32_t page_id = page_count - 1;
+    storage::PageGuard page =
+        pin_table_page(page_manager_, table_id, page_id);
+    std::unique_lock<std::shared_mutex> latch;
+    if (page) {
+      latch = std::unique_lock<std::shared_mutex>(page.latch());
+    }
+    if (page && storage::PaxPage::is_pax(*page) &&
+        storage::PaxPage::append(*page, record)) {
+      uint16_t slot =
+          static_cast<uint16_t>(storage::PaxPage(*page).row_count() - 1);
+      latch.unlock();
+      page_manager_.mark_dirty(table_id, page_id);
+      row = storage::RowId{page_id, slot};
+      return true;
+    }
+  }
+
+  uint32_t page_id = page_manager_.allocate_page(table_id);
+  if (page_id == UINT32_MAX) {
+    throw std::bad_alloc(); // No frame for the new page
+  }
+  storage::PageGuard page = pin_table_page(page_manager_, table_id, page_id);
+  if (!page) {
+    return false;
+  }
+  {
+    std::unique_lock<std::shared_mutex> latch(page.latch());
+    if (!storage::PaxPage::init(*page, page_id, types) ||
+        !storage::PaxPage::append(*page, record)) {
+      return false;
+    }
+  }
+  page_manager_.mark_dirty(table_id, page_id);
+  row = storage::RowId{page_id, 0};
+  return true;
+}
+
+bool Executor::append_partitioned(
+    const planner::TableInfo &table,
+    const std::vector<storage::ColumnType> &types,
+    const storage::Record &record, std::vector<uint8_t> &buffer,
+    uint32_t &segment_id) {
+  int64_t time = record.get_integer(table.partitioning.column);
+  storage::Segment *segment =
+      segment_manager().segment_for_time(table.id, time);
+  if (!segment) {
+    return false;
+  }
+  segment_id = segment->segment_id();
+
+  bool pax = table.layout == storage::PageLayout::PAX;
+  size_t length = 0;
+  if (!pax) {
+    length = record.serialize(buffer.data(), buffer.size());
+    if (length == 0) {
+      return false;
+    }
+  }
+  auto insert = [&](storage::Page &page) {
+    uint16_t slot;
+    return pax ? storage::PaxPage::append(page, record)
+               : page.insert_record(buffer.data(),
+                                    static_cast<uint16_t>(length), &slot);
+  };
+
+  // The range is widened first so it is written with the page
+  segment->extend_time_range(time);
+
+  // Rows go into the segment's buffered last page; the page is written
+  // once full, when the next one is appended
+  if (segment->append_to_tail(insert)) {
+    return true;
+  }
+
+  storage::Page page;
+  uint32_t page_count = segment->page_count();
+  if (pax) {
+    if (!storage::PaxPage::init(page, page_count, types)) {
+      return false;
+    }
+  } else {
+    page.init(page_count);
+  }
+  return insert(page) && segment->append_page(&page) != UINT32_MAX;
+}
+
+std::mutex &Executor::write_lock(uint32_t table_id) {
+  std::lock_guard<std::mutex> lock(write_locks_mutex_);
+  auto &slot = write_locks_[table_id];
+  if (!slot) {
+    slot = std::make_unique<std::mutex>();
+  }
+  return *slot;
+}
+
+storage::SegmentManager &Executor::segment_manager() {
+  std::call_once(segments_once_, [this]() {
+    segments_ = std::make_unique<storage::SegmentManager>(
+        page_manager_.data_dir() + "/segments");
+    if (!segments_->init()) {
+      std::cerr << "Failed to open segment storage\n";
+    }
+
+    // Expires partitions past their retention and merges small segments
+    segments_->start_compactor();
+  });
+  return *segments_;
+}
+
 ExecutionResult
 Executor::execute_create_table(const planner::CreateTableNode &node,
                                ExecutionContext &ctx) {
-  ExecutionResult result;
+  ExecutionResult result(ctx.memory_resource());
 
   // Check if table exists
   if (!node.if_not_exists && catalog_.table_exists(node.table_name)) {
@@ -400,7 +1791,7 @@ Executor::execute_create_table(const planner::CreateTableNode &node,
   std::vector<planner::ColumnInfo> columns;
   for (const auto &col : node.columns) {
     planner::ColumnInfo info;
-    info.name = col.name;
+    info.name = std::string(col.name);
     info.not_null = col.not_null;
     info.primary_key = col.primary_key;
 
@@ -422,20 +1813,223 @@ Executor::execute_create_table(const planner::CreateTableNode &node,
     columns.push_back(info);
   }
 
-  uint32_t table_id = catalog_.create_table(node.table_name, columns);
+  uint32_t table_id = catalog_.create_table(node.table_name, columns,
+                                            node.layout, node.partitioning);
   if (table_id == 0 && !node.if_not_exists) {
     result.error = "Failed to create table";
     return result;
   }
 
+  // Time-partitioned tables live in segments rather than a table file
+  if (table_id != 0 &&
+      !(node.partitioning.enabled()
+            ? segment_manager().create_table(table_id, node.partitioning)
+            : page_manager_.create_table_file(table_id))) {
+    catalog_.drop_table(node.table_name);
+    result.error = "Failed to create table file";
+    return result;
+  }
+  if (table_id != 0) {
+    bump_version(table_id);
+  }
+
   ctx.record_instructions(100);
   result.success = true;
   return result;
 }
 
+ExecutionResult
+Executor::execute_create_view(const planner::CreateViewNode &node,
+                              ExecutionContext &ctx) {
+  ExecutionResult result(ctx.memory_resource());
+
+  std::vector<planner::ColumnInfo> columns;
+  for (size_t i = 0; i < node.column_names.size(); ++i) {
+    planner::ColumnInfo info;
+    info.name = node.column_names[i];
+    info.type = node.column_types[i];
+    info.index = static_cast<uint32_t>(i);
+    columns.push_back(info);
+  }
+
+  const auto *base = catalog_.get_table_by_id(node.base_table_id);
+  if (!base) {
+    result.error = "Table not found for view: " + node.view_name;
+    return result;
+  }
+  uint32_t view_id = catalog_.create_view(node.view_name, columns,
+                                          node.base_table_id, node.query);
+  if (view_id == 0) {
+    result.error = "Table already exists: " + node.view_name;
+    return result;
+  }
+  if (!page_manager_.create_table_file(view_id)) {
+    catalog_.drop_table(node.view_name);
+    result.error = "Failed to create table file";
+    return result;
+  }
+
+  // Populate the view from the rows the table holds now
+  planner::MaterializedView view = node.view;
+  view.table_id = view_id;
+  std::vector<ViewDelta> deltas;
+  deltas.push_back(view_delta(view, *catalog_.get_table_by_id(view_id)));
+  try {
+    storage::SegmentManager *segments =
+        base->partitioning.enabled() ? &segment_manager() : nullptr;
+    TableScanOperator scan(base->id, base->name, page_manager_, base, {},
+                           segments);
+    scan.open(ctx);
+    ResultRow row(ctx.memory_resource());
+    while (scan.next(ctx, row)) {
+      deltas.front().prepare(row);
+      deltas.front().apply();
+      ctx.record_instructions(10);
+      ctx.check_budget();
+    }
+    scan.close();
+    write_views(deltas);
+  } catch (...) {
+    page_manager_.delete_table_file(view_id);
+    catalog_.drop_table(node.view_name);
+    std::lock_guard<std::mutex> lock(view_mutex_);
+    view_rows_.erase(view_id);
+    throw;
+  }
+
+  bump_version(view_id);
+  result.rows_affected = deltas.front().groups().size();
+  result.success = true;
+  return result;
+}
+
+ViewDelta Executor::view_delta(const planner::MaterializedView &view,
+                               const planner::TableInfo &view_table) {
+  // The lookup reads a group's stored row when the delta first reaches it
+  size_t keys = view.keys.size();
+  auto lookup = [this, table_id = view_table.id,
+                 keys](const std::string &key, storage::Record &out) {
+    std::lock_guard<std::mutex> lock(view_mutex_);
+    const auto &rows = view_rows(table_id, keys);
+    auto found = rows.find(key);
+    if (found == rows.end()) {
+      return false;
+    }
+    storage::PageGuard page =
+        pin_table_page(page_manager_, table_id, found->second.page_id);
+    if (!page) {
+      return false;
+    }
+    std::shared_lock<std::shared_mutex> latch(page.latch());
+    const uint8_t *data = nullptr;
+    uint16_t length = 0;
+    return page->get_record(found->second.slot_id, &data, &length) &&
+           out.deserialize(data, length);
+  };
+  return ViewDelta(view, view_table, std::move(lookup));
+}
+
+std::unordered_map<std::string, storage::RowId> &
+Executor::view_rows(uint32_t table_id, size_t keys) {
+  auto [entry, added] = view_rows_.try_emplace(table_id);
+  if (added) {
+    // Deleted slots hold no record
+    storage::Record record;
+    uint32_t page_count = page_manager_.table_page_count(table_id);
+    for (uint32_t page_id = 0; page_id < page_count; ++page_id) {
+      storage::PageGuard page =
+          pin_table_page(page_manager_, table_id, page_id);
+      if (!page) {
+        continue;
+      }
+      std::shared_lock<std::shared_mutex> latch(page.latch());
+      for (uint16_t slot = 0; slot < page->slot_count(); ++slot) {
+        const uint8_t *data = nullptr;
+        uint16_t length = 0;
+        if (page->get_record(slot, &data, &length) &&
+            record.deserialize(data, length)) {
+          entry->second[ViewDelta::group_key(record, keys)] =
+              storage::RowId{page_id, slot};
+        }
+      }
+    }
+  }
+  return entry->second;
+}
+
+void Executor::write_views(const std::vector<ViewDelta> &deltas) {
+  std::lock_guard<std::mutex> lock(view_mutex_);
+
+  // A group's row is rewritten in place when it still fits, else moved
+  std::vector<uint8_t> buffer(storage::PAGE_SIZE);
+  for (const ViewDelta &delta : deltas) {
+    uint32_t table_id = delta.view().table_id;
+    auto &rows = view_rows(table_id, delta.view().keys.size());
+    for (const auto &[key, record] : delta.groups()) {
+      auto found = rows.find(key);
+      if (found != rows.end()) {
+        storage::RowId row = found->second;
+        size_t length = record.serialize(buffer.data(), buffer.size());
+        storage::PageGuard page =
+            pin_table_page(page_manager_, table_id, row.page_id);
+        if (!page) {
+          throw std::runtime_error("Failed to read view page: " +
+                                   delta.view().table_name);
+        }
+        bool updated;
+        {
+          std::unique_lock<std::shared_mutex> latch(page.latch());
+          updated = length > 0 &&
+                    page->update_record(row.slot_id, buffer.data(),
+                                        static_cast<uint16_t>(length));
+          if (!updated) {
+            page->delete_record(row.slot_id);
+          }
+        }
+        page_manager_.mark_dirty(table_id, row.page_id);
+        if (updated) {
+          continue;
+        }
+        rows.erase(found);
+      }
+
+      storage::RowId row = storage::RowId::invalid();
+      if (!append_row(table_id, record, buffer, row)) {
+        throw std::runtime_error("View row does not fit in a page: " +
+                                 delta.view().table_name);
+      }
+      rows.emplace(key, row);
+    }
+
+    // Rows changed in place, so the view's summary is built again
+    {
+      std::lock_guard<std::mutex> summary_lock(summary_mutex_);
+      table_summaries_.erase(table_id);
+    }
+    catalog_.update_row_count(table_id, rows.size());
+    bump_version(table_id);
+  }
+}
+
+std::optional<uint64_t> Executor::table_version(uint32_t table_id) const {
+  // Retention drops segments in the background, without a statement
+  const auto *table = catalog_.get_table_by_id(table_id);
+  if (!table || table->partitioning.retention > 0) {
+    return std::nullopt;
+  }
+  std::lock_guard<std::mutex> lock(version_mutex_);
+  auto found = table_versions_.find(table_id);
+  return found == table_versions_.end() ? 0 : found->second;
+}
+
+void Executor::bump_version(uint32_t table_id) {
+  std::lock_guard<std::mutex> lock(version_mutex_);
+  table_versions_[table_id] = ++version_clock_;
+}
+
 ExecutionResult Executor::execute_drop_table(const planner::DropTableNode &node,
                                              ExecutionContext &ctx) {
-  ExecutionResult result;
+  ExecutionResult result(ctx.memory_resource());
 
   if (!catalog_.table_exists(node.table_name)) {
     if (!node.if_exists) {
@@ -443,7 +2037,31 @@ ExecutionResult Executor::execute_drop_table(const planner::DropTableNode &node,
       return result;
     }
   } else {
+    const auto *table = catalog_.get_table(node.table_name);
+    uint32_t table_id = table->id;
+    bool partitioned = table->partitioning.enabled();
     catalog_.drop_table(node.table_name);
+    {
+      std::lock_guard<std::mutex> lock(pk_mutex_);
+      pk_indexes_.erase(table_id);
+    }
+    {
+      std::lock_guard<std::mutex> lock(summary_mutex_);
+      table_summaries_.erase(table_id);
+      std::erase_if(segment_summaries_, [&](const auto &entry) {
+        return entry.first >> 32 == table_id;
+      });
+    }
+    {
+      std::lock_guard<std::mutex> lock(view_mutex_);
+      view_rows_.erase(table_id);
+    }
+    if (partitioned) {
+      segment_manager().drop_table(table_id);
+    } else {
+      page_manager_.delete_table_file(table_id);
+    }
+    bump_version(table_id);
   }
 
   ctx.record_instructions(50);
@@ -451,5 +2069,176 @@ ExecutionResult Executor::execute_drop_table(const planner::DropTableNode &node,
   return result;
 }
 
+ExecutionResult Executor::execute_analyze(const planner::AnalyzeNode &node,
+                                          ExecutionContext &ctx) {
+  ExecutionResult result(ctx.memory_resource());
+
+  for (uint32_t table_id : node.table_ids) {
+    const auto *table = catalog_.get_table_by_id(table_id);
+    if (!table) {
+      continue; // Dropped since planning
+    }
+
+    // Large tables are sampled: every stride-th page, so the sample is
+    // spread over the table and the same pages are read every time
+    uint64_t page_count = 0;
+    storage::SegmentManager *segments = nullptr;
+    if (table->partitioning.enabled()) {
+      segments = &segment_manager();
+      auto snapshot = segments->snapshot(table_id);
+      for (const storage::Segment *segment : snapshot.segments()) {
+        page_count += segment->page_count();
+      }
+    } else {
+      page_count = page_manager_.table_page_count(table_id);
+    }
+    uint64_t stride =
+        (page_count + ANALYZE_SAMPLE_PAGES - 1) / ANALYZE_SAMPLE_PAGES;
+
+    TableScanOperator scan(table_id, table->name, page_manager_, table, {},
+                           segments);
+    scan.sample_pages(static_cast<uint32_t>(std::max<uint64_t>(stride, 1)));
+    scan.open(ctx);
+
+    planner::StatsCollector collector(table->columns.size());
+    ResultRow row(ctx.memory_resource());
+    while (scan.next(ctx, row)) {
+      for (size_t i = 0; i < row.values.size(); ++i) {
+        collector.add(i, row.values[i]);
+      }
+      collector.add_row();
+      ctx.check_budget();
+    }
+    uint64_t pages_read = scan.pages_read();
+    scan.close();
+
+    catalog_.update_statistics(table_id,
+                               collector.finish(pages_read, page_count));
+    result.rows_affected++;
+  }
+
+  result.success = true;
+  return result;
+}
+
+std::vector<storage::RowId>
+Executor::primary_key_rows(const planner::TableInfo &table, int64_t lo,
+                           int64_t hi) {
+  std::lock_guard<std::mutex> lock(pk_mutex_);
+  return primary_key_index(table).lookup(lo, hi);
+}
+
+void Executor::primary_key_lookup(
+    const planner::TableInfo &table, const std::vector<int64_t> &keys,
+    std::vector<PrimaryKeyIndex::Match> &out) {
+  std::lock_guard<std::mutex> lock(pk_mutex_);
+  primary_key_index(table).lookup_sorted(keys, out);
+}
+
+PrimaryKeyIndex &
+Executor::primary_key_index(const planner::TableInfo &table) {
+  auto it = pk_indexes_.find(table.id);
+  if (it == pk_indexes_.end()) {
+    uint32_t column = static_cast<uint32_t>(table.primary_key_column());
+    it = pk_indexes_
+             .emplace(table.id,
+                      PrimaryKeyIndex::build(page_manager_, table.id, column))
+             .first;
+  }
+  return it->second;
+}
+
+void Executor::index_row(const planner::TableInfo &table,
+                         const storage::Record &record, storage::RowId row) {
+  int column = table.primary_key_column();
+  if (column < 0) {
+    return;
+  }
+
+  // Tables whose index is not built yet pick the row up when it is
+  std::lock_guard<std::mutex> lock(pk_mutex_);
+  auto it = pk_indexes_.find(table.id);
+  if (it != pk_indexes_.end()) {
+    it->second.insert(record.get_integer(column), row);
+  }
+}
+
+TableSummary Executor::table_summary(const planner::TableInfo &table) {
+  std::lock_guard<std::mutex> appends(write_lock(table.id));
+  std::lock_guard<std::mutex> lock(summary_mutex_);
+  size_t width = table.columns.size();
+  storage::Record record;
+
+  if (!table.partitioning.enabled()) {
+    auto it = table_summaries_.find(table.id);
+    if (it == table_summaries_.end()) {
+      TableSummary summary(width);
+      uint32_t page_count = page_manager_.table_page_count(table.id);
+      for (uint32_t page_id = 0; page_id < page_count; ++page_id) {
+        storage::PageGuard page =
+            pin_table_page(page_manager_, table.id, page_id);
+        if (page) {
+          std::shared_lock<std::shared_mutex> latch(page.latch());
+          summary.add_page(*page, record);
+        }
+      }
+      it = table_summaries_.emplace(table.id, std::move(summary)).first;
+    }
+    return it->second;
+  }
+
+  // Only segments not seen before are read. Those dropped by retention or
+  // replaced by compaction are no longer in the snapshot and are
+  // forgotten.
+  auto snapshot = segment_manager().snapshot(table.id);
+  TableSummary total(width);
+  std::vector<uint64_t> live;
+  std::unique_ptr<storage::Page> scratch;
+  for (storage::Segment *segment : snapshot.segments()) {
+    uint64_t key = uint64_t{table.id} << 32 | segment->segment_id();
+    auto it = segment_summaries_.find(key);
+    if (it == segment_summaries_.end()) {
+      TableSummary summary(width);
+      if (!scratch) {
+        scratch = std::make_unique<storage::Page>();
+      }
+      for (uint32_t i = 0; i < segment->page_count(); ++i) {
+        const storage::Page *page = segment->scan_page(i, *scratch);
+        if (page && page->header().is_valid()) {
+          summary.add_page(*page, record);
+        }
+      }
+      it = segment_summaries_.emplace(key, std::move(summary)).first;
+    }
+    total.merge(it->second);
+    live.push_back(key);
+  }
+  std::erase_if(segment_summaries_, [&](const auto &entry) {
+    return entry.first >> 32 == table.id &&
+           std::find(live.begin(), live.end(), entry.first) == live.end();
+  });
+  return total;
+}
+
+void Executor::summarize_row(const planner::TableInfo &table,
+                             const storage::Record &record,
+                             uint32_t segment_id) {
+  // Summaries not built yet pick the row up when they are; the caller
+  // holds the table's write lock
+  std::lock_guard<std::mutex> lock(summary_mutex_);
+  if (table.partitioning.enabled()) {
+    auto it =
+        segment_summaries_.find(uint64_t{table.id} << 32 | segment_id);
+    if (it != segment_summaries_.end()) {
+      it->second.add(record);
+    }
+    return;
+  }
+  auto it = table_summaries_.find(table.id);
+  if (it != table_summaries_.end()) {
+    it->second.add(record);
+  }
+}
+
 } // namespace executor
 } // namespace edgesql
@@ -5,23 +5,55 @@
  * @brief Pull-based query executor
  */
 
+#include "../memory/slab_allocator.hpp"
 #include "../planner/catalog.hpp"
 #include "../planner/plan.hpp"
 #include "../sql/ast.hpp"
 #include "../storage/page_manager.hpp"
+#include "../storage/segment.hpp"
 #include "context.hpp"
+#include "pk_index.hpp"
+#include "table_summary.hpp"
+#include <algorithm>
+#include <fstream>
 #include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
 namespace edgesql {
 namespace executor {
 
+class ViewDelta;
+
 /**
  * @brief Result row (column values)
+ *
+ * Allocator-aware so rows stored in a pmr container draw their values
+ * (and the strings inside them) from the same query arena.
  */
 struct ResultRow {
-  std::vector<sql::Literal> values;
+  using allocator_type = std::pmr::polymorphic_allocator<sql::Literal>;
+
+  std::pmr::vector<sql::Literal> values;
+
+  ResultRow() = default;
+  explicit ResultRow(const allocator_type &alloc) : values(alloc) {}
+  ResultRow(const ResultRow &other) = default;
+  ResultRow(ResultRow &&other) noexcept = default;
+  ResultRow(const ResultRow &other, const allocator_type &alloc)
+      : values(other.values, alloc) {}
+  ResultRow(ResultRow &&other, const allocator_type &alloc)
+      : values(std::move(other.values), alloc) {}
+
+  ResultRow &operator=(const ResultRow &other) = default;
+  // Not noexcept: values on another resource are copied, not stolen
+  ResultRow &operator=(ResultRow &&other) = default;
 };
 
 /**
@@ -31,15 +63,33 @@ struct ExecutionResult {
   bool success{false};
   std::string error;
   std::vector<std::string> column_names;
-  std::vector<ResultRow> rows;
+  std::pmr::vector<ResultRow> rows;
   uint64_t rows_affected{0};
   ExecutionStats stats;
+
+  ExecutionResult() = default;
+  explicit ExecutionResult(std::pmr::memory_resource *resource)
+      : rows(resource) {}
 };
 
+/**
+ * @brief Pin a table page for reading or appending
+ *
+ * A page the buffer pool has no frame for fails the query as a memory
+ * violation instead of reading as the end of the table.
+ *
+ * @return Guard holding the page, empty if the page does not exist
+ * @throws std::bad_alloc if no frame could be had
+ */
+storage::PageGuard pin_table_page(storage::PageManager &page_manager,
+                                  uint32_t table_id, uint32_t page_id);
+
 /**
  * @brief Base operator interface (pull-based)
+ *
+ * Operators are created per query, so they come from the slab allocator.
  */
-class Operator {
+class Operator : public memory::SlabAllocated {
 public:
   virtual ~Operator() = default;
 
@@ -67,47 +117,271 @@ public:
 
 /**
  * @brief Table scan operator
+ *
+ * Rows keep the table's column order. Only the requested columns are
+ * decoded; the rest are left NULL, so on PAX pages the minipages of
+ * unrequested columns are never touched.
+ *
+ * Time-partitioned tables are read from their segments instead of the
+ * table file. Segments outside the time range are skipped whole, and
+ * rows outside it are dropped.
  */
 class TableScanOperator : public Operator {
 public:
+  /**
+   * @param column_indices Columns to decode, ascending (empty = all)
+   * @param segments Segment storage, for time-partitioned tables
+   * @param time_lo Lowest partition column value to return
+   * @param time_hi Highest partition column value to return
+   */
   TableScanOperator(uint32_t table_id, const std::string &table_name,
                     storage::PageManager &page_manager,
-                    const planner::TableInfo *schema);
+                    const planner::TableInfo *schema,
+                    std::vector<uint32_t> column_indices = {},
+                    storage::SegmentManager *segments = nullptr,
+                    int64_t time_lo = INT64_MIN,
+                    int64_t time_hi = INT64_MAX);
 
   void open(ExecutionContext &ctx) override;
   bool next(ExecutionContext &ctx, ResultRow &row) override;
   void close() override;
   std::vector<std::string> column_names() const override;
 
-private:
+  /**
+   * @brief Read only every stride-th page, for sampling
+   */
+  void sample_pages(uint32_t stride) { page_stride_ = std::max(stride, 1u); }
+
+  /**
+   * @brief Return a random sample, for TABLESAMPLE
+   *
+   * SYSTEM keeps each page, BERNOULLI each row, with probability
+   * fraction; the others are not read or not decoded. Whether a page or
+   * row is kept depends only on the seed and its position, so the same
+   * seed draws the same sample again.
+   */
+  void sample(sql::SampleMethod method, double fraction, uint64_t seed);
+
+  /**
+   * @brief Append each row's RowId after the table's columns, as an
+   *        INTEGER named $row_id, for a FetchOperator above
+   */
+  void emit_row_ids() { row_ids_ = true; }
+
+  /**
+   * @brief Encode a RowId as the value of a $row_id column, and back
+   */
+  static int64_t row_id_value(storage::RowId id) {
+    return static_cast<int64_t>(id.page_id) << 16 | id.slot_id;
+  }
+  static storage::RowId row_id_of(const sql::Literal &value) {
+    return {static_cast<uint32_t>(value.int_value >> 16),
+            static_cast<uint16_t>(value.int_value & 0xFFFF)};
+  }
+
+  /**
+   * @brief Pages read so far
+   */
+  uint64_t pages_read() const { return pages_read_; }
+
+protected:
+  const storage::Page *fetch_page();
+  bool keep_page();
+  bool keep_row() const;
+  bool decode_page();
+  bool read_row(ExecutionContext &ctx, ResultRow &row);
+  bool read_at(ExecutionContext &ctx, storage::RowId id, ResultRow &row);
+  bool in_time_range(const ResultRow &row) const;
+  void read_record(ResultRow &row);
+  void read_pax_row(ResultRow &row);
+  void read_encoded_row(ResultRow &row);
+
   uint32_t table_id_;
   std::string table_name_;
   storage::PageManager &page_manager_;
   const planner::TableInfo *schema_;
+  std::vector<uint32_t> column_indices_;
+  storage::Record record_; // Decode buffer for row-layout pages
+
+  // Segment source; page numbers then count within the current segment
+  storage::SegmentManager *segments_;
+  storage::SegmentManager::Snapshot snapshot_;
+  std::unique_ptr<storage::Page> scratch_; // Pages of the active segment
+  size_t segment_index_{0};
+  int32_t time_column_{-1}; // Set when the time range restricts rows
+  int64_t time_lo_;
+  int64_t time_hi_;
+
+  // Requested columns of the current encoded page, by column index
+  std::vector<std::vector<int64_t>> encoded_ints_;
+  std::vector<std::vector<std::string_view>> encoded_texts_;
+  std::vector<uint8_t> encoded_selected_; // Rows in the time range, if set
 
   uint32_t current_page_{0};
-  uint16_t current_slot_{0};
-  storage::Page *page_{nullptr};
+  uint32_t current_slot_{0};
+  const storage::Page *page_{nullptr};
+  storage::PageGuard pinned_; // Holds page_ while it is a table page
+  uint32_t page_stride_{1};
+  uint64_t pages_read_{0};
+
+  // Sample: a page or row is kept when its hash under the seed falls
+  // below the threshold
+  bool sampled_{false};
+  sql::SampleMethod sample_method_{sql::SampleMethod::SYSTEM};
+  uint64_t sample_seed_{0};
+  uint64_t sample_threshold_{0};
+  uint64_t page_hash_{0};  // Of the current page, for sampling rows
+  uint32_t page_limit_{0}; // Pages of the table, when sampling its pages
+
+  bool row_ids_{false};
+};
+
+/**
+ * @brief Index scan operator
+ *
+ * Reads the rows at a list of row ids, found through the primary key
+ * index, in storage order. Rows are decoded as by a table scan.
+ */
+class IndexScanOperator : public TableScanOperator {
+public:
+  /**
+   * @param rows Rows to read, sorted by page and slot
+   */
+  IndexScanOperator(uint32_t table_id, const std::string &table_name,
+                    storage::PageManager &page_manager,
+                    const planner::TableInfo *schema,
+                    std::vector<uint32_t> column_indices,
+                    std::vector<storage::RowId> rows);
+
+  void open(ExecutionContext &ctx) override;
+  bool next(ExecutionContext &ctx, ResultRow &row) override;
+
+private:
+  std::vector<storage::RowId> rows_;
+  size_t next_row_{0};
+};
+
+/**
+ * @brief Fetch operator, for late materialization
+ *
+ * Input rows carry a RowId after the table's columns, from a scan with
+ * emit_row_ids(). The requested columns are read again from the row's
+ * page and filled in at their table positions, and the RowId is
+ * dropped. Rows are fetched in input order, and consecutive rows on
+ * one page read it once.
+ */
+class FetchOperator : public TableScanOperator {
+public:
+  /**
+   * @param column_indices Columns to fetch, ascending
+   */
+  FetchOperator(std::unique_ptr<Operator> child, uint32_t table_id,
+                const std::string &table_name,
+                storage::PageManager &page_manager,
+                const planner::TableInfo *schema,
+                std::vector<uint32_t> column_indices);
+
+  void open(ExecutionContext &ctx) override;
+  bool next(ExecutionContext &ctx, ResultRow &row) override;
+  void close() override;
+  std::vector<std::string> column_names() const override;
+
+private:
+  std::unique_ptr<Operator> child_;
+  std::optional<ResultRow> fetched_; // In the query arena, reused per row
+};
+
+/**
+ * @brief Empty operator: the given columns and no rows
+ */
+class EmptyOperator : public Operator {
+public:
+  explicit EmptyOperator(std::vector<std::string> column_names)
+      : column_names_(std::move(column_names)) {}
+
+  void open(ExecutionContext &) override {}
+  bool next(ExecutionContext &, ResultRow &) override { return false; }
+  void close() override {}
+  std::vector<std::string> column_names() const override {
+    return column_names_;
+  }
+
+private:
+  std::vector<std::string> column_names_;
 };
 
 /**
  * @brief Filter operator
+ *
+ * The predicate is split into its AND-ed conjuncts, evaluated in turn
+ * until one rejects the row. Each conjunct's pass rate is tracked, and
+ * every REORDER_INTERVAL input rows they are re-ranked so those that
+ * reject the most rows per unit of cost run first. Cost is a fixed
+ * per-node estimate, not a timing, and the order only changes between
+ * batches, so the same input is always charged the same instructions.
+ *
+ * Conjuncts that may fail on some rows (arithmetic, function calls)
+ * stay in their written order after the others, so a guard such as
+ * `x <> 0 AND 10 / x > 1` still protects the division.
  */
 class FilterOperator : public Operator {
 public:
   FilterOperator(std::unique_ptr<Operator> child,
-                 const sql::Expression *predicate);
+                 const sql::Expression *predicate,
+                 const planner::Bindings &bindings);
 
   void open(ExecutionContext &ctx) override;
   bool next(ExecutionContext &ctx, ResultRow &row) override;
   void close() override;
   std::vector<std::string> column_names() const override;
 
+  static constexpr uint64_t REORDER_INTERVAL = 1024;
+
 private:
-  bool evaluate_predicate(const ResultRow &row);
+  struct Conjunct {
+    const sql::Expression *predicate;
+    uint32_t cost;       // Estimated instructions per evaluation
+    bool can_fail;       // Evaluation may throw for some rows
+    uint64_t evaluated;  // Observations, halved at each reorder
+    uint64_t passed;
+  };
+
+  bool evaluate_predicate(ExecutionContext &ctx, const ResultRow &row);
+  void reorder();
+
+  std::unique_ptr<Operator> child_;
+  const planner::Bindings &bindings_;
+  std::vector<Conjunct> conjuncts_; // In evaluation order
+  size_t reorderable_{0};           // Leading conjuncts that cannot fail
+  uint64_t rows_until_reorder_{REORDER_INTERVAL};
+};
+
+/**
+ * @brief Project operator
+ *
+ * Plain column outputs are copied from their bound input position; the
+ * rest are evaluated against the input row.
+ */
+class ProjectOperator : public Operator {
+public:
+  ProjectOperator(std::unique_ptr<Operator> child,
+                  std::vector<const sql::Expression *> expressions,
+                  std::vector<int32_t> columns,
+                  std::vector<std::string> output_names,
+                  const planner::Bindings &bindings);
+
+  void open(ExecutionContext &ctx) override;
+  bool next(ExecutionContext &ctx, ResultRow &row) override;
+  void close() override;
+  std::vector<std::string> column_names() const override;
 
+private:
   std::unique_ptr<Operator> child_;
-  const sql::Expression *predicate_;
+  std::vector<const sql::Expression *> expressions_;
+  std::vector<int32_t> columns_;
+  std::vector<std::string> output_names_;
+  const planner::Bindings &bindings_;
+  std::optional<ResultRow> input_; // In the query arena, reused per row
 };
 
 /**
@@ -131,12 +405,104 @@ private:
 };
 
 /**
- * @brief Sort operator (in-memory)
+ * @brief Strict weak order of rows by sort keys
+ *
+ * Keys that are plain columns are read from their bound position; other
+ * keys are evaluated per comparison.
+ */
+class RowComparator {
+public:
+  RowComparator(std::vector<const sql::Expression *> keys,
+                std::vector<int32_t> key_columns, std::vector<bool> ascending,
+                const planner::Bindings &bindings);
+
+  /**
+   * @brief Check whether a sorts before b
+   */
+  bool operator()(const ResultRow &a, const ResultRow &b) const;
+
+private:
+  std::vector<const sql::Expression *> keys_;
+  std::vector<int32_t> key_columns_;
+  std::vector<bool> ascending_;
+  const planner::Bindings *bindings_;
+};
+
+/**
+ * @brief Sort operator
  */
 class SortOperator : public Operator {
 public:
+  /**
+   * @param spill_dir Directory for sorted runs when the input does not fit
+   *                  in the sort's working memory
+   */
   SortOperator(std::unique_ptr<Operator> child,
-               std::vector<size_t> sort_columns, std::vector<bool> ascending);
+               std::vector<const sql::Expression *> keys,
+               std::vector<int32_t> key_columns, std::vector<bool> ascending,
+               const planner::Bindings &bindings, std::string spill_dir);
+  ~SortOperator() override;
+
+  void open(ExecutionContext &ctx) override;
+  bool next(ExecutionContext &ctx, ResultRow &row) override;
+  void close() override;
+  std::vector<std::string> column_names() const override;
+
+private:
+  /**
+   * @brief Working memory for one sorted run
+   *
+   * A private arena so a spilled run's memory can be reused for the next
+   * one; the query arena never frees.
+   */
+  struct RunMemory {
+    explicit RunMemory(size_t limit)
+        : allocator(limit, arena), resource(allocator), rows(&resource) {}
+
+    memory::Arena arena;
+    memory::QueryAllocator allocator;
+    memory::QueryMemoryResource resource;
+    std::pmr::vector<ResultRow> rows;
+  };
+
+  /**
+   * @brief Sorted run spilled to disk, read back one row at a time
+   */
+  struct SpillRun {
+    std::string path;
+    std::ifstream in;
+    ResultRow head;
+    bool has_row{false};
+  };
+
+  void materialize(ExecutionContext &ctx);
+  bool must_spill(const ResultRow &row) const;
+  void sort_buffer(ExecutionContext &ctx);
+  void spill_buffer(ExecutionContext &ctx);
+  void start_merge();
+  void remove_runs();
+
+  std::unique_ptr<Operator> child_;
+  RowComparator compare_;
+  std::string spill_dir_;
+  std::unique_ptr<RunMemory> run_memory_;
+  std::vector<SpillRun> runs_;
+  size_t current_row_{0};
+  bool materialized_{false};
+};
+
+/**
+ * @brief Top-N operator
+ *
+ * Returns the first n rows of the sort order, keeping only n rows in a
+ * bounded heap instead of sorting the whole input.
+ */
+class TopNOperator : public Operator {
+public:
+  TopNOperator(std::unique_ptr<Operator> child,
+               std::vector<const sql::Expression *> keys,
+               std::vector<int32_t> key_columns, std::vector<bool> ascending,
+               const planner::Bindings &bindings, int64_t n);
 
   void open(ExecutionContext &ctx) override;
   bool next(ExecutionContext &ctx, ResultRow &row) override;
@@ -144,10 +510,12 @@ public:
   std::vector<std::string> column_names() const override;
 
 private:
+  void materialize(ExecutionContext &ctx);
+
   std::unique_ptr<Operator> child_;
-  std::vector<size_t> sort_columns_;
-  std::vector<bool> ascending_;
-  std::vector<ResultRow> buffer_;
+  RowComparator compare_;
+  size_t n_;
+  std::optional<std::pmr::vector<ResultRow>> heap_; // In the query arena
   size_t current_row_{0};
   bool materialized_{false};
 };
@@ -172,20 +540,99 @@ public:
    */
   ExecutionResult execute(const planner::PlanNode &plan, ExecutionContext &ctx);
 
+  /**
+   * @brief Get the version of a table's contents
+   *
+   * Advances once the rows of an insert, or a CREATE or DROP of the
+   * table, are in place; a table with a materialized view also advances
+   * when the view's rows change. Versions start at 0 and are not
+   * persisted, so only compare versions read by one process.
+   *
+   * @return The version, or nullopt if the table does not exist or its
+   *         rows also change without a statement (retention)
+   */
+  std::optional<uint64_t> table_version(uint32_t table_id) const;
+
 private:
-  std::unique_ptr<Operator> build_operator(const planner::PlanNode &plan);
+  std::unique_ptr<Operator> build_operator(const planner::PlanNode &plan,
+                                          const planner::Bindings &bindings,
+                                          ExecutionContext &ctx);
 
   ExecutionResult execute_select(const planner::PlanNode &plan,
                                  ExecutionContext &ctx);
   ExecutionResult execute_insert(const planner::InsertNode &node,
                                  ExecutionContext &ctx);
+  bool append_row(uint32_t table_id, const storage::Record &record,
+                  std::vector<uint8_t> &buffer, storage::RowId &row);
+  bool append_pax(uint32_t table_id,
+                  const std::vector<storage::ColumnType> &types,
+                  const storage::Record &record, storage::RowId &row);
+  bool append_partitioned(const planner::TableInfo &table,
+                          const std::vector<storage::ColumnType> &types,
+                          const storage::Record &record,
+                          std::vector<uint8_t> &buffer, uint32_t &segment_id);
+  storage::SegmentManager &segment_manager();
+  std::mutex &write_lock(uint32_t table_id);
   ExecutionResult execute_create_table(const planner::CreateTableNode &node,
                                        ExecutionContext &ctx);
+  ExecutionResult execute_create_view(const planner::CreateViewNode &node,
+                                      ExecutionContext &ctx);
+  ViewDelta view_delta(const planner::MaterializedView &view,
+                       const planner::TableInfo &view_table);
+  std::unordered_map<std::string, storage::RowId> &
+  view_rows(uint32_t table_id, size_t keys);
+  void write_views(const std::vector<ViewDelta> &deltas);
+  void bump_version(uint32_t table_id);
   ExecutionResult execute_drop_table(const planner::DropTableNode &node,
                                      ExecutionContext &ctx);
+  ExecutionResult execute_analyze(const planner::AnalyzeNode &node,
+                                  ExecutionContext &ctx);
+  std::vector<storage::RowId> primary_key_rows(const planner::TableInfo &table,
+                                               int64_t lo, int64_t hi);
+  void primary_key_lookup(const planner::TableInfo &table,
+                          const std::vector<int64_t> &keys,
+                          std::vector<PrimaryKeyIndex::Match> &out);
+  PrimaryKeyIndex &primary_key_index(const planner::TableInfo &table);
+  void index_row(const planner::TableInfo &table,
+                 const storage::Record &record, storage::RowId row);
+  TableSummary table_summary(const planner::TableInfo &table);
+  void summarize_row(const planner::TableInfo &table,
+                     const storage::Record &record, uint32_t segment_id);
 
   storage::PageManager &page_manager_;
   planner::Catalog &catalog_;
+
+  // Segments of time-partitioned tables, opened on first use
+  std::unique_ptr<storage::SegmentManager> segments_;
+  std::once_flag segments_once_;
+
+  // Per table, serializes appends to it; by table id, never erased, so no
+  // statement can hold a lock that is gone
+  std::unordered_map<uint32_t, std::unique_ptr<std::mutex>> write_locks_;
+  std::mutex write_locks_mutex_;
+
+  // Primary key indexes by table id, built on first use
+  std::unordered_map<uint32_t, PrimaryKeyIndex> pk_indexes_;
+  std::mutex pk_mutex_;
+
+  // Row counts and value ranges, built on first use and kept current by
+  // inserts: by table id, or for time-partitioned tables by segment, keyed
+  // table_id << 32 | segment_id
+  std::unordered_map<uint32_t, TableSummary> table_summaries_;
+  std::unordered_map<uint64_t, TableSummary> segment_summaries_;
+  std::mutex summary_mutex_;
+
+  // Materialized view rows by view table id, then by encoded group key;
+  // read from the view's pages on first write
+  std::unordered_map<uint32_t, std::unordered_map<std::string, storage::RowId>>
+      view_rows_;
+  std::mutex view_mutex_;
+
+  // Content versions by table id, all drawn from one clock so a table
+  // dropped and created again under the same id never repeats a version
+  std::unordered_map<uint32_t, uint64_t> table_versions_;
+  uint64_t version_clock_{0};
+  mutable std::mutex version_mutex_;
 };
 
 } // namespace executor
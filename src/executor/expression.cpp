@@ -0,0 +1,334 @@
+/**
+ * @file expression.cpp
+ * @brief Expression evaluation implementation
+ */
+
+#include "expression.hpp"
+#include "executor.hpp"
+#include "../planner/statistics.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+namespace edgesql {
+namespace executor {
+
+namespace {
+
+using Type = sql::Literal::Type;
+
+bool is_numeric(const Value &v) {
+  return v.type == Type::INTEGER || v.type == Type::FLOAT;
+}
+
+double as_double(const Value &v) {
+  return v.type == Type::INTEGER ? static_cast<double>(v.int_value)
+                                 : v.float_value;
+}
+
+// Truth of a non-NULL value; numbers are true when non-zero
+bool truth(const Value &v) {
+  switch (v.type) {
+  case Type::BOOLEAN:
+    return v.bool_value;
+  case Type::INTEGER:
+    return v.int_value != 0;
+  case Type::FLOAT:
+    return v.float_value != 0.0;
+  default:
+    throw std::runtime_error("Expected a boolean expression");
+  }
+}
+
+Value arithmetic(sql::BinaryOp op, const Value &a, const Value &b) {
+  if (!is_numeric(a) || !is_numeric(b)) {
+    throw std::runtime_error("Arithmetic on non-numeric value");
+  }
+
+  if (a.type == Type::INTEGER && b.type == Type::INTEGER) {
+    int64_t x = a.int_value;
+    int64_t y = b.int_value;
+    int64_t r = 0;
+    bool overflow = false;
+    switch (op) {
+    case sql::BinaryOp::ADD:
+      overflow = __builtin_add_overflow(x, y, &r);
+      break;
+    case sql::BinaryOp::SUB:
+      overflow = __builtin_sub_overflow(x, y, &r);
+      break;
+    case sql::BinaryOp::MUL:
+      overflow = __builtin_mul_overflow(x, y, &r);
+      break;
+    case sql::BinaryOp::DIV:
+    case sql::BinaryOp::MOD:
+      if (y == 0) {
+        throw std::runtime_error("Division by zero");
+      }
+      overflow = x == INT64_MIN && y == -1;
+      if (!overflow) {
+        r = op == sql::BinaryOp::DIV ? x / y : x % y;
+      }
+      break;
+    default:
+      break;
+    }
+    if (overflow) {
+      throw std::runtime_error("Integer overflow");
+    }
+    return Value::integer(r);
+  }
+
+  double x = as_double(a);
+  double y = as_double(b);
+  switch (op) {
+  case sql::BinaryOp::ADD:
+    return Value::floating(x + y);
+  case sql::BinaryOp::SUB:
+    return Value::floating(x - y);
+  case sql::BinaryOp::MUL:
+    return Value::floating(x * y);
+  case sql::BinaryOp::DIV:
+  case sql::BinaryOp::MOD:
+    if (y == 0.0) {
+      throw std::runtime_error("Division by zero");
+    }
+    return Value::floating(op == sql::BinaryOp::DIV ? x / y
+                                                    : std::fmod(x, y));
+  default:
+    return Value();
+  }
+}
+
+Value evaluate_binary(const sql::Expression &expr, const ResultRow &row,
+                      const planner::Bindings &bindings) {
+  sql::BinaryOp op = expr.binary_op;
+
+  // AND/OR skip the right side once the left decides the result
+  if (op == sql::BinaryOp::AND || op == sql::BinaryOp::OR) {
+    bool decisive = op == sql::BinaryOp::OR;
+    Value left = evaluate(*expr.left, row, bindings);
+    if (!left.is_null() && truth(left) == decisive) {
+      return Value::boolean(decisive);
+    }
+    Value right = evaluate(*expr.right, row, bindings);
+    if (!right.is_null() && truth(right) == decisive) {
+      return Value::boolean(decisive);
+    }
+    if (left.is_null() || right.is_null()) {
+      return Value();
+    }
+    return Value::boolean(!decisive);
+  }
+
+  Value left = evaluate(*expr.left, row, bindings);
+  Value right = evaluate(*expr.right, row, bindings);
+  if (left.is_null() || right.is_null()) {
+    return Value();
+  }
+
+  switch (op) {
+  case sql::BinaryOp::EQ:
+    return Value::boolean(compare_values(left, right) == 0);
+  case sql::BinaryOp::NE:
+    return Value::boolean(compare_values(left, right) != 0);
+  case sql::BinaryOp::LT:
+    return Value::boolean(compare_values(left, right) < 0);
+  case sql::BinaryOp::LE:
+    return Value::boolean(compare_values(left, right) <= 0);
+  case sql::BinaryOp::GT:
+    return Value::boolean(compare_values(left, right) > 0);
+  case sql::BinaryOp::GE:
+    return Value::boolean(compare_values(left, right) >= 0);
+  default:
+    return arithmetic(op, left, right);
+  }
+}
+
+Value evaluate_unary(const sql::Expression &expr, const ResultRow &row,
+                     const planner::Bindings &bindings) {
+  Value operand = evaluate(*expr.operand(), row, bindings);
+  if (operand.is_null()) {
+    return operand;
+  }
+
+  if (expr.unary_op == sql::UnaryOp::NOT) {
+    return Value::boolean(!truth(operand));
+  }
+
+  switch (operand.type) {
+  case Type::INTEGER:
+    if (operand.int_value == INT64_MIN) {
+      throw std::runtime_error("Integer overflow");
+    }
+    return Value::integer(-operand.int_value);
+  case Type::FLOAT:
+    return Value::floating(-operand.float_value);
+  default:
+    throw std::runtime_error("Arithmetic on non-numeric value");
+  }
+}
+
+} // anonymous namespace
+
+Value Value::of(const sql::Literal &literal) {
+  Value v;
+  v.type = literal.type;
+  switch (literal.type) {
+  case Type::FLOAT:
+    v.float_value = literal.float_value;
+    break;
+  case Type::BOOLEAN:
+    v.bool_value = literal.bool_value;
+    break;
+  case Type::STRING:
+    v.string_value = literal.string_value;
+    break;
+  default:
+    v.int_value = literal.int_value;
+    break;
+  }
+  return v;
+}
+
+Value Value::integer(int64_t v) {
+  Value value;
+  value.type = Type::INTEGER;
+  value.int_value = v;
+  return value;
+}
+
+Value Value::floating(double v) {
+  Value value;
+  value.type = Type::FLOAT;
+  value.float_value = v;
+  return value;
+}
+
+Value Value::boolean(bool v) {
+  Value value;
+  value.type = Type::BOOLEAN;
+  value.bool_value = v;
+  return value;
+}
+
+Value evaluate(const sql::Expression &expr, const ResultRow &row,
+               const planner::Bindings &bindings) {
+  // A bound node, column or computed below (e.g. an aggregate), is read
+  // from the row
+  int32_t index = bindings.position(expr);
+  if (index >= 0) {
+    if (static_cast<size_t>(index) >= row.values.size()) {
+      throw std::runtime_error("Bound column out of range");
+    }
+    return Value::of(row.values[index]);
+  }
+
+  switch (expr.type) {
+  case sql::ExprType::LITERAL: {
+    Value v;
+    v.type = expr.literal_type;
+    switch (expr.literal_type) {
+    case Type::FLOAT:
+      v.float_value = expr.float_value;
+      break;
+    case Type::BOOLEAN:
+      v.bool_value = expr.bool_value;
+      break;
+    case Type::STRING:
+      v.string_value = expr.string_value;
+      break;
+    default:
+      v.int_value = expr.int_value;
+      break;
+    }
+    return v;
+  }
+  case sql::ExprType::COLUMN_REF:
+    throw std::runtime_error("Unbound column: " + std::string(expr.name));
+  case sql::ExprType::BINARY_OP:
+    return evaluate_binary(expr, row, bindings);
+  case sql::ExprType::UNARY_OP:
+    return evaluate_unary(expr, row, bindings);
+  case sql::ExprType::FUNCTION_CALL:
+    throw std::runtime_error("Unsupported function: " +
+                             std::string(expr.name));
+  case sql::ExprType::STAR:
+    break;
+  }
+  throw std::runtime_error("Unexpected * in expression");
+}
+
+Value evaluate_constant(const sql::Expression &expr) {
+  static const ResultRow no_columns;
+  static const planner::Bindings unbound;
+  return evaluate(expr, no_columns, unbound);
+}
+
+bool is_true(const sql::Expression &predicate, const ResultRow &row,
+             const planner::Bindings &bindings) {
+  Value v = evaluate(predicate, row, bindings);
+  return !v.is_null() && truth(v);
+}
+
+int compare_values(const Value &a, const Value &b) {
+  if (a.is_null() || b.is_null()) {
+    return static_cast<int>(!a.is_null()) - static_cast<int>(!b.is_null());
+  }
+
+  if (a.type == Type::INTEGER && b.type == Type::INTEGER) {
+    return (a.int_value > b.int_value) - (a.int_value < b.int_value);
+  }
+  if (is_numeric(a) && is_numeric(b)) {
+    double x = as_double(a);
+    double y = as_double(b);
+    return (x > y) - (x < y);
+  }
+  if (a.type == Type::STRING && b.type == Type::STRING) {
+    int c = a.string_value.compare(b.string_value);
+    return (c > 0) - (c < 0);
+  }
+  if (a.type == Type::BOOLEAN && b.type == Type::BOOLEAN) {
+    return static_cast<int>(a.bool_value) - static_cast<int>(b.bool_value);
+  }
+  throw std::runtime_error("Cannot compare values of different types");
+}
+
+uint64_t hash_value(const Value &value) {
+  switch (value.type) {
+  case Type::INTEGER:
+    return planner::hash_integer(value.int_value);
+  case Type::FLOAT: {
+    sql::Literal literal = sql::Literal::floating(value.float_value);
+    return planner::hash_literal(literal);
+  }
+  case Type::BOOLEAN:
+    return planner::hash_integer(value.bool_value ? 1 : 0);
+  case Type::STRING:
+    return planner::hash_string(value.string_value);
+  case Type::NULL_VAL:
+    break;
+  }
+  return 0x5BD1E995u;
+}
+
+void assign(sql::Literal &out, const Value &value) {
+  out.type = value.type;
+  switch (value.type) {
+  case Type::FLOAT:
+    out.float_value = value.float_value;
+    break;
+  case Type::BOOLEAN:
+    out.bool_value = value.bool_value;
+    break;
+  case Type::STRING:
+    out.string_value.assign(value.string_value);
+    break;
+  default:
+    out.int_value = value.int_value;
+    break;
+  }
+}
+
+} // namespace executor
+} // namespace edgesql
@@ -0,0 +1,92 @@
+#pragma once
+
+/**
+ * @file expression.hpp
+ * @brief Row-at-a-time expression evaluation
+ */
+
+#include "../planner/bindings.hpp"
+#include "../sql/ast.hpp"
+#include <cstdint>
+#include <string_view>
+
+namespace edgesql {
+namespace executor {
+
+struct ResultRow;
+
+/**
+ * @brief Evaluated value
+ *
+ * Strings are views into the input row or the statement's arena, so
+ * evaluation never allocates. A value must not outlive the row it was
+ * evaluated against.
+ */
+struct Value {
+  sql::Literal::Type type{sql::Literal::Type::NULL_VAL};
+  union {
+    int64_t int_value{0};
+    double float_value;
+    bool bool_value;
+  };
+  std::string_view string_value;
+
+  bool is_null() const { return type == sql::Literal::Type::NULL_VAL; }
+
+  static Value of(const sql::Literal &literal);
+  static Value integer(int64_t v);
+  static Value floating(double v);
+  static Value boolean(bool v);
+};
+
+/**
+ * @brief Evaluate an expression against a row
+ *
+ * Bound nodes (column references, and group keys or aggregates computed
+ * below) read the position the plan's bindings give them.
+ * Comparisons and logic follow SQL three-valued semantics: NULL operands
+ * yield NULL, except where AND/OR are decided by the other side.
+ *
+ * @throws std::runtime_error on type errors, division by zero, integer
+ *         overflow and unsupported functions
+ */
+Value evaluate(const sql::Expression &expr, const ResultRow &row,
+               const planner::Bindings &bindings);
+
+/**
+ * @brief Evaluate an expression that reads no columns, e.g. while planning
+ * @throws std::runtime_error as evaluate() does
+ */
+Value evaluate_constant(const sql::Expression &expr);
+
+/**
+ * @brief Check whether a predicate holds for a row (NULL does not)
+ */
+bool is_true(const sql::Expression &predicate, const ResultRow &row,
+             const planner::Bindings &bindings);
+
+/**
+ * @brief Order two values: negative, zero or positive
+ *
+ * NULL sorts before everything else; numbers compare across INTEGER and
+ * FLOAT.
+ *
+ * @throws std::runtime_error if the types are not comparable
+ */
+int compare_values(const Value &a, const Value &b);
+
+/**
+ * @brief Hash a value for grouping and joining
+ *
+ * Values that compare equal hash equally, 1 and 1.0 included; NULLs all
+ * share one hash.
+ */
+uint64_t hash_value(const Value &value);
+
+/**
+ * @brief Store a value in a row slot, reusing the slot's string storage
+ */
+void assign(sql::Literal &out, const Value &value);
+
+} // namespace executor
+} // namespace edgesql
@@ -0,0 +1,611 @@
+/**
+ * @file join.cpp
+ * @brief Join operator implementation
+ */
+
+#include "join.hpp"
+#include "spill.hpp"
+#include "../memory/memory_tracker.hpp"
+#include "../observability/metrics.hpp"
+#include <bit>
+#include <cmath>
+#include <filesystem>
+#include <numeric>
+
+namespace edgesql {
+namespace executor {
+
+namespace {
+
+using Type = sql::Literal::Type;
+
+// Join working memory: a quarter of the query budget, at least 256KB
+constexpr size_t MIN_BUILD_BYTES = 256 * 1024;
+
+// Table bytes per build row besides the row and its hash: its chain link
+// and up to two slots
+constexpr size_t ROW_INDEX_BYTES = 5 * sizeof(uint32_t);
+
+bool is_numeric(const Value &v) {
+  return v.type == Type::INTEGER || v.type == Type::FLOAT;
+}
+
+// Keys match when they compare equal; values of unrelated types never
+// match instead of raising a comparison error
+bool same_key(const Value &a, const Value &b) {
+  if (a.type != b.type && !(is_numeric(a) && is_numeric(b))) {
+    return false;
+  }
+  return compare_values(a, b) == 0;
+}
+
+void set_null(sql::Literal &value) { value.type = Type::NULL_VAL; }
+
+// Joined row: the left row followed by the right one, or by NULLs
+void concat(const ResultRow &left, uint32_t left_width,
+            const ResultRow *right, uint32_t right_width, ResultRow &out) {
+  out.values.resize(left_width + right_width);
+  std::copy_n(left.values.begin(), left_width, out.values.begin());
+  if (right) {
+    std::copy_n(right->values.begin(), right_width,
+                out.values.begin() + left_width);
+    return;
+  }
+  for (size_t i = left_width; i < out.values.size(); ++i) {
+    set_null(out.values[i]);
+  }
+}
+
+} // anonymous namespace
+
+HashJoinOperator::HashJoinOperator(
+    std::unique_ptr<Operator> left, std::unique_ptr<Operator> right,
+    sql::JoinType type, std::vector<const sql::Expression *> left_keys,
+    std::vector<const sql::Expression *> right_keys,
+    const sql::Expression *residual, const planner::Bindings &bindings,
+    uint32_t left_width, uint32_t right_width, bool build_left,
+    std::string spill_dir)
+    : left_(std::move(left)), right_(std::move(right)), type_(type),
+      left_keys_(std::move(left_keys)), right_keys_(std::move(right_keys)),
+      residual_(residual), bindings_(bindings), left_width_(left_width),
+      right_width_(right_width),
+      build_left_(build_left && type == sql::JoinType::INNER),
+      spill_dir_(std::move(spill_dir)) {}
+
+HashJoinOperator::~HashJoinOperator() { remove_files(); }
+
+void HashJoinOperator::open(ExecutionContext &ctx) {
+  left_->open(ctx);
+  right_->open(ctx);
+  release_build();
+  remove_files();
+  pending_.clear();
+
+  work_memory_ = std::max(ctx.budget().work_memory(), MIN_BUILD_BYTES);
+  query_allocator_ = &ctx.allocator();
+  input_.emplace(ctx.memory_resource());
+  probe_.emplace(ctx.memory_resource());
+  has_probe_ = false;
+  started_ = false;
+}
+
+bool HashJoinOperator::next(ExecutionContext &ctx, ResultRow &row) {
+  if (!started_) {
+    started_ = true;
+    build_ = std::make_unique<BuildMemory>(build_limit());
+    if (load(ctx, nullptr, true)) {
+      index_rows();
+      probing_child_ = true;
+    } else {
+      partition(ctx, nullptr, nullptr, 0);
+      probing_child_ = false;
+    }
+  }
+
+  while (true) {
+    if (has_probe_) {
+      // Walk the probe row's slot chain; rows of other hashes share it
+      while (match_ != EMPTY) {
+        uint32_t at = match_;
+        match_ = build_->chain[at];
+        ctx.record_instructions(1);
+
+        const ResultRow &candidate = build_->rows[at];
+        if (build_->hashes[at] != probe_hash_ || !keys_match(candidate)) {
+          continue;
+        }
+        join_rows(candidate, row);
+        if (residual_ && !is_true(*residual_, row, bindings_)) {
+          continue;
+        }
+        matched_ = true;
+        return true;
+      }
+
+      has_probe_ = false;
+      if (type_ == sql::JoinType::LEFT && !matched_) {
+        pad(row);
+        return true;
+      }
+    }
+
+    if (!next_probe(ctx) && !next_partition(ctx)) {
+      return false;
+    }
+  }
+}
+
+void HashJoinOperator::close() {
+  left_->close();
+  right_->close();
+  probe_in_.close();
+  remove_files();
+  pending_.clear();
+  release_build();
+  input_.reset();
+  probe_.reset();
+}
+
+std::vector<std::string> HashJoinOperator::column_names() const {
+  std::vector<std::string> names = left_->column_names();
+  std::vector<std::string> right = right_->column_names();
+  names.insert(names.end(), right.begin(), right.end());
+  return names;
+}
+
+size_t HashJoinOperator::build_limit() const {
+  // Never more than the query has left, so the table spills before the
+  // query runs out of memory
+  return std::min(work_memory_, query_allocator_->remaining());
+}
+
+bool HashJoinOperator::load(ExecutionContext &ctx, std::ifstream *in,
+                            bool limited) {
+  // Rows accumulate in the build arena; the row that does not fit is left
+  // in input_ for the caller to spill
+  Operator *child = build_left_ ? left_.get() : right_.get();
+  const auto &keys = build_left_ ? left_keys_ : right_keys_;
+  auto &build = *build_;
+  ResultRow &temp = *input_;
+  while (in ? read_row(*in, temp) : child->next(ctx, temp)) {
+    uint64_t hash;
+    if (!hash_keys(keys, temp, hash)) {
+      continue; // NULL keys match nothing
+    }
+    if (limited && !build.rows.empty() && must_spill(temp)) {
+      return false;
+    }
+    // Copied rather than moved: a move across arenas would clear temp,
+    // and the next row would allocate its strings afresh
+    build.rows.push_back(temp);
+    build.hashes.push_back(hash);
+    charge_build();
+    ctx.record_instructions(2);
+    ctx.check_budget();
+  }
+  return true;
+}
+
+bool HashJoinOperator::must_spill(const ResultRow &row) const {
+  const auto &build = *build_;
+  size_t needed = row_footprint(row) + ROW_INDEX_BYTES;
+  if (build.rows.size() == build.rows.capacity()) {
+    // Growing the arrays copies them into blocks twice the size
+    needed += (build.rows.capacity() * 2 + 1) *
+              (sizeof(ResultRow) + sizeof(uint64_t));
+  }
+
+  const auto &allocator = build.allocator;
+  if (allocator.would_exceed(needed)) {
+    return true;
+  }
+
+  // Under global memory pressure give back memory early, but not so early
+  // that partitions stay too small to be worth joining one at a time
+  return memory::MemoryTracker::instance().under_pressure() &&
+         allocator.bytes_used() >= allocator.memory_limit() / 8;
+}
+
+void HashJoinOperator::index_rows() {
+  // Chains are threaded back to front so each keeps build order
+  auto &build = *build_;
+  size_t count = build.rows.size();
+  build.slots.assign(std::bit_ceil(std::max<size_t>(count * 2, 1)), EMPTY);
+  build.chain.assign(count, EMPTY);
+  size_t mask = build.slots.size() - 1;
+  for (size_t i = count; i-- > 0;) {
+    size_t at = build.hashes[i] & mask;
+    build.chain[i] = build.slots[at];
+    build.slots[at] = static_cast<uint32_t>(i);
+  }
+  charge_build();
+}
+
+void HashJoinOperator::partition(ExecutionContext &ctx,
+                                 std::ifstream *build_in,
+                                 std::ifstream *probe_in, uint32_t level) {
+  // Rows go to a partition by the hash bits below those used so far, from
+  // the top so they are independent of the table's slot bits
+  constexpr size_t FANOUT = size_t{1} << PARTITION_BITS;
+  uint32_t shift = 64 - PARTITION_BITS * (level + 1);
+  auto which = [&](uint64_t hash) { return (hash >> shift) & (FANOUT - 1); };
+
+  std::error_code ec;
+  std::filesystem::create_directories(spill_dir_, ec);
+  std::vector<Partition> parts;
+  std::vector<std::ofstream> build_out(FANOUT);
+  std::vector<std::ofstream> probe_out(FANOUT);
+  for (size_t i = 0; i < FANOUT; ++i) {
+    parts.push_back(Partition{spill_path(spill_dir_, "join"),
+                              spill_path(spill_dir_, "join"), level + 1});
+    files_.push_back(parts.back().build_path);
+    files_.push_back(parts.back().probe_path);
+    build_out[i].open(parts.back().build_path,
+                      std::ios::binary | std::ios::trunc);
+    probe_out[i].open(parts.back().probe_path,
+                      std::ios::binary | std::ios::trunc);
+  }
+
+  // Build rows: those in the table, the one that did not fit, the rest
+  auto &build = *build_;
+  for (size_t i = 0; i < build.rows.size(); ++i) {
+    write_row(build_out[which(build.hashes[i])], build.rows[i]);
+  }
+  ctx.record_instructions(static_cast<uint64_t>(build.rows.size()) * 2);
+  release_build();
+
+  Operator *build_child = build_left_ ? left_.get() : right_.get();
+  Operator *probe_child = build_left_ ? right_.get() : left_.get();
+  const auto &build_keys = build_left_ ? left_keys_ : right_keys_;
+  const auto &probe_keys = build_left_ ? right_keys_ : left_keys_;
+  ResultRow &temp = *input_;
+  uint64_t hash;
+  hash_keys(build_keys, temp, hash);
+  write_row(build_out[which(hash)], temp);
+  while (build_in ? read_row(*build_in, temp)
+                  : build_child->next(ctx, temp)) {
+    if (hash_keys(build_keys, temp, hash)) {
+      write_row(build_out[which(hash)], temp);
+      ctx.record_instructions(2);
+      ctx.check_budget();
+    }
+  }
+
+  // Probe rows with a NULL key only matter to a LEFT join, which pads
+  // them wherever they land
+  while (probe_in ? read_row(*probe_in, temp)
+                  : probe_child->next(ctx, temp)) {
+    bool has_keys = hash_keys(probe_keys, temp, hash);
+    if (has_keys || type_ == sql::JoinType::LEFT) {
+      write_row(probe_out[has_keys ? which(hash) : 0], temp);
+      ctx.record_instructions(2);
+      ctx.check_budget();
+    }
+  }
+
+  for (size_t i = 0; i < FANOUT; ++i) {
+    build_out[i].close();
+    probe_out[i].close();
+    if (!build_out[i] || !probe_out[i]) {
+      throw std::runtime_error("Failed to write join spill file");
+    }
+  }
+  observability::Metrics::instance().increment("join_spills");
+
+  // Joined first partition first
+  pending_.insert(pending_.end(), std::make_move_iterator(parts.rbegin()),
+                  std::make_move_iterator(parts.rend()));
+}
+
+bool HashJoinOperator::next_partition(ExecutionContext &ctx) {
+  probe_in_.close();
+  probe_in_.clear();
+  release_build();
+
+  while (!pending_.empty()) {
+    Partition part = std::move(pending_.back());
+    pending_.pop_back();
+
+    // Past the last level a partition is joined in memory however large,
+    // up to the query budget: its rows may all share one key
+    bool limited = part.level < MAX_LEVEL;
+    build_ = std::make_unique<BuildMemory>(limited ? build_limit()
+                                                   : SIZE_MAX);
+    std::ifstream build_in(part.build_path, std::ios::binary);
+    if (load(ctx, &build_in, limited)) {
+      index_rows();
+      build_in.close();
+      std::error_code ec;
+      std::filesystem::remove(part.build_path, ec);
+      probe_in_.open(part.probe_path, std::ios::binary);
+      return true;
+    }
+
+    std::ifstream probe_in(part.probe_path, std::ios::binary);
+    partition(ctx, &build_in, &probe_in, part.level);
+    build_in.close();
+    probe_in.close();
+    std::error_code ec;
+    std::filesystem::remove(part.build_path, ec);
+    std::filesystem::remove(part.probe_path, ec);
+  }
+  return false;
+}
+
+bool HashJoinOperator::next_probe(ExecutionContext &ctx) {
+  // An empty table matches nothing, so an INNER join need not probe it
+  if (!build_ ||
+      (build_->rows.empty() && type_ == sql::JoinType::INNER)) {
+    return false;
+  }
+
+  Operator *child = build_left_ ? right_.get() : left_.get();
+  const auto &keys = build_left_ ? right_keys_ : left_keys_;
+  ResultRow &probe = *probe_;
+  while (probing_child_ ? child->next(ctx, probe)
+                        : read_row(probe_in_, probe)) {
+    ctx.record_instructions(1);
+    if (!hash_keys(keys, probe, probe_hash_)) {
+      if (type_ == sql::JoinType::INNER) {
+        continue;
+      }
+      match_ = EMPTY;
+    } else {
+      const auto &slots = build_->slots;
+      match_ = slots[probe_hash_ & (slots.size() - 1)];
+    }
+    has_probe_ = true;
+    matched_ = false;
+    return true;
+  }
+  return false;
+}
+
+bool HashJoinOperator::hash_keys(
+    const std::vector<const sql::Expression *> &keys, const ResultRow &row,
+    uint64_t &hash) {
+  hash = 0;
+  probe_keys_.clear();
+  for (const sql::Expression *key : keys) {
+    Value value = evaluate(*key, row, bindings_);
+    if (value.is_null()) {
+      return false;
+    }
+    probe_keys_.push_back(value);
+    hash = (hash ^ hash_value(value)) * 0x100000001B3ull;
+  }
+  return true;
+}
+
+bool HashJoinOperator::keys_match(const ResultRow &build_row) const {
+  const auto &keys = build_left_ ? left_keys_ : right_keys_;
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (!same_key(evaluate(*keys[i], build_row, bindings_), probe_keys_[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void HashJoinOperator::join_rows(const ResultRow &build_row,
+                                 ResultRow &row) const {
+  const ResultRow &left = build_left_ ? build_row : *probe_;
+  const ResultRow &right = build_left_ ? *probe_ : build_row;
+  concat(left, left_width_, &right, right_width_, row);
+}
+
+void HashJoinOperator::pad(ResultRow &row) const {
+  concat(*probe_, left_width_, nullptr, right_width_, row);
+}
+
+void HashJoinOperator::charge_build() {
+  size_t used = build_->allocator.bytes_used();
+  if (used > charged_) {
+    query_allocator_->charge(used - charged_);
+    charged_ = used;
+  }
+}
+
+void HashJoinOperator::release_build() {
+  if (query_allocator_) {
+    query_allocator_->release(charged_);
+  }
+  charged_ = 0;
+  build_.reset();
+}
+
+void HashJoinOperator::remove_files() {
+  for (const auto &path : files_) {
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+  }
+  files_.clear();
+}
+
+// IndexJoinOperator implementation
+
+IndexJoinOperator::IndexJoinOperator(
+    std::unique_ptr<Operator> left, uint32_t table_id,
+    const std::string &table_name, storage::PageManager &page_manager,
+    const planner::TableInfo *schema, std::vector<uint32_t> column_indices,
+    KeyLookup lookup, sql::JoinType type,
+    std::vector<const sql::Expression *> left_keys,
+    std::vector<const sql::Expression *> right_keys, size_t probe_key,
+    const sql::Expression *inner_filter, const sql::Expression *residual,
+    const planner::Bindings &bindings, uint32_t left_width,
+    uint32_t right_width, uint32_t batch_size)
+    : TableScanOperator(table_id, table_name, page_manager, schema,
+                        std::move(column_indices)),
+      left_(std::move(left)), lookup_(std::move(lookup)), type_(type),
+      left_keys_(std::move(left_keys)), right_keys_(std::move(right_keys)),
+      probe_key_(probe_key), inner_filter_(inner_filter),
+      residual_(residual), bindings_(bindings), left_width_(left_width),
+      right_width_(right_width), batch_size_(std::max(batch_size, 1u)) {}
+
+void IndexJoinOperator::open(ExecutionContext &ctx) {
+  left_->open(ctx);
+  page_ = nullptr;
+  pages_read_ = 0;
+  left_rows_.emplace(ctx.memory_resource());
+  right_rows_.emplace(ctx.memory_resource());
+  batch_count_ = 0;
+  next_left_ = 0;
+  match_ = 0;
+  match_end_ = 0;
+  pad_pending_ = false;
+  ctx.record_instructions(10); // Opening cost
+}
+
+bool IndexJoinOperator::next(ExecutionContext &ctx, ResultRow &row) {
+  while (true) {
+    while (match_ < match_end_) {
+      uint32_t at = match_++;
+      ctx.record_instructions(1);
+
+      const ResultRow &left = (*left_rows_)[current_left_];
+      const ResultRow &right = (*right_rows_)[at];
+      if (!found_[at] || !keys_match(left, right)) {
+        continue;
+      }
+      concat(left, left_width_, &right, right_width_, row);
+      if (residual_ && !is_true(*residual_, row, bindings_)) {
+        continue;
+      }
+      matched_ = true;
+      return true;
+    }
+
+    if (pad_pending_) {
+      pad_pending_ = false;
+      if (!matched_) {
+        concat((*left_rows_)[current_left_], left_width_, nullptr,
+               right_width_, row);
+        return true;
+      }
+    }
+
+    if (next_left_ == batch_count_ && !next_batch(ctx)) {
+      return false;
+    }
+    current_left_ = next_left_++;
+    uint32_t key = key_of_[current_left_];
+    match_ = key == NO_KEY ? 0 : key_matches_[key];
+    match_end_ = key == NO_KEY ? 0 : key_matches_[key + 1];
+    matched_ = false;
+    pad_pending_ = type_ == sql::JoinType::LEFT;
+  }
+}
+
+void IndexJoinOperator::close() {
+  left_->close();
+  TableScanOperator::close();
+  left_rows_.reset();
+  right_rows_.reset();
+}
+
+std::vector<std::string> IndexJoinOperator::column_names() const {
+  std::vector<std::string> names = left_->column_names();
+  std::vector<std::string> right = TableScanOperator::column_names();
+  names.insert(names.end(), right.begin(), right.end());
+  return names;
+}
+
+bool IndexJoinOperator::next_batch(ExecutionContext &ctx) {
+  auto &rows = *left_rows_;
+  batch_count_ = 0;
+  next_left_ = 0;
+  while (batch_count_ < batch_size_) {
+    if (batch_count_ == rows.size()) {
+      rows.emplace_back();
+    }
+    if (!left_->next(ctx, rows[batch_count_])) {
+      break;
+    }
+    ++batch_count_;
+  }
+  if (batch_count_ == 0) {
+    return false;
+  }
+
+  // Only an integral value can equal an INTEGER key
+  probes_.clear();
+  key_of_.assign(batch_count_, NO_KEY);
+  for (size_t i = 0; i < batch_count_; ++i) {
+    Value value = evaluate(*left_keys_[probe_key_], rows[i], bindings_);
+    double number = value.float_value;
+    if (value.type == Type::INTEGER) {
+      probes_.emplace_back(value.int_value, static_cast<uint32_t>(i));
+    } else if (value.type == Type::FLOAT && number == std::trunc(number) &&
+               std::fabs(number) < 9.2e18) {
+      probes_.emplace_back(static_cast<int64_t>(number),
+                           static_cast<uint32_t>(i));
+    }
+  }
+
+  // Sorted keys are found in one pass over the index
+  std::sort(probes_.begin(), probes_.end());
+  keys_.clear();
+  for (const auto &[key, at] : probes_) {
+    if (keys_.empty() || keys_.back() != key) {
+      keys_.push_back(key);
+    }
+    key_of_[at] = static_cast<uint32_t>(keys_.size() - 1);
+  }
+  matches_.clear();
+  lookup_(keys_, matches_);
+
+  // Matches come back in key order, so each key's form a range
+  key_matches_.assign(keys_.size() + 1, 0);
+  for (const auto &match : matches_) {
+    key_matches_[match.key + 1]++;
+  }
+  std::partial_sum(key_matches_.begin(), key_matches_.end(),
+                   key_matches_.begin());
+  ctx.record_instructions(batch_count_ + probes_.size() * 2);
+
+  fetch_matches(ctx);
+  return true;
+}
+
+void IndexJoinOperator::fetch_matches(ExecutionContext &ctx) {
+  // Read in page order, so each page is fetched once per batch
+  size_t count = matches_.size();
+  auto &rows = *right_rows_;
+  while (rows.size() < count) {
+    rows.emplace_back();
+  }
+  fetch_order_.resize(count);
+  std::iota(fetch_order_.begin(), fetch_order_.end(), 0u);
+  std::sort(fetch_order_.begin(), fetch_order_.end(),
+            [&](uint32_t a, uint32_t b) {
+              return matches_[a].row < matches_[b].row;
+            });
+
+  // The page last read may have been evicted while reading the left input
+  page_ = nullptr;
+  found_.assign(count, false);
+  for (uint32_t at : fetch_order_) {
+    found_[at] =
+        read_at(ctx, matches_[at].row, rows[at]) &&
+        (!inner_filter_ || is_true(*inner_filter_, rows[at], bindings_));
+  }
+}
+
+bool IndexJoinOperator::keys_match(const ResultRow &left,
+                                   const ResultRow &right) const {
+  // The probe key matched in the index; the others are checked here
+  for (size_t i = 0; i < left_keys_.size(); ++i) {
+    if (i == probe_key_) {
+      continue;
+    }
+    Value a = evaluate(*left_keys_[i], left, bindings_);
+    Value b = evaluate(*right_keys_[i], right, bindings_);
+    if (a.is_null() || b.is_null() || !same_key(a, b)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace executor
+} // namespace edgesql
@@ -0,0 +1,218 @@
+#pragma once
+
+/**
+ * @file join.hpp
+ * @brief Join operators
+ */
+
+#include "executor.hpp"
+#include "expression.hpp"
+#include <functional>
+
+namespace edgesql {
+namespace executor {
+
+/**
+ * @brief Hash join
+ *
+ * Reads the build input into a hash table, then streams the probe input
+ * past it. Output rows are the left row followed by the right row,
+ * whichever side was hashed; a LEFT join always hashes the right input
+ * and pads left rows without a match with NULLs.
+ *
+ * The table is compact: rows and their hashes sit in arrays, chained by
+ * row number from a power-of-two slot array, all in an arena of the
+ * join's own that is charged to the query budget as it grows. When the
+ * build input outgrows the join's working memory, both inputs are
+ * partitioned to disk by hash and joined one partition pair at a time
+ * (grace hash join); a partition that is still too large is partitioned
+ * again by further hash bits.
+ */
+class HashJoinOperator : public Operator {
+public:
+  /**
+   * @param spill_dir Directory for partitions when the build input does
+   *                  not fit in the join's working memory
+   */
+  HashJoinOperator(std::unique_ptr<Operator> left,
+                   std::unique_ptr<Operator> right, sql::JoinType type,
+                   std::vector<const sql::Expression *> left_keys,
+                   std::vector<const sql::Expression *> right_keys,
+                   const sql::Expression *residual,
+                   const planner::Bindings &bindings, uint32_t left_width,
+                   uint32_t right_width, bool build_left,
+                   std::string spill_dir);
+  ~HashJoinOperator() override;
+
+  void open(ExecutionContext &ctx) override;
+  bool next(ExecutionContext &ctx, ResultRow &row) override;
+  void close() override;
+  std::vector<std::string> column_names() const override;
+
+private:
+  /**
+   * @brief Hash table of build rows
+   *
+   * A private arena so a joined partition's memory can be reused for the
+   * next one; the query arena never frees.
+   */
+  struct BuildMemory {
+    explicit BuildMemory(size_t limit)
+        : allocator(limit, arena), resource(allocator), rows(&resource),
+          hashes(&resource), chain(&resource), slots(&resource) {}
+
+    memory::Arena arena;
+    memory::QueryAllocator allocator;
+    memory::QueryMemoryResource resource;
+    std::pmr::vector<ResultRow> rows;
+    std::pmr::vector<uint64_t> hashes; // By row
+    std::pmr::vector<uint32_t> chain;  // Next row in the slot, or EMPTY
+    std::pmr::vector<uint32_t> slots;  // First row in the slot, or EMPTY
+  };
+
+  /**
+   * @brief Build and probe rows spilled to disk, hashing to one partition
+   */
+  struct Partition {
+    std::string build_path;
+    std::string probe_path;
+    uint32_t level; // Partitioning passes its rows went through
+  };
+
+  static constexpr uint32_t EMPTY = UINT32_MAX;
+  static constexpr uint32_t PARTITION_BITS = 4;
+  static constexpr uint32_t MAX_LEVEL = 3;
+
+  size_t build_limit() const;
+  bool load(ExecutionContext &ctx, std::ifstream *in, bool limited);
+  bool must_spill(const ResultRow &row) const;
+  void index_rows();
+  void partition(ExecutionContext &ctx, std::ifstream *build_in,
+                 std::ifstream *probe_in, uint32_t level);
+  bool next_partition(ExecutionContext &ctx);
+  bool next_probe(ExecutionContext &ctx);
+  // Evaluate keys into probe_keys_ and hash them; false on a NULL key
+  bool hash_keys(const std::vector<const sql::Expression *> &keys,
+                 const ResultRow &row, uint64_t &hash);
+  bool keys_match(const ResultRow &build_row) const;
+  void join_rows(const ResultRow &build_row, ResultRow &row) const;
+  void pad(ResultRow &row) const;
+  void charge_build();
+  void release_build();
+  void remove_files();
+
+  std::unique_ptr<Operator> left_;
+  std::unique_ptr<Operator> right_;
+  sql::JoinType type_;
+  std::vector<const sql::Expression *> left_keys_;
+  std::vector<const sql::Expression *> right_keys_;
+  const sql::Expression *residual_;
+  const planner::Bindings &bindings_;
+  uint32_t left_width_;
+  uint32_t right_width_;
+  bool build_left_;
+  std::string spill_dir_;
+
+  size_t work_memory_{0};
+  std::unique_ptr<BuildMemory> build_;
+  memory::QueryAllocator *query_allocator_{nullptr};
+  size_t charged_{0}; // Build memory counted against the query budget
+
+  std::vector<Partition> pending_; // Partitions still to join
+  std::vector<std::string> files_; // Every spill file, removed on close
+  std::ifstream probe_in_;         // Probe rows of the current partition
+  bool probing_child_{false};      // Probe rows come from the operator
+
+  std::optional<ResultRow> input_; // In the query arena, reused per row
+  std::optional<ResultRow> probe_; // Current probe row
+  std::vector<Value> probe_keys_;
+  uint64_t probe_hash_{0};
+  uint32_t match_{EMPTY}; // Next candidate build row for the probe row
+  bool has_probe_{false};
+  bool matched_{false};
+  bool started_{false};
+};
+
+/**
+ * @brief Index nested-loop join
+ *
+ * Joins left rows to the rows of a table found through its primary key
+ * index, so the table is neither read whole nor hashed. Left rows are
+ * taken a batch at a time: the batch's keys are sorted and looked up in
+ * one pass over the index, and the rows they find are read in page
+ * order, each page once per batch. Rows then come out in left order.
+ * Output and matching follow HashJoinOperator.
+ */
+class IndexJoinOperator : public TableScanOperator {
+public:
+  /**
+   * @brief Finds the rows holding each of a sorted list of keys
+   */
+  using KeyLookup = std::function<void(const std::vector<int64_t> &,
+                                       std::vector<PrimaryKeyIndex::Match> &)>;
+
+  /**
+   * @param probe_key Key pair whose right key is the primary key
+   * @param inner_filter Predicate right rows must pass, or nullptr
+   * @param batch_size Left rows looked up at once
+   */
+  IndexJoinOperator(std::unique_ptr<Operator> left, uint32_t table_id,
+                    const std::string &table_name,
+                    storage::PageManager &page_manager,
+                    const planner::TableInfo *schema,
+                    std::vector<uint32_t> column_indices, KeyLookup lookup,
+                    sql::JoinType type,
+                    std::vector<const sql::Expression *> left_keys,
+                    std::vector<const sql::Expression *> right_keys,
+                    size_t probe_key, const sql::Expression *inner_filter,
+                    const sql::Expression *residual,
+                    const planner::Bindings &bindings, uint32_t left_width,
+                    uint32_t right_width, uint32_t batch_size);
+
+  void open(ExecutionContext &ctx) override;
+  bool next(ExecutionContext &ctx, ResultRow &row) override;
+  void close() override;
+  std::vector<std::string> column_names() const override;
+
+private:
+  static constexpr uint32_t NO_KEY = UINT32_MAX;
+
+  bool next_batch(ExecutionContext &ctx);
+  void fetch_matches(ExecutionContext &ctx);
+  bool keys_match(const ResultRow &left, const ResultRow &right) const;
+
+  std::unique_ptr<Operator> left_;
+  KeyLookup lookup_;
+  sql::JoinType type_;
+  std::vector<const sql::Expression *> left_keys_;
+  std::vector<const sql::Expression *> right_keys_;
+  size_t probe_key_;
+  const sql::Expression *inner_filter_;
+  const sql::Expression *residual_;
+  const planner::Bindings &bindings_;
+  uint32_t left_width_;
+  uint32_t right_width_;
+  uint32_t batch_size_;
+
+  // The current batch, in the query arena and reused across batches
+  std::optional<std::pmr::vector<ResultRow>> left_rows_;
+  std::optional<std::pmr::vector<ResultRow>> right_rows_; // By match
+  size_t batch_count_{0};
+  std::vector<std::pair<int64_t, uint32_t>> probes_; // Key, left row
+  std::vector<int64_t> keys_;                         // Distinct, sorted
+  std::vector<uint32_t> key_of_;       // Per left row, or NO_KEY
+  std::vector<PrimaryKeyIndex::Match> matches_;
+  std::vector<uint32_t> key_matches_;  // Per key, its first match
+  std::vector<uint32_t> fetch_order_;  // Matches in page order
+  std::vector<bool> found_;            // Per match: read and passed filter
+
+  size_t next_left_{0};   // Next left row of the batch to join
+  size_t current_left_{0};
+  uint32_t match_{0};     // Next match for the current left row
+  uint32_t match_end_{0};
+  bool pad_pending_{false};
+  bool matched_{false};
+};
+
+} // namespace executor
+} // namespace edgesql
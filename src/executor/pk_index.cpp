@@ -0,0 +1,99 @@
+/**
+ * @file pk_index.cpp
+ * @brief Primary key index implementation
+ */
+
+#include "pk_index.hpp"
+#include "executor.hpp"
+#include "../storage/pax_page.hpp"
+#include <algorithm>
+
+namespace edgesql {
+namespace executor {
+
+PrimaryKeyIndex PrimaryKeyIndex::build(storage::PageManager &page_manager,
+                                       uint32_t table_id, uint32_t column) {
+  PrimaryKeyIndex index;
+  storage::Record record;
+  uint32_t page_count = page_manager.table_page_count(table_id);
+  for (uint32_t page_id = 0; page_id < page_count; ++page_id) {
+    storage::PageGuard page =
+        pin_table_page(page_manager, table_id, page_id);
+    if (!page) {
+      continue;
+    }
+    std::shared_lock<std::shared_mutex> latch(page.latch());
+
+    if (storage::PaxPage::is_pax(*page)) {
+      storage::PaxPage pax(*page);
+      if (column >= pax.column_count()) {
+        continue;
+      }
+      const int64_t *keys = pax.int_values(column);
+      for (uint16_t r = 0; r < pax.row_count(); ++r) {
+        if (!pax.is_null(column, r)) {
+          index.insert(keys[r], storage::RowId{page_id, r});
+        }
+      }
+      continue;
+    }
+
+    for (uint16_t slot = 0; slot < page->slot_count(); ++slot) {
+      const uint8_t *data = nullptr;
+      uint16_t length = 0;
+      if (page->get_record(slot, &data, &length) &&
+          record.deserialize(data, length) &&
+          column < record.column_count() && !record.is_null(column)) {
+        index.insert(record.get_integer(column),
+                     storage::RowId{page_id, slot});
+      }
+    }
+  }
+  return index;
+}
+
+void PrimaryKeyIndex::insert(int64_t key, storage::RowId row) {
+  if (entries_.empty() || entries_.back().key <= key) {
+    entries_.push_back(Entry{key, row});
+    return;
+  }
+  auto at = std::upper_bound(
+      entries_.begin(), entries_.end(), key,
+      [](int64_t k, const Entry &entry) { return k < entry.key; });
+  entries_.insert(at, Entry{key, row});
+}
+
+std::vector<storage::RowId> PrimaryKeyIndex::lookup(int64_t lo,
+                                                    int64_t hi) const {
+  std::vector<storage::RowId> rows;
+  if (lo > hi) {
+    return rows;
+  }
+
+  auto first = std::lower_bound(
+      entries_.begin(), entries_.end(), lo,
+      [](const Entry &entry, int64_t k) { return entry.key < k; });
+  for (auto it = first; it != entries_.end() && it->key <= hi; ++it) {
+    rows.push_back(it->row);
+  }
+
+  // Page order reads each page once, however the keys are laid out
+  std::sort(rows.begin(), rows.end());
+  return rows;
+}
+
+void PrimaryKeyIndex::lookup_sorted(const std::vector<int64_t> &keys,
+                                    std::vector<Match> &out) const {
+  auto it = entries_.begin();
+  for (size_t i = 0; i < keys.size() && it != entries_.end(); ++i) {
+    it = std::lower_bound(
+        it, entries_.end(), keys[i],
+        [](const Entry &entry, int64_t k) { return entry.key < k; });
+    for (; it != entries_.end() && it->key == keys[i]; ++it) {
+      out.push_back(Match{static_cast<uint32_t>(i), it->row});
+    }
+  }
+}
+
+} // namespace executor
+} // namespace edgesql
@@ -0,0 +1,76 @@
+#pragma once
+
+/**
+ * @file pk_index.hpp
+ * @brief In-memory primary key index
+ */
+
+#include "../storage/page_manager.hpp"
+#include "../storage/record.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace edgesql {
+namespace executor {
+
+/**
+ * @brief Primary key index of one table
+ *
+ * Maps the values of an INTEGER primary key to the rows holding them,
+ * kept sorted by key. The index lives in memory only: it is built by one
+ * scan of the table when first needed and kept current by inserts.
+ *
+ * Not thread-safe; the executor serializes access.
+ */
+class PrimaryKeyIndex {
+public:
+  /**
+   * @brief A row holding one of the keys looked up
+   */
+  struct Match {
+    uint32_t key; // Position of the key in the lookup
+    storage::RowId row;
+  };
+
+  /**
+   * @brief Build the index by scanning a table's row and PAX pages
+   * @param column Key column
+   */
+  static PrimaryKeyIndex build(storage::PageManager &page_manager,
+                               uint32_t table_id, uint32_t column);
+
+  /**
+   * @brief Add a row; keys usually arrive in ascending order
+   */
+  void insert(int64_t key, storage::RowId row);
+
+  /**
+   * @brief Get the rows with keys in [lo, hi], in storage order
+   */
+  std::vector<storage::RowId> lookup(int64_t lo, int64_t hi) const;
+
+  /**
+   * @brief Find the rows holding each of a list of keys
+   *
+   * The keys must be ascending. Each search starts where the previous
+   * one ended, so a batch of keys costs about one search plus a pass
+   * over the part of the index they span.
+   *
+   * @param out Appended with the rows found, in key order
+   */
+  void lookup_sorted(const std::vector<int64_t> &keys,
+                     std::vector<Match> &out) const;
+
+  size_t size() const { return entries_.size(); }
+
+private:
+  struct Entry {
+    int64_t key;
+    storage::RowId row;
+  };
+
+  std::vector<Entry> entries_;
+};
+
+} // namespace executor
+} // namespace edgesql
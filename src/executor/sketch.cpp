@@ -0,0 +1,292 @@
+/**
+ * @file sketch.cpp
+ * @brief Approximate aggregate sketch implementation
+ */
+
+#include "sketch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace edgesql {
+namespace executor {
+
+namespace {
+
+using planner::HyperLogLog;
+
+constexpr double PI = 3.14159265358979323846;
+
+// Largest fraction of the values that may share a centroid starting at
+// quantile q, by the k1 scale k(q) = delta / (2 pi) * asin(2q - 1)
+double centroid_limit(double q) {
+  double delta = QuantileSketch::COMPRESSION;
+  double k = delta / (2.0 * PI) * std::asin(2.0 * std::clamp(q, 0.0, 1.0) -
+                                             1.0);
+  double next = std::min(k + 1.0, delta / 4.0);
+  return (std::sin(next * 2.0 * PI / delta) + 1.0) / 2.0;
+}
+
+} // anonymous namespace
+
+// DistinctSketch implementation
+
+void DistinctSketch::add(uint64_t hash) {
+  set(HyperLogLog::register_of(hash), HyperLogLog::rank_of(hash));
+}
+
+void DistinctSketch::merge(std::string_view other) {
+  if (other.empty()) {
+    return;
+  }
+  if (other[0] == SPARSE) {
+    for (size_t i = 1; i + 4 <= other.size(); i += 4) {
+      uint32_t entry;
+      std::memcpy(&entry, other.data() + i, sizeof(entry));
+      set(entry >> 8, static_cast<uint8_t>(entry & 0xFF));
+    }
+    return;
+  }
+
+  if (state_.empty()) {
+    state_.assign(other);
+    return;
+  }
+  densify();
+  auto *registers = reinterpret_cast<uint8_t *>(state_.data() + 1);
+  const auto *theirs = reinterpret_cast<const uint8_t *>(other.data() + 1);
+  for (size_t i = 0; i < REGISTERS; ++i) {
+    registers[i] = std::max(registers[i], theirs[i]);
+  }
+}
+
+double DistinctSketch::estimate() const {
+  if (state_.empty()) {
+    return 0.0;
+  }
+
+  // Registers missing from a sparse list are zero
+  double sum = 0.0;
+  size_t zeros = 0;
+  if (state_[0] == SPARSE) {
+    zeros = REGISTERS - sparse_entries();
+    sum = static_cast<double>(zeros);
+    for (size_t i = 0; i < sparse_entries(); ++i) {
+      sum += std::ldexp(1.0, -static_cast<int>(sparse_entry(i) & 0xFF));
+    }
+  } else {
+    const auto *registers =
+        reinterpret_cast<const uint8_t *>(state_.data() + 1);
+    for (size_t i = 0; i < REGISTERS; ++i) {
+      sum += std::ldexp(1.0, -registers[i]);
+      zeros += registers[i] == 0;
+    }
+  }
+  return HyperLogLog::cardinality(sum, zeros);
+}
+
+void DistinctSketch::set(size_t index, uint8_t rank) {
+  if (state_.empty()) {
+    state_.push_back(SPARSE);
+  }
+  if (state_[0] == DENSE) {
+    auto &r = reinterpret_cast<uint8_t &>(state_[1 + index]);
+    r = std::max(r, rank);
+    return;
+  }
+
+  size_t lo = 0;
+  size_t hi = sparse_entries();
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if ((sparse_entry(mid) >> 8) < index) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+
+  uint32_t entry = static_cast<uint32_t>(index) << 8 | rank;
+  if (lo < sparse_entries() && sparse_entry(lo) >> 8 == index) {
+    if ((sparse_entry(lo) & 0xFF) < rank) {
+      std::memcpy(state_.data() + 1 + lo * 4, &entry, sizeof(entry));
+    }
+    return;
+  }
+  if (sparse_entries() == SPARSE_LIMIT) {
+    densify();
+    set(index, rank);
+    return;
+  }
+  char bytes[sizeof(entry)];
+  std::memcpy(bytes, &entry, sizeof(entry));
+  state_.insert(1 + lo * 4, bytes, sizeof(bytes));
+}
+
+void DistinctSketch::densify() {
+  if (!state_.empty() && state_[0] == DENSE) {
+    return;
+  }
+
+  uint32_t entries[SPARSE_LIMIT];
+  size_t count = state_.empty() ? 0 : sparse_entries();
+  for (size_t i = 0; i < count; ++i) {
+    entries[i] = sparse_entry(i);
+  }
+  state_.assign(MAX_BYTES, '\0');
+  state_[0] = DENSE;
+  for (size_t i = 0; i < count; ++i) {
+    state_[1 + (entries[i] >> 8)] = static_cast<char>(entries[i] & 0xFF);
+  }
+}
+
+uint32_t DistinctSketch::sparse_entry(size_t i) const {
+  uint32_t entry;
+  std::memcpy(&entry, state_.data() + 1 + i * 4, sizeof(entry));
+  return entry;
+}
+
+// QuantileSketch implementation
+
+void QuantileSketch::add(double value) {
+  if (std::isnan(value)) {
+    return;
+  }
+
+  Header h{0.0, value, value, 0, 0};
+  if (state_.empty()) {
+    state_.assign(sizeof(Header), '\0');
+  } else {
+    h = header(state_);
+  }
+  h.count += 1.0;
+  h.min = std::min(h.min, value);
+  h.max = std::max(h.max, value);
+  h.buffered++;
+
+  char bytes[sizeof(value)];
+  std::memcpy(bytes, &value, sizeof(value));
+  state_.append(bytes, sizeof(bytes));
+  std::memcpy(state_.data(), &h, sizeof(h));
+
+  if (h.buffered >= BUFFER_SIZE) {
+    scratch_.clear();
+    gather(state_, scratch_);
+    fold(h);
+  }
+}
+
+void QuantileSketch::merge(std::string_view other) {
+  if (other.empty()) {
+    return;
+  }
+  if (state_.empty()) {
+    state_.assign(other);
+    return;
+  }
+
+  Header h = header(state_);
+  Header theirs = header(other);
+  h.count += theirs.count;
+  h.min = std::min(h.min, theirs.min);
+  h.max = std::max(h.max, theirs.max);
+
+  scratch_.clear();
+  gather(state_, scratch_);
+  gather(other, scratch_);
+  fold(h);
+}
+
+double QuantileSketch::quantile(double fraction) const {
+  if (state_.empty()) {
+    return std::nan("");
+  }
+
+  Header h = header(state_);
+  scratch_.clear();
+  gather(state_, scratch_);
+  std::sort(scratch_.begin(), scratch_.end(),
+            [](const Centroid &a, const Centroid &b) {
+              return a.mean < b.mean;
+            });
+
+  // The CDF is taken to run straight from the minimum to the first
+  // centroid's midpoint, between midpoints, and on to the maximum
+  double target = std::clamp(fraction, 0.0, 1.0) * h.count;
+  double prev_rank = 0.0;
+  double prev_value = h.min;
+  double seen = 0.0;
+  for (const Centroid &centroid : scratch_) {
+    double rank = seen + centroid.weight / 2.0;
+    if (target <= rank) {
+      return prev_value + (target - prev_rank) / (rank - prev_rank) *
+                              (centroid.mean - prev_value);
+    }
+    prev_rank = rank;
+    prev_value = centroid.mean;
+    seen += centroid.weight;
+  }
+  return prev_value + (target - prev_rank) / (h.count - prev_rank) *
+                          (h.max - prev_value);
+}
+
+QuantileSketch::Header QuantileSketch::header(std::string_view state) {
+  Header h;
+  std::memcpy(&h, state.data(), sizeof(h));
+  return h;
+}
+
+void QuantileSketch::gather(std::string_view state, Scratch &out) {
+  Header h = header(state);
+  const char *at = state.data() + sizeof(Header);
+  for (uint32_t i = 0; i < h.centroids; ++i, at += sizeof(Centroid)) {
+    Centroid centroid;
+    std::memcpy(&centroid, at, sizeof(centroid));
+    out.push_back(centroid);
+  }
+  for (uint32_t i = 0; i < h.buffered; ++i, at += sizeof(double)) {
+    double value;
+    std::memcpy(&value, at, sizeof(value));
+    out.push_back(Centroid{value, 1.0});
+  }
+}
+
+void QuantileSketch::fold(Header h) {
+  std::sort(scratch_.begin(), scratch_.end(),
+            [](const Centroid &a, const Centroid &b) {
+              return a.mean < b.mean;
+            });
+
+  // One pass in value order, merging neighbours while the centroid stays
+  // within the weight its quantile allows
+  size_t out = 0;
+  if (!scratch_.empty()) {
+    double before = 0.0; // Weight of the centroids already written
+    double limit = h.count * centroid_limit(0.0);
+    Centroid current = scratch_[0];
+    for (size_t i = 1; i < scratch_.size(); ++i) {
+      Centroid next = scratch_[i];
+      if (before + current.weight + next.weight <= limit) {
+        current.weight += next.weight;
+        current.mean +=
+            (next.mean - current.mean) * next.weight / current.weight;
+        continue;
+      }
+      before += current.weight;
+      scratch_[out++] = current;
+      limit = h.count * centroid_limit(before / h.count);
+      current = next;
+    }
+    scratch_[out++] = current;
+  }
+
+  h.centroids = static_cast<uint32_t>(out);
+  h.buffered = 0;
+  state_.resize(sizeof(Header) + out * sizeof(Centroid));
+  std::memcpy(state_.data(), &h, sizeof(h));
+  std::memcpy(state_.data() + sizeof(Header), scratch_.data(),
+              out * sizeof(Centroid));
+}
+
+} // namespace executor
+} // namespace edgesql
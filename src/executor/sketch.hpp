@@ -0,0 +1,141 @@
+#pragma once
+
+/**
+ * @file sketch.hpp
+ * @brief Fixed-size sketches for approximate aggregates
+ */
+
+#include "../planner/statistics.hpp"
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace edgesql {
+namespace executor {
+
+/**
+ * @brief HyperLogLog distinct-value sketch kept in a byte string
+ *
+ * A view over an aggregate's state, so the sketch lives in its group's
+ * slot and in the query arena. The registers and estimate are those of
+ * planner::HyperLogLog. The state starts sparse, as a sorted list of the
+ * registers set so far, and turns dense, one byte per register, once
+ * the list would pass SPARSE_LIMIT entries. An empty string is an empty
+ * sketch; sketches merge in either form.
+ *
+ * Sparse layout: 'S', then per set register index << 8 | rank (uint32)
+ * Dense layout:  'D', then REGISTERS ranks
+ */
+class DistinctSketch {
+public:
+  static constexpr size_t REGISTERS = planner::HyperLogLog::REGISTERS;
+  static constexpr size_t SPARSE_LIMIT = REGISTERS / 16;
+  static constexpr size_t MAX_BYTES = 1 + REGISTERS;
+
+  explicit DistinctSketch(std::pmr::string &state) : state_(state) {}
+
+  /**
+   * @brief Add a value by its 64-bit hash
+   */
+  void add(uint64_t hash);
+
+  /**
+   * @brief Fold another sketch's state into this one
+   */
+  void merge(std::string_view other);
+
+  /**
+   * @brief Estimate the number of distinct values added
+   */
+  double estimate() const;
+
+private:
+  static constexpr char SPARSE = 'S';
+  static constexpr char DENSE = 'D';
+
+  void set(size_t index, uint8_t rank);
+  void densify();
+  size_t sparse_entries() const { return (state_.size() - 1) / 4; }
+  uint32_t sparse_entry(size_t i) const;
+
+  std::pmr::string &state_;
+};
+
+/**
+ * @brief Merging t-digest quantile sketch kept in a byte string
+ *
+ * Like DistinctSketch, a view over an aggregate's state. Values are
+ * buffered, then folded into centroids whose weight is bounded by the
+ * k1 scale function: small near the tails, where quantiles are read
+ * most precisely, larger in the middle. With COMPRESSION 100 the state
+ * stays near 2KB however many values are added. An empty string is an
+ * empty sketch; sketches merge by folding their centroids together.
+ *
+ * Layout: Header, then centroids (mean, weight), then buffered values.
+ *
+ * Folding sorts the points in a caller-owned scratch vector, reused
+ * across calls.
+ */
+class QuantileSketch {
+public:
+  static constexpr double COMPRESSION = 100.0;
+  static constexpr uint32_t BUFFER_SIZE = 64;
+
+  struct Centroid {
+    double mean;
+    double weight;
+  };
+  using Scratch = std::vector<Centroid>;
+
+  // Centroids come to about COMPRESSION at most, plus the buffer
+  static constexpr size_t MAX_BYTES =
+      32 + static_cast<size_t>(COMPRESSION) * sizeof(Centroid) +
+      BUFFER_SIZE * sizeof(double);
+
+  QuantileSketch(std::pmr::string &state, Scratch &scratch)
+      : state_(state), scratch_(scratch) {}
+
+  /**
+   * @brief Add a value; NaN is ignored
+   */
+  void add(double value);
+
+  /**
+   * @brief Fold another sketch's state into this one
+   */
+  void merge(std::string_view other);
+
+  /**
+   * @brief Check whether any value was added
+   */
+  bool empty() const { return state_.empty(); }
+
+  /**
+   * @brief Estimate the value at a fraction of the way through the
+   *        sorted values, interpolating between centroids
+   * @param fraction In [0, 1]; 0 is the minimum, 1 the maximum
+   */
+  double quantile(double fraction) const;
+
+private:
+  struct Header {
+    double count;
+    double min;
+    double max;
+    uint32_t centroids;
+    uint32_t buffered;
+  };
+  static_assert(sizeof(Header) == 32);
+
+  static Header header(std::string_view state);
+  static void gather(std::string_view state, Scratch &out);
+  void fold(Header header);
+
+  std::pmr::string &state_;
+  Scratch &scratch_;
+};
+
+} // namespace executor
+} // namespace edgesql
@@ -0,0 +1,115 @@
+/**
+ * @file spill.cpp
+ * @brief Spill file implementation
+ */
+
+#include "spill.hpp"
+#include <atomic>
+#include <unistd.h>
+
+namespace edgesql {
+namespace executor {
+
+namespace {
+
+// Allocation slack per row for alignment padding
+constexpr size_t ROW_SLACK_BYTES = 64;
+
+std::atomic<uint64_t> next_spill_id{0};
+
+} // anonymous namespace
+
+size_t row_footprint(const ResultRow &row) {
+  size_t bytes = row.values.size() * sizeof(sql::Literal) + ROW_SLACK_BYTES;
+  for (const auto &value : row.values) {
+    // Strings beyond the small-string buffer need their own allocation
+    if (value.string_value.size() >= sizeof(std::pmr::string)) {
+      bytes += value.string_value.size() + 1;
+    }
+  }
+  return bytes;
+}
+
+void write_row(std::ofstream &out, const ResultRow &row) {
+  uint32_t count = static_cast<uint32_t>(row.values.size());
+  out.write(reinterpret_cast<const char *>(&count), sizeof(count));
+
+  for (const auto &value : row.values) {
+    uint8_t type = static_cast<uint8_t>(value.type);
+    out.write(reinterpret_cast<const char *>(&type), sizeof(type));
+
+    switch (value.type) {
+    case sql::Literal::Type::NULL_VAL:
+      break;
+    case sql::Literal::Type::INTEGER:
+      out.write(reinterpret_cast<const char *>(&value.int_value),
+                sizeof(value.int_value));
+      break;
+    case sql::Literal::Type::FLOAT:
+      out.write(reinterpret_cast<const char *>(&value.float_value),
+                sizeof(value.float_value));
+      break;
+    case sql::Literal::Type::STRING: {
+      uint32_t length = static_cast<uint32_t>(value.string_value.size());
+      out.write(reinterpret_cast<const char *>(&length), sizeof(length));
+      out.write(value.string_value.data(), length);
+      break;
+    }
+    case sql::Literal::Type::BOOLEAN: {
+      uint8_t flag = value.bool_value ? 1 : 0;
+      out.write(reinterpret_cast<const char *>(&flag), sizeof(flag));
+      break;
+    }
+    }
+  }
+}
+
+bool read_row(std::ifstream &in, ResultRow &row) {
+  uint32_t count = 0;
+  if (!in.read(reinterpret_cast<char *>(&count), sizeof(count))) {
+    return false;
+  }
+
+  row.values.resize(count);
+  for (auto &value : row.values) {
+    uint8_t type = 0;
+    in.read(reinterpret_cast<char *>(&type), sizeof(type));
+    value.type = static_cast<sql::Literal::Type>(type);
+
+    switch (value.type) {
+    case sql::Literal::Type::NULL_VAL:
+      break;
+    case sql::Literal::Type::INTEGER:
+      in.read(reinterpret_cast<char *>(&value.int_value),
+              sizeof(value.int_value));
+      break;
+    case sql::Literal::Type::FLOAT:
+      in.read(reinterpret_cast<char *>(&value.float_value),
+              sizeof(value.float_value));
+      break;
+    case sql::Literal::Type::STRING: {
+      uint32_t length = 0;
+      in.read(reinterpret_cast<char *>(&length), sizeof(length));
+      value.string_value.resize(length);
+      in.read(value.string_value.data(), length);
+      break;
+    }
+    case sql::Literal::Type::BOOLEAN: {
+      uint8_t flag = 0;
+      in.read(reinterpret_cast<char *>(&flag), sizeof(flag));
+      value.bool_value = flag != 0;
+      break;
+    }
+    }
+  }
+
+  return static_cast<bool>(in);
+}
+
+std::string spill_path(const std::string &dir, const char *kind) {
+  return dir + "/" + kind + "_" + std::to_string(::getpid()) + "_" +
+         std::to_string(next_spill_id.fetch_add(1)) + ".run";
+}
+
+} // namespace executor
+} // namespace edgesql
@@ -0,0 +1,42 @@
+#pragma once
+
+/**
+ * @file spill.hpp
+ * @brief Rows spilled to disk by operators that outgrow their memory
+ */
+
+#include "executor.hpp"
+#include <fstream>
+#include <string>
+
+namespace edgesql {
+namespace executor {
+
+/**
+ * @brief Estimate the arena bytes needed to copy a row into a buffer
+ */
+size_t row_footprint(const ResultRow &row);
+
+/**
+ * @brief Append a row to a spill file
+ */
+void write_row(std::ofstream &out, const ResultRow &row);
+
+/**
+ * @brief Read the next row of a spill file
+ *
+ * Reads in place, so the row's storage is reused across calls.
+ *
+ * @return false at the end of the file
+ */
+bool read_row(std::ifstream &in, ResultRow &row);
+
+/**
+ * @brief Path for a new spill file, unique within the process and
+ *        across processes sharing the directory
+ * @param kind Operator writing it, e.g. "sort"
+ */
+std::string spill_path(const std::string &dir, const char *kind);
+
+} // namespace executor
+} // namespace edgesql
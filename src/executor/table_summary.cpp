@@ -0,0 +1,138 @@
+/**
+ * @file table_summary.cpp
+ * @brief Table summary implementation
+ */
+
+#include "table_summary.hpp"
+#include "../storage/encoded_page.hpp"
+#include "../storage/pax_page.hpp"
+#include <algorithm>
+
+namespace edgesql {
+namespace executor {
+
+namespace {
+
+void add_encoded(TableSummary &summary, const storage::Page &page) {
+  storage::EncodedPage encoded(page);
+  uint32_t rows = encoded.row_count();
+  summary.rows += rows;
+
+  std::vector<int64_t> ints;
+  std::vector<double> floats;
+  size_t width = std::min<size_t>(encoded.column_count(),
+                                  summary.columns.size());
+  for (size_t col = 0; col < width; ++col) {
+    ColumnSummary &column = summary.columns[col];
+    storage::ColumnType type = encoded.column_type(col);
+    if (type == storage::ColumnType::INTEGER) {
+      ints.resize(rows);
+      encoded.decode_ints(col, ints.data());
+      for (uint32_t r = 0; r < rows; ++r) {
+        if (!encoded.is_null(col, r)) {
+          column.add_integer(ints[r]);
+        }
+      }
+    } else if (type == storage::ColumnType::FLOAT) {
+      floats.resize(rows);
+      encoded.decode_floats(col, floats.data());
+      for (uint32_t r = 0; r < rows; ++r) {
+        if (!encoded.is_null(col, r)) {
+          column.add_float(floats[r]);
+        }
+      }
+    } else {
+      for (uint32_t r = 0; r < rows; ++r) {
+        column.values += !encoded.is_null(col, r);
+      }
+    }
+  }
+}
+
+void add_pax(TableSummary &summary, const storage::Page &page) {
+  storage::PaxPage pax(page);
+  uint16_t rows = pax.row_count();
+  summary.rows += rows;
+
+  size_t width = std::min<size_t>(pax.column_count(), summary.columns.size());
+  for (size_t col = 0; col < width; ++col) {
+    ColumnSummary &column = summary.columns[col];
+    storage::ColumnType type = pax.column_type(col);
+    for (uint16_t r = 0; r < rows; ++r) {
+      if (pax.is_null(col, r)) {
+        continue;
+      }
+      if (type == storage::ColumnType::INTEGER) {
+        column.add_integer(pax.int_values(col)[r]);
+      } else if (type == storage::ColumnType::FLOAT) {
+        column.add_float(pax.float_values(col)[r]);
+      } else {
+        column.values++;
+      }
+    }
+  }
+}
+
+} // anonymous namespace
+
+void ColumnSummary::merge(const ColumnSummary &other) {
+  values += other.values;
+  int_min = std::min(int_min, other.int_min);
+  int_max = std::max(int_max, other.int_max);
+  float_min = std::min(float_min, other.float_min);
+  float_max = std::max(float_max, other.float_max);
+}
+
+void TableSummary::add(const storage::Record &record) {
+  rows++;
+  size_t width = std::min(record.column_count(), columns.size());
+  for (size_t col = 0; col < width; ++col) {
+    if (record.is_null(col)) {
+      continue;
+    }
+    switch (record.get_type(col)) {
+    case storage::ColumnType::INTEGER:
+      columns[col].add_integer(record.get_integer(col));
+      break;
+    case storage::ColumnType::FLOAT:
+      columns[col].add_float(record.get_float(col));
+      break;
+    default:
+      columns[col].values++;
+      break;
+    }
+  }
+}
+
+void TableSummary::add_page(const storage::Page &page,
+                            storage::Record &record) {
+  if (storage::EncodedPage::is_encoded(page)) {
+    add_encoded(*this, page);
+    return;
+  }
+  if (storage::PaxPage::is_pax(page)) {
+    add_pax(*this, page);
+    return;
+  }
+
+  // Deleted slots hold no record
+  for (uint16_t slot = 0; slot < page.slot_count(); ++slot) {
+    const uint8_t *data = nullptr;
+    uint16_t length = 0;
+    if (page.get_record(slot, &data, &length) &&
+        record.deserialize(data, length)) {
+      add(record);
+    }
+  }
+}
+
+void TableSummary::merge(const TableSummary &other) {
+  rows += other.rows;
+  size_t width = std::min(columns.size(), other.columns.size());
+  for (size_t col = 0; col < width; ++col) {
+    columns[col].merge(other.columns[col]);
+  }
+}
+
+} // namespace executor
+} // namespace edgesql
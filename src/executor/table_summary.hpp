@@ -0,0 +1,73 @@
+#pragma once
+
+/**
+ * @file table_summary.hpp
+ * @brief Row counts and value ranges kept per table and segment
+ */
+
+#include "../storage/page.hpp"
+#include "../storage/record.hpp"
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace edgesql {
+namespace executor {
+
+/**
+ * @brief Count and range of one column's non-NULL values
+ *
+ * The range is kept for INTEGER and FLOAT values; other types are only
+ * counted.
+ */
+struct ColumnSummary {
+  uint64_t values{0};
+  int64_t int_min{INT64_MAX};
+  int64_t int_max{INT64_MIN};
+  double float_min{std::numeric_limits<double>::infinity()};
+  double float_max{-std::numeric_limits<double>::infinity()};
+
+  void add_integer(int64_t value) {
+    values++;
+    int_min = value < int_min ? value : int_min;
+    int_max = value > int_max ? value : int_max;
+  }
+
+  void add_float(double value) {
+    values++;
+    float_min = value < float_min ? value : float_min;
+    float_max = value > float_max ? value : float_max;
+  }
+
+  void merge(const ColumnSummary &other);
+};
+
+/**
+ * @brief Live row count and per-column summaries of a set of rows
+ *
+ * Tables only grow by appends, so a summary kept current by inserts is
+ * exact: the live row count and the true extremes, not bounds.
+ */
+struct TableSummary {
+  uint64_t rows{0};
+  std::vector<ColumnSummary> columns; // By column index
+
+  TableSummary() = default;
+  explicit TableSummary(size_t column_count) : columns(column_count) {}
+
+  /**
+   * @brief Count an inserted row
+   */
+  void add(const storage::Record &record);
+
+  /**
+   * @brief Count the live rows of a row, PAX or encoded page
+   * @param record Decode buffer for row-layout pages
+   */
+  void add_page(const storage::Page &page, storage::Record &record);
+
+  void merge(const TableSummary &other);
+};
+
+} // namespace executor
+} // namespace edgesql
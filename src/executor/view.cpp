@@ -0,0 +1,286 @@
+/**
+ * @file view.cpp
+ * @brief Materialized view maintenance implementation
+ */
+
+#include "view.hpp"
+#include <stdexcept>
+
+namespace edgesql {
+namespace executor {
+
+namespace {
+
+using planner::AggregateType;
+using Type = sql::Literal::Type;
+
+// A stored column's value; strings view the record
+Value value_of(const storage::Record &record, size_t index) {
+  Value value;
+  if (record.is_null(index)) {
+    return value;
+  }
+  switch (record.get_type(index)) {
+  case storage::ColumnType::INTEGER:
+    return Value::integer(record.get_integer(index));
+  case storage::ColumnType::FLOAT:
+    return Value::floating(record.get_float(index));
+  case storage::ColumnType::BOOLEAN:
+    return Value::boolean(record.get_boolean(index));
+  case storage::ColumnType::TEXT:
+    value.type = Type::STRING;
+    value.string_value = record.get_text(index);
+    return value;
+  case storage::ColumnType::BLOB: {
+    const auto &blob = record.get_blob(index);
+    value.type = Type::STRING;
+    value.string_value = std::string_view(
+        reinterpret_cast<const char *>(blob.data()), blob.size());
+    return value;
+  }
+  case storage::ColumnType::NULLTYPE:
+    break;
+  }
+  return value;
+}
+
+// Store a value in a view column of the given type
+void set_column(storage::Record &record, size_t index, const Value &value,
+                storage::ColumnType type, const std::string &name) {
+  if (value.is_null()) {
+    record.set_null(index);
+    return;
+  }
+  switch (type) {
+  case storage::ColumnType::INTEGER:
+    if (value.type == Type::INTEGER) {
+      record.set_integer(index, value.int_value);
+      return;
+    }
+    break;
+  case storage::ColumnType::FLOAT:
+    if (value.type == Type::INTEGER || value.type == Type::FLOAT) {
+      record.set_float(index, value.type == Type::INTEGER
+                                  ? static_cast<double>(value.int_value)
+                                  : value.float_value);
+      return;
+    }
+    break;
+  case storage::ColumnType::BOOLEAN:
+    if (value.type == Type::BOOLEAN) {
+      record.set_boolean(index, value.bool_value);
+      return;
+    }
+    break;
+  case storage::ColumnType::TEXT:
+    if (value.type == Type::STRING) {
+      record.set_text(index, std::string(value.string_value));
+      return;
+    }
+    break;
+  default:
+    break;
+  }
+  throw std::runtime_error("Type mismatch for view column: " + name);
+}
+
+void append_bytes(std::string &out, const void *data, size_t size) {
+  out.append(static_cast<const char *>(data), size);
+}
+
+} // anonymous namespace
+
+ViewDelta::ViewDelta(const planner::MaterializedView &view,
+                     const planner::TableInfo &view_table, Lookup lookup)
+    : view_(view), lookup_(std::move(lookup)) {
+  for (const auto &column : view_table.columns) {
+    types_.push_back(column.type);
+    names_.push_back(column.name);
+  }
+
+  // AVG keeps a sum and a count
+  folds_.assign(types_.size() - view_.keys.size(), Fold::COUNT);
+  for (size_t i = 0; i < view_.aggregates.size(); ++i) {
+    size_t state = view_.state_columns[i] - view_.keys.size();
+    switch (view_.aggregates[i].type) {
+    case AggregateType::SUM:
+    case AggregateType::AVG:
+      folds_[state] = Fold::SUM;
+      break;
+    case AggregateType::MIN:
+      folds_[state] = Fold::MIN;
+      break;
+    case AggregateType::MAX:
+      folds_[state] = Fold::MAX;
+      break;
+    default:
+      break;
+    }
+  }
+
+  keys_ = storage::Record(view_.keys.size());
+  inputs_.resize(types_.size());
+  states_.resize(types_.size());
+}
+
+void ViewDelta::prepare(const storage::Record &record) {
+  row_.values.resize(record.column_count());
+  for (size_t i = 0; i < record.column_count(); ++i) {
+    assign(row_.values[i], value_of(record, i));
+  }
+  prepare(row_);
+}
+
+void ViewDelta::prepare(const ResultRow &row) {
+  for (size_t i = 0; i < view_.keys.size(); ++i) {
+    set_column(keys_, i, evaluate(*view_.keys[i], row, *view_.bindings),
+               types_[i], names_[i]);
+  }
+  key_ = group_key(keys_, view_.keys.size());
+
+  // COUNT counts a row, or a non-NULL argument; the other aggregates take
+  // the argument's value, and AVG both
+  for (size_t i = 0; i < view_.aggregates.size(); ++i) {
+    const planner::AggregateExpr &aggregate = view_.aggregates[i];
+    uint32_t state = view_.state_columns[i];
+    Value value = aggregate.arg
+                      ? evaluate(*aggregate.arg, row, *view_.bindings)
+                      : Value::integer(1);
+    Value counted = Value::integer(value.is_null() ? 0 : 1);
+    switch (aggregate.type) {
+    case AggregateType::COUNT:
+      inputs_[state] = counted;
+      break;
+    case AggregateType::AVG:
+      inputs_[state] = value;
+      inputs_[state + 1] = counted;
+      break;
+    default:
+      inputs_[state] = value;
+      break;
+    }
+  }
+
+  auto group = groups_.find(key_);
+  new_group_ = group == groups_.end();
+  if (!new_group_) {
+    fold(group->second);
+    return;
+  }
+
+  // A group the view has no row for starts with zero counts and NULL
+  // otherwise
+  if (!lookup_(key_, start_)) {
+    start_ = storage::Record(types_.size());
+    for (size_t i = 0; i < view_.keys.size(); ++i) {
+      start_.get_value(i) = keys_.get_value(i);
+    }
+    for (size_t i = view_.keys.size(); i < types_.size(); ++i) {
+      if (folds_[i - view_.keys.size()] == Fold::COUNT) {
+        start_.set_integer(i, 0);
+      }
+    }
+  }
+  fold(start_);
+}
+
+void ViewDelta::apply() {
+  storage::Record &record =
+      new_group_ ? groups_.emplace(key_, start_).first->second
+                 : groups_.find(key_)->second;
+  for (size_t i = view_.keys.size(); i < types_.size(); ++i) {
+    set_column(record, i, states_[i], types_[i], names_[i]);
+  }
+}
+
+void ViewDelta::fold(const storage::Record &current) {
+  for (size_t i = view_.keys.size(); i < types_.size(); ++i) {
+    const Value &input = inputs_[i];
+    Value &state = states_[i];
+    state = value_of(current, i);
+    if (input.is_null()) {
+      continue;
+    }
+
+    switch (folds_[i - view_.keys.size()]) {
+    case Fold::COUNT:
+      state = Value::integer(state.int_value + input.int_value);
+      break;
+    case Fold::SUM:
+      if (input.type != Type::INTEGER && input.type != Type::FLOAT) {
+        throw std::runtime_error("SUM and AVG need numeric values");
+      }
+      if (types_[i] == storage::ColumnType::INTEGER) {
+        if (input.type != Type::INTEGER) {
+          throw std::runtime_error("Type mismatch for view column: " +
+                                   names_[i]);
+        }
+        int64_t sum = 0;
+        if (!state.is_null() &&
+            __builtin_add_overflow(state.int_value, input.int_value, &sum)) {
+          throw std::runtime_error("Integer overflow");
+        }
+        state = state.is_null() ? input : Value::integer(sum);
+      } else {
+        double value = input.type == Type::INTEGER
+                           ? static_cast<double>(input.int_value)
+                           : input.float_value;
+        state = Value::floating(state.is_null() ? value
+                                                : state.float_value + value);
+      }
+      break;
+    case Fold::MIN:
+    case Fold::MAX: {
+      if (state.is_null()) {
+        state = input;
+        break;
+      }
+      int order = compare_values(input, state);
+      if (folds_[i - view_.keys.size()] == Fold::MIN ? order < 0
+                                                     : order > 0) {
+        state = input;
+      }
+      break;
+    }
+    }
+  }
+}
+
+std::string ViewDelta::group_key(const storage::Record &row, size_t keys) {
+  // A type tag, then the value; every row of a view has the same types,
+  // so tags only tell NULL apart and lengths keep texts apart
+  std::string key;
+  for (size_t i = 0; i < keys; ++i) {
+    Value value = value_of(row, i);
+    switch (value.type) {
+    case Type::NULL_VAL:
+      key.push_back('N');
+      break;
+    case Type::INTEGER:
+      key.push_back('I');
+      append_bytes(key, &value.int_value, sizeof(value.int_value));
+      break;
+    case Type::FLOAT: {
+      // -0.0 groups with 0.0
+      double number = value.float_value == 0.0 ? 0.0 : value.float_value;
+      key.push_back('F');
+      append_bytes(key, &number, sizeof(number));
+      break;
+    }
+    case Type::BOOLEAN:
+      key.push_back(value.bool_value ? '1' : '0');
+      break;
+    case Type::STRING: {
+      uint32_t length = static_cast<uint32_t>(value.string_value.size());
+      key.push_back('S');
+      append_bytes(key, &length, sizeof(length));
+      key.append(value.string_value);
+      break;
+    }
+    }
+  }
+  return key;
+}
+
+} // namespace executor
+} // namespace edgesql
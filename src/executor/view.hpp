@@ -0,0 +1,99 @@
+#pragma once
+
+/**
+ * @file view.hpp
+ * @brief Materialized view maintenance
+ */
+
+#include "../planner/catalog.hpp"
+#include "../planner/plan.hpp"
+#include "../storage/record.hpp"
+#include "executor.hpp"
+#include "expression.hpp"
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace edgesql {
+namespace executor {
+
+/**
+ * @brief Changes to a materialized view, one state row per group
+ *
+ * Base table rows are folded into a state row per group, laid out like
+ * the view's rows: the group keys, then each aggregate's state. A group
+ * starts from the row the view stores for it, so the delta holds the
+ * groups' new rows, each written back once however many rows reached
+ * it. A view is populated the same way, from the whole table.
+ *
+ * Folding a row is split in two so a row is taken by every view or by
+ * none: prepare() evaluates everything that can fail, overflow of the
+ * stored sums included, and apply() only writes the result.
+ */
+class ViewDelta {
+public:
+  /**
+   * @brief Reads the view's stored row for an encoded group key
+   * @return false if the view has no row for the group
+   */
+  using Lookup = std::function<bool(const std::string &, storage::Record &)>;
+
+  ViewDelta(const planner::MaterializedView &view,
+            const planner::TableInfo &view_table, Lookup lookup);
+
+  /**
+   * @brief Evaluate a base table row's group and new states
+   * @param row The row's values, in table column order
+   * @throws std::runtime_error on type errors and integer overflow, as
+   *         evaluate() and SUM do
+   */
+  void prepare(const ResultRow &row);
+  void prepare(const storage::Record &record);
+
+  /**
+   * @brief Fold the prepared row into its group
+   */
+  void apply();
+
+  /**
+   * @brief Encode a view row's leading keys; one group's rows encode
+   *        equally
+   */
+  static std::string group_key(const storage::Record &row, size_t keys);
+
+  const planner::MaterializedView &view() const { return view_; }
+
+  /**
+   * @brief New rows of the groups changed, by encoded group key
+   */
+  const std::unordered_map<std::string, storage::Record> &groups() const {
+    return groups_;
+  }
+
+private:
+  // How a state column combines values
+  enum class Fold { COUNT, SUM, MIN, MAX };
+
+  void fold(const storage::Record &current);
+
+  const planner::MaterializedView &view_;
+  Lookup lookup_;
+  std::vector<storage::ColumnType> types_; // Of the view's columns
+  std::vector<std::string> names_;
+  std::vector<Fold> folds_; // By state column, after the keys
+
+  std::unordered_map<std::string, storage::Record> groups_;
+
+  // The prepared row: its group, and its new states by state column
+  ResultRow row_; // A stored record's values
+  storage::Record keys_;
+  std::string key_;
+  storage::Record start_; // The group's row before the delta, if new
+  bool new_group_{false};
+  std::vector<Value> inputs_;
+  std::vector<Value> states_;
+};
+
+} // namespace executor
+} // namespace edgesql
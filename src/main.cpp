@@ -9,6 +9,8 @@
 #include "core/signal_handler.hpp"
 #include "core/thread_pool.hpp"
 #include "edgesql/config.hpp"
+#include "memory/arena_pool.hpp"
+#include "memory/memory_tracker.hpp"
 #include "server/listener.hpp"
 
 #include <cstdlib>
@@ -104,6 +106,19 @@ int main(int argc, char *argv[]) {
   // Parse command line arguments
   edgesql::Config config = parse_args(argc, argv);
 
+  // Memory limits and per-worker arena pools (before workers start)
+  edgesql::memory::MemoryTracker::instance().set_limit(
+      config.memory.global_limit_bytes);
+  edgesql::memory::MemoryTracker::instance().set_pressure_percent(
+      config.memory.pressure_percent);
+
+  edgesql::memory::ArenaPoolConfig arena_config;
+  arena_config.max_idle_arenas = config.memory.arena_pool_size;
+  arena_config.block_size = config.memory.arena_block_size;
+  arena_config.retain_bytes = config.memory.arena_retain_bytes;
+  arena_config.idle_timeout = config.memory.arena_idle_timeout;
+  edgesql::memory::ArenaPool::set_default_config(arena_config);
+
   // Install signal handlers
   edgesql::core::SignalHandler::install();
 
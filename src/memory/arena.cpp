@@ -4,6 +4,7 @@
  */
 
 #include "arena.hpp"
+#include "memory_tracker.hpp"
 #include <cstring>
 #include <stdexcept>
 
@@ -11,12 +12,14 @@ namespace edgesql {
 namespace memory {
 
 Arena::Arena(size_t block_size) : block_size_(block_size) {
-  // Pre-allocate first block
+  // Pre-allocate first block; under memory pressure the first allocate()
+  // retries
   add_block();
 }
 
 Arena::~Arena() {
-  // Blocks are automatically cleaned up by unique_ptr
+  // Blocks are freed by unique_ptr; give back their reservation
+  MemoryTracker::instance().release(capacity_, MemoryCategory::ARENA);
 }
 
 void *Arena::allocate(size_t size, size_t alignment) {
@@ -48,6 +51,11 @@ void *Arena::allocate(size_t size, size_t alignment) {
   size_t min_block_size = align_up(size, alignment) + alignment;
   if (min_block_size > block_size_) {
     // Create an oversized block just for this allocation
+    if (!MemoryTracker::instance().reserve(min_block_size,
+                                           MemoryCategory::ARENA)) {
+      return nullptr;
+    }
+
     Block block;
     block.size = min_block_size;
     block.data = std::make_unique<uint8_t[]>(block.size);
@@ -65,7 +73,9 @@ void *Arena::allocate(size_t size, size_t alignment) {
     return ptr;
   }
 
-  add_block();
+  if (!add_block()) {
+    return nullptr; // Global memory limit reached
+  }
   return allocate(size, alignment); // Retry with new block
 }
 
@@ -86,7 +96,43 @@ void Arena::reset() {
   bytes_allocated_ = 0;
 }
 
-void Arena::add_block() {
+size_t Arena::trim(size_t retain_bytes) {
+  size_t before = capacity_;
+  size_t kept = 0;
+
+  // Compact in place so trimming itself never allocates
+  size_t out = 0;
+  for (size_t i = 0; i < blocks_.size(); ++i) {
+    Block &block = blocks_[i];
+    bool oversized = block.size > block_size_;
+    if (oversized || (out > 0 && kept + block.size > retain_bytes)) {
+      continue;
+    }
+    kept += block.size;
+    if (out != i) {
+      blocks_[out] = std::move(block);
+    }
+    out++;
+  }
+  blocks_.resize(out);
+  capacity_ = kept;
+  MemoryTracker::instance().release(before - kept, MemoryCategory::ARENA);
+
+  // Always keep one regular block so the next allocation is malloc-free
+  if (blocks_.empty()) {
+    add_block();
+  }
+
+  current_block_ = 0;
+  bytes_allocated_ = 0;
+  return before > capacity_ ? before - capacity_ : 0;
+}
+
+bool Arena::add_block() {
+  if (!MemoryTracker::instance().reserve(block_size_, MemoryCategory::ARENA)) {
+    return false;
+  }
+
   Block block;
   block.size = block_size_;
   block.data = std::make_unique<uint8_t[]>(block.size);
@@ -94,6 +140,7 @@ void Arena::add_block() {
 
   blocks_.push_back(std::move(block));
   capacity_ += block_size_;
+  return true;
 }
 
 size_t Arena::align_up(size_t value, size_t alignment) {
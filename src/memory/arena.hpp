@@ -18,6 +18,8 @@ namespace memory {
  *
  * Provides fast bump-pointer allocation with O(1) reset.
  * No individual deallocation - all memory is freed at once with reset().
+ * Block capacity is reserved in the global MemoryTracker; allocate()
+ * returns nullptr when the global limit is reached.
  */
 class Arena {
 public:
@@ -28,7 +30,7 @@ public:
   explicit Arena(size_t block_size = 64 * 1024); // 64KB default
 
   /**
-   * @brief Destructor
+   * @brief Destructor - frees blocks and their reservations
    */
   ~Arena();
 
@@ -80,6 +82,18 @@ public:
    */
   void reset();
 
+  /**
+   * @brief Release blocks beyond a retention limit
+   *
+   * Oversized blocks are always released; regular blocks are kept until
+   * their combined size reaches retain_bytes. At least one block is kept.
+   * Must only be called on a reset arena.
+   *
+   * @param retain_bytes Maximum capacity to keep
+   * @return Number of bytes released
+   */
+  size_t trim(size_t retain_bytes);
+
   /**
    * @brief Get total bytes allocated
    */
@@ -101,7 +115,7 @@ public:
   size_t block_size() const { return block_size_; }
 
 private:
-  void add_block();
+  bool add_block();
   static size_t align_up(size_t value, size_t alignment);
 
   struct Block {
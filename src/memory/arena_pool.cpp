@@ -0,0 +1,142 @@
+/**
+ * @file arena_pool.cpp
+ * @brief Arena pool implementation
+ */
+
+#include "arena_pool.hpp"
+#include "memory_tracker.hpp"
+#include <mutex>
+
+namespace edgesql {
+namespace memory {
+
+namespace {
+
+std::mutex default_config_mutex;
+ArenaPoolConfig default_config;
+
+ArenaPoolConfig current_default_config() {
+  std::lock_guard<std::mutex> lock(default_config_mutex);
+  return default_config;
+}
+
+} // anonymous namespace
+
+// PooledArena implementation
+
+PooledArena &PooledArena::operator=(PooledArena &&other) noexcept {
+  if (this != &other) {
+    release();
+    pool_ = other.pool_;
+    arena_ = std::move(other.arena_);
+  }
+  return *this;
+}
+
+void PooledArena::release() {
+  if (arena_) {
+    if (pool_) {
+      pool_->release(std::move(arena_));
+    } else {
+      arena_.reset();
+    }
+  }
+}
+
+// ArenaPool implementation
+
+ArenaPool::ArenaPool(const ArenaPoolConfig &config) : config_(config) {
+  // Reserve up front so returning an arena never grows the vector
+  idle_.reserve(config_.max_idle_arenas);
+}
+
+ArenaPool::~ArenaPool() {
+  retained_bytes_ = 0;
+  idle_.clear();
+}
+
+ArenaPool &ArenaPool::local() {
+  thread_local ArenaPool pool(current_default_config());
+  return pool;
+}
+
+void ArenaPool::set_default_config(const ArenaPoolConfig &config) {
+  std::lock_guard<std::mutex> lock(default_config_mutex);
+  default_config = config;
+}
+
+PooledArena ArenaPool::acquire() {
+  if (MemoryTracker::instance().under_pressure()) {
+    drop_idle();
+  } else {
+    trim_idle();
+  }
+
+  if (idle_.empty()) {
+    return PooledArena(this, std::make_unique<Arena>(config_.block_size));
+  }
+
+  // Most recently returned arena is the warmest
+  std::unique_ptr<Arena> arena = std::move(idle_.back().arena);
+  idle_.pop_back();
+  retained_bytes_ -= arena->capacity();
+
+  return PooledArena(this, std::move(arena));
+}
+
+void ArenaPool::release(std::unique_ptr<Arena> arena) {
+  if (!arena) {
+    return;
+  }
+
+  arena->reset();
+  if (arena->capacity() > config_.retain_bytes) {
+    arena->trim(config_.retain_bytes);
+  }
+
+  if (idle_.size() >= config_.max_idle_arenas) {
+    return; // Pool full - let the arena go
+  }
+
+  // Under memory pressure give the capacity back instead of pooling it
+  if (MemoryTracker::instance().under_pressure()) {
+    drop_idle();
+    return;
+  }
+
+  retained_bytes_ += arena->capacity();
+  idle_.push_back({std::move(arena), std::chrono::steady_clock::now()});
+}
+
+size_t ArenaPool::trim_idle() {
+  if (idle_.empty()) {
+    return 0;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  size_t released = 0;
+
+  for (auto &entry : idle_) {
+    if (now - entry.since < config_.idle_timeout) {
+      continue;
+    }
+
+    // Shrink long-idle arenas down to a single block
+    size_t freed = entry.arena->trim(0);
+    released += freed;
+    entry.since = now;
+  }
+
+  retained_bytes_ -= released;
+  return released;
+}
+
+size_t ArenaPool::drop_idle() {
+  size_t released = retained_bytes_;
+  idle_.clear();
+  retained_bytes_ = 0;
+  return released;
+}
+
+} // namespace memory
+} // namespace edgesql
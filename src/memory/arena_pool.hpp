@@ -0,0 +1,151 @@
+#pragma once
+
+/**
+ * @file arena_pool.hpp
+ * @brief Per-worker pool of reusable query arenas
+ */
+
+#include "arena.hpp"
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace edgesql {
+namespace memory {
+
+/**
+ * @brief Arena pool configuration
+ */
+struct ArenaPoolConfig {
+  size_t max_idle_arenas = 4;            // Arenas kept per worker
+  size_t block_size = 64 * 1024;         // 64KB blocks
+  size_t retain_bytes = 256 * 1024;      // Capacity kept per idle arena
+  std::chrono::seconds idle_timeout{30}; // Shrink arenas idle this long
+};
+
+class ArenaPool;
+
+/**
+ * @brief Arena borrowed from a pool
+ *
+ * RAII handle that returns the arena to its pool when destroyed. Must be
+ * destroyed on the thread that acquired it.
+ */
+class PooledArena {
+public:
+  PooledArena() = default;
+  PooledArena(ArenaPool *pool, std::unique_ptr<Arena> arena)
+      : pool_(pool), arena_(std::move(arena)) {}
+
+  ~PooledArena() { release(); }
+
+  // Non-copyable but movable
+  PooledArena(const PooledArena &) = delete;
+  PooledArena &operator=(const PooledArena &) = delete;
+  PooledArena(PooledArena &&other) noexcept = default;
+  PooledArena &operator=(PooledArena &&other) noexcept;
+
+  Arena &operator*() { return *arena_; }
+  Arena *operator->() { return arena_.get(); }
+  Arena *get() { return arena_.get(); }
+
+  /**
+   * @brief Return the arena to its pool early
+   */
+  void release();
+
+private:
+  ArenaPool *pool_{nullptr};
+  std::unique_ptr<Arena> arena_;
+};
+
+/**
+ * @brief Pool of pre-warmed arenas
+ *
+ * Each worker thread owns one pool (see local()), so acquiring and
+ * returning an arena needs no locking. Returned arenas are reset and
+ * trimmed back to the configured retention; their blocks stay reserved in
+ * the global MemoryTracker. Under memory pressure idle arenas are freed
+ * rather than pooled. On the steady-state path a short query reuses an
+ * arena without touching malloc.
+ */
+class ArenaPool {
+public:
+  /**
+   * @brief Constructor
+   * @param config Pool configuration
+   */
+  explicit ArenaPool(const ArenaPoolConfig &config);
+
+  /**
+   * @brief Destructor - frees idle arenas
+   */
+  ~ArenaPool();
+
+  // Non-copyable, non-movable
+  ArenaPool(const ArenaPool &) = delete;
+  ArenaPool &operator=(const ArenaPool &) = delete;
+
+  /**
+   * @brief Get the calling thread's pool
+   */
+  static ArenaPool &local();
+
+  /**
+   * @brief Set the configuration used by pools created after this call
+   *
+   * Must be called before worker threads start.
+   */
+  static void set_default_config(const ArenaPoolConfig &config);
+
+  /**
+   * @brief Borrow an arena (creates one if the pool is empty)
+   */
+  PooledArena acquire();
+
+  /**
+   * @brief Return an arena to the pool
+   */
+  void release(std::unique_ptr<Arena> arena);
+
+  /**
+   * @brief Shrink arenas that have been idle longer than idle_timeout
+   * @return Bytes released
+   */
+  size_t trim_idle();
+
+  /**
+   * @brief Free all idle arenas
+   * @return Bytes released
+   */
+  size_t drop_idle();
+
+  /**
+   * @brief Get number of idle arenas
+   */
+  size_t idle_count() const { return idle_.size(); }
+
+  /**
+   * @brief Get capacity held by idle arenas
+   */
+  size_t retained_bytes() const { return retained_bytes_; }
+
+  /**
+   * @brief Get pool configuration
+   */
+  const ArenaPoolConfig &config() const { return config_; }
+
+private:
+  struct IdleArena {
+    std::unique_ptr<Arena> arena;
+    std::chrono::steady_clock::time_point since;
+  };
+
+  ArenaPoolConfig config_;
+  std::vector<IdleArena> idle_;
+  size_t retained_bytes_{0};
+};
+
+} // namespace memory
+} // namespace edgesql
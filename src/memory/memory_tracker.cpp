@@ -10,6 +10,23 @@
 namespace edgesql {
 namespace memory {
 
+const char *memory_category_name(MemoryCategory category) {
+  switch (category) {
+  case MemoryCategory::ARENA:
+    return "arena";
+  case MemoryCategory::BUFFER_POOL:
+    return "buffer_pool";
+  case MemoryCategory::SLAB:
+    return "slab";
+  case MemoryCategory::RESULT_CACHE:
+    return "result_cache";
+  case MemoryCategory::OTHER:
+  case MemoryCategory::COUNT:
+    break;
+  }
+  return "other";
+}
+
 MemoryTracker::MemoryTracker() = default;
 
 MemoryTracker &MemoryTracker::instance() {
@@ -21,7 +38,19 @@ void MemoryTracker::set_limit(size_t limit) {
   limit_.store(limit, std::memory_order_release);
 }
 
-bool MemoryTracker::try_reserve(size_t size) {
+void MemoryTracker::set_pressure_percent(uint32_t percent) {
+  pressure_percent_.store(std::min<uint32_t>(percent, 100),
+                          std::memory_order_release);
+}
+
+bool MemoryTracker::under_pressure() const {
+  size_t limit = limit_.load(std::memory_order_acquire);
+  size_t percent = pressure_percent_.load(std::memory_order_acquire);
+  size_t threshold = limit / 100 * percent;
+  return used_.load(std::memory_order_acquire) > threshold;
+}
+
+bool MemoryTracker::try_reserve(size_t size, MemoryCategory category) {
   size_t current = used_.load(std::memory_order_acquire);
   size_t limit = limit_.load(std::memory_order_acquire);
 
@@ -35,6 +64,8 @@ bool MemoryTracker::try_reserve(size_t size) {
                                     std::memory_order_acq_rel,
                                     std::memory_order_acquire)) {
       allocation_count_.fetch_add(1, std::memory_order_relaxed);
+      category_used_[static_cast<size_t>(category)].fetch_add(
+          size, std::memory_order_relaxed);
 
       // Update peak
       size_t new_used = current + size;
@@ -53,18 +84,84 @@ bool MemoryTracker::try_reserve(size_t size) {
   }
 }
 
-void MemoryTracker::release(size_t size) {
+bool MemoryTracker::reserve(size_t size, MemoryCategory category) {
+  if (try_reserve(size, category)) {
+    return true;
+  }
+
+  reclaim(size);
+  return try_reserve(size, category);
+}
+
+void MemoryTracker::charge(size_t size, MemoryCategory category) {
+  size_t new_used = used_.fetch_add(size, std::memory_order_acq_rel) + size;
+  category_used_[static_cast<size_t>(category)].fetch_add(
+      size, std::memory_order_relaxed);
+  allocation_count_.fetch_add(1, std::memory_order_relaxed);
+
+  size_t old_peak = peak_.load(std::memory_order_acquire);
+  while (new_used > old_peak) {
+    if (peak_.compare_exchange_weak(old_peak, new_used,
+                                    std::memory_order_acq_rel,
+                                    std::memory_order_acquire)) {
+      break;
+    }
+  }
+}
+
+void MemoryTracker::release(size_t size, MemoryCategory category) {
   size_t current = used_.load(std::memory_order_acquire);
   while (!used_.compare_exchange_weak(
       current, current > size ? current - size : 0, std::memory_order_acq_rel,
       std::memory_order_acquire)) {
     // current is updated on failure
   }
+
+  auto &bucket = category_used_[static_cast<size_t>(category)];
+  current = bucket.load(std::memory_order_acquire);
+  while (!bucket.compare_exchange_weak(
+      current, current > size ? current - size : 0, std::memory_order_acq_rel,
+      std::memory_order_acquire)) {
+    // current is updated on failure
+  }
+}
+
+uint64_t MemoryTracker::add_reclaimer(Reclaimer reclaimer) {
+  std::lock_guard<std::mutex> lock(reclaim_mutex_);
+  uint64_t id = next_reclaimer_id_++;
+  reclaimers_.push_back({id, std::move(reclaimer)});
+  return id;
+}
+
+void MemoryTracker::remove_reclaimer(uint64_t id) {
+  std::lock_guard<std::mutex> lock(reclaim_mutex_);
+  std::erase_if(reclaimers_,
+                [id](const ReclaimerEntry &entry) { return entry.id == id; });
+}
+
+size_t MemoryTracker::reclaim(size_t bytes) {
+  // Serializes reclaim passes; reclaimers must not reserve memory
+  std::lock_guard<std::mutex> lock(reclaim_mutex_);
+
+  size_t released = 0;
+  for (auto &entry : reclaimers_) {
+    if (released >= bytes) {
+      break;
+    }
+    released += entry.fn(bytes - released);
+  }
+
+  reclaimed_bytes_.fetch_add(released, std::memory_order_relaxed);
+  return released;
 }
 
 void MemoryTracker::reset_stats() {
   used_.store(0, std::memory_order_release);
   peak_.store(0, std::memory_order_release);
+  for (auto &bucket : category_used_) {
+    bucket.store(0, std::memory_order_release);
+  }
+  reclaimed_bytes_.store(0, std::memory_order_release);
   allocation_count_.store(0, std::memory_order_release);
   failed_count_.store(0, std::memory_order_release);
 }
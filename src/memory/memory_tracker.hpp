@@ -5,17 +5,42 @@
  * @brief Global memory tracking and limits
  */
 
+#include <array>
 #include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <mutex>
+#include <new>
+#include <vector>
 
 namespace edgesql {
 namespace memory {
 
+/**
+ * @brief Subsystems that hold memory against the global limit
+ */
+enum class MemoryCategory : uint8_t {
+  ARENA = 0,        // Query arenas, including pooled idle arenas
+  BUFFER_POOL = 1,  // Resident page frames
+  SLAB = 2,         // Small-object slabs
+  RESULT_CACHE = 3, // Cached query responses
+  OTHER = 4,
+  COUNT
+};
+
+/**
+ * @brief Get category name for metrics
+ */
+const char *memory_category_name(MemoryCategory category);
+
 /**
  * @brief Global memory tracker
  *
  * Tracks total memory usage across all queries and enforces global limits.
+ * Usage is broken down per MemoryCategory. Subsystems holding reclaimable
+ * memory (e.g. the buffer pool) register a reclaimer that reserve() calls
+ * before failing a request.
  */
 class MemoryTracker {
 public:
@@ -45,6 +70,27 @@ public:
    */
   size_t peak() const { return peak_.load(std::memory_order_acquire); }
 
+  /**
+   * @brief Get current memory usage of one subsystem
+   */
+  size_t used(MemoryCategory category) const {
+    return category_used_[static_cast<size_t>(category)].load(
+        std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Set the pressure threshold as a percentage of the limit
+   */
+  void set_pressure_percent(uint32_t percent);
+
+  /**
+   * @brief Check if usage is above the pressure threshold
+   *
+   * Under pressure new queries are throttled, pooled arenas are dropped
+   * and large operators spill early.
+   */
+  bool under_pressure() const;
+
   /**
    * @brief Check if allocation would exceed limit
    */
@@ -56,15 +102,62 @@ public:
   /**
    * @brief Try to reserve memory
    * @param size Bytes to reserve
+   * @param category Subsystem the bytes are charged to
+   * @return true if reservation succeeded
+   */
+  bool try_reserve(size_t size,
+                   MemoryCategory category = MemoryCategory::OTHER);
+
+  /**
+   * @brief Reserve memory, reclaiming from other subsystems if needed
+   *
+   * Runs the registered reclaimers when the limit would be exceeded, then
+   * retries once.
+   *
+   * @param size Bytes to reserve
+   * @param category Subsystem the bytes are charged to
    * @return true if reservation succeeded
    */
-  bool try_reserve(size_t size);
+  bool reserve(size_t size, MemoryCategory category = MemoryCategory::OTHER);
+
+  /**
+   * @brief Account memory without checking the limit
+   *
+   * For allocations that cannot fail gracefully; the overshoot shows up
+   * as pressure on later reservations instead.
+   */
+  void charge(size_t size, MemoryCategory category = MemoryCategory::OTHER);
 
   /**
    * @brief Release reserved memory
    * @param size Bytes to release
+   * @param category Subsystem the bytes were charged to
+   */
+  void release(size_t size, MemoryCategory category = MemoryCategory::OTHER);
+
+  /**
+   * @brief Reclaimer callback: asked to free at least the given bytes,
+   *        returns the number of bytes actually released
    */
-  void release(size_t size);
+  using Reclaimer = std::function<size_t(size_t)>;
+
+  /**
+   * @brief Register a reclaimer
+   * @return Handle for remove_reclaimer()
+   */
+  uint64_t add_reclaimer(Reclaimer reclaimer);
+
+  /**
+   * @brief Unregister a reclaimer
+   */
+  void remove_reclaimer(uint64_t id);
+
+  /**
+   * @brief Ask registered reclaimers to free memory
+   * @param bytes Bytes wanted
+   * @return Bytes released
+   */
+  size_t reclaim(size_t bytes);
 
   /**
    * @brief Reset statistics
@@ -85,14 +178,34 @@ public:
     return failed_count_.load(std::memory_order_acquire);
   }
 
+  /**
+   * @brief Get bytes freed by reclaimers so far
+   */
+  uint64_t reclaimed_bytes() const {
+    return reclaimed_bytes_.load(std::memory_order_acquire);
+  }
+
 private:
   MemoryTracker();
 
+  struct ReclaimerEntry {
+    uint64_t id;
+    Reclaimer fn;
+  };
+
   std::atomic<size_t> limit_{512 * 1024 * 1024}; // 512MB default
   std::atomic<size_t> used_{0};
   std::atomic<size_t> peak_{0};
   std::atomic<uint64_t> allocation_count_{0};
   std::atomic<uint64_t> failed_count_{0};
+  std::atomic<uint64_t> reclaimed_bytes_{0};
+  std::atomic<uint32_t> pressure_percent_{90};
+  std::array<std::atomic<size_t>, static_cast<size_t>(MemoryCategory::COUNT)>
+      category_used_{};
+
+  std::mutex reclaim_mutex_;
+  std::vector<ReclaimerEntry> reclaimers_;
+  uint64_t next_reclaimer_id_{1};
 };
 
 /**
@@ -24,6 +24,13 @@ void *QueryAllocator::allocate(size_t size, size_t alignment) {
   return ptr;
 }
 
+void QueryAllocator::charge(size_t size) {
+  if (would_exceed(size)) {
+    throw MemoryBudgetExceeded(size, bytes_used_, memory_limit_);
+  }
+  bytes_used_ += size;
+}
+
 void *QueryAllocator::allocate_zeroed(size_t size, size_t alignment) {
   void *ptr = allocate(size, alignment);
   if (ptr) {
@@ -101,6 +101,23 @@ public:
     return memory_limit_ > bytes_used_ ? memory_limit_ - bytes_used_ : 0;
   }
 
+  /**
+   * @brief Count memory held outside the arena against the budget
+   *
+   * For operators that keep working memory in an arena of their own so
+   * they can free it early.
+   *
+   * @throws MemoryBudgetExceeded if budget would be exceeded
+   */
+  void charge(size_t size);
+
+  /**
+   * @brief Stop counting memory given to charge() once it is freed
+   */
+  void release(size_t size) {
+    bytes_used_ -= size < bytes_used_ ? size : bytes_used_;
+  }
+
   /**
    * @brief Reset allocation tracking (doesn't actually free memory)
    */
@@ -0,0 +1,40 @@
+/**
+ * @file query_resource.cpp
+ * @brief Query memory resource implementation
+ */
+
+#include "query_resource.hpp"
+#include <new>
+
+namespace edgesql {
+namespace memory {
+
+void *QueryMemoryResource::do_allocate(size_t bytes, size_t alignment) {
+  // Arena returns nullptr for zero-sized requests; pmr expects a pointer
+  if (bytes == 0) {
+    bytes = 1;
+  }
+
+  // Throws MemoryBudgetExceeded when the query budget is exhausted
+  void *ptr = allocator_.allocate(bytes, alignment);
+  if (!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void QueryMemoryResource::do_deallocate(void *p, size_t bytes,
+                                        size_t alignment) {
+  // Arena memory is reclaimed all at once when the query ends
+  (void)p;
+  (void)bytes;
+  (void)alignment;
+}
+
+bool QueryMemoryResource::do_is_equal(
+    const std::pmr::memory_resource &other) const noexcept {
+  return this == &other;
+}
+
+} // namespace memory
+} // namespace edgesql
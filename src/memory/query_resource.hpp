@@ -0,0 +1,50 @@
+#pragma once
+
+/**
+ * @file query_resource.hpp
+ * @brief Polymorphic memory resource over a query allocator
+ */
+
+#include "query_allocator.hpp"
+#include <memory_resource>
+
+namespace edgesql {
+namespace memory {
+
+/**
+ * @brief std::pmr adapter for QueryAllocator
+ *
+ * Lets std::pmr containers allocate from the query arena. Every byte is
+ * bump-allocated and counted against the query's memory budget;
+ * deallocation is a no-op because the arena is released as a whole when
+ * the query finishes.
+ */
+class QueryMemoryResource : public std::pmr::memory_resource {
+public:
+  /**
+   * @brief Constructor
+   * @param allocator Query allocator to draw from
+   */
+  explicit QueryMemoryResource(QueryAllocator &allocator)
+      : allocator_(allocator) {}
+
+  // Non-copyable
+  QueryMemoryResource(const QueryMemoryResource &) = delete;
+  QueryMemoryResource &operator=(const QueryMemoryResource &) = delete;
+
+  /**
+   * @brief Get the underlying allocator
+   */
+  QueryAllocator &allocator() { return allocator_; }
+
+private:
+  void *do_allocate(size_t bytes, size_t alignment) override;
+  void do_deallocate(void *p, size_t bytes, size_t alignment) override;
+  bool do_is_equal(const std::pmr::memory_resource &other) const
+      noexcept override;
+
+  QueryAllocator &allocator_;
+};
+
+} // namespace memory
+} // namespace edgesql
@@ -0,0 +1,234 @@
+/**
+ * @file slab_allocator.cpp
+ * @brief Slab allocator implementation
+ */
+
+#include "slab_allocator.hpp"
+#include "memory_tracker.hpp"
+
+namespace edgesql {
+namespace memory {
+
+namespace {
+
+using FreeNode = SlabAllocator::FreeNode;
+
+/**
+ * @brief Per-thread free lists
+ *
+ * Plain data so it needs no thread-exit destructor of its own; the
+ * CacheFlusher below hands cached objects back when the thread exits.
+ */
+struct ThreadCache {
+  FreeNode *heads[SlabAllocator::NUM_CLASSES];
+  size_t counts[SlabAllocator::NUM_CLASSES];
+  bool registered;
+  bool dead;
+};
+
+thread_local ThreadCache tl_cache{};
+
+struct CacheFlusher {
+  ~CacheFlusher() {
+    for (size_t i = 0; i < SlabAllocator::NUM_CLASSES; ++i) {
+      FreeNode *head = tl_cache.heads[i];
+      if (!head) {
+        continue;
+      }
+      FreeNode *tail = head;
+      while (tail->next) {
+        tail = tail->next;
+      }
+      SlabAllocator::instance().return_batch(i, head, tail,
+                                             tl_cache.counts[i]);
+      tl_cache.heads[i] = nullptr;
+      tl_cache.counts[i] = 0;
+    }
+    // Objects freed later on this thread go straight to the central lists
+    tl_cache.dead = true;
+  }
+};
+
+thread_local CacheFlusher tl_flusher;
+
+void register_cache() {
+  if (!tl_cache.registered) {
+    tl_cache.registered = true;
+    (void)&tl_flusher; // Odr-use constructs the flusher for this thread
+  }
+}
+
+} // anonymous namespace
+
+SlabAllocator &SlabAllocator::instance() {
+  // Intentionally leaked: objects may still be freed during static
+  // destruction and thread exit, after a function-local static would die.
+  static SlabAllocator *instance = new SlabAllocator();
+  return *instance;
+}
+
+size_t SlabAllocator::size_class(size_t size) {
+  if (size > MAX_SIZE) {
+    return NUM_CLASSES;
+  }
+
+  // Few classes - a linear scan over one cache line beats a lookup table
+  for (size_t i = 0; i < NUM_CLASSES; ++i) {
+    if (size <= CLASS_SIZES[i]) {
+      return i;
+    }
+  }
+  return NUM_CLASSES;
+}
+
+void *SlabAllocator::allocate(size_t size) {
+  size_t index = size_class(size);
+  if (index == NUM_CLASSES) {
+    large_allocations_.fetch_add(1, std::memory_order_relaxed);
+    return ::operator new(size);
+  }
+
+  if (tl_cache.dead) {
+    FreeNode *node = nullptr;
+    if (fetch_batch(index, &node) == 0) {
+      throw std::bad_alloc();
+    }
+    // Keep one, give the rest back
+    FreeNode *rest = node->next;
+    if (rest) {
+      size_t count = 0;
+      FreeNode *tail = rest;
+      for (FreeNode *n = rest; n; n = n->next) {
+        tail = n;
+        count++;
+      }
+      return_batch(index, rest, tail, count);
+    }
+    return node;
+  }
+
+  register_cache();
+
+  FreeNode *head = tl_cache.heads[index];
+  if (!head) {
+    size_t fetched = fetch_batch(index, &head);
+    if (fetched == 0) {
+      throw std::bad_alloc();
+    }
+    tl_cache.counts[index] = fetched;
+  }
+
+  tl_cache.heads[index] = head->next;
+  tl_cache.counts[index]--;
+  return head;
+}
+
+void SlabAllocator::deallocate(void *ptr, size_t size) noexcept {
+  if (!ptr) {
+    return;
+  }
+
+  size_t index = size_class(size);
+  if (index == NUM_CLASSES) {
+    ::operator delete(ptr);
+    return;
+  }
+
+  FreeNode *node = static_cast<FreeNode *>(ptr);
+
+  if (tl_cache.dead) {
+    node->next = nullptr;
+    return_batch(index, node, node, 1);
+    return;
+  }
+
+  register_cache();
+
+  node->next = tl_cache.heads[index];
+  tl_cache.heads[index] = node;
+  tl_cache.counts[index]++;
+
+  // Bound the per-thread cache: hand a batch back to the central list
+  if (tl_cache.counts[index] > 2 * BATCH_SIZE) {
+    FreeNode *batch_head = tl_cache.heads[index];
+    FreeNode *batch_tail = batch_head;
+    for (size_t i = 1; i < BATCH_SIZE; ++i) {
+      batch_tail = batch_tail->next;
+    }
+    tl_cache.heads[index] = batch_tail->next;
+    tl_cache.counts[index] -= BATCH_SIZE;
+    batch_tail->next = nullptr;
+    return_batch(index, batch_head, batch_tail, BATCH_SIZE);
+  }
+}
+
+size_t SlabAllocator::fetch_batch(size_t index, FreeNode **out) {
+  CentralList &list = central_[index];
+  std::lock_guard<std::mutex> lock(list.mutex);
+
+  if (!list.head && !grow(index)) {
+    *out = nullptr;
+    return 0;
+  }
+
+  FreeNode *head = list.head;
+  FreeNode *tail = head;
+  size_t count = 1;
+  while (count < BATCH_SIZE && tail->next) {
+    tail = tail->next;
+    count++;
+  }
+
+  list.head = tail->next;
+  list.count -= count;
+  tail->next = nullptr;
+
+  *out = head;
+  return count;
+}
+
+void SlabAllocator::return_batch(size_t index, FreeNode *head, FreeNode *tail,
+                                 size_t count) noexcept {
+  CentralList &list = central_[index];
+  std::lock_guard<std::mutex> lock(list.mutex);
+
+  tail->next = list.head;
+  list.head = head;
+  list.count += count;
+}
+
+bool SlabAllocator::grow(size_t index) {
+  // Note: central_[index].mutex already held by caller
+  void *slab = ::operator new(SLAB_SIZE, std::nothrow);
+  if (!slab) {
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(slabs_mutex_);
+    slabs_.push_back(slab);
+  }
+  slab_bytes_.fetch_add(SLAB_SIZE, std::memory_order_relaxed);
+
+  // Slabs are never returned, so they are charged rather than reserved:
+  // failing here would surface as bad_alloc from operator new mid-parse
+  MemoryTracker::instance().charge(SLAB_SIZE, MemoryCategory::SLAB);
+
+  // Carve the slab into objects of this class
+  size_t object_size = CLASS_SIZES[index];
+  size_t count = SLAB_SIZE / object_size;
+  uint8_t *base = static_cast<uint8_t *>(slab);
+
+  CentralList &list = central_[index];
+  for (size_t i = count; i > 0; --i) {
+    FreeNode *node = reinterpret_cast<FreeNode *>(base + (i - 1) * object_size);
+    node->next = list.head;
+    list.head = node;
+  }
+  list.count += count;
+
+  return true;
+}
+
+} // namespace memory
+} // namespace edgesql
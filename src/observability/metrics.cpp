@@ -4,6 +4,7 @@
  */
 
 #include "metrics.hpp"
+#include "../memory/memory_tracker.hpp"
 #include <sstream>
 
 namespace edgesql {
@@ -112,7 +113,30 @@ std::string Metrics::to_json() const {
   }
   if (!gauges_.empty())
     out << "\n  ";
-  out << "}\n";
+  out << "},\n";
+
+  // Global memory accounting, broken down per subsystem
+  const auto &tracker = memory::MemoryTracker::instance();
+  out << "  \"memory\": {\n";
+  out << "    \"limit_bytes\": " << tracker.limit() << ",\n";
+  out << "    \"used_bytes\": " << tracker.used() << ",\n";
+  out << "    \"peak_bytes\": " << tracker.peak() << ",\n";
+  out << "    \"reclaimed_bytes\": " << tracker.reclaimed_bytes() << ",\n";
+  out << "    \"failed_reservations\": " << tracker.failed_allocation_count()
+      << ",\n";
+  out << "    \"under_pressure\": "
+      << (tracker.under_pressure() ? "true" : "false") << ",\n";
+  out << "    \"subsystems\": {";
+  constexpr size_t category_count =
+      static_cast<size_t>(memory::MemoryCategory::COUNT);
+  for (size_t i = 0; i < category_count; ++i) {
+    auto category = static_cast<memory::MemoryCategory>(i);
+    out << (i > 0 ? "," : "") << "\n      \""
+        << memory::memory_category_name(category)
+        << "\": " << tracker.used(category);
+  }
+  out << "\n    }\n";
+  out << "  }\n";
   out << "}";
 
   return out.str();
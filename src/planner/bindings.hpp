@@ -0,0 +1,116 @@
+#pragma once
+
+/**
+ * @file bindings.hpp
+ * @brief Row positions the planner binds expressions to
+ */
+
+#include "../memory/arena.hpp"
+#include "../sql/ast.hpp"
+#include <cstdint>
+#include <new>
+
+namespace edgesql {
+namespace planner {
+
+/**
+ * @brief Row positions of a plan's expression nodes
+ *
+ * A column reference is bound to its column, and a group key or
+ * aggregate to the slot computed for it below. Positions are kept here,
+ * keyed by node, rather than in the statement, so the AST stays
+ * immutable and can be planned again. A node without a position (not
+ * bound, or evaluated in place) reads as -1.
+ *
+ * An open-addressing table allocated from the statement's arena, which
+ * the plan's expressions already need to outlive it; outgrown tables are
+ * released with the arena. A default-constructed table is empty and
+ * cannot bind.
+ */
+class Bindings {
+public:
+  Bindings() = default;
+  explicit Bindings(memory::Arena &arena) : arena_(&arena) {}
+
+  /**
+   * @brief Get a node's position, -1 if it has none
+   */
+  int32_t position(const sql::Expression &expr) const {
+    if (size_ == 0) {
+      return -1;
+    }
+    const Slot &slot = slots_[find(&expr)];
+    return slot.expr ? slot.position : -1;
+  }
+
+  /**
+   * @brief Bind a node to a position; -1 unbinds it
+   * @throws std::bad_alloc if the arena cannot grow
+   */
+  void bind(const sql::Expression &expr, int32_t position) {
+    if (size_ > 0) {
+      Slot &slot = slots_[find(&expr)];
+      if (slot.expr) {
+        slot.position = position;
+        return;
+      }
+    }
+    if (position < 0) {
+      return;
+    }
+
+    // At most three quarters full, so probes stay short
+    if ((size_ + 1) * 4 > capacity_ * 3) {
+      grow();
+    }
+    Slot &slot = slots_[find(&expr)];
+    slot.expr = &expr;
+    slot.position = position;
+    size_++;
+  }
+
+private:
+  struct Slot {
+    const sql::Expression *expr;
+    int32_t position;
+  };
+
+  // The node's slot, or the empty slot where it would go
+  uint32_t find(const sql::Expression *expr) const {
+    uint64_t key = reinterpret_cast<uintptr_t>(expr) >> 3;
+    uint32_t mask = capacity_ - 1;
+    uint32_t at = static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ull) >> 32);
+    while (slots_[at & mask].expr && slots_[at & mask].expr != expr) {
+      at++;
+    }
+    return at & mask;
+  }
+
+  void grow() {
+    uint32_t capacity = capacity_ ? capacity_ * 2 : 16;
+    auto *slots = arena_ ? static_cast<Slot *>(arena_->allocate_zeroed(
+                               sizeof(Slot) * capacity, alignof(Slot)))
+                         : nullptr;
+    if (!slots) {
+      throw std::bad_alloc();
+    }
+
+    Slot *old = slots_;
+    uint32_t old_capacity = capacity_;
+    slots_ = slots;
+    capacity_ = capacity;
+    for (uint32_t i = 0; i < old_capacity; ++i) {
+      if (old[i].expr) {
+        slots_[find(old[i].expr)] = old[i];
+      }
+    }
+  }
+
+  memory::Arena *arena_{nullptr};
+  Slot *slots_{nullptr};
+  uint32_t capacity_{0}; // A power of two
+  uint32_t size_{0};
+};
+
+} // namespace planner
+} // namespace edgesql
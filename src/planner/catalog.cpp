@@ -10,7 +10,85 @@
 namespace edgesql {
 namespace planner {
 
-int TableInfo::find_column(const std::string &name) const {
+namespace {
+
+// Catalog file header; files written before it existed start with the
+// table count instead
+constexpr uint32_t CATALOG_MAGIC = 0x54434445; // "EDCT"
+constexpr uint32_t CATALOG_VERSION = 5;
+
+// Longest view definition read back; longer means a corrupt file
+constexpr uint32_t MAX_VIEW_QUERY = 1 << 20;
+
+template <typename T> void write_value(std::ofstream &file, const T &value) {
+  file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+template <typename T> void read_value(std::ifstream &file, T &value) {
+  file.read(reinterpret_cast<char *>(&value), sizeof(value));
+}
+
+void write_stats(std::ofstream &file, const TableStats &stats) {
+  uint8_t analyzed = stats.analyzed ? 1 : 0;
+  write_value(file, analyzed);
+  if (!stats.analyzed) {
+    return;
+  }
+
+  write_value(file, stats.row_count);
+  write_value(file, stats.page_count);
+  uint32_t columns = static_cast<uint32_t>(stats.columns.size());
+  write_value(file, columns);
+  for (const ColumnStats &column : stats.columns) {
+    write_value(file, column.null_fraction);
+    write_value(file, column.ndv);
+    uint8_t has_range = column.has_range ? 1 : 0;
+    write_value(file, has_range);
+    write_value(file, column.min);
+    write_value(file, column.max);
+    uint32_t bounds = static_cast<uint32_t>(column.bounds.size());
+    write_value(file, bounds);
+    file.write(reinterpret_cast<const char *>(column.bounds.data()),
+               static_cast<std::streamsize>(bounds * sizeof(double)));
+  }
+}
+
+void read_stats(std::ifstream &file, TableStats &stats) {
+  uint8_t analyzed = 0;
+  read_value(file, analyzed);
+  stats.analyzed = analyzed != 0;
+  if (!stats.analyzed) {
+    return;
+  }
+
+  read_value(file, stats.row_count);
+  read_value(file, stats.page_count);
+  uint32_t columns = 0;
+  read_value(file, columns);
+  stats.columns.resize(columns);
+  for (ColumnStats &column : stats.columns) {
+    read_value(file, column.null_fraction);
+    read_value(file, column.ndv);
+    uint8_t has_range = 0;
+    read_value(file, has_range);
+    column.has_range = has_range != 0;
+    read_value(file, column.min);
+    read_value(file, column.max);
+    uint32_t bounds = 0;
+    read_value(file, bounds);
+    if (!file.good() || bounds > StatsCollector::HISTOGRAM_BUCKETS + 1) {
+      file.setstate(std::ios::failbit);
+      return;
+    }
+    column.bounds.resize(bounds);
+    file.read(reinterpret_cast<char *>(column.bounds.data()),
+              static_cast<std::streamsize>(bounds * sizeof(double)));
+  }
+}
+
+} // anonymous namespace
+
+int TableInfo::find_column(std::string_view name) const {
   for (size_t i = 0; i < columns.size(); ++i) {
     if (columns[i].name == name) {
       return static_cast<int>(i);
@@ -19,6 +97,23 @@ int TableInfo::find_column(const std::string &name) const {
   return -1;
 }
 
+int TableInfo::primary_key_column() const {
+  if (partitioning.enabled()) {
+    return -1;
+  }
+
+  int key = -1;
+  for (size_t i = 0; i < columns.size(); ++i) {
+    if (columns[i].primary_key) {
+      if (key >= 0 || columns[i].type != storage::ColumnType::INTEGER) {
+        return -1;
+      }
+      key = static_cast<int>(i);
+    }
+  }
+  return key;
+}
+
 const ColumnInfo *TableInfo::get_column(uint32_t index) const {
   if (index >= columns.size())
     return nullptr;
@@ -31,12 +126,40 @@ Catalog &Catalog::instance() {
 }
 
 uint32_t Catalog::create_table(const std::string &name,
-                               const std::vector<ColumnInfo> &columns) {
+                               const std::vector<ColumnInfo> &columns,
+                               storage::PageLayout layout,
+                               const storage::TimePartitioning &partitioning) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  TableInfo *table = add_table(name, columns);
+  if (!table) {
+    return 0;
+  }
+  table->layout = layout;
+  table->partitioning = partitioning;
+  return table->id;
+}
+
+uint32_t Catalog::create_view(const std::string &name,
+                              const std::vector<ColumnInfo> &columns,
+                              uint32_t base_table_id,
+                              const std::string &query) {
   std::lock_guard<std::mutex> lock(mutex_);
 
+  TableInfo *table = add_table(name, columns);
+  if (!table) {
+    return 0;
+  }
+  table->view_of = base_table_id;
+  table->view_query = query;
+  return table->id;
+}
+
+TableInfo *Catalog::add_table(const std::string &name,
+                              const std::vector<ColumnInfo> &columns) {
   // Check if table already exists
   if (tables_by_name_.find(name) != tables_by_name_.end()) {
-    return 0;
+    return nullptr;
   }
 
   uint32_t id = next_table_id_++;
@@ -55,7 +178,7 @@ uint32_t Catalog::create_table(const std::string &name,
   tables_by_name_[name] = std::move(table);
   tables_by_id_[id] = ptr;
 
-  return id;
+  return ptr;
 }
 
 bool Catalog::drop_table(const std::string &name) {
@@ -112,6 +235,18 @@ std::vector<std::string> Catalog::list_tables() const {
   return names;
 }
 
+std::vector<const TableInfo *> Catalog::views_of(uint32_t table_id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::vector<const TableInfo *> views;
+  for (const auto &[id, table] : tables_by_id_) {
+    if (table->view_of == table_id) {
+      views.push_back(table);
+    }
+  }
+  return views;
+}
+
 void Catalog::update_row_count(uint32_t table_id, uint64_t count) {
   std::lock_guard<std::mutex> lock(mutex_);
 
@@ -121,6 +256,15 @@ void Catalog::update_row_count(uint32_t table_id, uint64_t count) {
   }
 }
 
+void Catalog::update_statistics(uint32_t table_id, TableStats stats) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto it = tables_by_id_.find(table_id);
+  if (it != tables_by_id_.end()) {
+    it->second->set_statistics(std::move(stats));
+  }
+}
+
 void Catalog::clear() {
   std::lock_guard<std::mutex> lock(mutex_);
 
@@ -137,6 +281,11 @@ bool Catalog::save(const std::string &path) {
     return false;
   }
 
+  file.write(reinterpret_cast<const char *>(&CATALOG_MAGIC),
+             sizeof(CATALOG_MAGIC));
+  file.write(reinterpret_cast<const char *>(&CATALOG_VERSION),
+             sizeof(CATALOG_VERSION));
+
   // Write table count
   uint32_t count = static_cast<uint32_t>(tables_by_name_.size());
   file.write(reinterpret_cast<const char *>(&count), sizeof(count));
@@ -161,6 +310,18 @@ bool Catalog::save(const std::string &path) {
     file.write(reinterpret_cast<const char *>(&table->row_count),
                sizeof(table->row_count));
 
+    // Page layout
+    uint8_t layout = static_cast<uint8_t>(table->layout);
+    file.write(reinterpret_cast<const char *>(&layout), sizeof(layout));
+
+    // Time partitioning
+    const storage::TimePartitioning &spec = table->partitioning;
+    file.write(reinterpret_cast<const char *>(&spec.column),
+               sizeof(spec.column));
+    file.write(reinterpret_cast<const char *>(&spec.width), sizeof(spec.width));
+    file.write(reinterpret_cast<const char *>(&spec.retention),
+               sizeof(spec.retention));
+
     // Each column
     for (const auto &col : table->columns) {
       uint32_t col_name_len = static_cast<uint32_t>(col.name.size());
@@ -176,6 +337,17 @@ bool Catalog::save(const std::string &path) {
 
       file.write(reinterpret_cast<const char *>(&col.index), sizeof(col.index));
     }
+
+    // Statistics
+    write_stats(file, *table->statistics());
+
+    // Materialized view definition
+    file.write(reinterpret_cast<const char *>(&table->view_of),
+               sizeof(table->view_of));
+    uint32_t query_len = static_cast<uint32_t>(table->view_query.size());
+    file.write(reinterpret_cast<const char *>(&query_len), sizeof(query_len));
+    file.write(table->view_query.data(),
+               static_cast<std::streamsize>(query_len));
   }
 
   return file.good();
@@ -192,9 +364,17 @@ bool Catalog::load(const std::string &path) {
   tables_by_name_.clear();
   tables_by_id_.clear();
 
-  // Read table count
+  // Read header, or the table count of a headerless file
+  uint32_t version = 1;
   uint32_t count;
   file.read(reinterpret_cast<char *>(&count), sizeof(count));
+  if (count == CATALOG_MAGIC) {
+    file.read(reinterpret_cast<char *>(&version), sizeof(version));
+    if (version > CATALOG_VERSION) {
+      return false;
+    }
+    file.read(reinterpret_cast<char *>(&count), sizeof(count));
+  }
   file.read(reinterpret_cast<char *>(&next_table_id_), sizeof(next_table_id_));
 
   // Read each table
@@ -218,6 +398,22 @@ bool Catalog::load(const std::string &path) {
     file.read(reinterpret_cast<char *>(&table->row_count),
               sizeof(table->row_count));
 
+    // Page layout
+    if (version >= 2) {
+      uint8_t layout;
+      file.read(reinterpret_cast<char *>(&layout), sizeof(layout));
+      table->layout = static_cast<storage::PageLayout>(layout);
+    }
+
+    // Time partitioning
+    if (version >= 3) {
+      storage::TimePartitioning &spec = table->partitioning;
+      file.read(reinterpret_cast<char *>(&spec.column), sizeof(spec.column));
+      file.read(reinterpret_cast<char *>(&spec.width), sizeof(spec.width));
+      file.read(reinterpret_cast<char *>(&spec.retention),
+                sizeof(spec.retention));
+    }
+
     // Each column
     table->columns.resize(col_count);
     for (uint32_t j = 0; j < col_count && file.good(); ++j) {
@@ -240,6 +436,28 @@ bool Catalog::load(const std::string &path) {
       file.read(reinterpret_cast<char *>(&col.index), sizeof(col.index));
     }
 
+    // Statistics
+    if (version >= 4) {
+      TableStats stats;
+      read_stats(file, stats);
+      table->set_statistics(std::move(stats));
+    }
+
+    // Materialized view definition
+    if (version >= 5) {
+      file.read(reinterpret_cast<char *>(&table->view_of),
+                sizeof(table->view_of));
+      uint32_t query_len = 0;
+      file.read(reinterpret_cast<char *>(&query_len), sizeof(query_len));
+      if (!file.good() || query_len > MAX_VIEW_QUERY) {
+        file.setstate(std::ios::failbit);
+        break;
+      }
+      table->view_query.resize(query_len);
+      file.read(table->view_query.data(),
+                static_cast<std::streamsize>(query_len));
+    }
+
     if (file.good()) {
       TableInfo *ptr = table.get();
       tables_by_id_[table->id] = ptr;
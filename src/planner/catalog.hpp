@@ -5,11 +5,14 @@
  * @brief Schema catalog for table metadata
  */
 
+#include "../storage/page.hpp"
 #include "../storage/record.hpp"
+#include "statistics.hpp"
 #include <cstdint>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 
@@ -35,17 +38,54 @@ struct TableInfo {
   std::string name;
   std::vector<ColumnInfo> columns;
   uint64_t row_count{0}; // Estimate for planning
+  storage::PageLayout layout{storage::PageLayout::ROW};
+  storage::TimePartitioning partitioning; // Stored in segments if enabled
+
+  // A materialized view's table: the table it aggregates, and the SELECT
+  // defining it, planned again wherever the view is used
+  uint32_t view_of{0}; // 0 = not a view
+  std::string view_query;
 
   /**
    * @brief Find a column by name
    * @return Column index, or -1 if not found
    */
-  int find_column(const std::string &name) const;
+  int find_column(std::string_view name) const;
+
+  /**
+   * @brief Get the indexed primary key column
+   *
+   * A single-column INTEGER primary key is indexed, except on
+   * time-partitioned tables.
+   *
+   * @return Column index, or -1 if the table has no indexed key
+   */
+  int primary_key_column() const;
 
   /**
    * @brief Get column by index
    */
   const ColumnInfo *get_column(uint32_t index) const;
+
+  /**
+   * @brief Get the statistics from the last ANALYZE
+   *
+   * ANALYZE publishes new statistics rather than changing these, so the
+   * planner reads them without the catalog lock.
+   */
+  std::shared_ptr<const TableStats> statistics() const {
+    return stats_.load();
+  }
+
+  /**
+   * @brief Publish new statistics
+   */
+  void set_statistics(TableStats stats) {
+    stats_.store(std::make_shared<const TableStats>(std::move(stats)));
+  }
+
+private:
+  PublishedStats stats_; // From the last ANALYZE
 };
 
 /**
@@ -65,7 +105,19 @@ public:
    * @return Table ID, or 0 on failure
    */
   uint32_t create_table(const std::string &name,
-                        const std::vector<ColumnInfo> &columns);
+                        const std::vector<ColumnInfo> &columns,
+                        storage::PageLayout layout = storage::PageLayout::ROW,
+                        const storage::TimePartitioning &partitioning = {});
+
+  /**
+   * @brief Create the table of a materialized view
+   * @param base_table_id Table the view aggregates
+   * @param query SELECT defining the view
+   * @return Table ID, or 0 on failure
+   */
+  uint32_t create_view(const std::string &name,
+                       const std::vector<ColumnInfo> &columns,
+                       uint32_t base_table_id, const std::string &query);
 
   /**
    * @brief Drop a table
@@ -95,11 +147,21 @@ public:
    */
   std::vector<std::string> list_tables() const;
 
+  /**
+   * @brief Get the materialized views of a table
+   */
+  std::vector<const TableInfo *> views_of(uint32_t table_id) const;
+
   /**
    * @brief Update row count estimate
    */
   void update_row_count(uint32_t table_id, uint64_t count);
 
+  /**
+   * @brief Replace a table's statistics
+   */
+  void update_statistics(uint32_t table_id, TableStats stats);
+
   /**
    * @brief Clear all tables
    */
@@ -118,6 +180,9 @@ public:
 private:
   Catalog() = default;
 
+  TableInfo *add_table(const std::string &name,
+                       const std::vector<ColumnInfo> &columns);
+
   mutable std::mutex mutex_;
   std::unordered_map<std::string, std::unique_ptr<TableInfo>> tables_by_name_;
   std::unordered_map<uint32_t, TableInfo *> tables_by_id_;
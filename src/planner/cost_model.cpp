@@ -0,0 +1,391 @@
+/**
+ * @file cost_model.cpp
+ * @brief Cost model implementation
+ */
+
+#include "cost_model.hpp"
+#include "../executor/sketch.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace edgesql {
+namespace planner {
+
+namespace {
+
+// Selectivities when nothing better is known
+constexpr double DEFAULT_EQ_SELECTIVITY = 0.005;
+constexpr double DEFAULT_RANGE_SELECTIVITY = 1.0 / 3.0;
+constexpr double DEFAULT_BOOL_SELECTIVITY = 0.5;
+constexpr double DEFAULT_NDV = 200.0;
+
+// Stored bytes per value when no table has been analyzed
+constexpr double DEFAULT_VALUE_BYTES = 9.0;
+constexpr double DEFAULT_TEXT_BYTES = 16.0;
+
+// In-memory overhead of a buffered row
+constexpr double ROW_OVERHEAD_BYTES = 64.0;
+
+// Numeric value of a constant operand: a literal, optionally negated
+bool numeric_constant(const sql::Expression &expr, double &out) {
+  if (expr.type == sql::ExprType::UNARY_OP &&
+      expr.unary_op == sql::UnaryOp::MINUS) {
+    if (!numeric_constant(*expr.operand(), out)) {
+      return false;
+    }
+    out = -out;
+    return true;
+  }
+  if (expr.type != sql::ExprType::LITERAL) {
+    return false;
+  }
+  switch (expr.literal_type) {
+  case sql::Literal::Type::INTEGER:
+    out = static_cast<double>(expr.int_value);
+    return true;
+  case sql::Literal::Type::FLOAT:
+    out = expr.float_value;
+    return true;
+  case sql::Literal::Type::BOOLEAN:
+    out = expr.bool_value ? 1.0 : 0.0;
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool is_constant(const sql::Expression &expr) {
+  double unused;
+  return expr.type == sql::ExprType::LITERAL || numeric_constant(expr, unused);
+}
+
+size_t count_operators(const sql::Expression &expr) {
+  switch (expr.type) {
+  case sql::ExprType::BINARY_OP:
+    return 1 + count_operators(*expr.left) + count_operators(*expr.right);
+  case sql::ExprType::UNARY_OP:
+    return 1 + count_operators(*expr.operand());
+  default:
+    return 0;
+  }
+}
+
+double log2_rows(double rows) { return std::log2(std::max(rows, 1.0) + 1.0); }
+
+} // anonymous namespace
+
+CostModel::CostModel(const TableInfo &table, const Bindings &bindings)
+    : table_(table), bindings_(bindings), stats_(table.statistics()) {
+  const TableStats &stats = *stats_;
+  rows_ = static_cast<double>(table.row_count > 0 ? table.row_count
+                                                  : stats.row_count);
+
+  row_bytes_ = ROW_OVERHEAD_BYTES;
+  double stored_bytes = 0.0;
+  for (const auto &column : table.columns) {
+    row_bytes_ += sizeof(sql::Literal);
+    bool text = column.type == storage::ColumnType::TEXT ||
+                column.type == storage::ColumnType::BLOB;
+    row_bytes_ += text ? DEFAULT_TEXT_BYTES : 0.0;
+    stored_bytes += text ? DEFAULT_TEXT_BYTES : DEFAULT_VALUE_BYTES;
+  }
+
+  // Pages grow with the rows inserted since the last ANALYZE
+  if (stats.analyzed && stats.row_count > 0) {
+    pages_ = static_cast<double>(stats.page_count) * rows_ /
+             static_cast<double>(stats.row_count);
+  } else {
+    pages_ = std::ceil(rows_ * stored_bytes /
+                       static_cast<double>(storage::PAGE_SIZE));
+  }
+  pages_ = rows_ > 0 ? std::max(pages_, 1.0) : 0.0;
+}
+
+// A bound reference's position, which for a join's combined rows is the
+// only way to tell apart columns of the same name
+int CostModel::column_of(const sql::Expression &ref) const {
+  int32_t column = bindings_.position(ref);
+  if (column >= 0 && static_cast<size_t>(column) < table_.columns.size()) {
+    return column;
+  }
+  return table_.find_column(ref.name);
+}
+
+const ColumnStats *CostModel::column_stats(int column) const {
+  const TableStats &stats = *stats_;
+  if (!stats.analyzed || column < 0 ||
+      static_cast<size_t>(column) >= stats.columns.size()) {
+    return nullptr;
+  }
+  return &stats.columns[column];
+}
+
+double CostModel::value_bytes(uint32_t column) const {
+  if (column >= table_.columns.size()) {
+    return 0.0;
+  }
+  storage::ColumnType type = table_.columns[column].type;
+  return type == storage::ColumnType::TEXT || type == storage::ColumnType::BLOB
+             ? DEFAULT_TEXT_BYTES
+             : 0.0;
+}
+
+double CostModel::selectivity(const sql::Expression &predicate) const {
+  double s = DEFAULT_BOOL_SELECTIVITY;
+  switch (predicate.type) {
+  case sql::ExprType::BINARY_OP:
+    if (predicate.binary_op == sql::BinaryOp::AND) {
+      s = selectivity(*predicate.left) * selectivity(*predicate.right);
+    } else if (predicate.binary_op == sql::BinaryOp::OR) {
+      double a = selectivity(*predicate.left);
+      double b = selectivity(*predicate.right);
+      s = a + b - a * b;
+    } else {
+      s = compare_selectivity(predicate);
+    }
+    break;
+  case sql::ExprType::UNARY_OP:
+    if (predicate.unary_op == sql::UnaryOp::NOT) {
+      s = 1.0 - selectivity(*predicate.operand());
+    }
+    break;
+  case sql::ExprType::LITERAL: {
+    double value = 0.0;
+    s = numeric_constant(predicate, value) && value != 0.0 ? 1.0 : 0.0;
+    break;
+  }
+  case sql::ExprType::COLUMN_REF: {
+    // A BOOLEAN column: the fraction of TRUE
+    const ColumnStats *stats = column_stats(column_of(predicate));
+    if (stats && stats->has_range) {
+      s = (1.0 - stats->null_fraction) *
+          (1.0 - stats->fraction_below(1.0, false));
+    }
+    break;
+  }
+  default:
+    break;
+  }
+  return std::clamp(s, 0.0, 1.0);
+}
+
+double CostModel::compare_selectivity(const sql::Expression &expr) const {
+  sql::BinaryOp op = expr.binary_op;
+  const sql::Expression *column = expr.left;
+  const sql::Expression *constant = expr.right;
+  if (constant->type == sql::ExprType::COLUMN_REF && is_constant(*column)) {
+    std::swap(column, constant);
+    op = sql::mirror(op);
+  }
+
+  bool equality = op == sql::BinaryOp::EQ || op == sql::BinaryOp::NE;
+  bool range = op == sql::BinaryOp::LT || op == sql::BinaryOp::LE ||
+               op == sql::BinaryOp::GT || op == sql::BinaryOp::GE;
+  if (!equality && !range) {
+    return DEFAULT_BOOL_SELECTIVITY; // Arithmetic used as a truth value
+  }
+
+  int index =
+      column->type == sql::ExprType::COLUMN_REF ? column_of(*column) : -1;
+  if (index < 0 || !is_constant(*constant)) {
+    return op == sql::BinaryOp::EQ   ? DEFAULT_EQ_SELECTIVITY
+           : op == sql::BinaryOp::NE ? 1.0 - DEFAULT_EQ_SELECTIVITY
+                                     : DEFAULT_RANGE_SELECTIVITY;
+  }
+
+  const ColumnStats *stats = column_stats(index);
+  double present = stats ? 1.0 - stats->null_fraction : 1.0;
+  double value = 0.0;
+  bool numeric = numeric_constant(*constant, value);
+
+  if (equality) {
+    double eq = DEFAULT_EQ_SELECTIVITY;
+    if (stats && numeric && stats->has_range &&
+        (value < stats->min || value > stats->max)) {
+      eq = 0.0;
+    } else if (stats) {
+      eq = present / std::max(stats->ndv, 1.0);
+    } else if (index == table_.primary_key_column()) {
+      eq = 1.0 / std::max(rows_, 1.0);
+    }
+    return op == sql::BinaryOp::EQ ? eq : present - eq;
+  }
+
+  if (!stats || !numeric || !stats->has_range) {
+    return DEFAULT_RANGE_SELECTIVITY;
+  }
+  switch (op) {
+  case sql::BinaryOp::LT:
+    return present * stats->fraction_below(value, false);
+  case sql::BinaryOp::LE:
+    return present * stats->fraction_below(value, true);
+  case sql::BinaryOp::GT:
+    return present * (1.0 - stats->fraction_below(value, true));
+  default:
+    return present * (1.0 - stats->fraction_below(value, false));
+  }
+}
+
+double CostModel::range_selectivity(int column, int64_t lo, int64_t hi) const {
+  if (lo > hi) {
+    return 0.0;
+  }
+
+  const ColumnStats *stats = column_stats(column);
+  if (stats && stats->has_range) {
+    double present = 1.0 - stats->null_fraction;
+    if (lo == hi) {
+      double v = static_cast<double>(lo);
+      return v < stats->min || v > stats->max
+                 ? 0.0
+                 : present / std::max(stats->ndv, 1.0);
+    }
+    return present *
+           std::max(stats->fraction_below(static_cast<double>(hi), true) -
+                        stats->fraction_below(static_cast<double>(lo), false),
+                    0.0);
+  }
+
+  // Unanalyzed keys are taken to be dense, as auto-numbered keys are
+  double rows = std::max(rows_, 1.0);
+  if (column == table_.primary_key_column() && lo != INT64_MIN &&
+      hi != INT64_MAX) {
+    double span = static_cast<double>(hi) - static_cast<double>(lo) + 1.0;
+    return std::clamp(span / rows, 1.0 / rows, DEFAULT_RANGE_SELECTIVITY);
+  }
+  return lo == hi ? DEFAULT_EQ_SELECTIVITY : DEFAULT_RANGE_SELECTIVITY;
+}
+
+double CostModel::distinct(const sql::Expression &expr, double rows) const {
+  double ndv = DEFAULT_NDV;
+  if (expr.type == sql::ExprType::COLUMN_REF) {
+    int index = column_of(expr);
+    const ColumnStats *stats = column_stats(index);
+    if (index >= 0 && index == table_.primary_key_column()) {
+      ndv = rows_;
+    } else if (stats) {
+      // A unique column keeps growing with the table
+      double analyzed = static_cast<double>(stats_->row_count);
+      ndv = stats->ndv >= 0.9 * analyzed * (1.0 - stats->null_fraction) &&
+                    analyzed > 0
+                ? stats->ndv * rows_ / analyzed
+                : stats->ndv;
+      ndv += stats->null_fraction > 0.0 ? 1.0 : 0.0; // NULL is a group
+    }
+  }
+  return std::clamp(ndv, 1.0, std::max(rows, 1.0));
+}
+
+double CostModel::scan_cost() const {
+  return pages_ * SEQ_PAGE_COST + rows_ * CPU_ROW_COST;
+}
+
+double CostModel::sample_scan_cost(const sql::TableSample &sample) const {
+  // SYSTEM reads its fraction of the pages; BERNOULLI reads every page
+  // and decodes only the rows it keeps
+  double fraction = sample.percent / 100.0;
+  if (sample.method == sql::SampleMethod::SYSTEM) {
+    return fraction * scan_cost();
+  }
+  return pages_ * SEQ_PAGE_COST +
+         rows_ * (CPU_OPERATOR_COST + fraction * CPU_ROW_COST);
+}
+
+double CostModel::index_scan_cost(double matched_rows) const {
+  // Matches are fetched in page order, so each page is read at most once
+  return log2_rows(rows_) * CPU_OPERATOR_COST + fetch_cost(matched_rows);
+}
+
+double CostModel::fetch_cost(double rows) const {
+  // A page read again is likely still in the buffer pool, so each
+  // distinct page holding the rows counts once; their expected number
+  // follows Cardenas
+  if (rows <= 0.0 || pages_ <= 0.0) {
+    return 0.0;
+  }
+  double pages =
+      pages_ * (1.0 - std::pow(1.0 - 1.0 / std::max(pages_, 1.0), rows));
+  return pages * RANDOM_PAGE_COST + rows * CPU_ROW_COST;
+}
+
+double CostModel::index_join_cost(double probes, double matched_rows,
+                                  double batch) const {
+  // Each batch fetches its matches in page order, like an index scan
+  if (probes <= 0.0) {
+    return 0.0;
+  }
+  double batches = std::ceil(probes / std::max(batch, 1.0));
+  return batches * index_scan_cost(matched_rows / batches) +
+         probes * log2_rows(rows_) * CPU_OPERATOR_COST;
+}
+
+double CostModel::filter_cost(const sql::Expression &predicate, double rows) {
+  double operators = static_cast<double>(count_operators(predicate) + 1);
+  return rows * operators * CPU_OPERATOR_COST;
+}
+
+double CostModel::sort_cost(double rows, double row_bytes,
+                            size_t work_memory) {
+  if (rows < 2.0) {
+    return 0.0;
+  }
+  double cost = 2.0 * rows * std::log2(rows) * CPU_OPERATOR_COST;
+
+  // Spilled runs are written once and read back once
+  double bytes = rows * row_bytes;
+  if (bytes > static_cast<double>(work_memory)) {
+    cost += 2.0 * bytes / static_cast<double>(storage::PAGE_SIZE) *
+            SEQ_PAGE_COST;
+  }
+  return cost;
+}
+
+double CostModel::top_n_cost(double rows, double n) {
+  // Most rows lose against the heap root after one comparison
+  return rows * (1.0 + log2_rows(n)) * CPU_OPERATOR_COST;
+}
+
+double CostModel::hash_aggregate_cost(double rows, double groups,
+                                      size_t aggregates) {
+  double per_row = 2.0 + static_cast<double>(aggregates);
+  return rows * per_row * CPU_OPERATOR_COST + groups * CPU_ROW_COST;
+}
+
+double CostModel::sort_aggregate_cost(double rows, size_t keys,
+                                      size_t aggregates) {
+  double per_row = static_cast<double>(keys + aggregates);
+  return rows * per_row * CPU_OPERATOR_COST;
+}
+
+double CostModel::group_bytes(size_t keys,
+                              const std::vector<AggregateExpr> &aggregates) {
+  double bytes = static_cast<double>(keys + aggregates.size()) *
+                     sizeof(sql::Literal) +
+                 ROW_OVERHEAD_BYTES;
+  for (const AggregateExpr &aggregate : aggregates) {
+    if (aggregate.type == AggregateType::APPROX_COUNT_DISTINCT) {
+      bytes += executor::DistinctSketch::MAX_BYTES;
+    } else if (aggregate.type == AggregateType::APPROX_PERCENTILE) {
+      bytes += executor::QuantileSketch::MAX_BYTES;
+    }
+  }
+  return bytes;
+}
+
+double CostModel::hash_join_cost(double build_rows, double build_row_bytes,
+                                 double probe_rows, double probe_row_bytes,
+                                 size_t work_memory) {
+  double cost = (build_rows * 3.0 + probe_rows * 2.0) * CPU_OPERATOR_COST;
+
+  // Grace partitions of both inputs are written once and read back once
+  double build_bytes = build_rows * build_row_bytes;
+  if (build_bytes > static_cast<double>(work_memory)) {
+    double bytes = build_bytes + probe_rows * probe_row_bytes;
+    cost += 2.0 * bytes / static_cast<double>(storage::PAGE_SIZE) *
+            SEQ_PAGE_COST;
+  }
+  return cost;
+}
+
+} // namespace planner
+} // namespace edgesql
@@ -0,0 +1,159 @@
+#pragma once
+
+/**
+ * @file cost_model.hpp
+ * @brief Cardinality and cost estimation for planning
+ */
+
+#include "../sql/ast.hpp"
+#include "catalog.hpp"
+#include "plan.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace edgesql {
+namespace planner {
+
+/**
+ * @brief Cost and cardinality estimates for plans over one table
+ *
+ * Costs are in units of one sequential page read. Estimates use the
+ * table's ANALYZE statistics, scaled to its current row count; without
+ * them they fall back to fixed default selectivities.
+ */
+class CostModel {
+public:
+  static constexpr double SEQ_PAGE_COST = 1.0;
+  static constexpr double RANDOM_PAGE_COST = 4.0;
+  static constexpr double CPU_ROW_COST = 0.01;
+  static constexpr double CPU_OPERATOR_COST = 0.0025;
+
+  /**
+   * @param bindings Positions of the table's column references in the
+   *                 expressions to estimate
+   */
+  CostModel(const TableInfo &table, const Bindings &bindings);
+
+  /**
+   * @brief Estimated rows in the table
+   */
+  double rows() const { return rows_; }
+
+  /**
+   * @brief Estimated pages in the table
+   */
+  double pages() const { return pages_; }
+
+  /**
+   * @brief Estimated in-memory bytes of one row
+   */
+  double row_bytes() const { return row_bytes_; }
+
+  /**
+   * @brief Check whether estimates come from ANALYZE statistics
+   */
+  bool analyzed() const { return stats_->analyzed; }
+
+  /**
+   * @brief Estimated bytes a column's value holds outside its Literal
+   */
+  double value_bytes(uint32_t column) const;
+
+  /**
+   * @brief Estimate the fraction of rows a predicate keeps
+   */
+  double selectivity(const sql::Expression &predicate) const;
+
+  /**
+   * @brief Estimate the fraction of rows with a column in [lo, hi]
+   */
+  double range_selectivity(int column, int64_t lo, int64_t hi) const;
+
+  /**
+   * @brief Estimate the distinct values of an expression among some rows
+   */
+  double distinct(const sql::Expression &expr, double rows) const;
+
+  /**
+   * @brief Cost of reading every row
+   */
+  double scan_cost() const;
+
+  /**
+   * @brief Cost of reading a TABLESAMPLE of the rows
+   */
+  double sample_scan_cost(const sql::TableSample &sample) const;
+
+  /**
+   * @brief Cost of fetching rows through the primary key index
+   */
+  double index_scan_cost(double matched_rows) const;
+
+  /**
+   * @brief Cost of reading some rows again by RowId, in any order
+   */
+  double fetch_cost(double rows) const;
+
+  /**
+   * @brief Cost of joining rows to this table through its primary key
+   *        index, looking keys up a batch at a time
+   */
+  double index_join_cost(double probes, double matched_rows,
+                         double batch) const;
+
+  /**
+   * @brief Cost of evaluating a predicate on some rows
+   */
+  static double filter_cost(const sql::Expression &predicate, double rows);
+
+  /**
+   * @brief Cost of a full sort, spilling past the working memory
+   */
+  static double sort_cost(double rows, double row_bytes, size_t work_memory);
+
+  /**
+   * @brief Cost of keeping the first n rows in a bounded heap
+   */
+  static double top_n_cost(double rows, double n);
+
+  /**
+   * @brief Cost of hash aggregation into some groups
+   */
+  static double hash_aggregate_cost(double rows, double groups,
+                                    size_t aggregates);
+
+  /**
+   * @brief Cost of aggregating rows already sorted by group
+   */
+  static double sort_aggregate_cost(double rows, size_t keys,
+                                    size_t aggregates);
+
+  /**
+   * @brief Bytes of a hash aggregation group, sketches at their largest
+   */
+  static double group_bytes(size_t keys,
+                            const std::vector<AggregateExpr> &aggregates);
+
+  /**
+   * @brief Cost of a hash join, partitioning both inputs to disk when the
+   *        build side does not fit in working memory
+   */
+  static double hash_join_cost(double build_rows, double build_row_bytes,
+                               double probe_rows, double probe_row_bytes,
+                               size_t work_memory);
+
+private:
+  int column_of(const sql::Expression &ref) const;
+  const ColumnStats *column_stats(int column) const;
+  double compare_selectivity(const sql::Expression &expr) const;
+
+  const TableInfo &table_;
+  const Bindings &bindings_;
+  std::shared_ptr<const TableStats> stats_; // Held against a new ANALYZE
+  double rows_;
+  double pages_;
+  double row_bytes_;
+};
+
+} // namespace planner
+} // namespace edgesql
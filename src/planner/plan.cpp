@@ -4,6 +4,7 @@
  */
 
 #include "plan.hpp"
+#include <algorithm>
 
 namespace edgesql {
 namespace planner {
@@ -16,21 +17,45 @@ std::unique_ptr<PlanNode> PlanNode::table_scan(uint32_t table_id,
   return node;
 }
 
+std::unique_ptr<PlanNode> PlanNode::index_scan(uint32_t table_id,
+                                               const std::string &name,
+                                               uint32_t key_column,
+                                               int64_t key_lo,
+                                               int64_t key_hi) {
+  auto node = std::make_unique<PlanNode>();
+  node->type = PlanNodeType::INDEX_SCAN;
+  IndexScanNode i;
+  i.table_id = table_id;
+  i.table_name = name;
+  i.key_column = key_column;
+  i.key_lo = key_lo;
+  i.key_hi = key_hi;
+  node->node = std::move(i);
+  return node;
+}
+
+std::unique_ptr<PlanNode> PlanNode::empty(std::vector<std::string> columns) {
+  auto node = std::make_unique<PlanNode>();
+  node->type = PlanNodeType::EMPTY;
+  node->node = EmptyNode{std::move(columns)};
+  return node;
+}
+
 std::unique_ptr<PlanNode>
 PlanNode::filter(std::unique_ptr<PlanNode> child,
-                 std::unique_ptr<sql::Expression> predicate) {
+                 const sql::Expression *predicate) {
   auto node = std::make_unique<PlanNode>();
   node->type = PlanNodeType::FILTER;
   FilterNode f;
   f.child = std::move(child);
-  f.predicate = std::move(predicate);
+  f.predicate = predicate;
   node->node = std::move(f);
   return node;
 }
 
 std::unique_ptr<PlanNode>
 PlanNode::project(std::unique_ptr<PlanNode> child,
-                  std::vector<std::unique_ptr<sql::Expression>> exprs,
+                  std::vector<const sql::Expression *> exprs,
                   std::vector<std::string> names) {
   auto node = std::make_unique<PlanNode>();
   node->type = PlanNodeType::PROJECT;
@@ -44,7 +69,7 @@ PlanNode::project(std::unique_ptr<PlanNode> child,
 
 std::unique_ptr<PlanNode>
 PlanNode::sort(std::unique_ptr<PlanNode> child,
-               std::vector<std::unique_ptr<sql::Expression>> keys,
+               std::vector<const sql::Expression *> keys,
                std::vector<bool> ascending) {
   auto node = std::make_unique<PlanNode>();
   node->type = PlanNodeType::SORT;
@@ -69,28 +94,84 @@ std::unique_ptr<PlanNode> PlanNode::limit(std::unique_ptr<PlanNode> child,
   return node;
 }
 
-std::unique_ptr<PlanNode> PlanNode::aggregate(std::unique_ptr<PlanNode> child,
-                                              std::vector<AggregateExpr> aggs) {
+std::unique_ptr<PlanNode>
+PlanNode::aggregate(std::unique_ptr<PlanNode> child,
+                    std::vector<AggregateExpr> aggs,
+                    std::vector<const sql::Expression *> group_by,
+                    AggregateStrategy strategy) {
   auto node = std::make_unique<PlanNode>();
   node->type = PlanNodeType::AGGREGATE;
   AggregateNode a;
   a.child = std::move(child);
   a.aggregates = std::move(aggs);
+  a.group_by = std::move(group_by);
+  a.strategy = strategy;
   node->node = std::move(a);
   return node;
 }
 
-std::unique_ptr<PlanNode> PlanNode::insert(
-    uint32_t table_id, const std::string &name,
-    std::vector<std::string> columns,
-    std::vector<std::vector<std::unique_ptr<sql::Expression>>> values) {
+std::unique_ptr<PlanNode>
+PlanNode::metadata_aggregate(uint32_t table_id, const std::string &table_name,
+                             std::vector<AggregateExpr> aggs) {
+  auto node = std::make_unique<PlanNode>();
+  node->type = PlanNodeType::METADATA_AGGREGATE;
+  MetadataAggregateNode m;
+  m.table_id = table_id;
+  m.table_name = table_name;
+  m.aggregates = std::move(aggs);
+  node->node = std::move(m);
+  return node;
+}
+
+std::unique_ptr<PlanNode> PlanNode::hash_join(std::unique_ptr<PlanNode> left,
+                                              std::unique_ptr<PlanNode> right,
+                                              sql::JoinType join_type) {
+  auto node = std::make_unique<PlanNode>();
+  node->type = PlanNodeType::HASH_JOIN;
+  HashJoinNode j;
+  j.left = std::move(left);
+  j.right = std::move(right);
+  j.join_type = join_type;
+  node->node = std::move(j);
+  return node;
+}
+
+std::unique_ptr<PlanNode> PlanNode::index_join(std::unique_ptr<PlanNode> left,
+                                               uint32_t table_id,
+                                               const std::string &table_name,
+                                               sql::JoinType join_type) {
+  auto node = std::make_unique<PlanNode>();
+  node->type = PlanNodeType::INDEX_JOIN;
+  IndexJoinNode j;
+  j.left = std::move(left);
+  j.table_id = table_id;
+  j.table_name = table_name;
+  j.join_type = join_type;
+  node->node = std::move(j);
+  return node;
+}
+
+std::unique_ptr<PlanNode>
+PlanNode::fetch(std::unique_ptr<PlanNode> child, uint32_t table_id,
+                const std::string &table_name, std::vector<uint32_t> columns) {
+  auto node = std::make_unique<PlanNode>();
+  node->type = PlanNodeType::FETCH;
+  node->node = FetchNode{std::move(child), table_id, table_name,
+                         std::move(columns)};
+  return node;
+}
+
+std::unique_ptr<PlanNode>
+PlanNode::insert(uint32_t table_id, const std::string &name,
+                 std::vector<std::string> columns,
+                 sql::NodeList<sql::ExprList> values) {
   auto node = std::make_unique<PlanNode>();
   node->type = PlanNodeType::INSERT;
   InsertNode i;
   i.table_id = table_id;
   i.table_name = name;
   i.column_names = std::move(columns);
-  i.values = std::move(values);
+  i.values = values;
   node->node = std::move(i);
   return node;
 }
@@ -98,17 +179,27 @@ std::unique_ptr<PlanNode> PlanNode::insert(
 std::unique_ptr<PlanNode>
 PlanNode::create_table(const std::string &name,
                        std::vector<sql::ColumnDef> columns,
-                       bool if_not_exists) {
+                       bool if_not_exists, storage::PageLayout layout,
+                       storage::TimePartitioning partitioning) {
   auto node = std::make_unique<PlanNode>();
   node->type = PlanNodeType::CREATE_TABLE;
   CreateTableNode c;
   c.table_name = name;
   c.columns = std::move(columns);
   c.if_not_exists = if_not_exists;
+  c.layout = layout;
+  c.partitioning = partitioning;
   node->node = std::move(c);
   return node;
 }
 
+std::unique_ptr<PlanNode> PlanNode::create_view(CreateViewNode view) {
+  auto node = std::make_unique<PlanNode>();
+  node->type = PlanNodeType::CREATE_VIEW;
+  node->node = std::move(view);
+  return node;
+}
+
 std::unique_ptr<PlanNode> PlanNode::drop_table(const std::string &name,
                                                bool if_exists) {
   auto node = std::make_unique<PlanNode>();
@@ -120,5 +211,67 @@ std::unique_ptr<PlanNode> PlanNode::drop_table(const std::string &name,
   return node;
 }
 
+std::unique_ptr<PlanNode> PlanNode::analyze(std::vector<uint32_t> table_ids) {
+  auto node = std::make_unique<PlanNode>();
+  node->type = PlanNodeType::ANALYZE;
+  AnalyzeNode a;
+  a.table_ids = std::move(table_ids);
+  node->node = std::move(a);
+  return node;
+}
+
+bool read_tables(const PlanNode &plan, std::vector<uint32_t> &tables) {
+  auto add = [&tables](uint32_t table_id) {
+    if (std::find(tables.begin(), tables.end(), table_id) == tables.end()) {
+      tables.push_back(table_id);
+    }
+  };
+
+  switch (plan.type) {
+  case PlanNodeType::TABLE_SCAN: {
+    const auto &scan = std::get<TableScanNode>(plan.node);
+    add(scan.table_id);
+    return !scan.sample || scan.sample->repeatable;
+  }
+  case PlanNodeType::INDEX_SCAN:
+    add(std::get<IndexScanNode>(plan.node).table_id);
+    return true;
+  case PlanNodeType::EMPTY:
+    return true;
+  case PlanNodeType::FILTER:
+    return read_tables(*std::get<FilterNode>(plan.node).child, tables);
+  case PlanNodeType::PROJECT:
+    return read_tables(*std::get<ProjectNode>(plan.node).child, tables);
+  case PlanNodeType::SORT:
+    return read_tables(*std::get<SortNode>(plan.node).child, tables);
+  case PlanNodeType::LIMIT:
+    return read_tables(*std::get<LimitNode>(plan.node).child, tables);
+  case PlanNodeType::AGGREGATE:
+    return read_tables(*std::get<AggregateNode>(plan.node).child, tables);
+  case PlanNodeType::METADATA_AGGREGATE:
+    add(std::get<MetadataAggregateNode>(plan.node).table_id);
+    return true;
+  case PlanNodeType::HASH_JOIN: {
+    const auto &join = std::get<HashJoinNode>(plan.node);
+    return read_tables(*join.left, tables) &&
+           read_tables(*join.right, tables);
+  }
+  case PlanNodeType::INDEX_JOIN: {
+    const auto &join = std::get<IndexJoinNode>(plan.node);
+    add(join.table_id);
+    return read_tables(*join.left, tables);
+  }
+  case PlanNodeType::FETCH:
+    return read_tables(*std::get<FetchNode>(plan.node).child, tables);
+  case PlanNodeType::INSERT:
+  case PlanNodeType::CREATE_TABLE:
+  case PlanNodeType::CREATE_VIEW:
+  case PlanNodeType::DROP_TABLE:
+  case PlanNodeType::ANALYZE:
+    break;
+  }
+  return false;
+}
+
 } // namespace planner
 } // namespace edgesql
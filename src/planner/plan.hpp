@@ -5,7 +5,11 @@
  * @brief Query execution plan definitions
  */
 
+#include "../memory/slab_allocator.hpp"
 #include "../sql/ast.hpp"
+#include "../storage/page.hpp"
+#include "bindings.hpp"
+#include "../storage/record.hpp"
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -20,14 +24,21 @@ namespace planner {
 enum class PlanNodeType {
   TABLE_SCAN,
   INDEX_SCAN,
+  EMPTY,
   FILTER,
   PROJECT,
   SORT,
   LIMIT,
   AGGREGATE,
+  METADATA_AGGREGATE,
+  HASH_JOIN,
+  INDEX_JOIN,
+  FETCH,
   INSERT,
   CREATE_TABLE,
-  DROP_TABLE
+  CREATE_VIEW,
+  DROP_TABLE,
+  ANALYZE
 };
 
 // Forward declarations
@@ -48,7 +59,41 @@ struct PlanColumn {
 struct TableScanNode {
   uint32_t table_id;
   std::string table_name;
-  std::vector<uint32_t> column_indices; // Which columns to read
+  std::vector<uint32_t> column_indices; // Columns to read (empty = all)
+
+  // Partition column bounds implied by WHERE, for partitioned tables
+  int64_t time_lo{INT64_MIN};
+  int64_t time_hi{INT64_MAX};
+
+  const sql::TableSample *sample{nullptr}; // TABLESAMPLE, or nullptr
+
+  // Append each row's RowId after the table's columns, for a FetchNode
+  bool row_ids{false};
+};
+
+/**
+ * @brief Index scan node
+ *
+ * Reads the rows whose primary key lies in [key_lo, key_hi] through the
+ * table's primary key index. Rows come back in storage order.
+ */
+struct IndexScanNode {
+  uint32_t table_id;
+  std::string table_name;
+  std::vector<uint32_t> column_indices; // Columns to read (empty = all)
+  uint32_t key_column;
+  int64_t key_lo{INT64_MIN};
+  int64_t key_hi{INT64_MAX};
+};
+
+/**
+ * @brief Empty relation node
+ *
+ * Stands in for a scan whose predicate can never hold: it has the
+ * table's columns and no rows, so nothing is read.
+ */
+struct EmptyNode {
+  std::vector<std::string> column_names;
 };
 
 /**
@@ -56,7 +101,7 @@ struct TableScanNode {
  */
 struct FilterNode {
   std::unique_ptr<PlanNode> child;
-  std::unique_ptr<sql::Expression> predicate;
+  const sql::Expression *predicate{nullptr};
 };
 
 /**
@@ -64,8 +109,10 @@ struct FilterNode {
  */
 struct ProjectNode {
   std::unique_ptr<PlanNode> child;
-  std::vector<std::unique_ptr<sql::Expression>> expressions;
+  std::vector<const sql::Expression *> expressions;
   std::vector<std::string> output_names;
+  std::vector<int32_t> columns; // Input position of plain column outputs,
+                                // -1 where the expression is computed
 };
 
 /**
@@ -73,8 +120,11 @@ struct ProjectNode {
  */
 struct SortNode {
   std::unique_ptr<PlanNode> child;
-  std::vector<std::unique_ptr<sql::Expression>> sort_keys;
+  std::vector<const sql::Expression *> sort_keys;
   std::vector<bool> ascending;
+  std::vector<int32_t> key_columns; // Input position of plain column keys,
+                                    // -1 where the key is computed
+  int64_t top_n{-1}; // Keep only the first n rows, -1 = all
 };
 
 /**
@@ -89,25 +139,141 @@ struct LimitNode {
 /**
  * @brief Aggregate type
  */
-enum class AggregateType { COUNT, SUM, MIN, MAX, AVG };
+enum class AggregateType {
+  COUNT,
+  SUM,
+  MIN,
+  MAX,
+  AVG,
+  APPROX_COUNT_DISTINCT, // HyperLogLog estimate
+  APPROX_PERCENTILE,     // t-digest estimate
+  SUM0                   // SUM, but 0 rather than NULL without values
+};
 
 /**
  * @brief Aggregate definition
  */
 struct AggregateExpr {
   AggregateType type;
-  std::unique_ptr<sql::Expression> arg;
+  const sql::Expression *arg{nullptr}; // nullptr for COUNT(*)
   bool distinct;
   std::string output_name;
+  double fraction{0.0}; // APPROX_PERCENTILE's percentile, in [0, 1]
+};
+
+/**
+ * @brief How an aggregate node groups its input
+ */
+enum class AggregateStrategy {
+  HASH, // Groups in a hash table; input in any order
+  SORT  // Input sorted by the group keys; one group in memory at a time
 };
 
 /**
  * @brief Aggregate node
+ *
+ * Output rows hold the group keys followed by the aggregates.
  */
 struct AggregateNode {
   std::unique_ptr<PlanNode> child;
   std::vector<AggregateExpr> aggregates;
-  std::vector<std::unique_ptr<sql::Expression>> group_by;
+  std::vector<const sql::Expression *> group_by;
+  AggregateStrategy strategy{AggregateStrategy::HASH};
+};
+
+/**
+ * @brief Aggregates answered from table metadata
+ *
+ * COUNT(*), COUNT(column), MIN and MAX of a whole table, read from the
+ * row counts and value ranges the executor keeps per table and segment
+ * instead of by a scan. Output is one row of the aggregates, as from an
+ * AggregateNode without GROUP BY.
+ */
+struct MetadataAggregateNode {
+  uint32_t table_id;
+  std::string table_name;
+  std::vector<AggregateExpr> aggregates; // Arguments are column references
+};
+
+/**
+ * @brief Hash join node
+ *
+ * Output rows are a left row followed by a right row; a LEFT join pads
+ * left rows without a match with NULLs. Rows match when each left key,
+ * evaluated on the left row, equals its right key evaluated on the right
+ * row, and the residual condition holds on the joined row. NULL keys
+ * match nothing.
+ */
+struct HashJoinNode {
+  std::unique_ptr<PlanNode> left;
+  std::unique_ptr<PlanNode> right;
+  sql::JoinType join_type{sql::JoinType::INNER};
+  std::vector<const sql::Expression *> left_keys;
+  std::vector<const sql::Expression *> right_keys;
+  const sql::Expression *residual{nullptr};
+  uint32_t left_width{0}; // Columns of a left row
+  uint32_t right_width{0};
+  bool build_left{false}; // Hash the left input instead; INNER only
+};
+
+/**
+ * @brief Index nested-loop join node
+ *
+ * Joins left rows to the rows of a table whose primary key equals
+ * left_keys[probe_key], found through the primary key index rather than
+ * by reading the table. Left rows are probed a batch at a time, with the
+ * batch's keys looked up in order and its matches read in page order.
+ * Output and matching follow HashJoinNode; right rows must also pass
+ * inner_filter.
+ */
+struct IndexJoinNode {
+  std::unique_ptr<PlanNode> left;
+  uint32_t table_id;
+  std::string table_name;
+  std::vector<uint32_t> column_indices; // Right columns (empty = all)
+  sql::JoinType join_type{sql::JoinType::INNER};
+  std::vector<const sql::Expression *> left_keys;
+  std::vector<const sql::Expression *> right_keys;
+  size_t probe_key{0}; // Key pair whose right key is the primary key
+  const sql::Expression *inner_filter{nullptr}; // On the right row
+  const sql::Expression *residual{nullptr};
+  uint32_t left_width{0};
+  uint32_t right_width{0};
+  uint32_t batch_size{1}; // Left rows per batch of lookups
+};
+
+/**
+ * @brief Late materialization node
+ *
+ * Reads the columns its input rows left out from the table, for the rows
+ * that reach it. Input rows come from a table scan with row_ids set,
+ * usually through filters, a sort and a limit that only need the
+ * columns already read; the fetched columns are filled in at their
+ * table positions and the RowId is dropped, so output rows look as if
+ * the scan had read every column.
+ */
+struct FetchNode {
+  std::unique_ptr<PlanNode> child;
+  uint32_t table_id;
+  std::string table_name;
+  std::vector<uint32_t> column_indices; // Columns to fetch, ascending
+};
+
+/**
+ * @brief A materialized view's definition, bound to its base table
+ *
+ * The view's table holds one row per group: the group keys, in GROUP BY
+ * order, then each aggregate's state from its state column on. COUNT,
+ * SUM, MIN and MAX keep their value; AVG keeps a FLOAT sum and an
+ * INTEGER count.
+ */
+struct MaterializedView {
+  uint32_t table_id{0};
+  std::string table_name;
+  std::vector<const sql::Expression *> keys; // On base table rows
+  std::vector<AggregateExpr> aggregates;
+  std::vector<uint32_t> state_columns; // By aggregate
+  const Bindings *bindings{nullptr};   // Positions of keys and arguments
 };
 
 /**
@@ -117,7 +283,8 @@ struct InsertNode {
   uint32_t table_id;
   std::string table_name;
   std::vector<std::string> column_names;
-  std::vector<std::vector<std::unique_ptr<sql::Expression>>> values;
+  sql::NodeList<sql::ExprList> values; // Rows of the statement's AST
+  std::vector<MaterializedView> views; // Of the table, kept current
 };
 
 /**
@@ -127,6 +294,20 @@ struct CreateTableNode {
   std::string table_name;
   std::vector<sql::ColumnDef> columns;
   bool if_not_exists;
+  storage::PageLayout layout{storage::PageLayout::ROW};
+  storage::TimePartitioning partitioning;
+};
+
+/**
+ * @brief Create materialized view node
+ */
+struct CreateViewNode {
+  std::string view_name;
+  std::vector<std::string> column_names;
+  std::vector<storage::ColumnType> column_types;
+  uint32_t base_table_id;
+  std::string query;     // The defining SELECT, kept in the catalog
+  MaterializedView view; // Populates the view once its table exists
 };
 
 /**
@@ -138,46 +319,100 @@ struct DropTableNode {
 };
 
 /**
- * @brief Plan node
+ * @brief Analyze node
  */
-struct PlanNode {
+struct AnalyzeNode {
+  std::vector<uint32_t> table_ids;
+};
+
+/**
+ * @brief Plan node (slab-allocated)
+ *
+ * Expressions are not copied: they point into the parsed statement, whose
+ * arena must outlive the plan. The statement is never written to; the
+ * row positions its expressions are bound to are in the root's
+ * bindings, allocated from the same arena, so a statement may be planned
+ * again without disturbing a plan already made from it.
+ */
+struct PlanNode : memory::SlabAllocated {
   PlanNodeType type;
 
-  std::variant<TableScanNode, FilterNode, ProjectNode, SortNode, LimitNode,
-               AggregateNode, InsertNode, CreateTableNode, DropTableNode>
+  // Positions of the plan's expressions; set on the root, nullptr for
+  // plans that bind nothing
+  const Bindings *bindings{nullptr};
+
+  std::variant<TableScanNode, IndexScanNode, EmptyNode, FilterNode,
+               ProjectNode, SortNode, LimitNode, AggregateNode,
+               MetadataAggregateNode, HashJoinNode, IndexJoinNode, FetchNode,
+               InsertNode, CreateTableNode, CreateViewNode, DropTableNode,
+               AnalyzeNode>
       node;
 
-  // Estimated cost and cardinality
+  // Estimated cost (cumulative, in sequential page reads) and output rows
   double estimated_cost{0.0};
   uint64_t estimated_rows{0};
 
   static std::unique_ptr<PlanNode> table_scan(uint32_t table_id,
                                               const std::string &name);
+  static std::unique_ptr<PlanNode> index_scan(uint32_t table_id,
+                                              const std::string &name,
+                                              uint32_t key_column,
+                                              int64_t key_lo, int64_t key_hi);
+  static std::unique_ptr<PlanNode> empty(std::vector<std::string> columns);
   static std::unique_ptr<PlanNode>
-  filter(std::unique_ptr<PlanNode> child,
-         std::unique_ptr<sql::Expression> predicate);
+  filter(std::unique_ptr<PlanNode> child, const sql::Expression *predicate);
   static std::unique_ptr<PlanNode>
   project(std::unique_ptr<PlanNode> child,
-          std::vector<std::unique_ptr<sql::Expression>> exprs,
+          std::vector<const sql::Expression *> exprs,
           std::vector<std::string> names);
   static std::unique_ptr<PlanNode>
   sort(std::unique_ptr<PlanNode> child,
-       std::vector<std::unique_ptr<sql::Expression>> keys,
+       std::vector<const sql::Expression *> keys,
        std::vector<bool> ascending);
   static std::unique_ptr<PlanNode> limit(std::unique_ptr<PlanNode> child,
                                          int64_t limit, int64_t offset);
-  static std::unique_ptr<PlanNode> aggregate(std::unique_ptr<PlanNode> child,
-                                             std::vector<AggregateExpr> aggs);
   static std::unique_ptr<PlanNode>
-  insert(uint32_t table_id, const std::string &name,
-         std::vector<std::string> columns,
-         std::vector<std::vector<std::unique_ptr<sql::Expression>>> values);
+  aggregate(std::unique_ptr<PlanNode> child, std::vector<AggregateExpr> aggs,
+            std::vector<const sql::Expression *> group_by = {},
+            AggregateStrategy strategy = AggregateStrategy::HASH);
+  static std::unique_ptr<PlanNode>
+  metadata_aggregate(uint32_t table_id, const std::string &table_name,
+                     std::vector<AggregateExpr> aggs);
+  static std::unique_ptr<PlanNode> hash_join(std::unique_ptr<PlanNode> left,
+                                             std::unique_ptr<PlanNode> right,
+                                             sql::JoinType join_type);
+  static std::unique_ptr<PlanNode> index_join(std::unique_ptr<PlanNode> left,
+                                              uint32_t table_id,
+                                              const std::string &table_name,
+                                              sql::JoinType join_type);
+  static std::unique_ptr<PlanNode>
+  fetch(std::unique_ptr<PlanNode> child, uint32_t table_id,
+        const std::string &table_name, std::vector<uint32_t> columns);
+  static std::unique_ptr<PlanNode> insert(uint32_t table_id,
+                                          const std::string &name,
+                                          std::vector<std::string> columns,
+                                          sql::NodeList<sql::ExprList> values);
   static std::unique_ptr<PlanNode>
   create_table(const std::string &name, std::vector<sql::ColumnDef> columns,
-               bool if_not_exists);
+               bool if_not_exists,
+               storage::PageLayout layout = storage::PageLayout::ROW,
+               storage::TimePartitioning partitioning = {});
+  static std::unique_ptr<PlanNode> create_view(CreateViewNode view);
   static std::unique_ptr<PlanNode> drop_table(const std::string &name,
                                               bool if_exists);
+  static std::unique_ptr<PlanNode> analyze(std::vector<uint32_t> table_ids);
 };
 
+/**
+ * @brief Collect the tables a query plan reads
+ *
+ * A table read more than once is listed once.
+ *
+ * @return false if the plan's result is not a function of those tables'
+ *         contents alone: it is not a query, or samples a table without
+ *         REPEATABLE
+ */
+bool read_tables(const PlanNode &plan, std::vector<uint32_t> &tables);
+
 } // namespace planner
 } // namespace edgesql
@@ -4,137 +4,1647 @@
  */
 
 #include "planner.hpp"
+#include "rewrite.hpp"
+#include "../sql/parser.hpp"
 #include <algorithm>
+#include <cctype>
+#include <cmath>
 
 namespace edgesql {
 namespace planner {
 
+namespace {
+
+// Add the table columns an expression reads; false if it needs all of them
+bool collect_columns(const sql::Expression &expr, const TableInfo &table,
+                     std::vector<uint32_t> &out) {
+  switch (expr.type) {
+  case sql::ExprType::STAR:
+    return false;
+  case sql::ExprType::COLUMN_REF: {
+    int index = table.find_column(expr.name);
+    if (index < 0) {
+      return false;
+    }
+    if (std::find(out.begin(), out.end(), static_cast<uint32_t>(index)) ==
+        out.end()) {
+      out.push_back(static_cast<uint32_t>(index));
+    }
+    return true;
+  }
+  case sql::ExprType::BINARY_OP:
+    return collect_columns(*expr.left, table, out) &&
+           collect_columns(*expr.right, table, out);
+  case sql::ExprType::UNARY_OP:
+    return collect_columns(*expr.operand(), table, out);
+  case sql::ExprType::FUNCTION_CALL: {
+    for (const sql::Expression *arg : expr.args) {
+      if (!collect_columns(*arg, table, out)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  default:
+    return true;
+  }
+}
+
+// Columns a SELECT reads, in schema order; empty when it needs every column
+std::vector<uint32_t> referenced_columns(const sql::SelectStmt &stmt,
+                                         const TableInfo &table) {
+  std::vector<uint32_t> columns;
+  bool partial = true;
+  for (const sql::Expression *expr : stmt.columns) {
+    partial = partial && collect_columns(*expr, table, columns);
+  }
+  if (stmt.where_clause) {
+    partial = partial && collect_columns(*stmt.where_clause, table, columns);
+  }
+  for (const sql::Expression *expr : stmt.group_by) {
+    partial = partial && collect_columns(*expr, table, columns);
+  }
+  for (const auto &item : stmt.order_by) {
+    partial = partial && collect_columns(*item.expr, table, columns);
+  }
+
+  if (!partial || columns.size() == table.columns.size()) {
+    return {};
+  }
+  std::sort(columns.begin(), columns.end());
+  return columns;
+}
+
+// Integer constant of a comparison operand: a literal, optionally negated
+bool integer_constant(const sql::Expression &expr, int64_t &out) {
+  if (expr.type == sql::ExprType::LITERAL) {
+    out = expr.int_value;
+    return expr.literal_type == sql::Literal::Type::INTEGER;
+  }
+  if (expr.type == sql::ExprType::UNARY_OP) {
+    if (expr.unary_op == sql::UnaryOp::MINUS &&
+        integer_constant(*expr.operand(), out) && out != INT64_MIN) {
+      out = -out;
+      return true;
+    }
+  }
+  return false;
+}
+
+// A numeric literal within [0, 1]
+bool fraction_constant(const sql::Expression &expr, double &out) {
+  if (expr.type != sql::ExprType::LITERAL) {
+    return false;
+  }
+  if (expr.literal_type == sql::Literal::Type::INTEGER) {
+    out = static_cast<double>(expr.int_value);
+  } else if (expr.literal_type == sql::Literal::Type::FLOAT) {
+    out = expr.float_value;
+  } else {
+    return false;
+  }
+  return out >= 0.0 && out <= 1.0;
+}
+
+bool is_column(const sql::Expression &expr, const std::string &name) {
+  return expr.type == sql::ExprType::COLUMN_REF && expr.name == name;
+}
+
+// Narrow [lo, hi] by the conjuncts of a predicate that compare the column
+// with an integer constant; anything else leaves the range alone
+void narrow_range(const sql::Expression &expr, const std::string &column,
+                  int64_t &lo, int64_t &hi) {
+  if (expr.type != sql::ExprType::BINARY_OP) {
+    return;
+  }
+  if (expr.binary_op == sql::BinaryOp::AND) {
+    narrow_range(*expr.left, column, lo, hi);
+    narrow_range(*expr.right, column, lo, hi);
+    return;
+  }
+
+  // Normalize to `column op value`
+  sql::BinaryOp op = expr.binary_op;
+  int64_t value;
+  if (is_column(*expr.right, column) && integer_constant(*expr.left, value)) {
+    op = sql::mirror(op);
+  } else if (!is_column(*expr.left, column) ||
+             !integer_constant(*expr.right, value)) {
+    return;
+  }
+
+  switch (op) {
+  case sql::BinaryOp::EQ:
+    lo = std::max(lo, value);
+    hi = std::min(hi, value);
+    break;
+  case sql::BinaryOp::LT:
+    if (value == INT64_MIN) {
+      lo = INT64_MAX; // Nothing is below the minimum
+      hi = INT64_MIN;
+    } else {
+      hi = std::min(hi, value - 1);
+    }
+    break;
+  case sql::BinaryOp::LE:
+    hi = std::min(hi, value);
+    break;
+  case sql::BinaryOp::GT:
+    if (value == INT64_MAX) {
+      lo = INT64_MAX;
+      hi = INT64_MIN;
+    } else {
+      lo = std::max(lo, value + 1);
+    }
+    break;
+  case sql::BinaryOp::GE:
+    lo = std::max(lo, value);
+    break;
+  default:
+    break;
+  }
+}
+
+// Check whether a simplified predicate rejects every row: it is FALSE, or
+// its conjuncts leave some INTEGER column no possible value
+bool never_holds(const sql::Expression &predicate, const TableInfo &table) {
+  if (is_boolean(predicate, false)) {
+    return true;
+  }
+
+  std::vector<uint32_t> columns;
+  collect_columns(predicate, table, columns);
+  for (uint32_t column : columns) {
+    if (table.columns[column].type != storage::ColumnType::INTEGER) {
+      continue;
+    }
+    int64_t lo = INT64_MIN;
+    int64_t hi = INT64_MAX;
+    narrow_range(predicate, table.columns[column].name, lo, hi);
+    if (lo > hi) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Case-insensitive aggregate function name
+bool aggregate_type(std::string_view name, AggregateType &type) {
+  static constexpr std::pair<std::string_view, AggregateType> names[] = {
+      {"COUNT", AggregateType::COUNT},
+      {"SUM", AggregateType::SUM},
+      {"MIN", AggregateType::MIN},
+      {"MAX", AggregateType::MAX},
+      {"AVG", AggregateType::AVG},
+      {"APPROX_COUNT_DISTINCT", AggregateType::APPROX_COUNT_DISTINCT},
+      {"APPROX_PERCENTILE", AggregateType::APPROX_PERCENTILE},
+      {"$SUM0", AggregateType::SUM0}}; // Only made by view rewrites
+  for (const auto &[candidate, candidate_type] : names) {
+    if (name.size() == candidate.size() &&
+        std::equal(name.begin(), name.end(), candidate.begin(),
+                   [](char a, char b) {
+                     return std::toupper(static_cast<unsigned char>(a)) == b;
+                   })) {
+      type = candidate_type;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool contains_aggregate(const sql::Expression &expr) {
+  AggregateType unused;
+  switch (expr.type) {
+  case sql::ExprType::FUNCTION_CALL:
+    return aggregate_type(expr.name, unused);
+  case sql::ExprType::BINARY_OP:
+    return contains_aggregate(*expr.left) || contains_aggregate(*expr.right);
+  case sql::ExprType::UNARY_OP:
+    return contains_aggregate(*expr.operand());
+  default:
+    return false;
+  }
+}
+
+// Whether table metadata holds the aggregates: counts of rows or of a
+// column's values, and MIN and MAX of INTEGER and FLOAT columns
+bool metadata_aggregates(const std::vector<AggregateExpr> &aggregates,
+                         const TableInfo &table, const Bindings &bindings) {
+  for (const AggregateExpr &aggregate : aggregates) {
+    if (!aggregate.arg) {
+      continue; // COUNT(*)
+    }
+    const sql::Expression &arg = *aggregate.arg;
+    int32_t column = bindings.position(arg);
+    if (arg.type != sql::ExprType::COLUMN_REF || column < 0 ||
+        static_cast<size_t>(column) >= table.columns.size()) {
+      return false;
+    }
+    storage::ColumnType type = table.columns[column].type;
+    bool ranged = type == storage::ColumnType::INTEGER ||
+                  type == storage::ColumnType::FLOAT;
+    if (aggregate.type != AggregateType::COUNT &&
+        !((aggregate.type == AggregateType::MIN ||
+           aggregate.type == AggregateType::MAX) &&
+          ranged)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Structural equality, for matching output expressions to GROUP BY keys
+bool same_expression(const sql::Expression &a, const sql::Expression &b,
+                     const Bindings &bindings) {
+  if (a.type != b.type) {
+    return false;
+  }
+  switch (a.type) {
+  case sql::ExprType::LITERAL:
+    if (a.literal_type != b.literal_type) {
+      return false;
+    }
+    switch (a.literal_type) {
+    case sql::Literal::Type::FLOAT:
+      return a.float_value == b.float_value;
+    case sql::Literal::Type::BOOLEAN:
+      return a.bool_value == b.bool_value;
+    case sql::Literal::Type::STRING:
+      return a.string_value == b.string_value;
+    default:
+      return a.int_value == b.int_value;
+    }
+  case sql::ExprType::COLUMN_REF:
+    // Both are bound to the one table, so positions decide
+    return bindings.position(a) == bindings.position(b) &&
+           bindings.position(a) >= 0;
+  case sql::ExprType::BINARY_OP:
+    return a.binary_op == b.binary_op &&
+           same_expression(*a.left, *b.left, bindings) &&
+           same_expression(*a.right, *b.right, bindings);
+  case sql::ExprType::UNARY_OP:
+    return a.unary_op == b.unary_op &&
+           same_expression(*a.operand(), *b.operand(), bindings);
+  case sql::ExprType::FUNCTION_CALL:
+    if (a.name != b.name || a.distinct != b.distinct ||
+        a.args.size() != b.args.size()) {
+      return false;
+    }
+    for (size_t i = 0; i < a.args.size(); ++i) {
+      if (!same_expression(*a.args[i], *b.args[i], bindings)) {
+        return false;
+      }
+    }
+    return true;
+  default:
+    return true;
+  }
+}
+
+// Row estimate from a fractional one
+uint64_t estimate(double rows) {
+  if (!(rows > 0.0)) {
+    return 0;
+  }
+  return rows >= 1.8e19 ? UINT64_MAX
+                        : static_cast<uint64_t>(std::llround(rows));
+}
+
+// Append an output column, named by its alias, column or function
+void add_output(ProjectNode &project, const sql::Expression &expr,
+                const Bindings &bindings) {
+  std::string name;
+  if (!expr.alias.empty()) {
+    name = std::string(expr.alias);
+  } else if (expr.type == sql::ExprType::COLUMN_REF ||
+             expr.type == sql::ExprType::FUNCTION_CALL) {
+    name = std::string(expr.name);
+  } else {
+    name = "column" + std::to_string(project.expressions.size() + 1);
+  }
+  project.expressions.push_back(&expr);
+  project.output_names.push_back(std::move(name));
+  project.columns.push_back(bindings.position(expr));
+}
+
+constexpr int AMBIGUOUS_COLUMN = -2;
+
+// Left rows an index join looks up at once
+constexpr uint32_t INDEX_JOIN_BATCH = 256;
+
+// Most of the rows read that may reach the output of a late-materialized
+// scan; fetching costs a second page access per row
+constexpr double LATE_FETCH_FRACTION = 0.25;
+
+// Position of a column reference in a table's rows: -1 when there is no
+// such column, AMBIGUOUS_COLUMN when several joined tables have it. A
+// join's combined columns form a table without a name, each called
+// `table.column`.
+int find_reference(const sql::Expression &ref, const TableInfo &table) {
+  if (!table.name.empty()) {
+    if (!ref.table_name.empty() && ref.table_name != table.name) {
+      return -1;
+    }
+    return table.find_column(ref.name);
+  }
+
+  int found = -1;
+  for (size_t i = 0; i < table.columns.size(); ++i) {
+    std::string_view name = table.columns[i].name;
+    size_t dot = name.find('.');
+    if (name.substr(dot + 1) != ref.name ||
+        (!ref.table_name.empty() && name.substr(0, dot) != ref.table_name)) {
+      continue;
+    }
+    if (found >= 0) {
+      return AMBIGUOUS_COLUMN;
+    }
+    found = static_cast<int>(i);
+  }
+  return found;
+}
+
+// Check whether a table, or one of a join's tables, goes by a name
+bool has_table(const TableInfo &table, std::string_view name) {
+  if (!table.name.empty()) {
+    return table.name == name;
+  }
+  for (const auto &column : table.columns) {
+    if (std::string_view(column.name).substr(0, column.name.find('.')) ==
+        name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Output name of a column: a join's combined columns drop the table
+std::string column_label(const ColumnInfo &column) {
+  return column.name.substr(column.name.find('.') + 1);
+}
+
+// Mark the columns an expression reads; references that do not resolve,
+// such as ORDER BY aliases, are skipped
+void mark_columns(const sql::Expression &expr, const TableInfo &table,
+                  std::vector<bool> &used) {
+  switch (expr.type) {
+  case sql::ExprType::COLUMN_REF: {
+    int index = find_reference(expr, table);
+    if (index >= 0) {
+      used[index] = true;
+    }
+    break;
+  }
+  case sql::ExprType::BINARY_OP:
+    mark_columns(*expr.left, table, used);
+    mark_columns(*expr.right, table, used);
+    break;
+  case sql::ExprType::UNARY_OP:
+    mark_columns(*expr.operand(), table, used);
+    break;
+  case sql::ExprType::FUNCTION_CALL:
+    for (const sql::Expression *arg : expr.args) {
+      mark_columns(*arg, table, used);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+// Split an AND tree into its conjuncts
+void split_conjuncts(const sql::Expression *expr,
+                     std::vector<const sql::Expression *> &out) {
+  if (expr->type == sql::ExprType::BINARY_OP &&
+      expr->binary_op == sql::BinaryOp::AND) {
+    split_conjuncts(expr->left, out);
+    split_conjuncts(expr->right, out);
+    return;
+  }
+  out.push_back(expr);
+}
+
+// AND of conjuncts, or nullptr when there are none
+const sql::Expression *
+conjunction(const std::vector<const sql::Expression *> &conjuncts,
+            memory::Arena &arena) {
+  const sql::Expression *result = nullptr;
+  for (const sql::Expression *conjunct : conjuncts) {
+    result = result ? sql::Expression::binary(arena, sql::BinaryOp::AND,
+                                              result, conjunct)
+                    : conjunct;
+  }
+  return result;
+}
+
+// The first and last of a join's tables, by offset, whose columns a bound
+// expression reads; lo > hi when it reads none
+void table_range(const sql::Expression &expr, const Bindings &bindings,
+                 const std::vector<uint32_t> &offsets, int &lo, int &hi) {
+  switch (expr.type) {
+  case sql::ExprType::COLUMN_REF: {
+    auto after =
+        std::upper_bound(offsets.begin(), offsets.end(),
+                         static_cast<uint32_t>(bindings.position(expr)));
+    int table = static_cast<int>(after - offsets.begin()) - 1;
+    lo = std::min(lo, table);
+    hi = std::max(hi, table);
+    break;
+  }
+  case sql::ExprType::BINARY_OP:
+    table_range(*expr.left, bindings, offsets, lo, hi);
+    table_range(*expr.right, bindings, offsets, lo, hi);
+    break;
+  case sql::ExprType::UNARY_OP:
+    table_range(*expr.operand(), bindings, offsets, lo, hi);
+    break;
+  case sql::ExprType::FUNCTION_CALL:
+    for (const sql::Expression *arg : expr.args) {
+      table_range(*arg, bindings, offsets, lo, hi);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+// Rebind the column references of an expression evaluated on one table's
+// rows instead of the joined row
+void rebase_columns(const sql::Expression &expr, uint32_t offset,
+                    Bindings &bindings) {
+  switch (expr.type) {
+  case sql::ExprType::COLUMN_REF:
+    bindings.bind(expr,
+                  bindings.position(expr) - static_cast<int32_t>(offset));
+    break;
+  case sql::ExprType::BINARY_OP:
+    rebase_columns(*expr.left, offset, bindings);
+    rebase_columns(*expr.right, offset, bindings);
+    break;
+  case sql::ExprType::UNARY_OP:
+    rebase_columns(*expr.operand(), offset, bindings);
+    break;
+  case sql::ExprType::FUNCTION_CALL:
+    for (const sql::Expression *arg : expr.args) {
+      rebase_columns(*arg, offset, bindings);
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+bool numeric(storage::ColumnType type) {
+  return type == storage::ColumnType::INTEGER ||
+         type == storage::ColumnType::FLOAT;
+}
+
+// Type of an expression's values on a table's rows, as far as its form
+// tells; false for NULL and for function calls
+bool value_type(const sql::Expression &expr, const TableInfo &table,
+                const Bindings &bindings, storage::ColumnType &type) {
+  switch (expr.type) {
+  case sql::ExprType::LITERAL:
+    switch (expr.literal_type) {
+    case sql::Literal::Type::INTEGER:
+      type = storage::ColumnType::INTEGER;
+      return true;
+    case sql::Literal::Type::FLOAT:
+      type = storage::ColumnType::FLOAT;
+      return true;
+    case sql::Literal::Type::STRING:
+      type = storage::ColumnType::TEXT;
+      return true;
+    case sql::Literal::Type::BOOLEAN:
+      type = storage::ColumnType::BOOLEAN;
+      return true;
+    default:
+      return false;
+    }
+  case sql::ExprType::COLUMN_REF: {
+    int32_t column = bindings.position(expr);
+    if (column < 0 || static_cast<size_t>(column) >= table.columns.size()) {
+      return false;
+    }
+    type = table.columns[column].type;
+    return true;
+  }
+  case sql::ExprType::BINARY_OP: {
+    switch (expr.binary_op) {
+    case sql::BinaryOp::ADD:
+    case sql::BinaryOp::SUB:
+    case sql::BinaryOp::MUL:
+    case sql::BinaryOp::DIV:
+    case sql::BinaryOp::MOD:
+      break;
+    default:
+      type = storage::ColumnType::BOOLEAN;
+      return true;
+    }
+    // Arithmetic stays INTEGER unless a FLOAT is involved
+    storage::ColumnType left;
+    storage::ColumnType right;
+    if (!value_type(*expr.left, table, bindings, left) ||
+        !value_type(*expr.right, table, bindings, right) || !numeric(left) ||
+        !numeric(right)) {
+      return false;
+    }
+    type = left == storage::ColumnType::FLOAT ? left : right;
+    return true;
+  }
+  case sql::ExprType::UNARY_OP:
+    if (expr.unary_op == sql::UnaryOp::NOT) {
+      type = storage::ColumnType::BOOLEAN;
+      return true;
+    }
+    return value_type(*expr.operand(), table, bindings, type);
+  default:
+    return false;
+  }
+}
+
+// Name of an output column, as add_output gives it; empty when the
+// column would be numbered instead
+std::string_view output_name(const sql::Expression &expr) {
+  if (!expr.alias.empty()) {
+    return expr.alias;
+  }
+  if (expr.type == sql::ExprType::COLUMN_REF ||
+      expr.type == sql::ExprType::FUNCTION_CALL) {
+    return expr.name;
+  }
+  return {};
+}
+
+// Maps expressions on a base table's rows to expressions on the rows of
+// one of its materialized views: group keys become the view's key
+// columns, and aggregates become aggregates of the groups' states, so an
+// aggregate query over the table is answered from the view. nullptr
+// where the view does not hold what the expression needs.
+class ViewMatcher {
+public:
+  ViewMatcher(const MaterializedView &view, const TableInfo &view_table,
+              const Bindings &bindings, memory::Arena &arena)
+      : view_(view), view_table_(view_table), bindings_(bindings),
+        arena_(arena) {}
+
+  const sql::Expression *map(const sql::Expression &expr) const {
+    for (size_t i = 0; i < view_.keys.size(); ++i) {
+      if (same_expression(expr, *view_.keys[i], bindings_)) {
+        return column(static_cast<uint32_t>(i));
+      }
+    }
+
+    switch (expr.type) {
+    case sql::ExprType::LITERAL:
+      return &expr;
+    case sql::ExprType::BINARY_OP: {
+      const sql::Expression *left = map(*expr.left);
+      const sql::Expression *right = left ? map(*expr.right) : nullptr;
+      return right ? sql::Expression::binary(arena_, expr.binary_op, left,
+                                             right)
+                   : nullptr;
+    }
+    case sql::ExprType::UNARY_OP: {
+      const sql::Expression *operand = map(*expr.operand());
+      return operand ? sql::Expression::unary(arena_, expr.unary_op, operand)
+                     : nullptr;
+    }
+    case sql::ExprType::FUNCTION_CALL:
+      return map_aggregate(expr);
+    default:
+      return nullptr; // Columns other than keys, and *
+    }
+  }
+
+private:
+  // COUNT sums the groups' counts, SUM their sums, MIN and MAX take the
+  // extremes of theirs, and AVG divides the summed sums by the counts
+  const sql::Expression *map_aggregate(const sql::Expression &call) const {
+    AggregateType type;
+    if (!aggregate_type(call.name, type) || call.distinct ||
+        call.args.size() != 1) {
+      return nullptr;
+    }
+    const sql::Expression &arg = *call.args[0];
+    bool star = arg.type == sql::ExprType::STAR;
+
+    for (size_t i = 0; i < view_.aggregates.size(); ++i) {
+      const AggregateExpr &held = view_.aggregates[i];
+      uint32_t state = view_.state_columns[i];
+      if (held.arg ? star || !same_expression(arg, *held.arg, bindings_)
+                   : !star) {
+        continue;
+      }
+      switch (type) {
+      case AggregateType::COUNT:
+        // Zero groups count 0 rows, where SUM would be NULL
+        if (held.type == AggregateType::COUNT) {
+          return call_on("$SUM0", state);
+        }
+        if (held.type == AggregateType::AVG) {
+          return call_on("$SUM0", state + 1);
+        }
+        break;
+      case AggregateType::SUM:
+      case AggregateType::MIN:
+      case AggregateType::MAX:
+        if (held.type == type) {
+          return call_on(call.name, state);
+        }
+        break;
+      case AggregateType::AVG:
+        if (held.type == AggregateType::AVG) {
+          return sql::Expression::binary(arena_, sql::BinaryOp::DIV,
+                                         call_on("SUM", state),
+                                         call_on("SUM", state + 1));
+        }
+        break;
+      default:
+        break;
+      }
+    }
+    return nullptr;
+  }
+
+  const sql::Expression *column(uint32_t index) const {
+    return sql::Expression::column(
+        arena_, sql::copy_text(arena_, view_table_.columns[index].name));
+  }
+
+  const sql::Expression *call_on(std::string_view function,
+                                 uint32_t index) const {
+    sql::ExprList args;
+    args.push_back(arena_, column(index));
+    return sql::Expression::function(arena_, function, args);
+  }
+
+  const MaterializedView &view_;
+  const TableInfo &view_table_;
+  const Bindings &bindings_;
+  memory::Arena &arena_;
+};
+
+} // anonymous namespace
+
 Planner::Planner(Catalog &catalog) : catalog_(catalog) {}
 
 std::optional<std::unique_ptr<PlanNode>>
-Planner::plan(const sql::Statement &stmt) {
+Planner::plan(const sql::Statement &stmt, memory::Arena &arena) {
   has_error_ = false;
 
+  // Bindings live in the statement's arena, next to the expressions
+  bindings_ = sql::make_node<Bindings>(arena);
+  *bindings_ = Bindings(arena);
+
   std::unique_ptr<PlanNode> plan;
 
   switch (stmt.type) {
   case sql::StmtType::SELECT: {
-    const auto *select =
-        std::get_if<std::unique_ptr<sql::SelectStmt>>(&stmt.stmt);
+    const auto *select = std::get_if<const sql::SelectStmt *>(&stmt.stmt);
     if (select) {
-      plan = plan_select(**select);
+      plan = plan_select(**select, arena);
+    }
+    break;
+  }
+  case sql::StmtType::INSERT: {
+    const auto *insert = std::get_if<const sql::InsertStmt *>(&stmt.stmt);
+    if (insert) {
+      plan = plan_insert(**insert, arena);
+    }
+    break;
+  }
+  case sql::StmtType::CREATE_TABLE: {
+    const auto *create =
+        std::get_if<const sql::CreateTableStmt *>(&stmt.stmt);
+    if (create) {
+      plan = plan_create_table(**create);
+    }
+    break;
+  }
+  case sql::StmtType::CREATE_VIEW: {
+    const auto *create = std::get_if<const sql::CreateViewStmt *>(&stmt.stmt);
+    if (create) {
+      plan = plan_create_view(**create);
+    }
+    break;
+  }
+  case sql::StmtType::DROP_TABLE: {
+    const auto *drop = std::get_if<const sql::DropTableStmt *>(&stmt.stmt);
+    if (drop) {
+      plan = plan_drop_table(**drop);
+    }
+    break;
+  }
+  case sql::StmtType::ANALYZE: {
+    const auto *analyze = std::get_if<const sql::AnalyzeStmt *>(&stmt.stmt);
+    if (analyze) {
+      plan = plan_analyze(**analyze);
+    }
+    break;
+  }
+  }
+
+  if (has_error_ || !plan) {
+    return std::nullopt;
+  }
+
+  plan->bindings = bindings_;
+  return plan;
+}
+
+std::unique_ptr<PlanNode> Planner::plan_select(const sql::SelectStmt &original,
+                                               memory::Arena &arena) {
+  // Look up table
+  const TableInfo *table =
+      catalog_.get_table(std::string(original.table_name));
+  if (!table) {
+    set_error("Table not found: " + std::string(original.table_name));
+    return nullptr;
+  }
+
+  // Plan the statement with its WHERE simplified; a predicate that always
+  // holds is dropped
+  sql::SelectStmt stmt = original;
+  if (stmt.where_clause) {
+    stmt.where_clause = simplify_predicate(*stmt.where_clause, arena);
+    if (is_boolean(*stmt.where_clause, true)) {
+      stmt.where_clause = nullptr;
+    }
+  }
+
+  // With joins, columns are bound to their position in the joined row;
+  // an alias renames the table for binding
+  std::vector<Source> sources;
+  TableInfo scope;
+  if (!stmt.joins.empty()) {
+    if (!combine_tables(stmt, sources, scope)) {
+      return nullptr;
+    }
+    table = &scope;
+  } else if (!stmt.table_alias.empty()) {
+    scope = *table;
+    scope.name = std::string(stmt.table_alias);
+    table = &scope;
+  }
+
+  // Validate columns
+  if (!validate_columns(stmt, table)) {
+    return nullptr;
+  }
+
+  // An aggregate query one of the table's materialized views holds the
+  // groups for reads the view's rows instead
+  if (sources.empty() && !stmt.table_sample &&
+      (detect_aggregates(stmt.columns) || !stmt.group_by.empty())) {
+    if (const sql::SelectStmt *rewritten =
+            answer_from_view(stmt, *table, arena)) {
+      return plan_select(*rewritten, arena);
+    }
+    if (has_error_) {
+      return nullptr;
+    }
+  }
+
+  std::unique_ptr<PlanNode> plan;
+  if (sources.empty()) {
+    plan = plan_access(stmt, *table, CostModel(*table, *bindings_));
+  } else {
+    plan = plan_join(stmt, arena, sources, scope);
+    if (!plan) {
+      return nullptr;
+    }
+    // Later stages cost the join's output like a table of its rows
+    scope.row_count = std::max<uint64_t>(plan->estimated_rows, 1);
+  }
+  CostModel model(*table, *bindings_);
+
+  if (detect_aggregates(stmt.columns) || !stmt.group_by.empty()) {
+    return plan_aggregate(stmt, *table, model, std::move(plan));
+  }
+
+  // Output columns, with SELECT * expanded to the table's columns
+  ProjectNode project;
+  bool identity = true;
+  for (const sql::Expression *expr : stmt.columns) {
+    if (expr->type == sql::ExprType::STAR) {
+      for (size_t i = 0; i < table->columns.size(); ++i) {
+        identity = identity && project.columns.size() == i;
+        project.expressions.push_back(expr);
+        project.output_names.push_back(column_label(table->columns[i]));
+        project.columns.push_back(static_cast<int32_t>(i));
+      }
+      continue;
+    }
+
+    identity = false;
+    add_output(project, *expr, *bindings_);
+  }
+
+  // Sort the table's rows before projecting, so keys may use any column
+  std::vector<const sql::Expression *> keys;
+  std::vector<int32_t> key_columns;
+  std::vector<bool> ascending;
+  for (const auto &item : stmt.order_by) {
+    const sql::Expression *key = nullptr;
+    int32_t column = -1;
+    if (!resolve_sort_key(*item.expr, project, key, column)) {
+      return nullptr;
+    }
+    if (key == item.expr && !bind_columns(*key, *table)) {
+      return nullptr;
+    }
+    keys.push_back(key);
+    key_columns.push_back(column >= 0 ? column : bindings_->position(*key));
+    ascending.push_back(item.ascending);
+  }
+
+  // Columns only the output needs may be read for surviving rows alone
+  std::vector<uint32_t> deferred;
+  double row_bytes = model.row_bytes();
+  if (sources.empty()) {
+    deferred = defer_columns(stmt, *table, model, keys, key_columns, *plan);
+    for (uint32_t column : deferred) {
+      row_bytes -= model.value_bytes(column);
+    }
+  }
+
+  if (!keys.empty()) {
+    plan = plan_sort(stmt, std::move(plan), std::move(keys),
+                     std::move(key_columns), std::move(ascending), row_bytes);
+  }
+
+  plan = plan_limit(stmt, std::move(plan));
+
+  if (!deferred.empty()) {
+    double cost = plan->estimated_cost +
+                  model.fetch_cost(static_cast<double>(plan->estimated_rows));
+    uint64_t rows = plan->estimated_rows;
+    plan = PlanNode::fetch(std::move(plan), table->id, table->name,
+                           std::move(deferred));
+    plan->estimated_cost = cost;
+    plan->estimated_rows = rows;
+  }
+
+  // Project last so it only sees rows that survive the limit. SELECT *
+  // keeps the scan's rows as they are.
+  if (!identity) {
+    plan = project_node(std::move(plan), std::move(project));
+  }
+
+  return plan;
+}
+
+std::unique_ptr<PlanNode> Planner::plan_access(const sql::SelectStmt &stmt,
+                                               const TableInfo &table,
+                                               const CostModel &model) {
+  // A predicate that can never hold reads nothing
+  if (stmt.where_clause && never_holds(*stmt.where_clause, table)) {
+    std::vector<std::string> names;
+    for (const auto &column : table.columns) {
+      names.push_back(column.name);
+    }
+    return PlanNode::empty(std::move(names));
+  }
+
+  double rows = model.rows();
+  double scan_cost = model.scan_cost();
+
+  // A primary key range in WHERE can be read through the index instead,
+  // when the rows it matches are few enough to beat reading every page
+  int key = table.primary_key_column();
+  int64_t lo = INT64_MIN;
+  int64_t hi = INT64_MAX;
+  if (key >= 0 && stmt.where_clause) {
+    narrow_range(*stmt.where_clause, table.columns[key].name, lo, hi);
+  }
+
+  std::unique_ptr<PlanNode> plan;
+  std::vector<uint32_t> *columns = nullptr;
+  double matched = rows * model.range_selectivity(key, lo, hi);
+  double index_cost = model.index_scan_cost(matched);
+  const sql::TableSample *sample = stmt.table_sample;
+  if (!sample && (lo != INT64_MIN || hi != INT64_MAX) &&
+      index_cost < scan_cost) {
+    plan = PlanNode::index_scan(table.id, table.name,
+                                static_cast<uint32_t>(key), lo, hi);
+    columns = &std::get<IndexScanNode>(plan->node).column_indices;
+    plan->estimated_cost = index_cost;
+    plan->estimated_rows = estimate(matched);
+  } else {
+    plan = PlanNode::table_scan(table.id, table.name);
+    auto &scan = std::get<TableScanNode>(plan->node);
+    columns = &scan.column_indices;
+    plan->estimated_cost = scan_cost;
+
+    // A sample keeps its fraction of the pages, or of the rows
+    if (sample) {
+      scan.sample = sample;
+      rows *= sample->percent / 100.0;
+      plan->estimated_cost = model.sample_scan_cost(*sample);
+    }
+    plan->estimated_rows = estimate(rows);
+
+    // A time range in WHERE lets the scan skip whole partitions
+    if (table.partitioning.enabled() && stmt.where_clause) {
+      const auto &time_column = table.columns[table.partitioning.column];
+      narrow_range(*stmt.where_clause, time_column.name, scan.time_lo,
+                   scan.time_hi);
+    }
+  }
+
+  // Read only the columns the query touches
+  *columns = referenced_columns(stmt, table);
+
+  // The filter, sort and projection share the statement's expressions
+  if (stmt.where_clause) {
+    uint64_t input = plan->estimated_rows;
+    double cost = plan->estimated_cost +
+                  CostModel::filter_cost(*stmt.where_clause,
+                                         static_cast<double>(input));
+    plan = PlanNode::filter(std::move(plan), stmt.where_clause);
+    plan->estimated_cost = cost;
+    plan->estimated_rows = std::min(
+        input, estimate(rows * model.selectivity(*stmt.where_clause)));
+  }
+
+  return plan;
+}
+
+bool Planner::combine_tables(const sql::SelectStmt &stmt,
+                             std::vector<Source> &sources,
+                             TableInfo &combined) {
+  // Statistics carry over when every table has them
+  combined.id = 0;
+  TableStats combined_stats;
+  combined_stats.analyzed = true;
+
+  auto add = [&](std::string_view name, std::string_view alias,
+                 const sql::TableSample *sample) {
+    const TableInfo *table = catalog_.get_table(std::string(name));
+    if (!table) {
+      set_error("Table not found: " + std::string(name));
+      return false;
+    }
+    std::string qualifier(alias.empty() ? name : alias);
+    for (const Source &source : sources) {
+      if (source.qualifier == qualifier) {
+        set_error("Table joined twice without an alias: " + qualifier);
+        return false;
+      }
+    }
+
+    uint32_t offset = static_cast<uint32_t>(combined.columns.size());
+    sources.push_back(Source{table, qualifier, offset, sample});
+    for (const ColumnInfo &column : table->columns) {
+      ColumnInfo info = column;
+      info.name = qualifier + "." + column.name;
+      info.primary_key = false; // Unique in its table, not in the join
+      info.index = offset + column.index;
+      combined.columns.push_back(std::move(info));
+    }
+
+    std::shared_ptr<const TableStats> stats = table->statistics();
+    combined_stats.analyzed = combined_stats.analyzed && stats->analyzed &&
+                              stats->columns.size() == table->columns.size();
+    if (combined_stats.analyzed) {
+      combined_stats.columns.insert(combined_stats.columns.end(),
+                                    stats->columns.begin(),
+                                    stats->columns.end());
+    }
+    return true;
+  };
+
+  if (!add(stmt.table_name, stmt.table_alias, stmt.table_sample)) {
+    return false;
+  }
+  for (const sql::JoinClause &join : stmt.joins) {
+    if (!add(join.table_name, join.alias, join.sample)) {
+      return false;
+    }
+  }
+  if (!combined_stats.analyzed) {
+    combined_stats.columns.clear();
+  }
+  combined.set_statistics(std::move(combined_stats));
+  return true;
+}
+
+std::unique_ptr<PlanNode> Planner::plan_join(const sql::SelectStmt &stmt,
+                                             memory::Arena &arena,
+                                             const std::vector<Source> &sources,
+                                             const TableInfo &combined) {
+  // Columns each table must read
+  std::vector<bool> used(combined.columns.size(), false);
+  for (const sql::Expression *expr : stmt.columns) {
+    if (expr->type == sql::ExprType::STAR) {
+      used.assign(used.size(), true);
+    }
+    mark_columns(*expr, combined, used);
+  }
+  if (stmt.where_clause) {
+    mark_columns(*stmt.where_clause, combined, used);
+  }
+  for (const sql::JoinClause &join : stmt.joins) {
+    mark_columns(*join.condition, combined, used);
+  }
+  for (const sql::Expression *expr : stmt.group_by) {
+    mark_columns(*expr, combined, used);
+  }
+  for (const auto &item : stmt.order_by) {
+    mark_columns(*item.expr, combined, used);
+  }
+
+  // Each conjunct is applied as early as it can be. A conjunct of WHERE
+  // or of an INNER join's condition filters rows wherever its tables are
+  // joined: in a table's scan, unless a LEFT join pads that table with
+  // NULLs, else at the join that brings in the last table it reads. A
+  // LEFT join's condition only decides matches, so stays at its join
+  // except for the part that filters the joined table alone.
+  size_t count = sources.size();
+  std::vector<uint32_t> offsets;
+  for (const Source &source : sources) {
+    offsets.push_back(source.offset);
+  }
+  std::vector<std::vector<const sql::Expression *>> scan_filters(count);
+  std::vector<std::vector<const sql::Expression *>> join_conjuncts(count);
+  std::vector<std::vector<const sql::Expression *>> join_filters(count);
+
+  auto padded = [&](int table) {
+    return table > 0 && stmt.joins[table - 1].type == sql::JoinType::LEFT;
+  };
+  auto place = [&](const sql::Expression *conjunct) {
+    int lo = static_cast<int>(count);
+    int hi = 0;
+    table_range(*conjunct, *bindings_, offsets, lo, hi);
+    lo = std::min(lo, hi);
+    if (lo == hi && !padded(hi)) {
+      scan_filters[hi].push_back(conjunct);
+    } else if (padded(hi)) {
+      join_filters[hi].push_back(conjunct);
+    } else {
+      join_conjuncts[hi].push_back(conjunct);
+    }
+  };
+
+  std::vector<const sql::Expression *> conjuncts;
+  if (stmt.where_clause) {
+    split_conjuncts(stmt.where_clause, conjuncts);
+  }
+  for (const sql::Expression *conjunct : conjuncts) {
+    place(conjunct);
+  }
+
+  for (size_t i = 0; i < stmt.joins.size(); ++i) {
+    const sql::JoinClause &join = stmt.joins[i];
+    const sql::Expression *condition =
+        simplify_predicate(*join.condition, arena);
+    if (!bind_columns(*condition, combined)) {
+      return nullptr;
+    }
+    if (is_boolean(*condition, true)) {
+      continue;
+    }
+
+    int joined = static_cast<int>(i + 1);
+    conjuncts.clear();
+    split_conjuncts(condition, conjuncts);
+    for (const sql::Expression *conjunct : conjuncts) {
+      int lo = static_cast<int>(count);
+      int hi = -1;
+      table_range(*conjunct, *bindings_, offsets, lo, hi);
+      if (hi > joined) {
+        set_error("JOIN condition reads a table joined after it: " +
+                  std::string(join.table_name));
+        return nullptr;
+      }
+      if (join.type == sql::JoinType::INNER) {
+        place(conjunct);
+      } else if (lo == joined && hi == joined) {
+        scan_filters[joined].push_back(conjunct);
+      } else {
+        join_conjuncts[joined].push_back(conjunct);
+      }
     }
-    break;
   }
-  case sql::StmtType::INSERT: {
-    const auto *insert =
-        std::get_if<std::unique_ptr<sql::InsertStmt>>(&stmt.stmt);
-    if (insert) {
-      plan = plan_insert(**insert);
+
+  // Joins nest to the left: each brings one table into the rows so far
+  CostModel model(combined, *bindings_);
+  auto plan = plan_source(sources[0], scan_filters[0], used, arena);
+  for (size_t i = 1; i < count; ++i) {
+    auto right = plan_source(sources[i], scan_filters[i], used, arena);
+    plan = plan_hash_join(std::move(plan), std::move(right),
+                          stmt.joins[i - 1].type, join_conjuncts[i], sources,
+                          i, model, arena);
+    plan = plan_index_join(std::move(plan), sources[i]);
+
+    if (!join_filters[i].empty()) {
+      const sql::Expression *predicate = conjunction(join_filters[i], arena);
+      uint64_t input = plan->estimated_rows;
+      double cost =
+          plan->estimated_cost +
+          CostModel::filter_cost(*predicate, static_cast<double>(input));
+      plan = PlanNode::filter(std::move(plan), predicate);
+      plan->estimated_cost = cost;
+      plan->estimated_rows = estimate(static_cast<double>(input) *
+                                      model.selectivity(*predicate));
     }
-    break;
   }
-  case sql::StmtType::CREATE_TABLE: {
-    const auto *create =
-        std::get_if<std::unique_ptr<sql::CreateTableStmt>>(&stmt.stmt);
-    if (create) {
-      plan = plan_create_table(**create);
+  return plan;
+}
+
+std::unique_ptr<PlanNode>
+Planner::plan_source(const Source &source,
+                     const std::vector<const sql::Expression *> &filters,
+                     const std::vector<bool> &used, memory::Arena &arena) {
+  // Planned as a SELECT of the columns the query reads from the table,
+  // filtered by the conjuncts that read only it, so it gets the same
+  // access path a query of the table alone would
+  const TableInfo &table = *source.table;
+  sql::SelectStmt scan;
+  scan.table_name = table.name;
+  for (const ColumnInfo &column : table.columns) {
+    if (used[source.offset + column.index]) {
+      scan.columns.push_back(arena, sql::Expression::column(arena,
+                                                            column.name));
     }
-    break;
   }
-  case sql::StmtType::DROP_TABLE: {
-    const auto *drop =
-        std::get_if<std::unique_ptr<sql::DropTableStmt>>(&stmt.stmt);
-    if (drop) {
-      plan = plan_drop_table(**drop);
+  if (scan.columns.empty()) {
+    scan.columns.push_back(
+        arena, sql::Expression::column(arena, table.columns[0].name));
+  }
+
+  for (const sql::Expression *filter : filters) {
+    rebase_columns(*filter, source.offset, *bindings_);
+  }
+  scan.where_clause = conjunction(filters, arena);
+  scan.table_sample = source.sample;
+  return plan_access(scan, table, CostModel(table, *bindings_));
+}
+
+std::unique_ptr<PlanNode> Planner::plan_hash_join(
+    std::unique_ptr<PlanNode> left, std::unique_ptr<PlanNode> right,
+    sql::JoinType type, const std::vector<const sql::Expression *> &conjuncts,
+    const std::vector<Source> &sources, size_t joined, const CostModel &model,
+    memory::Arena &arena) {
+  const Source &source = sources[joined];
+  int table = static_cast<int>(joined);
+  std::vector<uint32_t> offsets;
+  for (const Source &s : sources) {
+    offsets.push_back(s.offset);
+  }
+
+  // `left = right` conjuncts, each side reading only its input, are the
+  // hash keys; the rest is checked on the joined row
+  std::vector<const sql::Expression *> left_keys;
+  std::vector<const sql::Expression *> right_keys;
+  std::vector<const sql::Expression *> residual;
+  for (const sql::Expression *conjunct : conjuncts) {
+    if (conjunct->type == sql::ExprType::BINARY_OP &&
+        conjunct->binary_op == sql::BinaryOp::EQ) {
+      int left_lo = table, left_hi = -1, right_lo = table, right_hi = -1;
+      table_range(*conjunct->left, *bindings_, offsets, left_lo, left_hi);
+      table_range(*conjunct->right, *bindings_, offsets, right_lo, right_hi);
+      if (left_hi >= 0 && left_hi < table && right_lo == table &&
+          right_hi == table) {
+        left_keys.push_back(conjunct->left);
+        right_keys.push_back(conjunct->right);
+        continue;
+      }
+      if (right_hi >= 0 && right_hi < table && left_lo == table &&
+          left_hi == table) {
+        left_keys.push_back(conjunct->right);
+        right_keys.push_back(conjunct->left);
+        continue;
+      }
     }
-    break;
+    residual.push_back(conjunct);
   }
+  for (const sql::Expression *key : right_keys) {
+    rebase_columns(*key, source.offset, *bindings_);
   }
 
-  if (has_error_ || !plan) {
-    return std::nullopt;
+  // Rows matched: for each left row, the right rows sharing its key
+  CostModel right_model(*source.table, *bindings_);
+  double left_rows = static_cast<double>(left->estimated_rows);
+  double right_rows = static_cast<double>(right->estimated_rows);
+  double rows = left_rows * right_rows;
+  if (!right_keys.empty()) {
+    rows /= right_model.distinct(*right_keys[0], right_rows);
+  }
+  const sql::Expression *condition = conjunction(residual, arena);
+  if (condition) {
+    rows *= model.selectivity(*condition);
+  }
+  if (type == sql::JoinType::LEFT) {
+    rows = std::max(rows, left_rows);
   }
 
+  // The smaller input is hashed; a LEFT join must hash the right one so
+  // that unmatched left rows are seen as they stream past
+  double left_bytes = 0.0;
+  for (size_t i = 0; i < joined; ++i) {
+    left_bytes += CostModel(*sources[i].table, *bindings_).row_bytes();
+  }
+  double right_bytes = right_model.row_bytes();
+  bool build_left = type == sql::JoinType::INNER &&
+                    left_rows * left_bytes < right_rows * right_bytes;
+  double cost =
+      left->estimated_cost + right->estimated_cost +
+      (build_left ? CostModel::hash_join_cost(left_rows, left_bytes,
+                                              right_rows, right_bytes,
+                                              work_memory_)
+                  : CostModel::hash_join_cost(right_rows, right_bytes,
+                                              left_rows, left_bytes,
+                                              work_memory_));
+
+  auto plan = PlanNode::hash_join(std::move(left), std::move(right), type);
+  auto &join = std::get<HashJoinNode>(plan->node);
+  join.left_keys = std::move(left_keys);
+  join.right_keys = std::move(right_keys);
+  join.residual = condition;
+  join.left_width = source.offset;
+  join.right_width = static_cast<uint32_t>(source.table->columns.size());
+  join.build_left = build_left;
+  plan->estimated_cost = cost;
+  plan->estimated_rows = estimate(rows);
   return plan;
 }
 
-std::unique_ptr<PlanNode> Planner::plan_select(const sql::SelectStmt &stmt) {
-  // Look up table
-  const TableInfo *table = catalog_.get_table(stmt.table_name);
-  if (!table) {
-    set_error("Table not found: " + stmt.table_name);
-    return nullptr;
+std::unique_ptr<PlanNode>
+Planner::plan_index_join(std::unique_ptr<PlanNode> hashed,
+                         const Source &source) {
+  // A join on the right table's primary key can look each left row's key
+  // up in the index instead of reading and hashing the table, which pays
+  // off when the left rows are few next to the table
+  auto &join = std::get<HashJoinNode>(hashed->node);
+  const TableInfo &table = *source.table;
+  int key = table.primary_key_column();
+  size_t probe_key = 0;
+  while (probe_key < join.right_keys.size() &&
+         (join.right_keys[probe_key]->type != sql::ExprType::COLUMN_REF ||
+          bindings_->position(*join.right_keys[probe_key]) != key)) {
+    ++probe_key;
+  }
+  if (key < 0 || probe_key == join.right_keys.size()) {
+    return hashed;
   }
 
-  // Validate columns
-  if (!validate_columns(stmt, table)) {
-    return nullptr;
+  // The table's own plan must be a scan, filtered or not, and not a
+  // sample, which a lookup by key would not keep
+  const PlanNode *right = join.right.get();
+  const sql::Expression *inner_filter = nullptr;
+  if (const auto *filter = std::get_if<FilterNode>(&right->node)) {
+    inner_filter = filter->predicate;
+    right = filter->child.get();
+  }
+  std::vector<uint32_t> columns;
+  if (const auto *scan = std::get_if<TableScanNode>(&right->node)) {
+    if (scan->sample) {
+      return hashed;
+    }
+    columns = scan->column_indices;
+  } else if (const auto *scan = std::get_if<IndexScanNode>(&right->node)) {
+    columns = scan->column_indices;
+  } else {
+    return hashed;
   }
 
-  // Start with table scan
-  auto plan = PlanNode::table_scan(table->id, table->name);
+  // Each left row finds at most one row by a unique key
+  CostModel model(table, *bindings_);
+  double probes = static_cast<double>(join.left->estimated_rows);
+  double cost = join.left->estimated_cost +
+                model.index_join_cost(probes, probes, INDEX_JOIN_BATCH);
+  if (inner_filter) {
+    cost += CostModel::filter_cost(*inner_filter, probes);
+  }
+  if (cost >= hashed->estimated_cost) {
+    return hashed;
+  }
 
-  // Add filter if WHERE clause
-  if (stmt.where_clause) {
-    // Deep copy the expression for the plan
-    // In a real implementation, we'd properly clone expressions
-    // For now, we'll use a simple approach
-    plan = PlanNode::filter(std::move(plan), nullptr);
+  auto plan = PlanNode::index_join(std::move(join.left), table.id,
+                                   table.name, join.join_type);
+  auto &index = std::get<IndexJoinNode>(plan->node);
+  index.column_indices = std::move(columns);
+  index.left_keys = std::move(join.left_keys);
+  index.right_keys = std::move(join.right_keys);
+  index.probe_key = probe_key;
+  index.inner_filter = inner_filter;
+  index.residual = join.residual;
+  index.left_width = join.left_width;
+  index.right_width = join.right_width;
+  index.batch_size = INDEX_JOIN_BATCH;
+  plan->estimated_cost = cost;
+  plan->estimated_rows = hashed->estimated_rows;
+  return plan;
+}
+
+std::unique_ptr<PlanNode>
+Planner::plan_aggregate(const sql::SelectStmt &stmt, const TableInfo &table,
+                        const CostModel &model,
+                        std::unique_ptr<PlanNode> input) {
+  std::vector<const sql::Expression *> group_by(stmt.group_by.begin(),
+                                                stmt.group_by.end());
+  for (const sql::Expression *expr : group_by) {
+    if (!bind_columns(*expr, table)) {
+      return nullptr;
+    }
+    if (contains_aggregate(*expr)) {
+      set_error("Aggregates are not allowed in GROUP BY");
+      return nullptr;
+    }
+  }
+
+  // Output columns and ORDER BY keys read the aggregate's rows: group
+  // keys first, then one slot per aggregate call
+  ProjectNode project;
+  for (const sql::Expression *expr : stmt.columns) {
+    if (expr->type == sql::ExprType::STAR) {
+      set_error("SELECT * is not allowed with aggregates");
+      return nullptr;
+    }
+    add_output(project, *expr, *bindings_);
+  }
+
+  std::vector<const sql::Expression *> order_keys;
+  std::vector<int32_t> order_columns;
+  for (const auto &item : stmt.order_by) {
+    const sql::Expression *key = nullptr;
+    int32_t column = -1;
+    if (!resolve_sort_key(*item.expr, project, key, column)) {
+      return nullptr;
+    }
+    order_keys.push_back(key);
+    order_columns.push_back(column);
+  }
+
+  std::vector<AggregateExpr> aggregates;
+  for (const sql::Expression *expr : project.expressions) {
+    if (!bind_output(*expr, group_by, aggregates, table)) {
+      return nullptr;
+    }
+  }
+  for (size_t i = 0; i < order_keys.size(); ++i) {
+    if (order_keys[i] == stmt.order_by[i].expr &&
+        !(bind_columns(*order_keys[i], table) &&
+          bind_output(*order_keys[i], group_by, aggregates, table))) {
+      return nullptr;
+    }
+    // Bound to the aggregate's rows now, output columns included
+    order_columns[i] = bindings_->position(*order_keys[i]);
+  }
+  for (size_t i = 0; i < project.expressions.size(); ++i) {
+    project.columns[i] = bindings_->position(*project.expressions[i]);
+  }
+
+  // A whole table's counts and extremes are kept as it is written, so
+  // the input is not read; a single row needs no sort
+  if (group_by.empty() && input->type == PlanNodeType::TABLE_SCAN &&
+      !std::get<TableScanNode>(input->node).sample && !stmt.where_clause &&
+      metadata_aggregates(aggregates, table, *bindings_)) {
+    double cost = static_cast<double>(aggregates.size()) *
+                  CostModel::CPU_OPERATOR_COST;
+    auto plan = PlanNode::metadata_aggregate(table.id, table.name,
+                                             std::move(aggregates));
+    plan->estimated_cost = cost;
+    plan->estimated_rows = 1;
+    plan = plan_limit(stmt, std::move(plan));
+    return project_node(std::move(plan), std::move(project));
   }
 
-  // Check for aggregates
-  bool has_aggregates = detect_aggregates(stmt.columns);
+  // ORDER BY the leading group keys is met by sorting the input on them
+  size_t keys = group_by.size();
+  size_t ordered = 0;
+  while (ordered < order_columns.size() &&
+         order_columns[ordered] == static_cast<int32_t>(ordered) &&
+         ordered < keys) {
+    ordered++;
+  }
+  bool order_by_groups = !order_keys.empty() && ordered == order_keys.size();
 
-  if (has_aggregates) {
-    // Add aggregate node
-    std::vector<AggregateExpr> aggs;
-    // TODO: Extract aggregates from columns
-    plan = PlanNode::aggregate(std::move(plan), std::move(aggs));
+  // Hash aggregation is cheaper per row, but holds every group in memory;
+  // sorting costs more but spills, and may leave the output in order
+  double rows = static_cast<double>(input->estimated_rows);
+  double groups = 1.0;
+  for (const sql::Expression *expr : group_by) {
+    groups *= model.distinct(*expr, rows);
   }
+  groups = std::clamp(groups, 1.0, std::max(rows, 1.0));
 
-  // Add projection
-  std::vector<std::unique_ptr<sql::Expression>> exprs;
-  std::vector<std::string> names;
-  // TODO: Deep copy expressions for projection
+  double group_bytes = CostModel::group_bytes(keys, aggregates);
+  double hash_cost =
+      CostModel::hash_aggregate_cost(rows, groups, aggregates.size());
+  if (order_by_groups) {
+    hash_cost += CostModel::sort_cost(groups, group_bytes, work_memory_);
+  }
+  double sort_cost =
+      CostModel::sort_cost(rows, model.row_bytes(), work_memory_) +
+      CostModel::sort_aggregate_cost(rows, keys, aggregates.size());
+  // Without statistics the group count is a guess, so hashing has to fit
+  // even if every row turns out to be its own group
+  double worst_groups = model.analyzed() ? groups : std::max(rows, 1.0);
+  bool hash_fits =
+      worst_groups * group_bytes <= static_cast<double>(work_memory_);
+  bool sorted = keys > 0 && (!hash_fits || sort_cost < hash_cost);
 
-  // Add sort if ORDER BY
-  if (!stmt.order_by.empty()) {
-    std::vector<std::unique_ptr<sql::Expression>> sort_keys;
+  double cost = input->estimated_cost;
+  auto plan = std::move(input);
+  if (sorted) {
+    std::vector<int32_t> key_columns;
     std::vector<bool> ascending;
+    for (size_t i = 0; i < keys; ++i) {
+      key_columns.push_back(bindings_->position(*group_by[i]));
+      ascending.push_back(i < ordered ? stmt.order_by[i].ascending : true);
+    }
+    cost += CostModel::sort_cost(rows, model.row_bytes(), work_memory_);
+    plan = PlanNode::sort(std::move(plan), group_by, std::move(ascending));
+    std::get<SortNode>(plan->node).key_columns = std::move(key_columns);
+    plan->estimated_cost = cost;
+    plan->estimated_rows = estimate(rows);
+    cost += CostModel::sort_aggregate_cost(rows, keys, aggregates.size());
+  } else {
+    cost += CostModel::hash_aggregate_cost(rows, groups, aggregates.size());
+  }
+
+  plan = PlanNode::aggregate(std::move(plan), std::move(aggregates),
+                             std::move(group_by),
+                             sorted ? AggregateStrategy::SORT
+                                    : AggregateStrategy::HASH);
+  plan->estimated_cost = cost;
+  plan->estimated_rows = estimate(groups);
 
+  if (!order_keys.empty() && !(sorted && order_by_groups)) {
+    std::vector<bool> ascending;
     for (const auto &item : stmt.order_by) {
       ascending.push_back(item.ascending);
-      // TODO: Clone sort key expressions
     }
+    plan = plan_sort(stmt, std::move(plan), std::move(order_keys),
+                     std::move(order_columns), std::move(ascending),
+                     group_bytes);
+  }
+
+  plan = plan_limit(stmt, std::move(plan));
+  return project_node(std::move(plan), std::move(project));
+}
+
+std::unique_ptr<PlanNode>
+Planner::plan_sort(const sql::SelectStmt &stmt, std::unique_ptr<PlanNode> input,
+                   std::vector<const sql::Expression *> keys,
+                   std::vector<int32_t> key_columns,
+                   std::vector<bool> ascending, double row_bytes) {
+  double rows = static_cast<double>(input->estimated_rows);
+  double cost = CostModel::sort_cost(rows, row_bytes, work_memory_);
+
+  // With a LIMIT only the first rows are needed; a bounded heap beats a
+  // full sort when those rows fit in memory
+  int64_t top_n = -1;
+  if (stmt.limit >= 0 && stmt.offset <= INT64_MAX - stmt.limit) {
+    double n = static_cast<double>(stmt.limit + stmt.offset);
+    double heap_cost = CostModel::top_n_cost(rows, n);
+    if (n * row_bytes <= static_cast<double>(work_memory_) &&
+        heap_cost < cost) {
+      top_n = stmt.limit + stmt.offset;
+      cost = heap_cost;
+      rows = std::min(rows, n);
+    }
+  }
+
+  double total = input->estimated_cost + cost;
+  auto plan = PlanNode::sort(std::move(input), std::move(keys),
+                             std::move(ascending));
+  auto &sort = std::get<SortNode>(plan->node);
+  sort.key_columns = std::move(key_columns);
+  sort.top_n = top_n;
+  plan->estimated_cost = total;
+  plan->estimated_rows = estimate(rows);
+  return plan;
+}
+
+std::unique_ptr<PlanNode>
+Planner::plan_limit(const sql::SelectStmt &stmt,
+                    std::unique_ptr<PlanNode> input) {
+  if (stmt.limit < 0) {
+    return input;
+  }
+
+  double cost = input->estimated_cost;
+  uint64_t rows = input->estimated_rows;
+  uint64_t skipped = static_cast<uint64_t>(stmt.offset);
+  rows = rows > skipped ? rows - skipped : 0;
+  rows = std::min(rows, static_cast<uint64_t>(stmt.limit));
+
+  auto plan = PlanNode::limit(std::move(input), stmt.limit, stmt.offset);
+  plan->estimated_cost = cost;
+  plan->estimated_rows = rows;
+  return plan;
+}
+
+std::vector<uint32_t>
+Planner::defer_columns(const sql::SelectStmt &stmt, const TableInfo &table,
+                       const CostModel &model,
+                       const std::vector<const sql::Expression *> &keys,
+                       const std::vector<int32_t> &key_columns,
+                       PlanNode &access) {
+  // Rows are fetched again by RowId, so only from a table file
+  PlanNode *node = &access;
+  if (node->type == PlanNodeType::FILTER) {
+    node = std::get<FilterNode>(node->node).child.get();
+  }
+  if (node->type != PlanNodeType::TABLE_SCAN ||
+      table.partitioning.enabled() ||
+      (!stmt.where_clause && stmt.order_by.empty())) {
+    return {};
+  }
+  auto &scan = std::get<TableScanNode>(node->node);
 
-    plan = PlanNode::sort(std::move(plan), std::move(sort_keys),
-                          std::move(ascending));
+  // The filter and sort need their columns for every row read
+  std::vector<uint32_t> needed;
+  if (stmt.where_clause &&
+      !collect_columns(*stmt.where_clause, table, needed)) {
+    return {};
+  }
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (key_columns[i] >= 0) {
+      uint32_t column = static_cast<uint32_t>(key_columns[i]);
+      if (std::find(needed.begin(), needed.end(), column) == needed.end()) {
+        needed.push_back(column);
+      }
+    } else if (!collect_columns(*keys[i], table, needed)) {
+      return {};
+    }
+  }
+  if (needed.empty()) {
+    return {};
   }
 
-  // Add limit if present
+  // Worth it when the deferred columns hold text and at most a
+  // LATE_FETCH_FRACTION of the rows read reach the output
+  std::vector<uint32_t> deferred;
+  bool wide = false;
+  for (uint32_t column = 0; column < table.columns.size(); ++column) {
+    bool scanned = scan.column_indices.empty() ||
+                   std::find(scan.column_indices.begin(),
+                             scan.column_indices.end(),
+                             column) != scan.column_indices.end();
+    if (scanned &&
+        std::find(needed.begin(), needed.end(), column) == needed.end()) {
+      deferred.push_back(column);
+      wide = wide || model.value_bytes(column) > 0.0;
+    }
+  }
+  double output = static_cast<double>(access.estimated_rows);
   if (stmt.limit >= 0) {
-    plan = PlanNode::limit(std::move(plan), stmt.limit, stmt.offset);
+    output = std::min(output, static_cast<double>(stmt.limit));
   }
+  double read = static_cast<double>(node->estimated_rows);
+  if (!wide || output > read * LATE_FETCH_FRACTION) {
+    return {};
+  }
+
+  std::sort(needed.begin(), needed.end());
+  scan.column_indices = std::move(needed);
+  scan.row_ids = true;
+  return deferred;
+}
+
+std::unique_ptr<PlanNode> Planner::project_node(std::unique_ptr<PlanNode> input,
+                                                ProjectNode project) {
+  double cost = input->estimated_cost;
+  uint64_t rows = input->estimated_rows;
+  cost += static_cast<double>(rows) *
+          static_cast<double>(project.expressions.size()) *
+          CostModel::CPU_OPERATOR_COST;
 
+  auto columns = std::move(project.columns);
+  auto plan = PlanNode::project(std::move(input),
+                                std::move(project.expressions),
+                                std::move(project.output_names));
+  std::get<ProjectNode>(plan->node).columns = std::move(columns);
+  plan->estimated_cost = cost;
+  plan->estimated_rows = rows;
   return plan;
 }
 
-std::unique_ptr<PlanNode> Planner::plan_insert(const sql::InsertStmt &stmt) {
+std::unique_ptr<PlanNode> Planner::plan_insert(const sql::InsertStmt &stmt,
+                                               memory::Arena &arena) {
   // Look up table
-  const TableInfo *table = catalog_.get_table(stmt.table_name);
+  const TableInfo *table = catalog_.get_table(std::string(stmt.table_name));
   if (!table) {
-    set_error("Table not found: " + stmt.table_name);
+    set_error("Table not found: " + std::string(stmt.table_name));
+    return nullptr;
+  }
+  if (table->view_of != 0) {
+    set_error("Cannot insert into materialized view: " + table->name);
     return nullptr;
   }
 
   // Validate columns if specified
-  if (!stmt.column_names.empty()) {
-    for (const auto &col_name : stmt.column_names) {
-      if (table->find_column(col_name) < 0) {
-        set_error("Column not found: " + col_name);
-        return nullptr;
-      }
+  std::vector<std::string> column_names;
+  for (std::string_view col_name : stmt.column_names) {
+    column_names.emplace_back(col_name);
+    if (table->find_column(column_names.back()) < 0) {
+      set_error("Column not found: " + column_names.back());
+      return nullptr;
     }
   }
 
@@ -142,89 +1652,581 @@ std::unique_ptr<PlanNode> Planner::plan_insert(const sql::InsertStmt &stmt) {
   size_t expected_cols = stmt.column_names.empty() ? table->columns.size()
                                                    : stmt.column_names.size();
 
-  for (const auto &row : stmt.values) {
+  for (const sql::ExprList &row : stmt.values) {
     if (row.size() != expected_cols) {
       set_error("Value count mismatch");
       return nullptr;
     }
   }
 
-  // Create insert node
-  std::vector<std::vector<std::unique_ptr<sql::Expression>>> values_copy;
-  // TODO: Deep copy values
+  // The rows are shared with the statement rather than copied
+  auto plan = PlanNode::insert(table->id, table->name,
+                               std::move(column_names), stmt.values);
 
-  return PlanNode::insert(table->id, table->name, stmt.column_names,
-                          std::move(values_copy));
+  // The table's materialized views take the rows in as they are stored
+  auto &insert = std::get<InsertNode>(plan->node);
+  for (const TableInfo *view_table : catalog_.views_of(table->id)) {
+    MaterializedView view;
+    if (!load_view(*view_table, arena, view)) {
+      return nullptr;
+    }
+    insert.views.push_back(std::move(view));
+  }
+  return plan;
 }
 
 std::unique_ptr<PlanNode>
 Planner::plan_create_table(const sql::CreateTableStmt &stmt) {
   // Check if table exists
-  if (!stmt.if_not_exists && catalog_.table_exists(stmt.table_name)) {
-    set_error("Table already exists: " + stmt.table_name);
+  std::string table_name(stmt.table_name);
+  if (!stmt.if_not_exists && catalog_.table_exists(table_name)) {
+    set_error("Table already exists: " + table_name);
     return nullptr;
   }
 
-  std::vector<sql::ColumnDef> columns_copy;
-  for (const auto &col : stmt.columns) {
-    sql::ColumnDef copy;
-    copy.name = col.name;
-    copy.type = col.type;
-    copy.not_null = col.not_null;
-    copy.primary_key = col.primary_key;
-    // Note: default_value copy would need proper cloning
-    columns_copy.push_back(std::move(copy));
+  std::vector<sql::ColumnDef> columns(stmt.columns.begin(),
+                                      stmt.columns.end());
+
+  storage::TimePartitioning partitioning;
+  if (!stmt.partition_column.empty()) {
+    for (size_t i = 0; i < stmt.columns.size(); ++i) {
+      if (stmt.columns[i].name == stmt.partition_column) {
+        partitioning.column = static_cast<int32_t>(i);
+      }
+    }
+    if (partitioning.column < 0) {
+      set_error("Partition column not found: " +
+                std::string(stmt.partition_column));
+      return nullptr;
+    }
+    if (stmt.columns[partitioning.column].type != "INTEGER") {
+      set_error("Partition column must be INTEGER: " +
+                std::string(stmt.partition_column));
+      return nullptr;
+    }
+    partitioning.width = stmt.partition_width;
+    partitioning.retention = stmt.retention;
+  }
+
+  return PlanNode::create_table(table_name, std::move(columns),
+                                stmt.if_not_exists,
+                                stmt.columnar ? storage::PageLayout::PAX
+                                              : storage::PageLayout::ROW,
+                                partitioning);
+}
+
+std::unique_ptr<PlanNode>
+Planner::plan_create_view(const sql::CreateViewStmt &stmt) {
+  std::string view_name(stmt.view_name);
+  if (catalog_.table_exists(view_name)) {
+    set_error("Table already exists: " + view_name);
+    return nullptr;
+  }
+  const TableInfo *base =
+      catalog_.get_table(std::string(stmt.query->table_name));
+  if (!base) {
+    set_error("Table not found: " + std::string(stmt.query->table_name));
+    return nullptr;
   }
 
-  return PlanNode::create_table(stmt.table_name, std::move(columns_copy),
-                                stmt.if_not_exists);
+  CreateViewNode node;
+  std::vector<ColumnInfo> columns;
+  if (!bind_view(*stmt.query, *base, node.view, columns)) {
+    return nullptr;
+  }
+  for (const ColumnInfo &column : columns) {
+    node.column_names.push_back(column.name);
+    node.column_types.push_back(column.type);
+  }
+  node.view_name = view_name;
+  node.base_table_id = base->id;
+  node.query = std::string(stmt.query_text);
+  node.view.table_name = view_name;
+  return PlanNode::create_view(std::move(node));
 }
 
 std::unique_ptr<PlanNode>
 Planner::plan_drop_table(const sql::DropTableStmt &stmt) {
   // Check if table exists
-  if (!stmt.if_exists && !catalog_.table_exists(stmt.table_name)) {
-    set_error("Table not found: " + stmt.table_name);
+  std::string table_name(stmt.table_name);
+  const TableInfo *table = catalog_.get_table(table_name);
+  if (!table) {
+    if (!stmt.if_exists) {
+      set_error((stmt.view ? "View not found: " : "Table not found: ") +
+                table_name);
+      return nullptr;
+    }
+    return PlanNode::drop_table(table_name, stmt.if_exists);
+  }
+
+  if (stmt.view != (table->view_of != 0)) {
+    set_error(stmt.view ? "Not a materialized view: " + table_name
+                        : "Use DROP MATERIALIZED VIEW to drop view: " +
+                              table_name);
+    return nullptr;
+  }
+  std::vector<const TableInfo *> views = catalog_.views_of(table->id);
+  if (!views.empty()) {
+    set_error("Table has materialized views: " + table_name + " (drop " +
+              views.front()->name + " first)");
+    return nullptr;
+  }
+
+  return PlanNode::drop_table(table_name, stmt.if_exists);
+}
+
+std::unique_ptr<PlanNode> Planner::plan_analyze(const sql::AnalyzeStmt &stmt) {
+  std::vector<uint32_t> table_ids;
+  if (stmt.table_name.empty()) {
+    for (const std::string &name : catalog_.list_tables()) {
+      table_ids.push_back(catalog_.get_table(name)->id);
+    }
+  } else {
+    const TableInfo *table = catalog_.get_table(std::string(stmt.table_name));
+    if (!table) {
+      set_error("Table not found: " + std::string(stmt.table_name));
+      return nullptr;
+    }
+    table_ids.push_back(table->id);
+  }
+  return PlanNode::analyze(std::move(table_ids));
+}
+
+bool Planner::bind_view(const sql::SelectStmt &query, const TableInfo &base,
+                        MaterializedView &view,
+                        std::vector<ColumnInfo> &columns) {
+  if (!query.joins.empty() || query.table_sample || query.where_clause ||
+      !query.order_by.empty() || query.limit >= 0 || query.offset > 0) {
+    set_error("A materialized view must aggregate one table, without "
+              "WHERE, ORDER BY or LIMIT");
+    return false;
+  }
+  if (base.view_of != 0) {
+    set_error("A materialized view cannot read another view: " + base.name);
+    return false;
+  }
+  if (base.partitioning.retention > 0) {
+    // Expired segments would take rows away the view still counts
+    set_error("A materialized view cannot read a table with retention: " +
+              base.name);
+    return false;
+  }
+
+  TableInfo scope;
+  const TableInfo *table = &base;
+  if (!query.table_alias.empty()) {
+    scope = base;
+    scope.name = std::string(query.table_alias);
+    table = &scope;
+  }
+
+  view.bindings = bindings_;
+  view.keys.assign(query.group_by.begin(), query.group_by.end());
+  for (const sql::Expression *key : view.keys) {
+    if (!bind_columns(*key, *table)) {
+      return false;
+    }
+    if (contains_aggregate(*key)) {
+      set_error("Aggregates are not allowed in GROUP BY");
+      return false;
+    }
+  }
+
+  // Key columns first, in GROUP BY order, then the aggregates' states
+  columns.assign(view.keys.size(), ColumnInfo{});
+  std::vector<bool> selected(view.keys.size(), false);
+  view.aggregates.clear();
+  view.state_columns.clear();
+  for (const sql::Expression *expr : query.columns) {
+    if (expr->type == sql::ExprType::STAR) {
+      set_error("SELECT * is not allowed with aggregates");
+      return false;
+    }
+    if (!bind_columns(*expr, *table)) {
+      return false;
+    }
+    std::string name(output_name(*expr));
+    if (name.empty()) {
+      set_error("Materialized view columns need a name: use AS");
+      return false;
+    }
+
+    auto key = std::find_if(view.keys.begin(), view.keys.end(),
+                            [&](const sql::Expression *k) {
+                              return same_expression(*expr, *k, *bindings_);
+                            });
+    if (key != view.keys.end()) {
+      size_t i = static_cast<size_t>(key - view.keys.begin());
+      if (selected[i]) {
+        set_error("GROUP BY key selected twice: " + name);
+        return false;
+      }
+      selected[i] = true;
+      columns[i].name = name;
+      if (!value_type(*expr, *table, *bindings_, columns[i].type)) {
+        set_error("Cannot tell the type of view column: " + name);
+        return false;
+      }
+      continue;
+    }
+
+    AggregateType type;
+    if (expr->type != sql::ExprType::FUNCTION_CALL ||
+        !aggregate_type(expr->name, type) ||
+        type == AggregateType::APPROX_COUNT_DISTINCT ||
+        type == AggregateType::APPROX_PERCENTILE) {
+      set_error("Materialized view columns must be GROUP BY keys or "
+                "COUNT, SUM, MIN, MAX or AVG calls: " +
+                name);
+      return false;
+    }
+    std::string function(expr->name);
+    if (expr->distinct) {
+      set_error("DISTINCT aggregates are not supported: " + function);
+      return false;
+    }
+    if (expr->args.size() != 1) {
+      set_error(function + " takes one argument");
+      return false;
+    }
+
+    const sql::Expression *arg = expr->args[0];
+    storage::ColumnType arg_type = storage::ColumnType::INTEGER;
+    if (arg->type == sql::ExprType::STAR) {
+      if (type != AggregateType::COUNT) {
+        set_error(function + "(*) is not supported");
+        return false;
+      }
+      arg = nullptr;
+    } else if (contains_aggregate(*arg)) {
+      set_error("Aggregate calls cannot be nested");
+      return false;
+    } else if (!value_type(*arg, *table, *bindings_, arg_type)) {
+      set_error("Cannot tell the type of view column: " + name);
+      return false;
+    }
+    if ((type == AggregateType::SUM || type == AggregateType::AVG) &&
+        !numeric(arg_type)) {
+      set_error(function + " needs a numeric argument: " + name);
+      return false;
+    }
+    if ((type == AggregateType::MIN || type == AggregateType::MAX) &&
+        !numeric(arg_type) && arg_type != storage::ColumnType::TEXT) {
+      set_error(function + " needs a number or text: " + name);
+      return false;
+    }
+
+    view.state_columns.push_back(static_cast<uint32_t>(columns.size()));
+    view.aggregates.push_back(AggregateExpr{type, arg, false, function, 0.0});
+    ColumnInfo column{};
+    column.name = name;
+    column.type = arg_type;
+    if (type == AggregateType::AVG) {
+      column.name = name + "_sum";
+      column.type = storage::ColumnType::FLOAT;
+      columns.push_back(column);
+      column.name = name + "_count";
+    }
+    if (type == AggregateType::COUNT || type == AggregateType::AVG) {
+      column.type = storage::ColumnType::INTEGER;
+    }
+    columns.push_back(column);
+  }
+
+  for (size_t i = 0; i < view.keys.size(); ++i) {
+    if (!selected[i]) {
+      set_error("A materialized view must select each GROUP BY key");
+      return false;
+    }
+  }
+  for (size_t i = 0; i < columns.size(); ++i) {
+    columns[i].index = static_cast<uint32_t>(i);
+    for (size_t j = 0; j < i; ++j) {
+      if (columns[j].name == columns[i].name) {
+        set_error("Duplicate view column: " + columns[i].name +
+                  " (name it with AS)");
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool Planner::load_view(const TableInfo &view_table, memory::Arena &arena,
+                        MaterializedView &view) {
+  // The definition is parsed from a copy, as the catalog's text may go
+  // before the plan does
+  const TableInfo *base = catalog_.get_table_by_id(view_table.view_of);
+  sql::Parser parser(sql::copy_text(arena, view_table.view_query), arena);
+  std::optional<sql::Statement> stmt = parser.parse();
+  const auto *query =
+      stmt ? std::get_if<const sql::SelectStmt *>(&stmt->stmt) : nullptr;
+  if (!base || !query) {
+    set_error("Invalid materialized view: " + view_table.name);
+    return false;
+  }
+
+  std::vector<ColumnInfo> columns;
+  if (!bind_view(**query, *base, view, columns)) {
+    return false;
+  }
+  view.table_id = view_table.id;
+  view.table_name = view_table.name;
+  return true;
+}
+
+const sql::SelectStmt *
+Planner::answer_from_view(const sql::SelectStmt &stmt, const TableInfo &table,
+                          memory::Arena &arena) {
+  std::vector<const TableInfo *> views = catalog_.views_of(table.id);
+  if (views.empty() ||
+      (stmt.where_clause && contains_aggregate(*stmt.where_clause))) {
     return nullptr;
   }
+  for (const sql::Expression *key : stmt.group_by) {
+    if (!bind_columns(*key, table)) {
+      return nullptr;
+    }
+  }
+
+  // The smallest view that holds every group key and aggregate wins
+  std::sort(views.begin(), views.end(),
+            [](const TableInfo *a, const TableInfo *b) {
+              return a->row_count < b->row_count;
+            });
+  for (const TableInfo *view_table : views) {
+    MaterializedView view;
+    if (!load_view(*view_table, arena, view)) {
+      return nullptr;
+    }
+    ViewMatcher matcher(view, *view_table, *bindings_, arena);
+
+    auto *rewritten = sql::make_node<sql::SelectStmt>(arena);
+    rewritten->table_name = sql::copy_text(arena, view_table->name);
+    rewritten->limit = stmt.limit;
+    rewritten->offset = stmt.offset;
+    bool matched = true;
+
+    // Output columns keep the names the query gives them
+    for (const sql::Expression *expr : stmt.columns) {
+      const sql::Expression *mapped = matcher.map(*expr);
+      if (!mapped) {
+        matched = false;
+        break;
+      }
+      auto *named = sql::make_node<sql::Expression>(arena);
+      *named = *mapped;
+      named->alias = output_name(*expr);
+      rewritten->columns.push_back(arena, named);
+    }
+    if (matched && stmt.where_clause) {
+      rewritten->where_clause = matcher.map(*stmt.where_clause);
+      matched = rewritten->where_clause != nullptr;
+    }
+    for (size_t i = 0; matched && i < stmt.group_by.size(); ++i) {
+      const sql::Expression *mapped = matcher.map(*stmt.group_by[i]);
+      matched = mapped != nullptr;
+      if (matched) {
+        rewritten->group_by.push_back(arena, mapped);
+      }
+    }
+    // ORDER BY positions and output names resolve as they did
+    for (size_t i = 0; matched && i < stmt.order_by.size(); ++i) {
+      sql::OrderByItem item = stmt.order_by[i];
+      const sql::Expression &key = *item.expr;
+      bool output =
+          (key.type == sql::ExprType::LITERAL &&
+           key.literal_type == sql::Literal::Type::INTEGER) ||
+          (key.type == sql::ExprType::COLUMN_REF && key.table_name.empty() &&
+           std::any_of(stmt.columns.begin(), stmt.columns.end(),
+                       [&](const sql::Expression *expr) {
+                         return !expr->alias.empty() &&
+                                expr->alias == key.name;
+                       }));
+      if (!output) {
+        if (!bind_columns(key, table)) {
+          return nullptr;
+        }
+        item.expr = matcher.map(key);
+        matched = item.expr != nullptr;
+      }
+      if (matched) {
+        rewritten->order_by.push_back(arena, item);
+      }
+    }
 
-  return PlanNode::drop_table(stmt.table_name, stmt.if_exists);
+    if (matched) {
+      return rewritten;
+    }
+  }
+  return nullptr;
 }
 
 bool Planner::validate_columns(const sql::SelectStmt &stmt,
                                const TableInfo *table) {
-  for (const auto &col_expr : stmt.columns) {
+  for (const sql::Expression *col_expr : stmt.columns) {
     if (col_expr->type == sql::ExprType::STAR) {
       continue; // SELECT * is always valid
     }
+    if (!bind_columns(*col_expr, *table)) {
+      return false;
+    }
+  }
+
+  // ORDER BY keys may name output columns, so they are bound when resolved
+  return !stmt.where_clause || bind_columns(*stmt.where_clause, *table);
+}
+
+bool Planner::bind_columns(const sql::Expression &expr,
+                           const TableInfo &table) {
+  // Anything but a column is evaluated in place unless an aggregate
+  // rebinds it
+  if (expr.type != sql::ExprType::COLUMN_REF) {
+    bindings_->bind(expr, -1);
+  }
 
-    if (col_expr->type == sql::ExprType::COLUMN_REF) {
-      const auto *ref = std::get_if<sql::ColumnRef>(&col_expr->value);
-      if (ref && table->find_column(ref->column_name) < 0) {
-        set_error("Column not found: " + ref->column_name);
+  switch (expr.type) {
+  case sql::ExprType::COLUMN_REF: {
+    if (!expr.table_name.empty() && !has_table(table, expr.table_name)) {
+      set_error("Unknown table: " + std::string(expr.table_name));
+      return false;
+    }
+    int index = find_reference(expr, table);
+    if (index == AMBIGUOUS_COLUMN) {
+      set_error("Ambiguous column: " + std::string(expr.name));
+      return false;
+    }
+    if (index < 0) {
+      set_error("Column not found: " + std::string(expr.name));
+      return false;
+    }
+    bindings_->bind(expr, index);
+    return true;
+  }
+  case sql::ExprType::BINARY_OP:
+    return bind_columns(*expr.left, table) && bind_columns(*expr.right, table);
+  case sql::ExprType::UNARY_OP:
+    return bind_columns(*expr.operand(), table);
+  case sql::ExprType::FUNCTION_CALL:
+    for (const sql::Expression *arg : expr.args) {
+      // COUNT(*) and the like
+      if (arg->type != sql::ExprType::STAR && !bind_columns(*arg, table)) {
         return false;
       }
     }
+    return true;
+  default:
+    return true;
+  }
+}
+
+bool Planner::resolve_sort_key(const sql::Expression &key,
+                               const ProjectNode &project,
+                               const sql::Expression *&expr, int32_t &column) {
+  // ORDER BY n names the n-th output column
+  if (key.type == sql::ExprType::LITERAL &&
+      key.literal_type == sql::Literal::Type::INTEGER) {
+    if (key.int_value < 1 ||
+        static_cast<uint64_t>(key.int_value) > project.expressions.size()) {
+      set_error("ORDER BY position out of range: " +
+                std::to_string(key.int_value));
+      return false;
+    }
+    size_t at = static_cast<size_t>(key.int_value - 1);
+    expr = project.expressions[at];
+    column = project.columns[at];
+    return true;
+  }
 
-    // For other expression types, we'd need to recursively validate
+  // An output alias takes precedence over a table column of the same name
+  if (key.type == sql::ExprType::COLUMN_REF && key.table_name.empty()) {
+    for (size_t i = 0; i < project.expressions.size(); ++i) {
+      if (!project.expressions[i]->alias.empty() &&
+          project.expressions[i]->alias == key.name) {
+        expr = project.expressions[i];
+        column = project.columns[i];
+        return true;
+      }
+    }
   }
 
+  expr = &key;
+  column = -1;
   return true;
 }
 
-bool Planner::detect_aggregates(
-    const std::vector<std::unique_ptr<sql::Expression>> &exprs) {
-  for (const auto &expr : exprs) {
-    if (expr->type == sql::ExprType::FUNCTION_CALL) {
-      const auto *fn =
-          std::get_if<std::unique_ptr<sql::FunctionCall>>(&expr->value);
-      if (fn) {
-        const std::string &name = (*fn)->name;
-        if (name == "COUNT" || name == "SUM" || name == "MIN" ||
-            name == "MAX" || name == "AVG") {
-          return true;
-        }
+bool Planner::bind_output(const sql::Expression &expr,
+                          const std::vector<const sql::Expression *> &group_by,
+                          std::vector<AggregateExpr> &aggregates,
+                          const TableInfo &table) {
+  for (size_t i = 0; i < group_by.size(); ++i) {
+    if (same_expression(expr, *group_by[i], *bindings_)) {
+      bindings_->bind(expr, static_cast<int32_t>(i));
+      return true;
+    }
+  }
+
+  switch (expr.type) {
+  case sql::ExprType::FUNCTION_CALL: {
+    AggregateType type;
+    std::string name(expr.name);
+    if (!aggregate_type(expr.name, type)) {
+      set_error("Unsupported function: " + name);
+      return false;
+    }
+    if (expr.distinct) {
+      set_error("DISTINCT aggregates are not supported: " + name);
+      return false;
+    }
+    bool percentile = type == AggregateType::APPROX_PERCENTILE;
+    if (expr.args.size() != (percentile ? 2u : 1u)) {
+      set_error(name + (percentile ? " takes two arguments"
+                                   : " takes one argument"));
+      return false;
+    }
+    double fraction = 0.0;
+    if (percentile && !fraction_constant(*expr.args[1], fraction)) {
+      set_error(name + " needs a constant fraction between 0 and 1");
+      return false;
+    }
+
+    const sql::Expression *arg = expr.args[0];
+    if (arg->type == sql::ExprType::STAR) {
+      if (type != AggregateType::COUNT) {
+        set_error(name + "(*) is not supported");
+        return false;
       }
+      arg = nullptr;
+    } else if (contains_aggregate(*arg)) {
+      set_error("Aggregate calls cannot be nested");
+      return false;
+    } else if (!bind_columns(*arg, table)) {
+      return false;
+    }
+
+    bindings_->bind(expr,
+                    static_cast<int32_t>(group_by.size() + aggregates.size()));
+    aggregates.push_back(AggregateExpr{type, arg, false, name, fraction});
+    return true;
+  }
+  case sql::ExprType::COLUMN_REF:
+    set_error("Column must appear in GROUP BY or an aggregate: " +
+              std::string(expr.name));
+    return false;
+  case sql::ExprType::BINARY_OP:
+    return bind_output(*expr.left, group_by, aggregates, table) &&
+           bind_output(*expr.right, group_by, aggregates, table);
+  case sql::ExprType::UNARY_OP:
+    return bind_output(*expr.operand(), group_by, aggregates, table);
+  default:
+    return true;
+  }
+}
+
+bool Planner::detect_aggregates(const sql::ExprList &exprs) {
+  for (const sql::Expression *expr : exprs) {
+    if (contains_aggregate(*expr)) {
+      return true;
     }
   }
   return false;
@@ -7,9 +7,12 @@
 
 #include "../sql/ast.hpp"
 #include "catalog.hpp"
+#include "cost_model.hpp"
 #include "plan.hpp"
+#include "../memory/arena.hpp"
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace edgesql {
 namespace planner {
@@ -39,9 +42,20 @@ public:
   /**
    * @brief Plan a statement
    * @param stmt Parsed statement
+   * @param arena Arena the statement was parsed into; simplified
+   *              expressions are allocated from it
    * @return Execution plan, or nullopt on error
    */
-  std::optional<std::unique_ptr<PlanNode>> plan(const sql::Statement &stmt);
+  std::optional<std::unique_ptr<PlanNode>> plan(const sql::Statement &stmt,
+                                                memory::Arena &arena);
+
+  /**
+   * @brief Set the memory a sort, hash aggregation or hash join may use
+   *        before it spills; plans favour operators that fit
+   *
+   * The query handler sets it from its QueryBudget::work_memory().
+   */
+  void set_work_memory(size_t bytes) { work_memory_ = bytes; }
 
   /**
    * @brief Get the last planning error
@@ -54,18 +68,93 @@ public:
   bool has_error() const { return has_error_; }
 
 private:
-  std::unique_ptr<PlanNode> plan_select(const sql::SelectStmt &stmt);
-  std::unique_ptr<PlanNode> plan_insert(const sql::InsertStmt &stmt);
+  std::unique_ptr<PlanNode> plan_select(const sql::SelectStmt &stmt,
+                                        memory::Arena &arena);
+  std::unique_ptr<PlanNode> plan_insert(const sql::InsertStmt &stmt,
+                                        memory::Arena &arena);
   std::unique_ptr<PlanNode> plan_create_table(const sql::CreateTableStmt &stmt);
+  std::unique_ptr<PlanNode> plan_create_view(const sql::CreateViewStmt &stmt);
   std::unique_ptr<PlanNode> plan_drop_table(const sql::DropTableStmt &stmt);
+  std::unique_ptr<PlanNode> plan_analyze(const sql::AnalyzeStmt &stmt);
+
+  /**
+   * @brief A table in a SELECT's FROM clause
+   */
+  struct Source {
+    const TableInfo *table;
+    std::string qualifier; // Alias, else the table name
+    uint32_t offset;       // Position of its first column in a joined row
+    const sql::TableSample *sample; // TABLESAMPLE, or nullptr
+  };
+
+  // SELECT stages, each costed on top of its input
+  std::unique_ptr<PlanNode> plan_access(const sql::SelectStmt &stmt,
+                                        const TableInfo &table,
+                                        const CostModel &model);
+  bool combine_tables(const sql::SelectStmt &stmt,
+                      std::vector<Source> &sources, TableInfo &combined);
+  std::unique_ptr<PlanNode> plan_join(const sql::SelectStmt &stmt,
+                                      memory::Arena &arena,
+                                      const std::vector<Source> &sources,
+                                      const TableInfo &combined);
+  std::unique_ptr<PlanNode>
+  plan_source(const Source &source,
+              const std::vector<const sql::Expression *> &filters,
+              const std::vector<bool> &used, memory::Arena &arena);
+  std::unique_ptr<PlanNode>
+  plan_hash_join(std::unique_ptr<PlanNode> left,
+                 std::unique_ptr<PlanNode> right, sql::JoinType type,
+                 const std::vector<const sql::Expression *> &conjuncts,
+                 const std::vector<Source> &sources, size_t joined,
+                 const CostModel &model, memory::Arena &arena);
+  std::unique_ptr<PlanNode> plan_index_join(std::unique_ptr<PlanNode> hashed,
+                                            const Source &source);
+  std::unique_ptr<PlanNode> plan_aggregate(const sql::SelectStmt &stmt,
+                                           const TableInfo &table,
+                                           const CostModel &model,
+                                           std::unique_ptr<PlanNode> input);
+  std::unique_ptr<PlanNode>
+  plan_sort(const sql::SelectStmt &stmt, std::unique_ptr<PlanNode> input,
+            std::vector<const sql::Expression *> keys,
+            std::vector<int32_t> key_columns, std::vector<bool> ascending,
+            double row_bytes);
+  std::unique_ptr<PlanNode> plan_limit(const sql::SelectStmt &stmt,
+                                       std::unique_ptr<PlanNode> input);
+  std::vector<uint32_t>
+  defer_columns(const sql::SelectStmt &stmt, const TableInfo &table,
+                const CostModel &model,
+                const std::vector<const sql::Expression *> &keys,
+                const std::vector<int32_t> &key_columns, PlanNode &access);
+  std::unique_ptr<PlanNode> project_node(std::unique_ptr<PlanNode> input,
+                                         ProjectNode project);
 
   bool validate_columns(const sql::SelectStmt &stmt, const TableInfo *table);
-  bool
-  detect_aggregates(const std::vector<std::unique_ptr<sql::Expression>> &exprs);
+  bool bind_columns(const sql::Expression &expr, const TableInfo &table);
+  bool bind_output(const sql::Expression &expr,
+                   const std::vector<const sql::Expression *> &group_by,
+                   std::vector<AggregateExpr> &aggregates,
+                   const TableInfo &table);
+  bool resolve_sort_key(const sql::Expression &key, const ProjectNode &project,
+                        const sql::Expression *&expr, int32_t &column);
+  bool detect_aggregates(const sql::ExprList &exprs);
+
+  // Materialized views: a view's SELECT bound to its base table, giving
+  // the view table's columns; and the query rewritten onto a view
+  bool bind_view(const sql::SelectStmt &query, const TableInfo &base,
+                 MaterializedView &view, std::vector<ColumnInfo> &columns);
+  bool load_view(const TableInfo &view_table, memory::Arena &arena,
+                 MaterializedView &view);
+  const sql::SelectStmt *answer_from_view(const sql::SelectStmt &stmt,
+                                          const TableInfo &table,
+                                          memory::Arena &arena);
 
   void set_error(const std::string &message);
 
+  static constexpr size_t DEFAULT_WORK_MEMORY = 16 * 1024 * 1024;
+
   Catalog &catalog_;
+  size_t work_memory_{DEFAULT_WORK_MEMORY};
+  Bindings *bindings_{nullptr}; // Of the plan being built
   PlanError error_;
   bool has_error_{false};
 };
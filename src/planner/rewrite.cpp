@@ -0,0 +1,335 @@
+/**
+ * @file rewrite.cpp
+ * @brief Predicate simplification implementation
+ */
+
+#include "rewrite.hpp"
+#include "../executor/expression.hpp"
+#include <stdexcept>
+
+namespace edgesql {
+namespace planner {
+
+namespace {
+
+using sql::BinaryOp;
+using sql::Expression;
+using sql::ExprType;
+using LiteralType = sql::Literal::Type;
+
+/**
+ * @brief How a node's value is used
+ */
+enum class Use {
+  VALUE,    // As a value
+  LOGIC,    // As a truth value, with NULL distinct from FALSE (under NOT)
+  PREDICATE // Only whether it is TRUE
+};
+
+bool is_comparison(BinaryOp op) {
+  return op == BinaryOp::EQ || op == BinaryOp::NE || op == BinaryOp::LT ||
+         op == BinaryOp::LE || op == BinaryOp::GT || op == BinaryOp::GE;
+}
+
+// The comparison that holds exactly when op does not (NULL stays NULL)
+BinaryOp negate(BinaryOp op) {
+  switch (op) {
+  case BinaryOp::EQ:
+    return BinaryOp::NE;
+  case BinaryOp::NE:
+    return BinaryOp::EQ;
+  case BinaryOp::LT:
+    return BinaryOp::GE;
+  case BinaryOp::LE:
+    return BinaryOp::GT;
+  case BinaryOp::GT:
+    return BinaryOp::LE;
+  case BinaryOp::GE:
+    return BinaryOp::LT;
+  default:
+    return op;
+  }
+}
+
+bool is_literal(const Expression &expr) {
+  return expr.type == ExprType::LITERAL;
+}
+
+bool is_null(const Expression &expr) {
+  return is_literal(expr) && expr.literal_type == LiteralType::NULL_VAL;
+}
+
+bool is_integer(const Expression &expr) {
+  return is_literal(expr) && expr.literal_type == LiteralType::INTEGER;
+}
+
+// Truth of a literal the way the executor reads it, if it has one
+bool literal_truth(const Expression &expr, bool &out) {
+  if (!is_literal(expr)) {
+    return false;
+  }
+  switch (expr.literal_type) {
+  case LiteralType::BOOLEAN:
+    out = expr.bool_value;
+    return true;
+  case LiteralType::INTEGER:
+    out = expr.int_value != 0;
+    return true;
+  case LiteralType::FLOAT:
+    out = expr.float_value != 0.0;
+    return true;
+  default:
+    return false;
+  }
+}
+
+class Rewriter {
+public:
+  explicit Rewriter(memory::Arena &arena) : arena_(arena) {}
+
+  const Expression *rewrite(const Expression *expr, Use use);
+
+private:
+  const Expression *rewrite_not(const Expression *expr, Use use);
+  const Expression *negated(const Expression *expr, Use use);
+  const Expression *logical(const Expression *expr, BinaryOp op,
+                            const Expression *left, const Expression *right,
+                            Use use);
+  const Expression *comparison(const Expression *expr, BinaryOp op,
+                               const Expression *left,
+                               const Expression *right);
+  const Expression *fold(const Expression *expr);
+  const Expression *boolean(bool value);
+  const Expression *integer(int64_t value);
+  const Expression *binary(const Expression *expr, BinaryOp op,
+                           const Expression *left, const Expression *right);
+
+  memory::Arena &arena_;
+};
+
+const Expression *Rewriter::rewrite(const Expression *expr, Use use) {
+  switch (expr->type) {
+  case ExprType::UNARY_OP: {
+    if (expr->unary_op == sql::UnaryOp::NOT) {
+      return rewrite_not(expr, use);
+    }
+    const Expression *operand = rewrite(expr->operand(), Use::VALUE);
+    if (operand != expr->operand()) {
+      expr = Expression::unary(arena_, expr->unary_op, operand);
+    }
+    return is_literal(*operand) ? fold(expr) : expr;
+  }
+  case ExprType::BINARY_OP: {
+    BinaryOp op = expr->binary_op;
+    if (op == BinaryOp::AND || op == BinaryOp::OR) {
+      // Operands of a truth test are tested the same way
+      return logical(expr, op, rewrite(expr->left, use),
+                     rewrite(expr->right, use), use);
+    }
+
+    const Expression *left = rewrite(expr->left, Use::VALUE);
+    const Expression *right = rewrite(expr->right, Use::VALUE);
+    if (is_null(*left) || is_null(*right)) {
+      return Expression::literal(arena_, sql::Literal::null());
+    }
+    if (is_comparison(op)) {
+      return comparison(expr, op, left, right);
+    }
+    expr = binary(expr, op, left, right);
+    return is_literal(*left) && is_literal(*right) ? fold(expr) : expr;
+  }
+  default:
+    return expr;
+  }
+}
+
+const Expression *Rewriter::rewrite_not(const Expression *expr, Use use) {
+  // The operand's NULL must stay NULL, so it is not a predicate
+  const Expression *operand = rewrite(expr->operand(), Use::LOGIC);
+  if (use == Use::VALUE) {
+    if (operand != expr->operand()) {
+      expr = Expression::unary(arena_, sql::UnaryOp::NOT, operand);
+    }
+    return is_literal(*operand) ? fold(expr) : expr;
+  }
+  return negated(operand, use);
+}
+
+// NOT of an already simplified expression, pushed as far down as it goes
+const Expression *Rewriter::negated(const Expression *expr, Use use) {
+  bool truth;
+  if (literal_truth(*expr, truth)) {
+    return boolean(!truth);
+  }
+  if (is_null(*expr)) {
+    return expr;
+  }
+
+  if (expr->type == ExprType::UNARY_OP &&
+      expr->unary_op == sql::UnaryOp::NOT) {
+    return expr->operand();
+  }
+
+  if (expr->type == ExprType::BINARY_OP) {
+    BinaryOp op = expr->binary_op;
+    if (op == BinaryOp::AND || op == BinaryOp::OR) {
+      // De Morgan holds under three-valued logic
+      BinaryOp dual = op == BinaryOp::AND ? BinaryOp::OR : BinaryOp::AND;
+      return logical(nullptr, dual, negated(expr->left, use),
+                     negated(expr->right, use), use);
+    }
+    if (is_comparison(op)) {
+      return Expression::binary(arena_, negate(op), expr->left, expr->right);
+    }
+  }
+  return Expression::unary(arena_, sql::UnaryOp::NOT, expr);
+}
+
+const Expression *Rewriter::logical(const Expression *expr, BinaryOp op,
+                                    const Expression *left,
+                                    const Expression *right, Use use) {
+  if (is_literal(*left) && is_literal(*right)) {
+    return fold(binary(expr, op, left, right));
+  }
+  if (use == Use::VALUE) {
+    return binary(expr, op, left, right);
+  }
+
+  // x AND TRUE is x, x AND FALSE is FALSE; OR the other way round. Under
+  // a predicate a NULL operand rejects like FALSE.
+  bool identity = op == BinaryOp::AND;
+  for (int side = 0; side < 2; ++side) {
+    const Expression *constant = side == 0 ? left : right;
+    const Expression *other = side == 0 ? right : left;
+    bool truth;
+    if (!literal_truth(*constant, truth)) {
+      if (!is_null(*constant) || use != Use::PREDICATE) {
+        continue;
+      }
+      truth = false;
+    }
+    return truth == identity ? other : boolean(truth);
+  }
+  return binary(expr, op, left, right);
+}
+
+const Expression *Rewriter::comparison(const Expression *expr, BinaryOp op,
+                                       const Expression *left,
+                                       const Expression *right) {
+  if (is_literal(*left) && is_literal(*right)) {
+    return fold(binary(expr, op, left, right));
+  }
+
+  // Constants go on the right
+  if (is_literal(*left)) {
+    std::swap(left, right);
+    op = sql::mirror(op);
+  }
+
+  // Move integer offsets and negation to the constant side: x + c op k is
+  // x op k - c, -x op k is x mirror(op) -k. Only when the new constant is
+  // exact; otherwise the comparison stays as written.
+  while (is_integer(*right)) {
+    if (left->type == ExprType::UNARY_OP &&
+        left->unary_op == sql::UnaryOp::MINUS) {
+      if (right->int_value == INT64_MIN || is_literal(*left->operand())) {
+        break;
+      }
+      op = sql::mirror(op);
+      left = left->operand();
+      right = integer(-right->int_value);
+      continue;
+    }
+    if (left->type != ExprType::BINARY_OP ||
+        (left->binary_op != BinaryOp::ADD &&
+         left->binary_op != BinaryOp::SUB)) {
+      break;
+    }
+    const Expression *a = left->left;
+    const Expression *b = left->right;
+    bool add = left->binary_op == BinaryOp::ADD;
+    int64_t k = right->int_value;
+    int64_t bound;
+    if (is_integer(*b) && !is_literal(*a)) {
+      // x + c op k  ->  x op k - c;  x - c op k  ->  x op k + c
+      bool overflow = add ? __builtin_sub_overflow(k, b->int_value, &bound)
+                          : __builtin_add_overflow(k, b->int_value, &bound);
+      if (overflow) {
+        break;
+      }
+      left = a;
+    } else if (is_integer(*a) && !is_literal(*b)) {
+      // c + x op k  ->  x op k - c;  c - x op k  ->  x mirror(op) c - k
+      bool overflow = add ? __builtin_sub_overflow(k, a->int_value, &bound)
+                          : __builtin_sub_overflow(a->int_value, k, &bound);
+      if (overflow) {
+        break;
+      }
+      op = add ? op : sql::mirror(op);
+      left = b;
+    } else {
+      break;
+    }
+    right = integer(bound);
+  }
+
+  return binary(expr, op, left, right);
+}
+
+// Evaluate a node whose operands are literals; left alone if that fails
+const Expression *Rewriter::fold(const Expression *expr) {
+  try {
+    executor::Value value = executor::evaluate_constant(*expr);
+    sql::Literal literal;
+    executor::assign(literal, value);
+    return Expression::literal(arena_, literal);
+  } catch (const std::runtime_error &) {
+    return expr;
+  }
+}
+
+const Expression *Rewriter::boolean(bool value) {
+  return Expression::literal(arena_, sql::Literal::boolean(value));
+}
+
+const Expression *Rewriter::integer(int64_t value) {
+  return Expression::literal(arena_, sql::Literal::integer(value));
+}
+
+// The node with these operands, reusing it when they are unchanged
+const Expression *Rewriter::binary(const Expression *expr, BinaryOp op,
+                                   const Expression *left,
+                                   const Expression *right) {
+  if (expr && expr->binary_op == op && expr->left == left &&
+      expr->right == right) {
+    return expr;
+  }
+  return Expression::binary(arena_, op, left, right);
+}
+
+} // anonymous namespace
+
+const sql::Expression *simplify_predicate(const sql::Expression &predicate,
+                                          memory::Arena &arena) {
+  Rewriter rewriter(arena);
+  const Expression *result = rewriter.rewrite(&predicate, Use::PREDICATE);
+
+  // A constant predicate keeps every row or none
+  bool truth;
+  if (is_null(*result)) {
+    return Expression::literal(arena, sql::Literal::boolean(false));
+  }
+  if (literal_truth(*result, truth) &&
+      result->literal_type != LiteralType::BOOLEAN) {
+    return Expression::literal(arena, sql::Literal::boolean(truth));
+  }
+  return result;
+}
+
+bool is_boolean(const sql::Expression &expr, bool value) {
+  return expr.type == ExprType::LITERAL &&
+         expr.literal_type == LiteralType::BOOLEAN && expr.bool_value == value;
+}
+
+} // namespace planner
+} // namespace edgesql
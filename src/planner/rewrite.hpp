@@ -0,0 +1,43 @@
+#pragma once
+
+/**
+ * @file rewrite.hpp
+ * @brief Predicate simplification
+ */
+
+#include "../memory/arena.hpp"
+#include "../sql/ast.hpp"
+
+namespace edgesql {
+namespace planner {
+
+/**
+ * @brief Simplify a WHERE predicate before planning
+ *
+ * - Constant subexpressions are folded, so `ts > 1700000000 + 3600` is
+ *   computed once instead of per row.
+ * - AND/OR identities drop decided operands, and NOT is pushed down
+ *   through AND/OR into comparisons.
+ * - Comparisons become `column op constant`, moving integer offsets
+ *   across (`5 < x + 1` becomes `x > 4`), so they are sargable.
+ *
+ * The result keeps exactly the rows the input keeps. Its value may
+ * differ where only truth matters: NULL and FALSE both reject a row.
+ * Expressions that fail to fold (e.g. division by zero) are left for
+ * the executor, so errors still surface only if a row is evaluated.
+ *
+ * Unchanged subtrees are shared with the input; new nodes come from the
+ * statement's arena and are unbound.
+ *
+ * @return The simplified predicate; a BOOLEAN literal when constant
+ */
+const sql::Expression *simplify_predicate(const sql::Expression &predicate,
+                                          memory::Arena &arena);
+
+/**
+ * @brief Check whether an expression is the BOOLEAN literal given
+ */
+bool is_boolean(const sql::Expression &expr, bool value);
+
+} // namespace planner
+} // namespace edgesql
@@ -0,0 +1,234 @@
+/**
+ * @file statistics.cpp
+ * @brief Statistics implementation
+ */
+
+#include "statistics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace edgesql {
+namespace planner {
+
+namespace {
+
+// splitmix64 finalizer
+uint64_t mix(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xBF58476D1CE4E5B9ull;
+  x ^= x >> 27;
+  x *= 0x94D049BB133111EBull;
+  x ^= x >> 31;
+  return x;
+}
+
+// A sampled column this close to all-distinct is taken to be unique, so
+// its distinct count scales with the table
+constexpr double UNIQUE_RATIO = 0.9;
+
+} // anonymous namespace
+
+void HyperLogLog::add(uint64_t hash) {
+  size_t index = register_of(hash);
+  registers_[index] = std::max(registers_[index], rank_of(hash));
+}
+
+void HyperLogLog::merge(const HyperLogLog &other) {
+  for (size_t i = 0; i < REGISTERS; ++i) {
+    registers_[i] = std::max(registers_[i], other.registers_[i]);
+  }
+}
+
+double HyperLogLog::estimate() const {
+  double sum = 0.0;
+  size_t zeros = 0;
+  for (uint8_t r : registers_) {
+    sum += std::ldexp(1.0, -r);
+    zeros += r == 0;
+  }
+  return cardinality(sum, zeros);
+}
+
+uint8_t HyperLogLog::rank_of(uint64_t hash) {
+  uint64_t rest = hash << PRECISION;
+  return rest == 0 ? static_cast<uint8_t>(64 - PRECISION + 1)
+                   : static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+}
+
+double HyperLogLog::cardinality(double inverse_sum, size_t zeros) {
+  double m = static_cast<double>(REGISTERS);
+  double alpha = 0.7213 / (1.0 + 1.079 / m);
+  double estimate = alpha * m * m / inverse_sum;
+
+  // Linear counting is more accurate while many registers are empty
+  if (estimate <= 2.5 * m && zeros > 0) {
+    estimate = m * std::log(m / static_cast<double>(zeros));
+  }
+  return estimate;
+}
+
+uint64_t hash_integer(int64_t value) {
+  return mix(static_cast<uint64_t>(value) + 0x9E3779B97F4A7C15ull);
+}
+
+uint64_t hash_string(std::string_view value) {
+  uint64_t hash = 14695981039346656037ull;
+  for (char c : value) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ull;
+  }
+  return mix(hash);
+}
+
+uint64_t hash_literal(const sql::Literal &value) {
+  switch (value.type) {
+  case sql::Literal::Type::INTEGER:
+    return hash_integer(value.int_value);
+  case sql::Literal::Type::FLOAT: {
+    // Integral floats hash like the integer they equal
+    double v = value.float_value;
+    if (v == std::trunc(v) && std::fabs(v) < 9.2e18) {
+      return hash_integer(static_cast<int64_t>(v));
+    }
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    return mix(bits);
+  }
+  case sql::Literal::Type::BOOLEAN:
+    return hash_integer(value.bool_value ? 1 : 0);
+  case sql::Literal::Type::STRING:
+    return hash_string(value.string_value);
+  case sql::Literal::Type::NULL_VAL:
+    break;
+  }
+  return 0;
+}
+
+double ColumnStats::fraction_below(double value, bool inclusive) const {
+  if (!has_range) {
+    return 1.0 / 3.0;
+  }
+
+  if (bounds.size() < 2) {
+    if (max <= min) {
+      return value > min || (inclusive && value == min) ? 1.0 : 0.0;
+    }
+    return std::clamp((value - min) / (max - min), 0.0, 1.0);
+  }
+
+  // Bounds at or below the value; it lies in the bucket ending at the
+  // first bound past it
+  size_t buckets = bounds.size() - 1;
+  auto it = inclusive ? std::upper_bound(bounds.begin(), bounds.end(), value)
+                      : std::lower_bound(bounds.begin(), bounds.end(), value);
+  size_t below = static_cast<size_t>(it - bounds.begin());
+  if (below == 0) {
+    return 0.0;
+  }
+  if (below > buckets) {
+    return 1.0;
+  }
+
+  double lo = bounds[below - 1];
+  double hi = bounds[below];
+  double within = hi > lo ? std::clamp((value - lo) / (hi - lo), 0.0, 1.0)
+                          : 1.0;
+  return (static_cast<double>(below - 1) + within) /
+         static_cast<double>(buckets);
+}
+
+StatsCollector::StatsCollector(size_t columns) : columns_(columns) {}
+
+void StatsCollector::add(size_t column, const sql::Literal &value) {
+  Column &stats = columns_[column];
+  switch (value.type) {
+  case sql::Literal::Type::NULL_VAL:
+    stats.nulls++;
+    return;
+  case sql::Literal::Type::INTEGER:
+    sample(stats, static_cast<double>(value.int_value));
+    break;
+  case sql::Literal::Type::FLOAT:
+    sample(stats, value.float_value);
+    break;
+  case sql::Literal::Type::BOOLEAN:
+    sample(stats, value.bool_value ? 1.0 : 0.0);
+    break;
+  case sql::Literal::Type::STRING:
+    break;
+  }
+  stats.distinct.add(hash_literal(value));
+}
+
+void StatsCollector::sample(Column &column, double value) {
+  column.min = column.seen == 0 ? value : std::min(column.min, value);
+  column.max = column.seen == 0 ? value : std::max(column.max, value);
+  column.seen++;
+  if (column.reservoir.size() < RESERVOIR_SIZE) {
+    column.reservoir.push_back(value);
+    return;
+  }
+
+  // Reservoir sampling: keep each value with probability size / seen
+  rng_ ^= rng_ << 13;
+  rng_ ^= rng_ >> 7;
+  rng_ ^= rng_ << 17;
+  uint64_t slot = rng_ % column.seen;
+  if (slot < RESERVOIR_SIZE) {
+    column.reservoir[slot] = value;
+  }
+}
+
+TableStats StatsCollector::finish(uint64_t pages_read,
+                                  uint64_t pages_total) const {
+  TableStats stats;
+  stats.analyzed = true;
+  stats.page_count = pages_total;
+
+  double scale = pages_read > 0 && pages_total > pages_read
+                     ? static_cast<double>(pages_total) /
+                           static_cast<double>(pages_read)
+                     : 1.0;
+  stats.row_count =
+      static_cast<uint64_t>(std::llround(static_cast<double>(rows_) * scale));
+
+  stats.columns.resize(columns_.size());
+  for (size_t c = 0; c < columns_.size(); ++c) {
+    const Column &column = columns_[c];
+    ColumnStats &out = stats.columns[c];
+    if (rows_ == 0) {
+      continue;
+    }
+
+    double present = static_cast<double>(rows_ - column.nulls);
+    out.null_fraction =
+        static_cast<double>(column.nulls) / static_cast<double>(rows_);
+
+    // Values repeated in the sample repeat in the table; only a column
+    // that looks unique grows with it
+    double distinct = std::min(column.distinct.estimate(), present);
+    out.ndv = scale > 1.0 && distinct > UNIQUE_RATIO * present
+                  ? distinct * scale
+                  : distinct;
+
+    if (column.reservoir.empty()) {
+      continue;
+    }
+    std::vector<double> values = column.reservoir;
+    std::sort(values.begin(), values.end());
+    out.has_range = true;
+    out.min = column.min;
+    out.max = column.max;
+
+    size_t buckets = std::min(HISTOGRAM_BUCKETS, values.size());
+    out.bounds.resize(buckets + 1);
+    for (size_t i = 0; i <= buckets; ++i) {
+      out.bounds[i] = values[i * (values.size() - 1) / buckets];
+    }
+  }
+  return stats;
+}
+
+} // namespace planner
+} // namespace edgesql
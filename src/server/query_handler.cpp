@@ -4,16 +4,25 @@
  */
 
 #include "query_handler.hpp"
+#include "../memory/memory_tracker.hpp"
+#include "../observability/metrics.hpp"
 #include <sstream>
 
 namespace edgesql {
 namespace server {
 
 QueryHandler::QueryHandler(executor::Executor &executor,
-                           planner::Planner &planner)
-    : executor_(executor), planner_(planner) {}
+                           planner::Planner &planner,
+                           const MemoryConfig &memory)
+    : executor_(executor), planner_(planner) {
+  planner_.set_work_memory(budget_.work_memory());
+  cache_.configure(memory.result_cache_bytes,
+                   memory.result_cache_max_staleness);
+}
 
 HttpResponse QueryHandler::handle(const HttpRequest &request) {
+  auto started = std::chrono::steady_clock::now();
+
   // Extract query from body or query string
   std::string query;
 
@@ -36,8 +45,51 @@ HttpResponse QueryHandler::handle(const HttpRequest &request) {
     return HttpResponse::bad_request("No query provided");
   }
 
+  // A cached response is sent as stored, before any memory is taken, with
+  // stats of its own: nothing was scanned to answer it
+  auto version_of = [this](uint32_t table_id) {
+    return executor_.table_version(table_id);
+  };
+  std::string cache_key;
+  if (cache_.enabled()) {
+    cache_key = ResultCache::make_key(query);
+  }
+  if (!cache_key.empty()) {
+    if (auto cached = cache_.lookup(cache_key, version_of)) {
+      observability::Metrics::instance().increment("result_cache_hits");
+      executor::ExecutionStats stats;
+      stats.rows_returned = cached->rows_returned;
+      stats.elapsed_time =
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - started);
+      HttpResponse response =
+          HttpResponse::ok(finish_result(cached->body, stats, true));
+      response.headers["X-Cache"] = "HIT";
+      return response;
+    }
+    observability::Metrics::instance().increment("result_cache_misses");
+  }
+
+  // Throttle new queries while the process is near its global memory
+  // limit; try to win back headroom first
+  auto &tracker = memory::MemoryTracker::instance();
+  if (tracker.under_pressure()) {
+    memory::ArenaPool::local().drop_idle();
+    tracker.reclaim(budget_.max_memory_bytes);
+    if (tracker.under_pressure()) {
+      observability::Metrics::instance().increment(
+          "queries_throttled_memory");
+      return HttpResponse::service_unavailable(
+          "Server under memory pressure, retry later");
+    }
+  }
+
+  // The query arena holds the AST as well as execution state; the plan
+  // points into the AST, so all of it goes away with one arena reset
+  memory::PooledArena arena = memory::ArenaPool::local().acquire();
+
   // Parse query
-  sql::Parser parser(query);
+  sql::Parser parser(query, *arena);
   auto stmt = parser.parse();
 
   if (!stmt) {
@@ -45,15 +97,30 @@ HttpResponse QueryHandler::handle(const HttpRequest &request) {
   }
 
   // Plan query
-  auto plan = planner_.plan(*stmt);
+  auto plan = planner_.plan(*stmt, *arena);
 
   if (!plan) {
     return HttpResponse::bad_request(planner_.error().to_string());
   }
 
+  // Versions are read before executing, so rows stored while the query
+  // runs leave the entry already out of date
+  ResultCache::Versions versions;
+  bool cacheable = false;
+  if (!cache_key.empty()) {
+    std::vector<uint32_t> tables;
+    cacheable = planner::read_tables(**plan, tables);
+    for (size_t i = 0; cacheable && i < tables.size(); ++i) {
+      std::optional<uint64_t> version = version_of(tables[i]);
+      cacheable = version.has_value();
+      if (cacheable) {
+        versions.emplace_back(tables[i], *version);
+      }
+    }
+  }
+
   // Create execution context
-  memory::Arena arena(64 * 1024); // 64KB blocks
-  memory::QueryAllocator allocator(budget_.max_memory_bytes, arena);
+  memory::QueryAllocator allocator(budget_.max_memory_bytes, *arena);
   executor::ExecutionContext ctx(budget_, allocator);
 
   // Execute
@@ -69,8 +136,13 @@ HttpResponse QueryHandler::handle(const HttpRequest &request) {
     return HttpResponse::internal_error(result.error);
   }
 
-  // Format response
-  std::string response = format_result(result);
+  // Format response; the cache keeps it without the stats
+  std::string rows = format_rows(result);
+  std::string response = finish_result(rows, result.stats, false);
+  if (cacheable) {
+    cache_.insert(cache_key, std::move(versions),
+                  {std::move(rows), result.stats.rows_returned});
+  }
   return HttpResponse::ok(response);
 }
 
@@ -78,8 +150,7 @@ RequestHandler QueryHandler::get_handler() {
   return [this](const HttpRequest &request) { return handle(request); };
 }
 
-std::string
-QueryHandler::format_result(const executor::ExecutionResult &result) {
+std::string QueryHandler::format_rows(const executor::ExecutionResult &result) {
   std::ostringstream out;
 
   out << "{\n";
@@ -129,14 +200,20 @@ QueryHandler::format_result(const executor::ExecutionResult &result) {
   }
   out << "  ],\n";
 
-  // Stats
   out << "  \"rows_affected\": " << result.rows_affected << ",\n";
-  out << "  \"stats\": " << format_stats(result.stats) << "\n";
-  out << "}";
 
   return out.str();
 }
 
+std::string QueryHandler::finish_result(std::string body,
+                                        const executor::ExecutionStats &stats,
+                                        bool cache_hit) {
+  body += "  \"stats\": ";
+  body += format_stats(stats, cache_hit);
+  body += "\n}";
+  return body;
+}
+
 std::string QueryHandler::format_error(const std::string &message) {
   std::ostringstream out;
   out << "{\n";
@@ -146,9 +223,11 @@ std::string QueryHandler::format_error(const std::string &message) {
   return out.str();
 }
 
-std::string QueryHandler::format_stats(const executor::ExecutionStats &stats) {
+std::string QueryHandler::format_stats(const executor::ExecutionStats &stats,
+                                       bool cache_hit) {
   std::ostringstream out;
   out << "{\n";
+  out << "    \"cache_hit\": " << (cache_hit ? "true" : "false") << ",\n";
   out << "    \"instructions\": " << stats.instructions_executed << ",\n";
   out << "    \"rows_scanned\": " << stats.rows_scanned << ",\n";
   out << "    \"rows_returned\": " << stats.rows_returned << ",\n";
@@ -7,10 +7,13 @@
 
 #include "../executor/context.hpp"
 #include "../executor/executor.hpp"
-#include "../memory/arena.hpp"
+#include "../memory/arena_pool.hpp"
 #include "../planner/planner.hpp"
 #include "../sql/parser.hpp"
+#include "edgesql/config.hpp"
 #include "http_server.hpp"
+#include "result_cache.hpp"
+#include <chrono>
 
 namespace edgesql {
 namespace server {
@@ -18,7 +21,9 @@ namespace server {
 /**
  * @brief Query handler
  *
- * Handles SQL query requests over HTTP.
+ * Handles SQL query requests over HTTP. Responses to queries are kept
+ * in a ResultCache, sized by the memory configuration, and served from it
+ * while the tables they read are unchanged.
  */
 class QueryHandler {
 public:
@@ -26,8 +31,10 @@ public:
    * @brief Constructor
    * @param executor Query executor
    * @param planner Query planner
+   * @param memory Result cache capacity and max staleness
    */
-  QueryHandler(executor::Executor &executor, planner::Planner &planner);
+  QueryHandler(executor::Executor &executor, planner::Planner &planner,
+               const MemoryConfig &memory = {});
 
   /**
    * @brief Handle a query request
@@ -43,17 +50,39 @@ public:
 
   /**
    * @brief Set default budget
+   *
+   * The planner sizes sorts, hash aggregations and hash joins to the
+   * budget's work memory.
    */
-  void set_budget(const executor::QueryBudget &budget) { budget_ = budget; }
+  void set_budget(const executor::QueryBudget &budget) {
+    budget_ = budget;
+    planner_.set_work_memory(budget_.work_memory());
+  }
+
+  /**
+   * @brief Resize the result cache
+   * @param max_bytes Capacity, 0 = disabled
+   * @param max_staleness How long a response may be served after the
+   *                      tables it read change, 0 = not at all
+   */
+  void set_result_cache(size_t max_bytes,
+                        std::chrono::milliseconds max_staleness) {
+    cache_.configure(max_bytes, max_staleness);
+  }
 
 private:
-  std::string format_result(const executor::ExecutionResult &result);
+  std::string format_rows(const executor::ExecutionResult &result);
+  std::string finish_result(std::string body,
+                            const executor::ExecutionStats &stats,
+                            bool cache_hit);
   std::string format_error(const std::string &message);
-  std::string format_stats(const executor::ExecutionStats &stats);
+  std::string format_stats(const executor::ExecutionStats &stats,
+                           bool cache_hit);
 
   executor::Executor &executor_;
   planner::Planner &planner_;
   executor::QueryBudget budget_;
+  ResultCache cache_;
 };
 
 } // namespace server
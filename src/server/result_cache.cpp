@@ -0,0 +1,176 @@
+/**
+ * @file result_cache.cpp
+ * @brief Result cache implementation
+ */
+
+#include "result_cache.hpp"
+#include "../memory/memory_tracker.hpp"
+#include "../sql/tokenizer.hpp"
+
+namespace edgesql {
+namespace server {
+
+namespace {
+
+constexpr memory::MemoryCategory CATEGORY =
+    memory::MemoryCategory::RESULT_CACHE;
+
+} // anonymous namespace
+
+ResultCache::ResultCache() {
+  reclaimer_id_ = memory::MemoryTracker::instance().add_reclaimer(
+      [this](size_t bytes) { return shrink(bytes); });
+}
+
+ResultCache::~ResultCache() {
+  memory::MemoryTracker::instance().remove_reclaimer(reclaimer_id_);
+  clear();
+}
+
+void ResultCache::configure(size_t max_bytes,
+                            std::chrono::milliseconds max_staleness) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_bytes_ = max_bytes;
+  max_staleness_ = max_staleness;
+  if (bytes_ > max_bytes_) {
+    evict(bytes_ - max_bytes_);
+  }
+}
+
+bool ResultCache::enabled() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return max_bytes_ > 0;
+}
+
+std::string ResultCache::make_key(std::string_view query) {
+  // Per token its type, then for all but keywords its text; lengths keep
+  // texts apart, so different token streams never share a key
+  std::string key;
+  size_t end = 0; // Key length before trailing semicolons
+  sql::Tokenizer tokenizer(query);
+  for (sql::Token token = tokenizer.next_token();
+       token.type != sql::TokenType::END_OF_INPUT;
+       token = tokenizer.next_token()) {
+    if (token.type == sql::TokenType::ERROR) {
+      return {};
+    }
+    key.push_back(static_cast<char>(token.type));
+    if (!token.is_keyword()) {
+      uint32_t length = static_cast<uint32_t>(token.text.size());
+      key.append(reinterpret_cast<const char *>(&length), sizeof(length));
+      key.append(token.text);
+    }
+    if (token.type != sql::TokenType::SEMICOLON) {
+      end = key.size();
+    }
+  }
+  if (!tokenizer.error().empty()) {
+    return {};
+  }
+  key.resize(end);
+  return key;
+}
+
+std::shared_ptr<const ResultCache::Response>
+ResultCache::lookup(const std::string &key, const VersionOf &version_of) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto found = index_.find(key);
+  if (found == index_.end()) {
+    return nullptr;
+  }
+  EntryList::iterator entry = found->second;
+
+  bool current = true;
+  for (const auto &[table_id, version] : entry->versions) {
+    std::optional<uint64_t> now = version_of(table_id);
+    if (!now) {
+      erase(entry);
+      return nullptr;
+    }
+    current = current && *now == version;
+  }
+  if (!current && Clock::now() - entry->stored > max_staleness_) {
+    erase(entry);
+    return nullptr;
+  }
+
+  entries_.splice(entries_.begin(), entries_, entry);
+  return entry->response;
+}
+
+void ResultCache::insert(const std::string &key, Versions versions,
+                         Response response) {
+  size_t bytes = ENTRY_OVERHEAD + key.size() + response.body.size() +
+                 versions.size() * sizeof(Versions::value_type);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (bytes > max_bytes_ / MAX_ENTRY_FRACTION) {
+    return;
+  }
+  auto found = index_.find(key);
+  if (found != index_.end()) {
+    erase(found->second);
+  }
+  if (bytes_ + bytes > max_bytes_) {
+    evict(bytes_ + bytes - max_bytes_);
+  }
+
+  // Make room under the global limit from this cache only
+  auto &tracker = memory::MemoryTracker::instance();
+  while (!tracker.try_reserve(bytes, CATEGORY)) {
+    if (entries_.empty()) {
+      return;
+    }
+    erase(std::prev(entries_.end()));
+  }
+
+  entries_.push_front(Entry{key, std::move(versions),
+                            std::make_shared<const Response>(
+                                std::move(response)),
+                            Clock::now(), bytes});
+  index_.emplace(entries_.front().key, entries_.begin());
+  bytes_ += bytes;
+}
+
+void ResultCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  evict(bytes_);
+}
+
+size_t ResultCache::shrink(size_t bytes) {
+  std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    return 0;
+  }
+  return evict(bytes);
+}
+
+size_t ResultCache::bytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bytes_;
+}
+
+size_t ResultCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+void ResultCache::erase(EntryList::iterator entry) {
+  memory::MemoryTracker::instance().release(entry->bytes, CATEGORY);
+  bytes_ -= entry->bytes;
+  index_.erase(entry->key);
+  entries_.erase(entry);
+}
+
+size_t ResultCache::evict(size_t bytes) {
+  size_t released = 0;
+  while (released < bytes && !entries_.empty()) {
+    auto last = std::prev(entries_.end());
+    released += last->bytes;
+    erase(last);
+  }
+  return released;
+}
+
+} // namespace server
+} // namespace edgesql
@@ -0,0 +1,163 @@
+#pragma once
+
+/**
+ * @file result_cache.hpp
+ * @brief Cache of encoded query responses
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace edgesql {
+namespace server {
+
+/**
+ * @brief Bounded cache of query responses, by normalized query text
+ *
+ * An entry holds the response body as sent, less its stats, so a hit is
+ * served without parsing, planning or executing anything; the handler
+ * adds stats of the hit itself. With each entry go
+ * the versions of the tables the query read, taken before it ran; the
+ * entry is valid while every table still has that version. With a max
+ * staleness, an entry whose tables have since changed is still served
+ * until it is that old, but never once a table is gone.
+ *
+ * Entries are charged to MemoryCategory::RESULT_CACHE and evicted least
+ * recently used first, to stay under the capacity, when the global
+ * limit would be passed, or when another subsystem asks for memory back.
+ * A capacity of 0 disables the cache.
+ *
+ * Thread-safe.
+ */
+class ResultCache {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // Table id and version, per table a query read
+  using Versions = std::vector<std::pair<uint32_t, uint64_t>>;
+
+  // A table's current version, or nullopt if it cannot be cached
+  using VersionOf = std::function<std::optional<uint64_t>(uint32_t)>;
+
+  // A response without its stats block
+  struct Response {
+    std::string body;
+    uint64_t rows_returned{0};
+  };
+
+  // Entries larger than this fraction of the capacity are not kept, so
+  // one large result cannot flush the cache
+  static constexpr size_t MAX_ENTRY_FRACTION = 8;
+
+  // Bytes charged per entry besides its key, body and versions
+  static constexpr size_t ENTRY_OVERHEAD = 160;
+
+  ResultCache();
+  ~ResultCache();
+
+  // Non-copyable
+  ResultCache(const ResultCache &) = delete;
+  ResultCache &operator=(const ResultCache &) = delete;
+
+  /**
+   * @brief Set the capacity and max staleness, evicting to fit
+   * @param max_bytes Capacity, 0 = disabled
+   * @param max_staleness How long an entry may be served after its
+   *                      tables change, 0 = not at all
+   */
+  void configure(size_t max_bytes, std::chrono::milliseconds max_staleness);
+
+  /**
+   * @brief Check whether the cache is enabled
+   */
+  bool enabled() const;
+
+  /**
+   * @brief Make the cache key of a query
+   *
+   * Queries that tokenize the same share a key: whitespace, comments,
+   * keyword case and trailing semicolons do not matter.
+   *
+   * @return The key, or empty if the query does not tokenize
+   */
+  static std::string make_key(std::string_view query);
+
+  /**
+   * @brief Find a valid entry
+   *
+   * An entry found to be invalid is dropped.
+   *
+   * @return The response, or nullptr
+   */
+  std::shared_ptr<const Response> lookup(const std::string &key,
+                                         const VersionOf &version_of);
+
+  /**
+   * @brief Store a response
+   * @param versions The versions of the tables read, from before the
+   *                 query ran
+   */
+  void insert(const std::string &key, Versions versions, Response response);
+
+  /**
+   * @brief Drop all entries
+   */
+  void clear();
+
+  /**
+   * @brief Evict entries to free memory for other subsystems
+   *
+   * Skips the pass if the cache is busy rather than blocking the caller.
+   *
+   * @param bytes Bytes wanted
+   * @return Bytes released
+   */
+  size_t shrink(size_t bytes);
+
+  /**
+   * @brief Get the bytes held
+   */
+  size_t bytes() const;
+
+  /**
+   * @brief Get the number of entries
+   */
+  size_t size() const;
+
+private:
+  struct Entry {
+    std::string key;
+    Versions versions;
+    std::shared_ptr<const Response> response;
+    Clock::time_point stored;
+    size_t bytes;
+  };
+  using EntryList = std::list<Entry>;
+
+  void erase(EntryList::iterator entry);
+  size_t evict(size_t bytes);
+
+  size_t max_bytes_{0};
+  std::chrono::milliseconds max_staleness_{0};
+  size_t bytes_{0};
+
+  EntryList entries_; // Most recently used first
+  std::unordered_map<std::string_view, EntryList::iterator> index_;
+  mutable std::mutex mutex_;
+
+  uint64_t reclaimer_id_{0};
+};
+
+} // namespace server
+} // namespace edgesql
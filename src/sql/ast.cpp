@@ -8,103 +8,170 @@
 namespace edgesql {
 namespace sql {
 
-std::unique_ptr<Expression> Expression::star() {
-  auto expr = std::make_unique<Expression>();
-  expr->type = ExprType::STAR;
-  expr->value = std::monostate{};
+namespace {
+
+Expression *make_expression(memory::Arena &arena, ExprType type) {
+  Expression *expr = make_node<Expression>(arena);
+  expr->type = type;
   return expr;
 }
 
-std::unique_ptr<Expression> Expression::literal(const Literal &lit) {
-  auto expr = std::make_unique<Expression>();
-  expr->type = ExprType::LITERAL;
-  expr->value = lit;
+} // anonymous namespace
+
+std::string_view copy_text(memory::Arena &arena, std::string_view text) {
+  if (text.empty()) {
+    return {};
+  }
+  char *copy = arena.allocate_array<char>(text.size());
+  if (!copy) {
+    throw std::bad_alloc();
+  }
+  std::memcpy(copy, text.data(), text.size());
+  return std::string_view(copy, text.size());
+}
+
+BinaryOp mirror(BinaryOp op) {
+  switch (op) {
+  case BinaryOp::LT:
+    return BinaryOp::GT;
+  case BinaryOp::LE:
+    return BinaryOp::GE;
+  case BinaryOp::GT:
+    return BinaryOp::LT;
+  case BinaryOp::GE:
+    return BinaryOp::LE;
+  default:
+    return op;
+  }
+}
+
+Literal Expression::to_literal() const {
+  switch (literal_type) {
+  case Literal::Type::INTEGER:
+    return Literal::integer(int_value);
+  case Literal::Type::FLOAT:
+    return Literal::floating(float_value);
+  case Literal::Type::STRING:
+    return Literal::string(string_value);
+  case Literal::Type::BOOLEAN:
+    return Literal::boolean(bool_value);
+  case Literal::Type::NULL_VAL:
+    break;
+  }
+  return Literal::null();
+}
+
+Expression *Expression::star(memory::Arena &arena) {
+  return make_expression(arena, ExprType::STAR);
+}
+
+Expression *Expression::literal(memory::Arena &arena, const Literal &lit) {
+  Expression *expr = make_expression(arena, ExprType::LITERAL);
+  expr->literal_type = lit.type;
+  switch (lit.type) {
+  case Literal::Type::FLOAT:
+    expr->float_value = lit.float_value;
+    break;
+  case Literal::Type::BOOLEAN:
+    expr->bool_value = lit.bool_value;
+    break;
+  case Literal::Type::STRING:
+    expr->string_value = copy_text(arena, lit.string_value);
+    break;
+  default:
+    expr->int_value = lit.int_value;
+    break;
+  }
   return expr;
 }
 
-std::unique_ptr<Expression> Expression::column(const std::string &name) {
-  auto expr = std::make_unique<Expression>();
-  expr->type = ExprType::COLUMN_REF;
-  ColumnRef ref;
-  ref.column_name = name;
-  expr->value = ref;
+Expression *Expression::string(memory::Arena &arena, std::string_view text) {
+  Expression *expr = make_expression(arena, ExprType::LITERAL);
+  expr->literal_type = Literal::Type::STRING;
+  expr->string_value = text;
   return expr;
 }
 
-std::unique_ptr<Expression> Expression::column(const std::string &table,
-                                               const std::string &name) {
-  auto expr = std::make_unique<Expression>();
-  expr->type = ExprType::COLUMN_REF;
-  ColumnRef ref;
-  ref.table_name = table;
-  ref.column_name = name;
-  expr->value = ref;
+Expression *Expression::column(memory::Arena &arena, std::string_view name) {
+  Expression *expr = make_expression(arena, ExprType::COLUMN_REF);
+  expr->name = name;
   return expr;
 }
 
-std::unique_ptr<Expression>
-Expression::binary(BinaryOp op, std::unique_ptr<Expression> left,
-                   std::unique_ptr<Expression> right) {
-  auto expr = std::make_unique<Expression>();
-  expr->type = ExprType::BINARY_OP;
-  auto bin = std::make_unique<BinaryExpr>();
-  bin->op = op;
-  bin->left = std::move(left);
-  bin->right = std::move(right);
-  expr->value = std::move(bin);
+Expression *Expression::column(memory::Arena &arena, std::string_view table,
+                               std::string_view name) {
+  Expression *expr = make_expression(arena, ExprType::COLUMN_REF);
+  expr->table_name = table;
+  expr->name = name;
   return expr;
 }
 
-std::unique_ptr<Expression>
-Expression::unary(UnaryOp op, std::unique_ptr<Expression> operand) {
-  auto expr = std::make_unique<Expression>();
-  expr->type = ExprType::UNARY_OP;
-  auto un = std::make_unique<UnaryExpr>();
-  un->op = op;
-  un->operand = std::move(operand);
-  expr->value = std::move(un);
+Expression *Expression::binary(memory::Arena &arena, BinaryOp op,
+                               const Expression *left,
+                               const Expression *right) {
+  Expression *expr = make_expression(arena, ExprType::BINARY_OP);
+  expr->binary_op = op;
+  expr->left = left;
+  expr->right = right;
   return expr;
 }
 
-std::unique_ptr<Expression>
-Expression::function(const std::string &name,
-                     std::vector<std::unique_ptr<Expression>> args,
-                     bool distinct) {
-  auto expr = std::make_unique<Expression>();
-  expr->type = ExprType::FUNCTION_CALL;
-  auto fn = std::make_unique<FunctionCall>();
-  fn->name = name;
-  fn->args = std::move(args);
-  fn->distinct = distinct;
-  expr->value = std::move(fn);
+Expression *Expression::unary(memory::Arena &arena, UnaryOp op,
+                              const Expression *operand) {
+  Expression *expr = make_expression(arena, ExprType::UNARY_OP);
+  expr->unary_op = op;
+  expr->left = operand;
   return expr;
 }
 
-Statement Statement::select(std::unique_ptr<SelectStmt> s) {
+Expression *Expression::function(memory::Arena &arena, std::string_view name,
+                                 ExprList args, bool distinct) {
+  Expression *expr = make_expression(arena, ExprType::FUNCTION_CALL);
+  expr->name = name;
+  expr->args = args;
+  expr->distinct = distinct;
+  return expr;
+}
+
+Statement Statement::select(const SelectStmt *s) {
   Statement stmt;
   stmt.type = StmtType::SELECT;
-  stmt.stmt = std::move(s);
+  stmt.stmt = s;
   return stmt;
 }
 
-Statement Statement::insert(std::unique_ptr<InsertStmt> s) {
+Statement Statement::insert(const InsertStmt *s) {
   Statement stmt;
   stmt.type = StmtType::INSERT;
-  stmt.stmt = std::move(s);
+  stmt.stmt = s;
   return stmt;
 }
 
-Statement Statement::create_table(std::unique_ptr<CreateTableStmt> s) {
+Statement Statement::create_table(const CreateTableStmt *s) {
   Statement stmt;
   stmt.type = StmtType::CREATE_TABLE;
-  stmt.stmt = std::move(s);
+  stmt.stmt = s;
+  return stmt;
+}
+
+Statement Statement::create_view(const CreateViewStmt *s) {
+  Statement stmt;
+  stmt.type = StmtType::CREATE_VIEW;
+  stmt.stmt = s;
   return stmt;
 }
 
-Statement Statement::drop_table(std::unique_ptr<DropTableStmt> s) {
+Statement Statement::drop_table(const DropTableStmt *s) {
   Statement stmt;
   stmt.type = StmtType::DROP_TABLE;
-  stmt.stmt = std::move(s);
+  stmt.stmt = s;
+  return stmt;
+}
+
+Statement Statement::analyze(const AnalyzeStmt *s) {
+  Statement stmt;
+  stmt.type = StmtType::ANALYZE;
+  stmt.stmt = s;
   return stmt;
 }
 
@@ -5,26 +5,33 @@
  * @brief Abstract Syntax Tree for SQL statements
  */
 
+#include "../memory/arena.hpp"
 #include <cstdint>
-#include <memory>
+#include <cstring>
+#include <memory_resource>
+#include <new>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <variant>
-#include <vector>
 
 namespace edgesql {
 namespace sql {
 
 // Forward declarations
-struct SelectStmt;
-struct InsertStmt;
-struct CreateTableStmt;
-struct DropTableStmt;
 struct Expression;
 
 /**
  * @brief Statement types
  */
-enum class StmtType { SELECT, INSERT, CREATE_TABLE, DROP_TABLE };
+enum class StmtType {
+  SELECT,
+  INSERT,
+  CREATE_TABLE,
+  CREATE_VIEW,
+  DROP_TABLE,
+  ANALYZE
+};
 
 /**
  * @brief Expression types
@@ -57,6 +64,13 @@ enum class BinaryOp {
   OR
 };
 
+/**
+ * @brief Get the comparison that holds with the operands swapped
+ *
+ * `a < b` is `b > a`; other operators are returned unchanged.
+ */
+BinaryOp mirror(BinaryOp op);
+
 /**
  * @brief Unary operators
  */
@@ -64,8 +78,13 @@ enum class UnaryOp { NOT, MINUS };
 
 /**
  * @brief Literal value
+ *
+ * Allocator-aware: inside std::pmr containers the string payload is
+ * allocated from the container's memory resource.
  */
 struct Literal {
+  using allocator_type = std::pmr::polymorphic_allocator<char>;
+
   enum class Type { NULL_VAL, INTEGER, FLOAT, STRING, BOOLEAN } type;
 
   union {
@@ -73,9 +92,28 @@ struct Literal {
     double float_value;
     bool bool_value;
   };
-  std::string string_value;
+  std::pmr::string string_value;
 
   Literal() : type(Type::NULL_VAL), int_value(0) {}
+  explicit Literal(const allocator_type &alloc)
+      : type(Type::NULL_VAL), int_value(0), string_value(alloc) {}
+
+  Literal(const Literal &other) = default;
+  Literal(Literal &&other) noexcept = default;
+  Literal(const Literal &other, const allocator_type &alloc)
+      : type(other.type), int_value(0),
+        string_value(other.string_value, alloc) {
+    copy_scalar(other);
+  }
+  Literal(Literal &&other, const allocator_type &alloc)
+      : type(other.type), int_value(0),
+        string_value(std::move(other.string_value), alloc) {
+    copy_scalar(other);
+  }
+
+  Literal &operator=(const Literal &other) = default;
+  // Not noexcept: a string on another resource is copied, not stolen
+  Literal &operator=(Literal &&other) = default;
 
   static Literal null() { return Literal(); }
   static Literal integer(int64_t v) {
@@ -90,99 +128,222 @@ struct Literal {
     l.float_value = v;
     return l;
   }
-  static Literal string(const std::string &v) {
+  static Literal string(std::string_view v) {
     Literal l;
     l.type = Type::STRING;
     l.string_value = v;
     return l;
   }
+  static Literal string(std::string_view v, const allocator_type &alloc) {
+    Literal l(alloc);
+    l.type = Type::STRING;
+    l.string_value = v;
+    return l;
+  }
   static Literal boolean(bool v) {
     Literal l;
     l.type = Type::BOOLEAN;
     l.bool_value = v;
     return l;
   }
-};
 
-/**
- * @brief Column reference
- */
-struct ColumnRef {
-  std::string table_name; // Optional
-  std::string column_name;
+private:
+  void copy_scalar(const Literal &other) {
+    switch (other.type) {
+    case Type::FLOAT:
+      float_value = other.float_value;
+      break;
+    case Type::BOOLEAN:
+      bool_value = other.bool_value;
+      break;
+    default:
+      int_value = other.int_value;
+      break;
+    }
+  }
 };
 
 /**
- * @brief Binary operation
+ * @brief Allocate an AST node from the query arena
+ *
+ * Nodes are never destroyed individually: resetting the arena releases
+ * the whole tree, so node types must be trivially destructible.
+ *
+ * @throws std::bad_alloc if the arena cannot grow
  */
-struct BinaryExpr {
-  BinaryOp op;
-  std::unique_ptr<Expression> left;
-  std::unique_ptr<Expression> right;
-};
+template <typename T> T *make_node(memory::Arena &arena) {
+  static_assert(std::is_trivially_destructible_v<T>);
+  void *memory = arena.allocate(sizeof(T), alignof(T));
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  return new (memory) T();
+}
 
 /**
- * @brief Unary operation
+ * @brief Copy text into the query arena, so a node can outlive its source
+ * @throws std::bad_alloc if the arena cannot grow
  */
-struct UnaryExpr {
-  UnaryOp op;
-  std::unique_ptr<Expression> operand;
-};
+std::string_view copy_text(memory::Arena &arena, std::string_view text);
 
 /**
- * @brief Function call (aggregates)
+ * @brief Arena-allocated array of AST items
+ *
+ * Grows by doubling into fresh arena memory; outgrown arrays are released
+ * with the rest of the arena. Copying a list copies the handle, not the
+ * items.
  */
-struct FunctionCall {
-  std::string name;
-  std::vector<std::unique_ptr<Expression>> args;
-  bool distinct{false};
+template <typename T> class NodeList {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+  /**
+   * @brief Append an item
+   * @throws std::bad_alloc if the arena cannot grow
+   */
+  void push_back(memory::Arena &arena, const T &item) {
+    if (size_ == capacity_) {
+      grow(arena);
+    }
+    items_[size_++] = item;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  const T &operator[](size_t index) const { return items_[index]; }
+  const T *begin() const { return items_; }
+  const T *end() const { return items_ + size_; }
+
+private:
+  void grow(memory::Arena &arena) {
+    uint32_t capacity = capacity_ ? capacity_ * 2 : 4;
+    T *items = arena.allocate_array<T>(capacity);
+    if (!items) {
+      throw std::bad_alloc();
+    }
+    if (size_) {
+      std::memcpy(static_cast<void *>(items), items_, size_ * sizeof(T));
+    }
+    items_ = items;
+    capacity_ = capacity;
+  }
+
+  T *items_{nullptr};
+  uint32_t size_{0};
+  uint32_t capacity_{0};
 };
 
+using ExprList = NodeList<const Expression *>;
+
 /**
  * @brief Expression node
+ *
+ * One flat node type for every expression kind, allocated from the query
+ * arena: a 1,000-row INSERT costs bump allocations rather than a malloc
+ * per node. Names and string literals are views into the query text (or
+ * the arena), which must outlive the tree.
  */
 struct Expression {
-  ExprType type;
-  std::variant<Literal, ColumnRef, std::unique_ptr<BinaryExpr>,
-               std::unique_ptr<UnaryExpr>, std::unique_ptr<FunctionCall>,
-               std::monostate // For STAR
-               >
-      value;
-
-  std::string alias; // Optional alias (AS ...)
-
-  static std::unique_ptr<Expression> star();
-  static std::unique_ptr<Expression> literal(const Literal &lit);
-  static std::unique_ptr<Expression> column(const std::string &name);
-  static std::unique_ptr<Expression> column(const std::string &table,
-                                            const std::string &name);
-  static std::unique_ptr<Expression> binary(BinaryOp op,
-                                            std::unique_ptr<Expression> left,
-                                            std::unique_ptr<Expression> right);
-  static std::unique_ptr<Expression> unary(UnaryOp op,
-                                           std::unique_ptr<Expression> operand);
-  static std::unique_ptr<Expression>
-  function(const std::string &name,
-           std::vector<std::unique_ptr<Expression>> args,
-           bool distinct = false);
+  ExprType type{ExprType::STAR};
+
+  BinaryOp binary_op{BinaryOp::ADD}; // BINARY_OP
+  UnaryOp unary_op{UnaryOp::NOT};    // UNARY_OP
+  bool distinct{false};              // FUNCTION_CALL
+
+  // LITERAL
+  Literal::Type literal_type{Literal::Type::NULL_VAL};
+  union {
+    int64_t int_value{0};
+    double float_value;
+    bool bool_value;
+  };
+  std::string_view string_value; // STRING, without quotes
+
+  std::string_view table_name; // COLUMN_REF, optional
+  std::string_view name;       // COLUMN_REF column, FUNCTION_CALL function
+  std::string_view alias;      // Optional alias (AS ...)
+
+  const Expression *left{nullptr};  // BINARY_OP; UNARY_OP operand
+  const Expression *right{nullptr}; // BINARY_OP
+  ExprList args;                    // FUNCTION_CALL
+
+  const Expression *operand() const { return left; }
+
+  /**
+   * @brief Copy a LITERAL node's value out of the arena
+   */
+  Literal to_literal() const;
+
+  static Expression *star(memory::Arena &arena);
+  // Copies string payloads into the arena
+  static Expression *literal(memory::Arena &arena, const Literal &lit);
+  // The text is referenced, not copied
+  static Expression *string(memory::Arena &arena, std::string_view text);
+  static Expression *column(memory::Arena &arena, std::string_view name);
+  static Expression *column(memory::Arena &arena, std::string_view table,
+                            std::string_view name);
+  static Expression *binary(memory::Arena &arena, BinaryOp op,
+                            const Expression *left, const Expression *right);
+  static Expression *unary(memory::Arena &arena, UnaryOp op,
+                           const Expression *operand);
+  static Expression *function(memory::Arena &arena, std::string_view name,
+                              ExprList args, bool distinct = false);
 };
 
 /**
  * @brief Order by specification
  */
 struct OrderByItem {
-  std::unique_ptr<Expression> expr;
+  const Expression *expr{nullptr};
   bool ascending{true};
 };
 
+/**
+ * @brief TABLESAMPLE methods
+ *
+ * SYSTEM keeps whole pages, BERNOULLI single rows.
+ */
+enum class SampleMethod { SYSTEM, BERNOULLI };
+
+/**
+ * @brief TABLESAMPLE clause of a table in FROM or JOIN
+ */
+struct TableSample {
+  SampleMethod method{SampleMethod::SYSTEM};
+  double percent{100.0}; // Of pages or rows kept, in [0, 100]
+  bool repeatable{false}; // REPEATABLE (seed) given
+  int64_t seed{0};
+};
+
+/**
+ * @brief Join types
+ */
+enum class JoinType { INNER, LEFT };
+
+/**
+ * @brief JOIN clause of a SELECT
+ */
+struct JoinClause {
+  JoinType type{JoinType::INNER};
+  std::string_view table_name;
+  std::string_view alias;            // Optional
+  const TableSample *sample{nullptr}; // Optional
+  const Expression *condition{nullptr};
+};
+
 /**
  * @brief SELECT statement
  */
 struct SelectStmt {
-  std::vector<std::unique_ptr<Expression>> columns;
-  std::string table_name;
-  std::unique_ptr<Expression> where_clause;
-  std::vector<OrderByItem> order_by;
+  ExprList columns;
+  std::string_view table_name;
+  std::string_view table_alias;  // Optional
+  const TableSample *table_sample{nullptr}; // Optional
+  NodeList<JoinClause> joins;    // Joined left to right
+  const Expression *where_clause{nullptr};
+  ExprList group_by;
+  NodeList<OrderByItem> order_by;
   int64_t limit{-1}; // -1 means no limit
   int64_t offset{0};
 };
@@ -191,52 +352,81 @@ struct SelectStmt {
  * @brief INSERT statement
  */
 struct InsertStmt {
-  std::string table_name;
-  std::vector<std::string> column_names; // Optional, if empty, all columns
-  std::vector<std::vector<std::unique_ptr<Expression>>> values; // Multiple rows
+  std::string_view table_name;
+  NodeList<std::string_view> column_names; // Optional, empty = all columns
+  NodeList<ExprList> values;               // Multiple rows
 };
 
 /**
  * @brief Column definition for CREATE TABLE
  */
 struct ColumnDef {
-  std::string name;
-  std::string type; // INTEGER, TEXT, FLOAT, BOOLEAN, BLOB
+  std::string_view name;
+  std::string_view type; // INTEGER, TEXT, FLOAT, BOOLEAN, BLOB
   bool not_null{false};
   bool primary_key{false};
-  std::unique_ptr<Expression> default_value;
+  const Expression *default_value{nullptr};
 };
 
 /**
  * @brief CREATE TABLE statement
  */
 struct CreateTableStmt {
-  std::string table_name;
-  std::vector<ColumnDef> columns;
+  std::string_view table_name;
+  NodeList<ColumnDef> columns;
   bool if_not_exists{false};
+  bool columnar{false}; // USING COLUMNAR: PAX pages
+
+  // PARTITION BY <column> [EVERY <width>] [RETENTION <span>]
+  std::string_view partition_column; // Empty if not partitioned
+  int64_t partition_width{86400}; // Default: one day of second timestamps
+  int64_t retention{0};           // 0 = keep forever
 };
 
 /**
- * @brief DROP TABLE statement
+ * @brief CREATE MATERIALIZED VIEW statement
+ */
+struct CreateViewStmt {
+  std::string_view view_name;
+  const SelectStmt *query{nullptr};
+  std::string_view query_text; // The SELECT as written
+};
+
+/**
+ * @brief DROP TABLE or DROP MATERIALIZED VIEW statement
  */
 struct DropTableStmt {
-  std::string table_name;
+  std::string_view table_name;
   bool if_exists{false};
+  bool view{false}; // DROP MATERIALIZED VIEW
+};
+
+/**
+ * @brief ANALYZE statement
+ */
+struct AnalyzeStmt {
+  std::string_view table_name; // Empty = every table
 };
 
 /**
  * @brief Statement wrapper
+ *
+ * A handle to a statement in the query arena; valid until the arena is
+ * reset.
  */
 struct Statement {
   StmtType type;
-  std::variant<std::unique_ptr<SelectStmt>, std::unique_ptr<InsertStmt>,
-               std::unique_ptr<CreateTableStmt>, std::unique_ptr<DropTableStmt>>
+  std::variant<const SelectStmt *, const InsertStmt *,
+               const CreateTableStmt *, const CreateViewStmt *,
+               const DropTableStmt *, const AnalyzeStmt *>
       stmt;
 
-  static Statement select(std::unique_ptr<SelectStmt> s);
-  static Statement insert(std::unique_ptr<InsertStmt> s);
-  static Statement create_table(std::unique_ptr<CreateTableStmt> s);
-  static Statement drop_table(std::unique_ptr<DropTableStmt> s);
+  static Statement select(const SelectStmt *s);
+  static Statement insert(const InsertStmt *s);
+  static Statement create_table(const CreateTableStmt *s);
+  static Statement create_view(const CreateViewStmt *s);
+  static Statement drop_table(const DropTableStmt *s);
+  static Statement analyze(const AnalyzeStmt *s);
 };
 
 } // namespace sql
@@ -10,13 +10,23 @@
 namespace edgesql {
 namespace sql {
 
-Parser::Parser(std::string_view input) : tokenizer_(input) {
+Parser::Parser(std::string_view input, memory::Arena &arena)
+    : tokenizer_(input), arena_(arena) {
   current_ = tokenizer_.next_token();
 }
 
 std::optional<Statement> Parser::parse() {
   has_error_ = false;
 
+  try {
+    return parse_statement();
+  } catch (const std::bad_alloc &) {
+    set_error("Out of memory");
+    return std::nullopt;
+  }
+}
+
+std::optional<Statement> Parser::parse_statement() {
   if (check(TokenType::END_OF_INPUT)) {
     set_error("Empty statement");
     return std::nullopt;
@@ -25,35 +35,54 @@ std::optional<Statement> Parser::parse() {
   Statement result;
 
   if (match(TokenType::SELECT)) {
-    auto stmt = parse_select();
+    const auto *stmt = parse_select();
     if (!stmt)
       return std::nullopt;
-    result = Statement::select(std::move(stmt));
+    result = Statement::select(stmt);
   } else if (match(TokenType::INSERT)) {
-    auto stmt = parse_insert();
+    const auto *stmt = parse_insert();
     if (!stmt)
       return std::nullopt;
-    result = Statement::insert(std::move(stmt));
+    result = Statement::insert(stmt);
   } else if (match(TokenType::CREATE)) {
-    if (!match(TokenType::TABLE)) {
-      set_error("Expected TABLE after CREATE");
-      return std::nullopt;
+    if (match(TokenType::MATERIALIZED)) {
+      const auto *stmt = parse_create_view();
+      if (!stmt)
+        return std::nullopt;
+      result = Statement::create_view(stmt);
+    } else {
+      if (!match(TokenType::TABLE)) {
+        set_error("Expected TABLE or MATERIALIZED VIEW after CREATE");
+        return std::nullopt;
+      }
+      const auto *stmt = parse_create_table();
+      if (!stmt)
+        return std::nullopt;
+      result = Statement::create_table(stmt);
     }
-    auto stmt = parse_create_table();
-    if (!stmt)
-      return std::nullopt;
-    result = Statement::create_table(std::move(stmt));
   } else if (match(TokenType::DROP)) {
-    if (!match(TokenType::TABLE)) {
-      set_error("Expected TABLE after DROP");
+    bool view = match(TokenType::MATERIALIZED);
+    if (view) {
+      if (!match(TokenType::VIEW)) {
+        set_error("Expected VIEW after MATERIALIZED");
+        return std::nullopt;
+      }
+    } else if (!match(TokenType::TABLE)) {
+      set_error("Expected TABLE or MATERIALIZED VIEW after DROP");
       return std::nullopt;
     }
-    auto stmt = parse_drop_table();
+    auto *stmt = parse_drop_table();
+    if (!stmt)
+      return std::nullopt;
+    stmt->view = view;
+    result = Statement::drop_table(stmt);
+  } else if (match(TokenType::ANALYZE)) {
+    const auto *stmt = parse_analyze();
     if (!stmt)
       return std::nullopt;
-    result = Statement::drop_table(std::move(stmt));
+    result = Statement::analyze(stmt);
   } else {
-    set_error("Expected SELECT, INSERT, CREATE, or DROP");
+    set_error("Expected SELECT, INSERT, CREATE, DROP, or ANALYZE");
     return std::nullopt;
   }
 
@@ -63,8 +92,8 @@ std::optional<Statement> Parser::parse() {
   return result;
 }
 
-std::unique_ptr<SelectStmt> Parser::parse_select() {
-  auto stmt = std::make_unique<SelectStmt>();
+SelectStmt *Parser::parse_select() {
+  SelectStmt *stmt = make_node<SelectStmt>(arena_);
 
   // Parse columns
   stmt->columns = parse_select_columns();
@@ -80,7 +109,49 @@ std::unique_ptr<SelectStmt> Parser::parse_select() {
   Token table = expect(TokenType::IDENTIFIER, "Expected table name");
   if (has_error_)
     return nullptr;
-  stmt->table_name = std::string(table.text);
+  stmt->table_name = table.text;
+  stmt->table_alias = parse_table_alias();
+  if (has_error_)
+    return nullptr;
+  stmt->table_sample = parse_table_sample();
+  if (has_error_)
+    return nullptr;
+
+  // JOIN clauses: [INNER] JOIN or LEFT [OUTER] JOIN
+  while (check(TokenType::JOIN) || check(TokenType::INNER) ||
+         check(TokenType::LEFT)) {
+    JoinClause join;
+    if (match(TokenType::LEFT)) {
+      join.type = JoinType::LEFT;
+      match(TokenType::OUTER);
+    } else {
+      match(TokenType::INNER);
+    }
+    if (!match(TokenType::JOIN)) {
+      set_error("Expected JOIN");
+      return nullptr;
+    }
+
+    Token joined = expect(TokenType::IDENTIFIER, "Expected table name");
+    if (has_error_)
+      return nullptr;
+    join.table_name = joined.text;
+    join.alias = parse_table_alias();
+    if (has_error_)
+      return nullptr;
+    join.sample = parse_table_sample();
+    if (has_error_)
+      return nullptr;
+
+    if (!match(TokenType::ON)) {
+      set_error("Expected ON after joined table");
+      return nullptr;
+    }
+    join.condition = parse_expression();
+    if (has_error_)
+      return nullptr;
+    stmt->joins.push_back(arena_, join);
+  }
 
   // Optional WHERE clause
   if (match(TokenType::WHERE)) {
@@ -89,6 +160,20 @@ std::unique_ptr<SelectStmt> Parser::parse_select() {
       return nullptr;
   }
 
+  // Optional GROUP BY
+  if (match(TokenType::GROUP)) {
+    if (!match(TokenType::BY)) {
+      set_error("Expected BY after GROUP");
+      return nullptr;
+    }
+    do {
+      Expression *expr = parse_expression();
+      if (has_error_)
+        return nullptr;
+      stmt->group_by.push_back(arena_, expr);
+    } while (match(TokenType::COMMA));
+  }
+
   // Optional ORDER BY
   if (match(TokenType::ORDER)) {
     if (!match(TokenType::BY)) {
@@ -120,8 +205,8 @@ std::unique_ptr<SelectStmt> Parser::parse_select() {
   return stmt;
 }
 
-std::unique_ptr<InsertStmt> Parser::parse_insert() {
-  auto stmt = std::make_unique<InsertStmt>();
+InsertStmt *Parser::parse_insert() {
+  InsertStmt *stmt = make_node<InsertStmt>(arena_);
 
   if (!match(TokenType::INTO)) {
     set_error("Expected INTO after INSERT");
@@ -131,7 +216,7 @@ std::unique_ptr<InsertStmt> Parser::parse_insert() {
   Token table = expect(TokenType::IDENTIFIER, "Expected table name");
   if (has_error_)
     return nullptr;
-  stmt->table_name = std::string(table.text);
+  stmt->table_name = table.text;
 
   // Optional column list
   if (match(TokenType::LPAREN)) {
@@ -139,7 +224,7 @@ std::unique_ptr<InsertStmt> Parser::parse_insert() {
       Token col = expect(TokenType::IDENTIFIER, "Expected column name");
       if (has_error_)
         return nullptr;
-      stmt->column_names.push_back(std::string(col.text));
+      stmt->column_names.push_back(arena_, col.text);
     } while (match(TokenType::COMMA));
 
     if (!match(TokenType::RPAREN)) {
@@ -160,12 +245,12 @@ std::unique_ptr<InsertStmt> Parser::parse_insert() {
       return nullptr;
     }
 
-    std::vector<std::unique_ptr<Expression>> row;
+    ExprList row;
     do {
-      auto expr = parse_expression();
+      Expression *expr = parse_expression();
       if (has_error_)
         return nullptr;
-      row.push_back(std::move(expr));
+      row.push_back(arena_, expr);
     } while (match(TokenType::COMMA));
 
     if (!match(TokenType::RPAREN)) {
@@ -173,37 +258,32 @@ std::unique_ptr<InsertStmt> Parser::parse_insert() {
       return nullptr;
     }
 
-    stmt->values.push_back(std::move(row));
+    stmt->values.push_back(arena_, row);
   } while (match(TokenType::COMMA));
 
   return stmt;
 }
 
-std::unique_ptr<CreateTableStmt> Parser::parse_create_table() {
-  auto stmt = std::make_unique<CreateTableStmt>();
+CreateTableStmt *Parser::parse_create_table() {
+  CreateTableStmt *stmt = make_node<CreateTableStmt>(arena_);
 
   // IF NOT EXISTS
-  if (current_.type == TokenType::IDENTIFIER &&
-      std::string(current_.text) == "IF") {
-    advance();
-    if (!(current_.type == TokenType::NOT)) {
+  if (match(TokenType::IF)) {
+    if (!match(TokenType::NOT)) {
       set_error("Expected NOT after IF");
       return nullptr;
     }
-    advance();
-    if (!(current_.type == TokenType::IDENTIFIER &&
-          std::string(current_.text) == "EXISTS")) {
+    if (!match(TokenType::EXISTS)) {
       set_error("Expected EXISTS after IF NOT");
       return nullptr;
     }
-    advance();
     stmt->if_not_exists = true;
   }
 
   Token table = expect(TokenType::IDENTIFIER, "Expected table name");
   if (has_error_)
     return nullptr;
-  stmt->table_name = std::string(table.text);
+  stmt->table_name = table.text;
 
   if (!match(TokenType::LPAREN)) {
     set_error("Expected '(' after table name");
@@ -219,63 +299,221 @@ std::unique_ptr<CreateTableStmt> Parser::parse_create_table() {
     return nullptr;
   }
 
+  // Optional USING COLUMNAR | ROW storage layout
+  if (match(TokenType::USING)) {
+    if (match(TokenType::COLUMNAR)) {
+      stmt->columnar = true;
+    } else if (!match(TokenType::ROW)) {
+      set_error("Expected COLUMNAR or ROW after USING");
+      return nullptr;
+    }
+  }
+
+  // Optional PARTITION BY <column> [EVERY <width>]
+  if (match(TokenType::PARTITION)) {
+    if (!match(TokenType::BY)) {
+      set_error("Expected BY after PARTITION");
+      return nullptr;
+    }
+    Token column =
+        expect(TokenType::IDENTIFIER, "Expected column after PARTITION BY");
+    if (has_error_)
+      return nullptr;
+    stmt->partition_column = column.text;
+
+    if (match(TokenType::EVERY)) {
+      Token width = expect(TokenType::INTEGER, "Expected integer after EVERY");
+      if (has_error_)
+        return nullptr;
+      if (width.int_value <= 0) {
+        set_error("Partition width must be positive");
+        return nullptr;
+      }
+      stmt->partition_width = width.int_value;
+    }
+  }
+
+  // Optional RETENTION <span>, in partition column units
+  if (check(TokenType::RETENTION)) {
+    if (stmt->partition_column.empty()) {
+      set_error("RETENTION requires PARTITION BY");
+      return nullptr;
+    }
+    advance();
+    Token span = expect(TokenType::INTEGER, "Expected integer after RETENTION");
+    if (has_error_)
+      return nullptr;
+    if (span.int_value <= 0) {
+      set_error("Retention must be positive");
+      return nullptr;
+    }
+    stmt->retention = span.int_value;
+  }
+
+  return stmt;
+}
+
+CreateViewStmt *Parser::parse_create_view() {
+  CreateViewStmt *stmt = make_node<CreateViewStmt>(arena_);
+
+  if (!match(TokenType::VIEW)) {
+    set_error("Expected VIEW after MATERIALIZED");
+    return nullptr;
+  }
+
+  Token view = expect(TokenType::IDENTIFIER, "Expected view name");
+  if (has_error_)
+    return nullptr;
+  stmt->view_name = view.text;
+
+  if (!match(TokenType::AS)) {
+    set_error("Expected AS after view name");
+    return nullptr;
+  }
+
+  // The SELECT's text is kept, to be planned again when the view is used
+  size_t start = current_.offset;
+  if (!match(TokenType::SELECT)) {
+    set_error("Expected SELECT after AS");
+    return nullptr;
+  }
+  stmt->query = parse_select();
+  if (!stmt->query)
+    return nullptr;
+  stmt->query_text =
+      tokenizer_.input().substr(start, current_.offset - start);
+
   return stmt;
 }
 
-std::unique_ptr<DropTableStmt> Parser::parse_drop_table() {
-  auto stmt = std::make_unique<DropTableStmt>();
+DropTableStmt *Parser::parse_drop_table() {
+  DropTableStmt *stmt = make_node<DropTableStmt>(arena_);
 
   // IF EXISTS
-  if (current_.type == TokenType::IDENTIFIER &&
-      std::string(current_.text) == "IF") {
-    advance();
-    if (!(current_.type == TokenType::IDENTIFIER &&
-          std::string(current_.text) == "EXISTS")) {
+  if (match(TokenType::IF)) {
+    if (!match(TokenType::EXISTS)) {
       set_error("Expected EXISTS after IF");
       return nullptr;
     }
-    advance();
     stmt->if_exists = true;
   }
 
   Token table = expect(TokenType::IDENTIFIER, "Expected table name");
   if (has_error_)
     return nullptr;
-  stmt->table_name = std::string(table.text);
+  stmt->table_name = table.text;
+
+  return stmt;
+}
+
+AnalyzeStmt *Parser::parse_analyze() {
+  AnalyzeStmt *stmt = make_node<AnalyzeStmt>(arena_);
+
+  // Optional table name
+  if (check(TokenType::IDENTIFIER)) {
+    stmt->table_name = current_.text;
+    advance();
+  }
 
   return stmt;
 }
 
-std::vector<std::unique_ptr<Expression>> Parser::parse_select_columns() {
-  std::vector<std::unique_ptr<Expression>> columns;
+std::string_view Parser::parse_table_alias() {
+  bool as = match(TokenType::AS);
+  if (current_.type != TokenType::IDENTIFIER) {
+    if (as) {
+      set_error("Expected alias name");
+    }
+    return {};
+  }
+
+  std::string_view alias = current_.text;
+  advance();
+  return alias;
+}
+
+const TableSample *Parser::parse_table_sample() {
+  // TABLESAMPLE { SYSTEM | BERNOULLI } (percent) [REPEATABLE (seed)]
+  if (!match(TokenType::TABLESAMPLE)) {
+    return nullptr;
+  }
+
+  TableSample *sample = make_node<TableSample>(arena_);
+  if (match(TokenType::SYSTEM)) {
+    sample->method = SampleMethod::SYSTEM;
+  } else if (match(TokenType::BERNOULLI)) {
+    sample->method = SampleMethod::BERNOULLI;
+  } else {
+    set_error("Expected SYSTEM or BERNOULLI after TABLESAMPLE");
+    return nullptr;
+  }
+
+  if (!match(TokenType::LPAREN)) {
+    set_error("Expected ( after sampling method");
+    return nullptr;
+  }
+  Token percent = current_;
+  if (match(TokenType::INTEGER)) {
+    sample->percent = static_cast<double>(percent.int_value);
+  } else if (match(TokenType::FLOAT)) {
+    sample->percent = percent.float_value;
+  } else {
+    set_error("Expected sample percentage");
+    return nullptr;
+  }
+  if (!(sample->percent >= 0.0 && sample->percent <= 100.0)) {
+    set_error("Sample percentage must be between 0 and 100", percent);
+    return nullptr;
+  }
+  expect(TokenType::RPAREN, "Expected ) after sample percentage");
+  if (has_error_)
+    return nullptr;
+
+  if (match(TokenType::REPEATABLE)) {
+    if (!match(TokenType::LPAREN)) {
+      set_error("Expected ( after REPEATABLE");
+      return nullptr;
+    }
+    Token seed = expect(TokenType::INTEGER, "Expected integer seed");
+    if (has_error_)
+      return nullptr;
+    expect(TokenType::RPAREN, "Expected ) after seed");
+    if (has_error_)
+      return nullptr;
+    sample->repeatable = true;
+    sample->seed = seed.int_value;
+  }
+  return sample;
+}
+
+ExprList Parser::parse_select_columns() {
+  ExprList columns;
 
   do {
     if (match(TokenType::STAR)) {
-      columns.push_back(Expression::star());
+      columns.push_back(arena_, Expression::star(arena_));
     } else {
-      auto expr = parse_expression();
+      Expression *expr = parse_expression();
       if (has_error_)
         return {};
 
       // Optional alias
-      if (current_.type == TokenType::IDENTIFIER &&
-          std::string(current_.text) == "AS") {
-        advance();
+      if (match(TokenType::AS)) {
         Token alias = expect(TokenType::IDENTIFIER, "Expected alias name");
         if (has_error_)
           return {};
-        expr->alias = std::string(alias.text);
+        expr->alias = alias.text;
       }
 
-      columns.push_back(std::move(expr));
+      columns.push_back(arena_, expr);
     }
   } while (match(TokenType::COMMA));
 
   return columns;
 }
 
-std::vector<OrderByItem> Parser::parse_order_by() {
-  std::vector<OrderByItem> items;
+NodeList<OrderByItem> Parser::parse_order_by() {
+  NodeList<OrderByItem> items;
 
   do {
     OrderByItem item;
@@ -289,20 +527,20 @@ std::vector<OrderByItem> Parser::parse_order_by() {
       item.ascending = false;
     }
 
-    items.push_back(std::move(item));
+    items.push_back(arena_, item);
   } while (match(TokenType::COMMA));
 
   return items;
 }
 
-std::vector<ColumnDef> Parser::parse_column_defs() {
-  std::vector<ColumnDef> columns;
+NodeList<ColumnDef> Parser::parse_column_defs() {
+  NodeList<ColumnDef> columns;
 
   do {
     ColumnDef col = parse_column_def();
     if (has_error_)
       return {};
-    columns.push_back(std::move(col));
+    columns.push_back(arena_, col);
   } while (match(TokenType::COMMA));
 
   return columns;
@@ -314,7 +552,7 @@ ColumnDef Parser::parse_column_def() {
   Token name = expect(TokenType::IDENTIFIER, "Expected column name");
   if (has_error_)
     return col;
-  col.name = std::string(name.text);
+  col.name = name.text;
 
   // Type
   if (check(TokenType::INT) || check(TokenType::INTEGER_TYPE)) {
@@ -334,7 +572,7 @@ ColumnDef Parser::parse_column_def() {
     col.type = "BLOB";
   } else if (check(TokenType::IDENTIFIER)) {
     // Custom type name
-    col.type = std::string(current_.text);
+    col.type = current_.text;
     advance();
   } else {
     set_error("Expected column type");
@@ -350,17 +588,10 @@ ColumnDef Parser::parse_column_def() {
         return col;
       }
       col.not_null = true;
-    } else if (current_.type == TokenType::IDENTIFIER &&
-               std::string(current_.text) == "PRIMARY") {
-      advance();
-      if (current_.type == TokenType::IDENTIFIER &&
-          std::string(current_.text) == "KEY") {
-        advance();
-      }
+    } else if (match(TokenType::PRIMARY)) {
+      match(TokenType::KEY);
       col.primary_key = true;
-    } else if (current_.type == TokenType::IDENTIFIER &&
-               std::string(current_.text) == "DEFAULT") {
-      advance();
+    } else if (match(TokenType::DEFAULT)) {
       col.default_value = parse_primary();
       if (has_error_)
         return col;
@@ -374,42 +605,42 @@ ColumnDef Parser::parse_column_def() {
 
 // Expression parsing with precedence
 
-std::unique_ptr<Expression> Parser::parse_expression() {
+Expression *Parser::parse_expression() {
   return parse_or_expr();
 }
 
-std::unique_ptr<Expression> Parser::parse_or_expr() {
-  auto left = parse_and_expr();
+Expression *Parser::parse_or_expr() {
+  Expression *left = parse_and_expr();
   if (has_error_)
     return nullptr;
 
   while (match(TokenType::OR)) {
-    auto right = parse_and_expr();
+    Expression *right = parse_and_expr();
     if (has_error_)
       return nullptr;
-    left = Expression::binary(BinaryOp::OR, std::move(left), std::move(right));
+    left = Expression::binary(arena_, BinaryOp::OR, left, right);
   }
 
   return left;
 }
 
-std::unique_ptr<Expression> Parser::parse_and_expr() {
-  auto left = parse_comparison();
+Expression *Parser::parse_and_expr() {
+  Expression *left = parse_comparison();
   if (has_error_)
     return nullptr;
 
   while (match(TokenType::AND)) {
-    auto right = parse_comparison();
+    Expression *right = parse_comparison();
     if (has_error_)
       return nullptr;
-    left = Expression::binary(BinaryOp::AND, std::move(left), std::move(right));
+    left = Expression::binary(arena_, BinaryOp::AND, left, right);
   }
 
   return left;
 }
 
-std::unique_ptr<Expression> Parser::parse_comparison() {
-  auto left = parse_additive();
+Expression *Parser::parse_comparison() {
+  Expression *left = parse_additive();
   if (has_error_)
     return nullptr;
 
@@ -437,17 +668,17 @@ std::unique_ptr<Expression> Parser::parse_comparison() {
   }
 
   if (has_op) {
-    auto right = parse_additive();
+    Expression *right = parse_additive();
     if (has_error_)
       return nullptr;
-    return Expression::binary(op, std::move(left), std::move(right));
+    return Expression::binary(arena_, op, left, right);
   }
 
   return left;
 }
 
-std::unique_ptr<Expression> Parser::parse_additive() {
-  auto left = parse_multiplicative();
+Expression *Parser::parse_additive() {
+  Expression *left = parse_multiplicative();
   if (has_error_)
     return nullptr;
 
@@ -460,17 +691,17 @@ std::unique_ptr<Expression> Parser::parse_additive() {
     } else
       break;
 
-    auto right = parse_multiplicative();
+    Expression *right = parse_multiplicative();
     if (has_error_)
       return nullptr;
-    left = Expression::binary(op, std::move(left), std::move(right));
+    left = Expression::binary(arena_, op, left, right);
   }
 
   return left;
 }
 
-std::unique_ptr<Expression> Parser::parse_multiplicative() {
-  auto left = parse_unary();
+Expression *Parser::parse_multiplicative() {
+  Expression *left = parse_unary();
   if (has_error_)
     return nullptr;
 
@@ -485,37 +716,37 @@ std::unique_ptr<Expression> Parser::parse_multiplicative() {
     } else
       break;
 
-    auto right = parse_unary();
+    Expression *right = parse_unary();
     if (has_error_)
       return nullptr;
-    left = Expression::binary(op, std::move(left), std::move(right));
+    left = Expression::binary(arena_, op, left, right);
   }
 
   return left;
 }
 
-std::unique_ptr<Expression> Parser::parse_unary() {
+Expression *Parser::parse_unary() {
   if (match(TokenType::NOT)) {
-    auto operand = parse_unary();
+    Expression *operand = parse_unary();
     if (has_error_)
       return nullptr;
-    return Expression::unary(UnaryOp::NOT, std::move(operand));
+    return Expression::unary(arena_, UnaryOp::NOT, operand);
   }
 
   if (match(TokenType::MINUS)) {
-    auto operand = parse_unary();
+    Expression *operand = parse_unary();
     if (has_error_)
       return nullptr;
-    return Expression::unary(UnaryOp::MINUS, std::move(operand));
+    return Expression::unary(arena_, UnaryOp::MINUS, operand);
   }
 
   return parse_primary();
 }
 
-std::unique_ptr<Expression> Parser::parse_primary() {
+Expression *Parser::parse_primary() {
   // Parenthesized expression
   if (match(TokenType::LPAREN)) {
-    auto expr = parse_expression();
+    Expression *expr = parse_expression();
     if (has_error_)
       return nullptr;
     if (!match(TokenType::RPAREN)) {
@@ -529,49 +760,45 @@ std::unique_ptr<Expression> Parser::parse_primary() {
   if (check(TokenType::INTEGER)) {
     Token tok = current_;
     advance();
-    return Expression::literal(Literal::integer(tok.int_value));
+    return Expression::literal(arena_, Literal::integer(tok.int_value));
   }
 
   if (check(TokenType::FLOAT)) {
     Token tok = current_;
     advance();
-    return Expression::literal(Literal::floating(tok.float_value));
+    return Expression::literal(arena_, Literal::floating(tok.float_value));
   }
 
   if (check(TokenType::STRING)) {
     Token tok = current_;
     advance();
-    // Remove quotes
-    std::string value(tok.text);
-    if (value.size() >= 2) {
-      value = value.substr(1, value.size() - 2);
-    }
-    return Expression::literal(Literal::string(value));
+    // Remove quotes; the literal views the query text
+    return Expression::string(arena_, tok.text.substr(1, tok.text.size() - 2));
   }
 
   if (match(TokenType::NULL_KEYWORD)) {
-    return Expression::literal(Literal::null());
+    return Expression::literal(arena_, Literal::null());
   }
 
   if (match(TokenType::TRUE_KEYWORD)) {
-    return Expression::literal(Literal::boolean(true));
+    return Expression::literal(arena_, Literal::boolean(true));
   }
 
   if (match(TokenType::FALSE_KEYWORD)) {
-    return Expression::literal(Literal::boolean(false));
+    return Expression::literal(arena_, Literal::boolean(false));
   }
 
   // Aggregate functions
   if (check(TokenType::COUNT) || check(TokenType::SUM) ||
       check(TokenType::MIN) || check(TokenType::MAX) || check(TokenType::AVG)) {
-    std::string name(current_.text);
+    std::string_view name = current_.text;
     advance();
     return parse_function_call(name);
   }
 
   // Identifier (column reference or function)
   if (check(TokenType::IDENTIFIER)) {
-    std::string name(current_.text);
+    std::string_view name = current_.text;
     advance();
 
     // Check for function call
@@ -579,47 +806,47 @@ std::unique_ptr<Expression> Parser::parse_primary() {
       return parse_function_call(name);
     }
 
-    // Check for table.column
-    if (match(TokenType::STAR)) {
-      // Actually, this would be after a '.', but we don't have DOT token yet
-      // For simplicity, just return column reference
+    // Qualified column: table.column
+    if (match(TokenType::DOT)) {
+      Token column = expect(TokenType::IDENTIFIER, "Expected column name");
+      if (has_error_)
+        return nullptr;
+      return Expression::column(arena_, name, column.text);
     }
 
-    return Expression::column(name);
+    return Expression::column(arena_, name);
   }
 
   set_error("Expected expression");
   return nullptr;
 }
 
-std::unique_ptr<Expression>
-Parser::parse_function_call(const std::string &name) {
+Expression *
+Parser::parse_function_call(std::string_view name) {
   if (!match(TokenType::LPAREN)) {
     set_error("Expected '(' after function name");
     return nullptr;
   }
 
-  std::vector<std::unique_ptr<Expression>> args;
+  ExprList args;
   bool distinct = false;
 
   // DISTINCT for aggregates
-  if (current_.type == TokenType::IDENTIFIER &&
-      std::string(current_.text) == "DISTINCT") {
+  if (match(TokenType::DISTINCT)) {
     distinct = true;
-    advance();
   }
 
   if (!check(TokenType::RPAREN)) {
     // Handle COUNT(*)
     if (check(TokenType::STAR)) {
       advance();
-      args.push_back(Expression::star());
+      args.push_back(arena_, Expression::star(arena_));
     } else {
       do {
-        auto arg = parse_expression();
+        Expression *arg = parse_expression();
         if (has_error_)
           return nullptr;
-        args.push_back(std::move(arg));
+        args.push_back(arena_, arg);
       } while (match(TokenType::COMMA));
     }
   }
@@ -629,7 +856,7 @@ Parser::parse_function_call(const std::string &name) {
     return nullptr;
   }
 
-  return Expression::function(name, std::move(args), distinct);
+  return Expression::function(arena_, name, args, distinct);
 }
 
 // Token helpers
@@ -652,7 +879,7 @@ bool Parser::match(TokenType type) {
   return false;
 }
 
-Token Parser::expect(TokenType type, const std::string &message) {
+Token Parser::expect(TokenType type, const char *message) {
   if (check(type)) {
     return advance();
   }
@@ -667,8 +894,13 @@ void Parser::set_error(const std::string &message) {
 void Parser::set_error(const std::string &message, const Token &token) {
   has_error_ = true;
   error_.message = message;
-  error_.line = token.line;
-  error_.column = token.column;
+  if (token.type == TokenType::ERROR && !tokenizer_.error().empty()) {
+    error_.message = tokenizer_.error();
+  }
+
+  SourceLocation location = tokenizer_.location(token.offset);
+  error_.line = location.line;
+  error_.column = location.column;
 }
 
 } // namespace sql
@@ -30,15 +30,18 @@ struct ParseError {
 /**
  * @brief SQL Parser
  *
- * Recursive descent parser for SQL statements.
+ * Recursive descent parser for SQL statements. The tree is allocated from
+ * the given arena and views the input text, so both must outlive the
+ * statement (and any plan built from it).
  */
 class Parser {
 public:
   /**
    * @brief Constructor
    * @param input SQL input string
+   * @param arena Arena the statement is allocated from
    */
-  explicit Parser(std::string_view input);
+  Parser(std::string_view input, memory::Arena &arena);
 
   /**
    * @brief Parse a single statement
@@ -58,26 +61,31 @@ public:
 
 private:
   // Statement parsers
-  std::unique_ptr<SelectStmt> parse_select();
-  std::unique_ptr<InsertStmt> parse_insert();
-  std::unique_ptr<CreateTableStmt> parse_create_table();
-  std::unique_ptr<DropTableStmt> parse_drop_table();
+  std::optional<Statement> parse_statement();
+  SelectStmt *parse_select();
+  InsertStmt *parse_insert();
+  CreateTableStmt *parse_create_table();
+  CreateViewStmt *parse_create_view();
+  DropTableStmt *parse_drop_table();
+  AnalyzeStmt *parse_analyze();
 
   // Expression parsers (precedence climbing)
-  std::unique_ptr<Expression> parse_expression();
-  std::unique_ptr<Expression> parse_or_expr();
-  std::unique_ptr<Expression> parse_and_expr();
-  std::unique_ptr<Expression> parse_comparison();
-  std::unique_ptr<Expression> parse_additive();
-  std::unique_ptr<Expression> parse_multiplicative();
-  std::unique_ptr<Expression> parse_unary();
-  std::unique_ptr<Expression> parse_primary();
-  std::unique_ptr<Expression> parse_function_call(const std::string &name);
+  Expression *parse_expression();
+  Expression *parse_or_expr();
+  Expression *parse_and_expr();
+  Expression *parse_comparison();
+  Expression *parse_additive();
+  Expression *parse_multiplicative();
+  Expression *parse_unary();
+  Expression *parse_primary();
+  Expression *parse_function_call(std::string_view name);
 
   // Helper parsers
-  std::vector<std::unique_ptr<Expression>> parse_select_columns();
-  std::vector<OrderByItem> parse_order_by();
-  std::vector<ColumnDef> parse_column_defs();
+  std::string_view parse_table_alias();
+  const TableSample *parse_table_sample();
+  ExprList parse_select_columns();
+  NodeList<OrderByItem> parse_order_by();
+  NodeList<ColumnDef> parse_column_defs();
   ColumnDef parse_column_def();
 
   // Token helpers
@@ -85,13 +93,14 @@ private:
   Token advance();
   bool check(TokenType type);
   bool match(TokenType type);
-  Token expect(TokenType type, const std::string &message);
+  Token expect(TokenType type, const char *message);
 
   // Error handling
   void set_error(const std::string &message);
   void set_error(const std::string &message, const Token &token);
 
   Tokenizer tokenizer_;
+  memory::Arena &arena_;
   Token current_;
   ParseError error_;
   bool has_error_{false};
@@ -6,15 +6,24 @@
 #include "tokenizer.hpp"
 #include <algorithm>
 #include <cctype>
-#include <unordered_map>
+#include <charconv>
+#include <iterator>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
 
 namespace edgesql {
 namespace sql {
 
 namespace {
 
-// Keyword lookup table
-const std::unordered_map<std::string, TokenType> keywords = {
+struct Keyword {
+  std::string_view text; // Upper case
+  TokenType type;
+};
+
+constexpr Keyword KEYWORDS[] = {
     {"SELECT", TokenType::SELECT},
     {"FROM", TokenType::FROM},
     {"WHERE", TokenType::WHERE},
@@ -36,6 +45,32 @@ const std::unordered_map<std::string, TokenType> keywords = {
     {"NULL", TokenType::NULL_KEYWORD},
     {"TRUE", TokenType::TRUE_KEYWORD},
     {"FALSE", TokenType::FALSE_KEYWORD},
+    {"JOIN", TokenType::JOIN},
+    {"INNER", TokenType::INNER},
+    {"LEFT", TokenType::LEFT},
+    {"OUTER", TokenType::OUTER},
+    {"ON", TokenType::ON},
+    {"PARTITION", TokenType::PARTITION},
+    {"EVERY", TokenType::EVERY},
+    {"RETENTION", TokenType::RETENTION},
+    {"USING", TokenType::USING},
+    {"COLUMNAR", TokenType::COLUMNAR},
+    {"ROW", TokenType::ROW},
+    {"TABLESAMPLE", TokenType::TABLESAMPLE},
+    {"SYSTEM", TokenType::SYSTEM},
+    {"BERNOULLI", TokenType::BERNOULLI},
+    {"REPEATABLE", TokenType::REPEATABLE},
+    {"GROUP", TokenType::GROUP},
+    {"ANALYZE", TokenType::ANALYZE},
+    {"MATERIALIZED", TokenType::MATERIALIZED},
+    {"VIEW", TokenType::VIEW},
+    {"AS", TokenType::AS},
+    {"IF", TokenType::IF},
+    {"EXISTS", TokenType::EXISTS},
+    {"PRIMARY", TokenType::PRIMARY},
+    {"KEY", TokenType::KEY},
+    {"DEFAULT", TokenType::DEFAULT},
+    {"DISTINCT", TokenType::DISTINCT},
     {"COUNT", TokenType::COUNT},
     {"SUM", TokenType::SUM},
     {"MIN", TokenType::MIN},
@@ -49,14 +84,222 @@ const std::unordered_map<std::string, TokenType> keywords = {
     {"BOOL", TokenType::BOOLEAN},
     {"BLOB", TokenType::BLOB}};
 
-std::string to_upper(std::string_view sv) {
-  std::string result;
-  result.reserve(sv.size());
-  for (char c : sv) {
-    result.push_back(
-        static_cast<char>(std::toupper(static_cast<unsigned char>(c))));
+constexpr size_t KEYWORD_SLOTS = 256; // Power of two
+constexpr size_t NO_KEYWORD = std::size(KEYWORDS);
+
+constexpr size_t max_keyword_length() {
+  size_t length = 0;
+  for (const Keyword &keyword : KEYWORDS) {
+    length = std::max(length, keyword.text.size());
+  }
+  return length;
+}
+
+constexpr size_t MAX_KEYWORD_LENGTH = max_keyword_length();
+
+constexpr char fold(char c) {
+  return (c >= 'a' && c <= 'z') ? static_cast<char>(c - ('a' - 'A')) : c;
+}
+
+// FNV-1a over the upper-cased text, seeded
+constexpr size_t keyword_slot(std::string_view text, uint32_t seed) {
+  uint32_t hash = 2166136261u ^ seed;
+  for (char c : text) {
+    hash ^= static_cast<uint8_t>(fold(c));
+    hash *= 16777619u;
+  }
+  return (hash ^ (hash >> 15)) & (KEYWORD_SLOTS - 1);
+}
+
+constexpr bool keyword_seed_works(uint32_t seed) {
+  bool used[KEYWORD_SLOTS] = {};
+  for (const Keyword &keyword : KEYWORDS) {
+    size_t slot = keyword_slot(keyword.text, seed);
+    if (used[slot]) {
+      return false;
+    }
+    used[slot] = true;
+  }
+  return true;
+}
+
+// First seed under which no two keywords share a slot
+constexpr uint32_t find_keyword_seed() {
+  uint32_t seed = 0;
+  while (!keyword_seed_works(seed)) {
+    seed++;
+  }
+  return seed;
+}
+
+constexpr uint32_t KEYWORD_SEED = find_keyword_seed();
+
+struct KeywordTable {
+  uint8_t slots[KEYWORD_SLOTS]; // KEYWORDS index, NO_KEYWORD if empty
+};
+
+constexpr KeywordTable build_keyword_table() {
+  KeywordTable table{};
+  for (uint8_t &slot : table.slots) {
+    slot = static_cast<uint8_t>(NO_KEYWORD);
+  }
+  for (size_t i = 0; i < std::size(KEYWORDS); ++i) {
+    table.slots[keyword_slot(KEYWORDS[i].text, KEYWORD_SEED)] =
+        static_cast<uint8_t>(i);
+  }
+  return table;
+}
+
+// Perfect hash: every keyword has a slot of its own, so a lookup hashes
+// once and compares against at most one keyword
+constexpr KeywordTable KEYWORD_TABLE = build_keyword_table();
+
+static_assert(keyword_seed_works(KEYWORD_SEED));
+
+enum class CharClass {
+  SPACE,      // ' ', '\t', '\r', '\n'
+  WORD,       // Identifier characters
+  DIGIT,      // '0'-'9'
+  STRING_BODY // Anything but the quote, '\\' or '\n'
+};
+
+template <CharClass Class> bool in_class(char c, char quote) {
+  switch (Class) {
+  case CharClass::SPACE:
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  case CharClass::WORD:
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+  case CharClass::DIGIT:
+    return c >= '0' && c <= '9';
+  case CharClass::STRING_BODY:
+    return c != quote && c != '\\' && c != '\n';
+  }
+  return false;
+}
+
+#if defined(__x86_64__)
+
+// Bytes >= 0x80 compare as negative, so signed range checks exclude them
+template <CharClass Class> uint32_t class_mask_sse2(const char *p, char quote) {
+  __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+  auto eq = [&](char c) { return _mm_cmpeq_epi8(bytes, _mm_set1_epi8(c)); };
+  auto range = [](__m128i v, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+  };
+
+  __m128i hits;
+  switch (Class) {
+  case CharClass::SPACE:
+    hits = _mm_or_si128(_mm_or_si128(eq(' '), eq('\t')),
+                        _mm_or_si128(eq('\r'), eq('\n')));
+    break;
+  case CharClass::WORD: {
+    __m128i lower = _mm_or_si128(bytes, _mm_set1_epi8(0x20));
+    hits = _mm_or_si128(_mm_or_si128(range(bytes, '0', '9'), eq('_')),
+                        range(lower, 'a', 'z'));
+    break;
+  }
+  case CharClass::DIGIT:
+    hits = range(bytes, '0', '9');
+    break;
+  case CharClass::STRING_BODY:
+    hits = _mm_or_si128(_mm_or_si128(eq(quote), eq('\\')), eq('\n'));
+    hits = _mm_xor_si128(hits, _mm_set1_epi8(-1));
+    break;
+  }
+  return static_cast<uint32_t>(_mm_movemask_epi8(hits));
+}
+
+// Lambdas would not inherit the target, so comparisons are spelled out
+template <CharClass Class>
+__attribute__((target("avx2"))) uint32_t class_mask_avx2(const char *p,
+                                                         char quote) {
+  __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  __m256i digits =
+      _mm256_and_si256(_mm256_cmpgt_epi8(bytes, _mm256_set1_epi8('0' - 1)),
+                       _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), bytes));
+
+  __m256i hits;
+  switch (Class) {
+  case CharClass::SPACE:
+    hits = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')),
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\t'))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\r')),
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'))));
+    break;
+  case CharClass::WORD: {
+    __m256i lower = _mm256_or_si256(bytes, _mm256_set1_epi8(0x20));
+    __m256i letters =
+        _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                         _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+    hits = _mm256_or_si256(
+        _mm256_or_si256(digits, letters),
+        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('_')));
+    break;
+  }
+  case CharClass::DIGIT:
+    hits = digits;
+    break;
+  case CharClass::STRING_BODY:
+    hits = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(quote)),
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\'))),
+        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n')));
+    hits = _mm256_xor_si256(hits, _mm256_set1_epi8(-1));
+    break;
+  }
+  return static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+}
+
+template <CharClass Class>
+__attribute__((target("avx2"))) size_t skip_avx2(std::string_view input,
+                                                 size_t pos, char quote) {
+  while (pos + 32 <= input.size()) {
+    uint32_t misses = ~class_mask_avx2<Class>(input.data() + pos, quote);
+    if (misses) {
+      return pos + static_cast<size_t>(__builtin_ctz(misses));
+    }
+    pos += 32;
   }
-  return result;
+  return pos;
+}
+
+bool has_avx2() {
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+}
+
+#endif
+
+/**
+ * @brief Skip the run of Class characters starting at pos
+ *
+ * Tests 32 (AVX2) or 16 (SSE2) bytes per step and finishes the tail a
+ * byte at a time.
+ *
+ * @return Position of the first character outside the class
+ */
+template <CharClass Class>
+size_t skip_class(std::string_view input, size_t pos, char quote = 0) {
+#if defined(__x86_64__)
+  if (has_avx2()) {
+    pos = skip_avx2<Class>(input, pos, quote);
+  }
+  while (pos + 16 <= input.size()) {
+    uint32_t misses =
+        ~class_mask_sse2<Class>(input.data() + pos, quote) & 0xFFFF;
+    if (misses) {
+      return pos + static_cast<size_t>(__builtin_ctz(misses));
+    }
+    pos += 16;
+  }
+#endif
+  while (pos < input.size() && in_class<Class>(input[pos], quote)) {
+    pos++;
+  }
+  return pos;
 }
 
 } // anonymous namespace
@@ -72,11 +315,9 @@ Token Tokenizer::next_token() {
   skip_whitespace();
 
   if (at_end()) {
-    return Token(TokenType::END_OF_INPUT, "", line_, column_);
+    return Token(TokenType::END_OF_INPUT, "", pos_);
   }
 
-  size_t start_line = line_;
-  size_t start_column = column_;
   size_t start_pos = pos_;
 
   char c = current();
@@ -85,28 +326,25 @@ Token Tokenizer::next_token() {
   switch (c) {
   case '(':
     advance();
-    return Token(TokenType::LPAREN, input_.substr(start_pos, 1), start_line,
-                 start_column);
+    return Token(TokenType::LPAREN, input_.substr(start_pos, 1), start_pos);
   case ')':
     advance();
-    return Token(TokenType::RPAREN, input_.substr(start_pos, 1), start_line,
-                 start_column);
+    return Token(TokenType::RPAREN, input_.substr(start_pos, 1), start_pos);
   case ',':
     advance();
-    return Token(TokenType::COMMA, input_.substr(start_pos, 1), start_line,
-                 start_column);
+    return Token(TokenType::COMMA, input_.substr(start_pos, 1), start_pos);
   case ';':
     advance();
-    return Token(TokenType::SEMICOLON, input_.substr(start_pos, 1), start_line,
-                 start_column);
+    return Token(TokenType::SEMICOLON, input_.substr(start_pos, 1), start_pos);
+  case '.':
+    advance();
+    return Token(TokenType::DOT, input_.substr(start_pos, 1), start_pos);
   case '*':
     advance();
-    return Token(TokenType::STAR, input_.substr(start_pos, 1), start_line,
-                 start_column);
+    return Token(TokenType::STAR, input_.substr(start_pos, 1), start_pos);
   case '+':
     advance();
-    return Token(TokenType::PLUS, input_.substr(start_pos, 1), start_line,
-                 start_column);
+    return Token(TokenType::PLUS, input_.substr(start_pos, 1), start_pos);
   case '-':
     // Could be minus or line comment
     if (peek() == '-') {
@@ -114,8 +352,7 @@ Token Tokenizer::next_token() {
       return next_token();
     }
     advance();
-    return Token(TokenType::MINUS, input_.substr(start_pos, 1), start_line,
-                 start_column);
+    return Token(TokenType::MINUS, input_.substr(start_pos, 1), start_pos);
   case '/':
     // Could be slash or block comment
     if (peek() == '*') {
@@ -123,49 +360,39 @@ Token Tokenizer::next_token() {
       return next_token();
     }
     advance();
-    return Token(TokenType::SLASH, input_.substr(start_pos, 1), start_line,
-                 start_column);
+    return Token(TokenType::SLASH, input_.substr(start_pos, 1), start_pos);
   case '%':
     advance();
-    return Token(TokenType::PERCENT, input_.substr(start_pos, 1), start_line,
-                 start_column);
+    return Token(TokenType::PERCENT, input_.substr(start_pos, 1), start_pos);
   case '=':
     advance();
-    return Token(TokenType::EQ, input_.substr(start_pos, 1), start_line,
-                 start_column);
+    return Token(TokenType::EQ, input_.substr(start_pos, 1), start_pos);
   case '<':
     advance();
     if (current() == '=') {
       advance();
-      return Token(TokenType::LE, input_.substr(start_pos, 2), start_line,
-                   start_column);
+      return Token(TokenType::LE, input_.substr(start_pos, 2), start_pos);
     }
     if (current() == '>') {
       advance();
-      return Token(TokenType::NE, input_.substr(start_pos, 2), start_line,
-                   start_column);
+      return Token(TokenType::NE, input_.substr(start_pos, 2), start_pos);
     }
-    return Token(TokenType::LT, input_.substr(start_pos, 1), start_line,
-                 start_column);
+    return Token(TokenType::LT, input_.substr(start_pos, 1), start_pos);
   case '>':
     advance();
     if (current() == '=') {
       advance();
-      return Token(TokenType::GE, input_.substr(start_pos, 2), start_line,
-                   start_column);
+      return Token(TokenType::GE, input_.substr(start_pos, 2), start_pos);
     }
-    return Token(TokenType::GT, input_.substr(start_pos, 1), start_line,
-                 start_column);
+    return Token(TokenType::GT, input_.substr(start_pos, 1), start_pos);
   case '!':
     advance();
     if (current() == '=') {
       advance();
-      return Token(TokenType::NE, input_.substr(start_pos, 2), start_line,
-                   start_column);
+      return Token(TokenType::NE, input_.substr(start_pos, 2), start_pos);
     }
     error_ = "Expected '=' after '!'";
-    return Token(TokenType::ERROR, input_.substr(start_pos, 1), start_line,
-                 start_column);
+    return Token(TokenType::ERROR, input_.substr(start_pos, 1), start_pos);
   case '\'':
   case '"':
     return scan_string();
@@ -187,8 +414,7 @@ Token Tokenizer::next_token() {
   error_ = "Unexpected character: ";
   error_ += c;
   advance();
-  return Token(TokenType::ERROR, input_.substr(start_pos, 1), start_line,
-               start_column);
+  return Token(TokenType::ERROR, input_.substr(start_pos, 1), start_pos);
 }
 
 Token Tokenizer::peek_token() {
@@ -199,101 +425,70 @@ Token Tokenizer::peek_token() {
   return peeked_;
 }
 
+SourceLocation Tokenizer::location(size_t offset) const {
+  std::string_view before = input_.substr(0, offset);
+  size_t newline = before.rfind('\n');
+
+  SourceLocation location;
+  location.line = 1 + static_cast<size_t>(
+                          std::count(before.begin(), before.end(), '\n'));
+  location.column =
+      newline == std::string_view::npos ? offset + 1 : offset - newline;
+  return location;
+}
+
 void Tokenizer::skip_whitespace() {
-  while (!at_end()) {
-    char c = current();
-    if (c == ' ' || c == '\t' || c == '\r') {
-      advance();
-    } else if (c == '\n') {
-      advance();
-      line_++;
-      column_ = 1;
-    } else {
-      break;
-    }
-  }
+  pos_ = skip_class<CharClass::SPACE>(input_, pos_);
 }
 
 void Tokenizer::skip_line_comment() {
-  // Skip --
-  advance();
-  advance();
-
-  while (!at_end() && current() != '\n') {
-    advance();
-  }
+  // Skip to the newline, which is whitespace
+  size_t end = input_.find('\n', pos_ + 2);
+  pos_ = end == std::string_view::npos ? input_.size() : end;
 }
 
 void Tokenizer::skip_block_comment() {
-  // Skip /*
-  advance();
-  advance();
-
-  while (!at_end()) {
-    if (current() == '*' && peek() == '/') {
-      advance();
-      advance();
-      return;
-    }
-    if (current() == '\n') {
-      line_++;
-      column_ = 0;
-    }
-    advance();
+  size_t end = input_.find("*/", pos_ + 2);
+  if (end == std::string_view::npos) {
+    pos_ = input_.size();
+    error_ = "Unterminated block comment";
+    return;
   }
-
-  error_ = "Unterminated block comment";
+  pos_ = end + 2;
 }
 
 Token Tokenizer::scan_identifier_or_keyword() {
   size_t start_pos = pos_;
-  size_t start_line = line_;
-  size_t start_column = column_;
-
-  while (!at_end()) {
-    char c = current();
-    if (std::isalnum(static_cast<unsigned char>(c)) || c == '_') {
-      advance();
-    } else {
-      break;
-    }
-  }
+  pos_ = skip_class<CharClass::WORD>(input_, pos_);
 
   std::string_view text = input_.substr(start_pos, pos_ - start_pos);
   TokenType type = keyword_type(text);
 
-  return Token(type, text, start_line, start_column);
+  return Token(type, text, start_pos);
 }
 
 Token Tokenizer::scan_number() {
   size_t start_pos = pos_;
-  size_t start_line = line_;
-  size_t start_column = column_;
-
-  bool has_dot = false;
 
-  while (!at_end()) {
-    char c = current();
-    if (std::isdigit(static_cast<unsigned char>(c))) {
-      advance();
-    } else if (c == '.' && !has_dot) {
-      has_dot = true;
-      advance();
-    } else {
-      break;
-    }
+  pos_ = skip_class<CharClass::DIGIT>(input_, pos_);
+  bool has_dot = current() == '.';
+  if (has_dot) {
+    pos_ = skip_class<CharClass::DIGIT>(input_, pos_ + 1);
   }
 
   std::string_view text = input_.substr(start_pos, pos_ - start_pos);
-  Token token(has_dot ? TokenType::FLOAT : TokenType::INTEGER, text, start_line,
-              start_column);
+  Token token(has_dot ? TokenType::FLOAT : TokenType::INTEGER, text,
+              start_pos);
 
   // Parse the value
-  std::string text_str(text);
-  if (has_dot) {
-    token.float_value = std::stod(text_str);
-  } else {
-    token.int_value = std::stoll(text_str);
+  const char *end = text.data() + text.size();
+  std::from_chars_result result =
+      has_dot ? std::from_chars(text.data(), end, token.float_value)
+              : std::from_chars(text.data(), end, token.int_value);
+  if (result.ec != std::errc()) {
+    error_ = "Numeric literal out of range: ";
+    error_ += text;
+    token.type = TokenType::ERROR;
   }
 
   return token;
@@ -302,38 +497,30 @@ Token Tokenizer::scan_number() {
 Token Tokenizer::scan_string() {
   char quote = current();
   size_t start_pos = pos_;
-  size_t start_line = line_;
-  size_t start_column = column_;
 
   advance(); // Skip opening quote
 
-  while (!at_end() && current() != quote) {
-    if (current() == '\n') {
+  for (;;) {
+    pos_ = skip_class<CharClass::STRING_BODY>(input_, pos_, quote);
+    if (at_end() || current() == '\n') {
       error_ = "Unterminated string literal";
       return Token(TokenType::ERROR, input_.substr(start_pos, pos_ - start_pos),
-                   start_line, start_column);
+                   start_pos);
     }
-    if (current() == '\\') {
-      advance(); // Skip escape character
-      if (!at_end()) {
-        advance();
-      }
-    } else {
-      advance();
+    if (current() == quote) {
+      break;
     }
-  }
 
-  if (at_end()) {
-    error_ = "Unterminated string literal";
-    return Token(TokenType::ERROR, input_.substr(start_pos, pos_ - start_pos),
-                 start_line, start_column);
+    // Skip the escape character and the character it escapes
+    advance();
+    advance();
   }
 
   advance(); // Skip closing quote
 
   // Return the string including quotes
   return Token(TokenType::STRING, input_.substr(start_pos, pos_ - start_pos),
-               start_line, start_column);
+               start_pos);
 }
 
 char Tokenizer::current() const {
@@ -351,17 +538,29 @@ char Tokenizer::peek(size_t offset) const {
 void Tokenizer::advance() {
   if (!at_end()) {
     pos_++;
-    column_++;
   }
 }
 
 TokenType Tokenizer::keyword_type(std::string_view text) {
-  std::string upper = to_upper(text);
-  auto it = keywords.find(upper);
-  if (it != keywords.end()) {
-    return it->second;
+  if (text.size() > MAX_KEYWORD_LENGTH) {
+    return TokenType::IDENTIFIER;
+  }
+
+  size_t index = KEYWORD_TABLE.slots[keyword_slot(text, KEYWORD_SEED)];
+  if (index == NO_KEYWORD) {
+    return TokenType::IDENTIFIER;
+  }
+
+  const Keyword &keyword = KEYWORDS[index];
+  if (keyword.text.size() != text.size()) {
+    return TokenType::IDENTIFIER;
+  }
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (fold(text[i]) != keyword.text[i]) {
+      return TokenType::IDENTIFIER;
+    }
   }
-  return TokenType::IDENTIFIER;
+  return keyword.type;
 }
 
 } // namespace sql
@@ -49,6 +49,46 @@ enum class TokenType {
   TRUE_KEYWORD,
   FALSE_KEYWORD,
 
+  // Joins
+  JOIN,
+  INNER,
+  LEFT,
+  OUTER,
+  ON,
+
+  // Time partitioning
+  PARTITION,
+  EVERY,
+  RETENTION,
+
+  // Storage layout
+  USING,
+  COLUMNAR,
+  ROW,
+
+  // Sampling
+  TABLESAMPLE,
+  SYSTEM,
+  BERNOULLI,
+  REPEATABLE,
+
+  // Grouping and statistics
+  GROUP,
+  ANALYZE,
+
+  // Views and aliases
+  MATERIALIZED,
+  VIEW,
+  AS,
+
+  // Statement and column options
+  IF,
+  EXISTS,
+  PRIMARY,
+  KEY,
+  DEFAULT,
+  DISTINCT,
+
   // Aggregate functions
   COUNT,
   SUM,
@@ -69,6 +109,7 @@ enum class TokenType {
   RPAREN,    // )
   COMMA,     // ,
   SEMICOLON, // ;
+  DOT,       // .
   STAR,      // *
   PLUS,      // +
   MINUS,     // -
@@ -91,8 +132,7 @@ enum class TokenType {
 struct Token {
   TokenType type;
   std::string_view text;
-  size_t line;
-  size_t column;
+  size_t offset; // Byte offset in the input (see Tokenizer::location)
 
   // For numeric literals
   union {
@@ -100,10 +140,10 @@ struct Token {
     double float_value;
   };
 
-  Token() : type(TokenType::END_OF_INPUT), line(0), column(0), int_value(0) {}
+  Token() : type(TokenType::END_OF_INPUT), offset(0), int_value(0) {}
 
-  Token(TokenType t, std::string_view txt, size_t ln, size_t col)
-      : type(t), text(txt), line(ln), column(col), int_value(0) {}
+  Token(TokenType t, std::string_view txt, size_t off)
+      : type(t), text(txt), offset(off), int_value(0) {}
 
   bool is_keyword() const {
     return type >= TokenType::SELECT && type <= TokenType::BLOB;
@@ -118,10 +158,21 @@ struct Token {
   }
 };
 
+/**
+ * @brief Line and column of an input position, both 1-based
+ */
+struct SourceLocation {
+  size_t line{1};
+  size_t column{1};
+};
+
 /**
  * @brief SQL Tokenizer
  *
- * Single-pass tokenizer with minimal memory allocation.
+ * Single-pass tokenizer with minimal memory allocation. Whitespace,
+ * identifiers, numbers and string bodies are skipped with SIMD character
+ * class tests. Tokens carry only their byte offset; line and column are
+ * worked out when an error needs them.
  */
 class Tokenizer {
 public:
@@ -148,6 +199,11 @@ public:
    */
   bool at_end() const { return pos_ >= input_.size(); }
 
+  /**
+   * @brief Get the input being tokenized
+   */
+  std::string_view input() const { return input_; }
+
   /**
    * @brief Get current position
    */
@@ -156,12 +212,19 @@ public:
   /**
    * @brief Get current line
    */
-  size_t line() const { return line_; }
+  size_t line() const { return location(pos_).line; }
 
   /**
    * @brief Get current column
    */
-  size_t column() const { return column_; }
+  size_t column() const { return location(pos_).column; }
+
+  /**
+   * @brief Get the line and column of an input position
+   *
+   * Counts newlines up to the position, so meant for error reporting.
+   */
+  SourceLocation location(size_t offset) const;
 
   /**
    * @brief Get error message (if any)
@@ -185,8 +248,6 @@ private:
 
   std::string_view input_;
   size_t pos_{0};
-  size_t line_{1};
-  size_t column_{1};
 
   std::string error_;
   Token peeked_;
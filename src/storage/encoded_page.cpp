@@ -0,0 +1,272 @@
+/**
+ * @file encoded_page.cpp
+ * @brief Encoded page implementation
+ */
+
+#include "encoded_page.hpp"
+#include "pax_page.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace edgesql {
+namespace storage {
+
+namespace {
+
+constexpr size_t DIRECTORY_START = sizeof(PageHeader) + sizeof(EncodedHeader);
+
+bool is_text(ColumnType type) {
+  return type == ColumnType::TEXT || type == ColumnType::BLOB;
+}
+
+// Start a batch from a page's column types, or check it matches the batch
+bool match_columns(std::vector<ColumnVector> &columns,
+                   const std::vector<ColumnType> &types) {
+  if (columns.empty()) {
+    columns.resize(types.size());
+    for (size_t c = 0; c < types.size(); ++c) {
+      columns[c].type = types[c];
+    }
+    return true;
+  }
+
+  if (columns.size() != types.size()) {
+    return false;
+  }
+  for (size_t c = 0; c < types.size(); ++c) {
+    if (columns[c].type != types[c]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool gather_pax(const Page &page, std::vector<ColumnVector> &columns) {
+  PaxPage pax(page);
+  std::vector<ColumnType> types(pax.column_count());
+  for (size_t c = 0; c < types.size(); ++c) {
+    types[c] = pax.column_type(c);
+  }
+  if (!match_columns(columns, types)) {
+    return false;
+  }
+
+  for (size_t c = 0; c < types.size(); ++c) {
+    ColumnVector &column = columns[c];
+    for (uint16_t r = 0; r < pax.row_count(); ++r) {
+      bool null = pax.is_null(c, r);
+      column.nulls.push_back(null);
+
+      switch (types[c]) {
+      case ColumnType::INTEGER:
+        column.ints.push_back(null ? 0 : pax.int_values(c)[r]);
+        break;
+      case ColumnType::FLOAT: {
+        int64_t bits = 0;
+        if (!null) {
+          std::memcpy(&bits, &pax.float_values(c)[r], sizeof(bits));
+        }
+        column.ints.push_back(bits);
+        break;
+      }
+      case ColumnType::BOOLEAN:
+        column.ints.push_back(null ? 0 : pax.bool_values(c)[r]);
+        break;
+      case ColumnType::TEXT:
+      case ColumnType::BLOB:
+        column.texts.push_back(null ? std::string_view() : pax.text(c, r));
+        break;
+      case ColumnType::NULLTYPE:
+        column.ints.push_back(0);
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+bool gather_encoded(const Page &page, std::vector<ColumnVector> &columns) {
+  EncodedPage encoded(page);
+  std::vector<ColumnType> types(encoded.column_count());
+  for (size_t c = 0; c < types.size(); ++c) {
+    types[c] = encoded.column_type(c);
+  }
+  if (!match_columns(columns, types)) {
+    return false;
+  }
+
+  size_t rows = encoded.row_count();
+  for (size_t c = 0; c < types.size(); ++c) {
+    ColumnVector &column = columns[c];
+    size_t at = column.size();
+
+    if (is_text(types[c])) {
+      column.texts.resize(at + rows);
+      if (!encoded.decode_strings(c, column.texts.data() + at)) {
+        return false;
+      }
+    } else {
+      column.ints.resize(at + rows);
+      if (!encoded.decode_ints(c, column.ints.data() + at)) {
+        return false;
+      }
+    }
+
+    column.nulls.resize(at + rows);
+    for (uint32_t r = 0; r < rows; ++r) {
+      column.nulls[at + r] = encoded.is_null(c, r);
+    }
+  }
+  return true;
+}
+
+} // anonymous namespace
+
+EncodedPage::EncodedPage(const Page &page)
+    : base_(page.data()),
+      header_(reinterpret_cast<const EncodedHeader *>(base_ +
+                                                      sizeof(PageHeader))),
+      columns_(reinterpret_cast<const EncodedColumn *>(base_ +
+                                                       DIRECTORY_START)) {}
+
+bool EncodedPage::gather(const Page &page, std::vector<ColumnVector> &columns) {
+  if (is_encoded(page)) {
+    return gather_encoded(page, columns);
+  }
+  if (PaxPage::is_pax(page)) {
+    return gather_pax(page, columns);
+  }
+  return false;
+}
+
+size_t EncodedPage::pack(Page &page, uint32_t page_id,
+                         const std::vector<ColumnVector> &columns,
+                         size_t begin, size_t hint) {
+  if (columns.empty() || begin >= columns[0].size()) {
+    return 0;
+  }
+  size_t limit = std::min(MAX_ROWS, columns[0].size() - begin);
+
+  // Grow from the hint while rows fit, then binary search the boundary.
+  // Encoded size is not linear in rows (runs, dictionaries), so each probe
+  // encodes for real.
+  size_t fits = 0;          // Most rows known to fit
+  size_t fails = limit + 1; // Fewest rows known not to fit
+  size_t encoded = 0;       // Rows the page currently holds
+  size_t probe = std::clamp<size_t>(hint, 1, limit);
+  for (;;) {
+    if (encode(page, page_id, columns, begin, probe)) {
+      fits = encoded = probe;
+    } else {
+      fails = probe;
+    }
+
+    if (fails == fits + 1 || fits == limit) {
+      break;
+    }
+    probe = fails > limit ? std::min(fits * 2, limit)
+                          : fits + (fails - fits) / 2;
+  }
+
+  if (fits > 0 && encoded != fits) {
+    encode(page, page_id, columns, begin, fits);
+  }
+  return fits;
+}
+
+bool EncodedPage::encode(Page &page, uint32_t page_id,
+                         const std::vector<ColumnVector> &columns,
+                         size_t begin, size_t count) {
+  size_t directory_end =
+      DIRECTORY_START + columns.size() * sizeof(EncodedColumn);
+  std::vector<EncodedColumn> directory(columns.size());
+  std::vector<uint8_t> body;
+
+  for (size_t c = 0; c < columns.size(); ++c) {
+    const ColumnVector &column = columns[c];
+    EncodedColumn &entry = directory[c];
+    size_t at = body.size();
+
+    Encoding encoding =
+        is_text(column.type)
+            ? encode_strings(column.texts.data() + begin, count, body)
+            : encode_ints(column.ints.data() + begin, count, body);
+
+    entry.type = static_cast<uint8_t>(column.type);
+    entry.encoding = static_cast<uint8_t>(encoding);
+    entry.offset = static_cast<uint16_t>(directory_end + at);
+    entry.size = static_cast<uint16_t>(body.size() - at);
+    entry.nulls = 0;
+
+    const uint8_t *nulls = column.nulls.data() + begin;
+    if (std::find(nulls, nulls + count, 1) != nulls + count) {
+      size_t bitmap = body.size();
+      body.resize(bitmap + (count + 7) / 8);
+      for (size_t r = 0; r < count; ++r) {
+        if (nulls[r]) {
+          body[bitmap + r / 8] |= static_cast<uint8_t>(1u << (r % 8));
+        }
+      }
+      entry.nulls = static_cast<uint16_t>(directory_end + bitmap);
+    }
+
+    if (directory_end + body.size() > PAGE_SIZE) {
+      return false;
+    }
+  }
+
+  page.init(page_id, PageHeader::FLAG_LEAF | PageHeader::FLAG_ENCODED);
+  uint8_t *base = page.data();
+
+  EncodedHeader header{};
+  header.column_count = static_cast<uint16_t>(columns.size());
+  header.row_count = static_cast<uint32_t>(count);
+  std::memcpy(base + sizeof(PageHeader), &header, sizeof(header));
+  std::memcpy(base + DIRECTORY_START, directory.data(),
+              directory.size() * sizeof(EncodedColumn));
+  std::memcpy(base + directory_end, body.data(), body.size());
+
+  size_t end = directory_end + body.size();
+  page.header().data_start = static_cast<uint16_t>(end);
+  page.header().free_space = static_cast<uint16_t>(PAGE_SIZE - end);
+  return true;
+}
+
+bool EncodedPage::decode_ints(size_t column, int64_t *out) const {
+  return storage::decode_ints(block(column), columns_[column].size,
+                              row_count(), out);
+}
+
+bool EncodedPage::decode_floats(size_t column, double *out) const {
+  std::vector<int64_t> bits(row_count());
+  if (!decode_ints(column, bits.data())) {
+    return false;
+  }
+  std::memcpy(out, bits.data(), bits.size() * sizeof(double));
+  return true;
+}
+
+bool EncodedPage::decode_strings(size_t column, std::string_view *out) const {
+  return storage::decode_strings(block(column), columns_[column].size,
+                                 row_count(), out);
+}
+
+size_t EncodedPage::select_range(size_t column, int64_t lo, int64_t hi,
+                                 uint8_t *selected) const {
+  size_t hits = select_int_range(block(column), columns_[column].size,
+                                 row_count(), lo, hi, selected);
+
+  // NULL rows hold a zero placeholder that may have matched
+  if (columns_[column].nulls) {
+    for (uint32_t r = 0; r < row_count(); ++r) {
+      if (selected[r] && is_null(column, r)) {
+        selected[r] = 0;
+        hits--;
+      }
+    }
+  }
+  return hits;
+}
+
+} // namespace storage
+} // namespace edgesql
@@ -0,0 +1,183 @@
+#pragma once
+
+/**
+ * @file encoded_page.hpp
+ * @brief Compressed columnar page layout for sealed segments
+ */
+
+#include "encoding.hpp"
+#include "page.hpp"
+#include "record.hpp"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace edgesql {
+namespace storage {
+
+/**
+ * @brief Encoded page header, following the PageHeader
+ */
+struct EncodedHeader {
+  uint16_t column_count;
+  uint16_t reserved;
+  uint32_t row_count;
+};
+
+static_assert(sizeof(EncodedHeader) == 8, "EncodedHeader must be 8 bytes");
+
+/**
+ * @brief Column directory entry
+ */
+struct EncodedColumn {
+  uint8_t type;     // ColumnType
+  uint8_t encoding; // Encoding of the value block
+  uint16_t nulls;   // Offset of the null bitmap, 0 if the column has none
+  uint16_t offset;  // Offset of the value block
+  uint16_t size;    // Size of the value block
+};
+
+static_assert(sizeof(EncodedColumn) == 8, "EncodedColumn must be 8 bytes");
+
+/**
+ * @brief One column of a row batch, gathered for encoding
+ *
+ * NULL rows hold a zero or empty placeholder so positions line up.
+ */
+struct ColumnVector {
+  ColumnType type{ColumnType::NULLTYPE};
+  std::vector<int64_t> ints;           // INTEGER, BOOLEAN; FLOAT bit patterns
+  std::vector<std::string_view> texts; // TEXT, BLOB (views into source pages)
+  std::vector<uint8_t> nulls;          // 1 = NULL
+
+  size_t size() const { return nulls.size(); }
+};
+
+/**
+ * @brief Read-only view of an encoded page
+ *
+ * +------------------------+
+ * | PageHeader (ENCODED)   |
+ * | EncodedHeader          |
+ * | EncodedColumn[n]       |
+ * +------------------------+
+ * | column 0 block [nulls] |
+ * | column 1 block [nulls] |
+ * | ...                    |
+ * +------------------------+
+ *
+ * Sealed PAX segments are rewritten into these pages: each column is one
+ * block in the encoding that came out smallest, so a page holds many
+ * times the rows of a PAX page and scans read that many fewer bytes.
+ */
+class EncodedPage {
+public:
+  // Upper bound on rows per page, which bounds decode buffers
+  static constexpr size_t MAX_ROWS = 16384;
+
+  /**
+   * @brief Constructor
+   * @param page Page with FLAG_ENCODED set
+   */
+  explicit EncodedPage(const Page &page);
+
+  /**
+   * @brief Check if a page is encoded
+   */
+  static bool is_encoded(const Page &page) {
+    return page.header().flags & PageHeader::FLAG_ENCODED;
+  }
+
+  /**
+   * @brief Append the rows of a PAX or encoded page to a batch
+   *
+   * Text views point into the page, which must outlive the batch.
+   *
+   * @return false if the page is neither, or its columns differ from the
+   *         batch's
+   */
+  static bool gather(const Page &page, std::vector<ColumnVector> &columns);
+
+  /**
+   * @brief Encode as many rows as fit, starting at a batch position
+   * @param page Output page
+   * @param page_id Page identifier
+   * @param columns Row batch
+   * @param begin First row to encode
+   * @param hint Row count to try first (e.g. what fit last time)
+   * @return Rows encoded, 0 if not even one row fits
+   */
+  static size_t pack(Page &page, uint32_t page_id,
+                     const std::vector<ColumnVector> &columns, size_t begin,
+                     size_t hint);
+
+  uint32_t row_count() const { return header_->row_count; }
+  uint16_t column_count() const { return header_->column_count; }
+
+  /**
+   * @brief Get the type of a column
+   */
+  ColumnType column_type(size_t column) const {
+    return static_cast<ColumnType>(columns_[column].type);
+  }
+
+  /**
+   * @brief Get the encoding a column was stored with
+   */
+  Encoding encoding(size_t column) const {
+    return static_cast<Encoding>(columns_[column].encoding);
+  }
+
+  /**
+   * @brief Check if a value is NULL
+   */
+  bool is_null(size_t column, uint32_t row) const {
+    uint16_t nulls = columns_[column].nulls;
+    return nulls && (base_[nulls + row / 8] & (1u << (row % 8)));
+  }
+
+  /**
+   * @brief Decode an INTEGER or BOOLEAN column
+   * @param out Receives row_count() values
+   */
+  bool decode_ints(size_t column, int64_t *out) const;
+
+  /**
+   * @brief Decode a FLOAT column
+   * @param out Receives row_count() values
+   */
+  bool decode_floats(size_t column, double *out) const;
+
+  /**
+   * @brief Decode a TEXT or BLOB column; views point into the page
+   * @param out Receives row_count() values
+   */
+  bool decode_strings(size_t column, std::string_view *out) const;
+
+  /**
+   * @brief Select the rows of an INTEGER column within [lo, hi]
+   *
+   * Filters on the encoded block; NULL rows are never selected.
+   *
+   * @param selected Receives row_count() flags
+   * @return Rows selected
+   */
+  size_t select_range(size_t column, int64_t lo, int64_t hi,
+                      uint8_t *selected) const;
+
+private:
+  static bool encode(Page &page, uint32_t page_id,
+                     const std::vector<ColumnVector> &columns, size_t begin,
+                     size_t count);
+
+  const uint8_t *block(size_t column) const {
+    return base_ + columns_[column].offset;
+  }
+
+  const uint8_t *base_;
+  const EncodedHeader *header_;
+  const EncodedColumn *columns_;
+};
+
+} // namespace storage
+} // namespace edgesql
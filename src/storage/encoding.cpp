@@ -0,0 +1,725 @@
+/**
+ * @file encoding.cpp
+ * @brief Column encoding implementation
+ */
+
+#include "encoding.hpp"
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace edgesql {
+namespace storage {
+
+namespace {
+
+// Blocks that bit-pack offsets: reference value, then the width byte
+constexpr size_t FRAME_BYTES = sizeof(int64_t) + 1;
+
+template <typename T> void put(std::vector<uint8_t> &out, T value) {
+  size_t at = out.size();
+  out.resize(at + sizeof(T));
+  std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+// Bounds-checked little reader over one block
+struct Reader {
+  const uint8_t *pos;
+  const uint8_t *end;
+
+  template <typename T> bool get(T &value) {
+    if (static_cast<size_t>(end - pos) < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(&value, pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+  }
+
+  bool skip(size_t bytes) {
+    if (static_cast<size_t>(end - pos) < bytes) {
+      return false;
+    }
+    pos += bytes;
+    return true;
+  }
+
+  size_t left() const { return static_cast<size_t>(end - pos); }
+};
+
+unsigned bit_width(uint64_t range) {
+  return range == 0 ? 0 : 64 - static_cast<unsigned>(__builtin_clzll(range));
+}
+
+// Byte-aligned widths unpack with plain SIMD widening; they are worth up
+// to 25% more bytes
+unsigned choose_width(unsigned width) {
+  for (unsigned aligned : {8u, 16u, 32u, 64u}) {
+    if (width <= aligned) {
+      return aligned * 4 <= width * 5 ? aligned : width;
+    }
+  }
+  return width;
+}
+
+size_t packed_bytes(size_t count, unsigned width) {
+  return (count * width + 63) / 64 * 8;
+}
+
+// Packs LSB-first into little-endian 64-bit words, so 8/16/32-bit widths
+// come out as plain arrays of that integer type
+void pack_bits(const uint64_t *values, size_t count, unsigned width,
+               uint8_t *out) {
+  if (width == 0) {
+    return;
+  }
+
+  uint64_t acc = 0;
+  unsigned bits = 0;
+  for (size_t i = 0; i < count; ++i) {
+    uint64_t value = values[i];
+    acc |= value << bits;
+    if (bits + width >= 64) {
+      std::memcpy(out, &acc, sizeof(acc));
+      out += sizeof(acc);
+      unsigned used = 64 - bits;
+      acc = used < 64 ? value >> used : 0;
+      bits = bits + width - 64;
+    } else {
+      bits += width;
+    }
+  }
+  if (bits > 0) {
+    std::memcpy(out, &acc, sizeof(acc));
+  }
+}
+
+void unpack_scalar(const uint8_t *words, size_t count, unsigned width,
+                   int64_t reference, int64_t *out) {
+  uint64_t mask = width == 64 ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+  size_t bit = 0;
+  for (size_t i = 0; i < count; ++i, bit += width) {
+    size_t word = bit / 64;
+    unsigned offset = bit % 64;
+
+    uint64_t lo;
+    std::memcpy(&lo, words + word * 8, sizeof(lo));
+    uint64_t value = lo >> offset;
+    if (offset + width > 64) {
+      uint64_t hi;
+      std::memcpy(&hi, words + (word + 1) * 8, sizeof(hi));
+      value |= hi << (64 - offset);
+    }
+    out[i] = static_cast<int64_t>(static_cast<uint64_t>(reference) +
+                                  (value & mask));
+  }
+}
+
+// Widen an array of 8/16/32-bit offsets and add the reference
+template <typename T>
+size_t widen_scalar(const uint8_t *in, size_t begin, size_t count,
+                    int64_t reference, int64_t *out) {
+  for (size_t i = begin; i < count; ++i) {
+    T value;
+    std::memcpy(&value, in + i * sizeof(T), sizeof(T));
+    out[i] = static_cast<int64_t>(static_cast<uint64_t>(reference) + value);
+  }
+  return count;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2"))) size_t widen_avx2(const uint8_t *in,
+                                                  unsigned width, size_t count,
+                                                  int64_t reference,
+                                                  int64_t *out) {
+  __m256i ref = _mm256_set1_epi64x(reference);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m256i wide;
+    if (width == 8) {
+      int32_t bytes;
+      std::memcpy(&bytes, in + i, sizeof(bytes));
+      wide = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(bytes));
+    } else if (width == 16) {
+      wide = _mm256_cvtepu16_epi64(
+          _mm_loadl_epi64(reinterpret_cast<const __m128i *>(in + i * 2)));
+    } else {
+      wide = _mm256_cvtepu32_epi64(
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i * 4)));
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i),
+                        _mm256_add_epi64(wide, ref));
+  }
+  return i;
+}
+
+// SSE2 is baseline on x86-64
+void store_u32x4(__m128i values, __m128i ref, int64_t *out) {
+  __m128i zero = _mm_setzero_si128();
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                   _mm_add_epi64(_mm_unpacklo_epi32(values, zero), ref));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2),
+                   _mm_add_epi64(_mm_unpackhi_epi32(values, zero), ref));
+}
+
+void store_u16x8(__m128i values, __m128i ref, int64_t *out) {
+  __m128i zero = _mm_setzero_si128();
+  store_u32x4(_mm_unpacklo_epi16(values, zero), ref, out);
+  store_u32x4(_mm_unpackhi_epi16(values, zero), ref, out + 4);
+}
+
+size_t widen_sse2(const uint8_t *in, unsigned width, size_t count,
+                  int64_t reference, int64_t *out) {
+  __m128i ref = _mm_set1_epi64x(reference);
+  __m128i zero = _mm_setzero_si128();
+  size_t per_load = 16 / (width / 8);
+  size_t i = 0;
+  for (; i + per_load <= count; i += per_load) {
+    __m128i values = _mm_loadu_si128(
+        reinterpret_cast<const __m128i *>(in + i * (width / 8)));
+    if (width == 8) {
+      store_u16x8(_mm_unpacklo_epi8(values, zero), ref, out + i);
+      store_u16x8(_mm_unpackhi_epi8(values, zero), ref, out + i + 8);
+    } else if (width == 16) {
+      store_u16x8(values, ref, out + i);
+    } else {
+      store_u32x4(values, ref, out + i);
+    }
+  }
+  return i;
+}
+
+bool has_avx2() {
+  static const bool supported = __builtin_cpu_supports("avx2");
+  return supported;
+}
+
+#endif
+
+void unpack(const uint8_t *words, size_t count, unsigned width,
+            int64_t reference, int64_t *out) {
+  if (width == 0) {
+    std::fill(out, out + count, reference);
+    return;
+  }
+  if (width != 8 && width != 16 && width != 32) {
+    unpack_scalar(words, count, width, reference, out);
+    return;
+  }
+
+  size_t done = 0;
+#if defined(__x86_64__)
+  done = has_avx2() ? widen_avx2(words, width, count, reference, out)
+                    : widen_sse2(words, width, count, reference, out);
+#endif
+  if (width == 8) {
+    widen_scalar<uint8_t>(words, done, count, reference, out);
+  } else if (width == 16) {
+    widen_scalar<uint16_t>(words, done, count, reference, out);
+  } else {
+    widen_scalar<uint32_t>(words, done, count, reference, out);
+  }
+}
+
+// Bit-pack values as offsets from their minimum
+void write_frame(const int64_t *values, size_t count, std::vector<uint8_t> &out,
+                 std::vector<uint64_t> &scratch) {
+  int64_t min = count ? *std::min_element(values, values + count) : 0;
+  int64_t max = count ? *std::max_element(values, values + count) : 0;
+  unsigned width = choose_width(
+      bit_width(static_cast<uint64_t>(max) - static_cast<uint64_t>(min)));
+
+  scratch.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    scratch[i] = static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(min);
+  }
+
+  put(out, min);
+  put(out, static_cast<uint8_t>(width));
+  size_t at = out.size();
+  out.resize(at + packed_bytes(count, width));
+  pack_bits(scratch.data(), count, width, out.data() + at);
+}
+
+bool read_frame(Reader &in, size_t count, int64_t *out) {
+  int64_t reference;
+  uint8_t width;
+  if (!in.get(reference) || !in.get(width) || width > 64) {
+    return false;
+  }
+  size_t bytes = packed_bytes(count, width);
+  if (in.left() < bytes) {
+    return false;
+  }
+  unpack(in.pos, count, width, reference, out);
+  in.pos += bytes;
+  return true;
+}
+
+struct Runs {
+  std::vector<int64_t> values;
+  std::vector<int64_t> lengths;
+};
+
+void build_runs(const int64_t *values, size_t count, Runs &runs) {
+  for (size_t i = 0; i < count;) {
+    size_t j = i + 1;
+    while (j < count && values[j] == values[i]) {
+      j++;
+    }
+    runs.values.push_back(values[i]);
+    runs.lengths.push_back(static_cast<int64_t>(j - i));
+    i = j;
+  }
+}
+
+size_t frame_size(int64_t min, int64_t max, size_t count) {
+  return FRAME_BYTES +
+         packed_bytes(count, choose_width(bit_width(
+                                 static_cast<uint64_t>(max) -
+                                 static_cast<uint64_t>(min))));
+}
+
+/**
+ * @brief Size every candidate encoding and return the smallest
+ */
+Encoding choose_int_encoding(const int64_t *values, size_t count,
+                             bool allow_rle, size_t *size_out) {
+  Encoding best = Encoding::PLAIN;
+  size_t best_size = 1 + count * sizeof(int64_t);
+  auto consider = [&](Encoding encoding, size_t size) {
+    if (size < best_size) {
+      best = encoding;
+      best_size = size;
+    }
+  };
+
+  if (count > 0) {
+    int64_t min = values[0];
+    int64_t max = values[0];
+    size_t runs = 1;
+    int64_t dod_min = 0;
+    int64_t dod_max = 0;
+    uint64_t prev_delta = 0;
+
+    for (size_t i = 1; i < count; ++i) {
+      min = std::min(min, values[i]);
+      max = std::max(max, values[i]);
+      runs += values[i] != values[i - 1];
+
+      uint64_t delta = static_cast<uint64_t>(values[i]) -
+                       static_cast<uint64_t>(values[i - 1]);
+      if (i >= 2) {
+        auto dod = static_cast<int64_t>(delta - prev_delta);
+        dod_min = i == 2 ? dod : std::min(dod_min, dod);
+        dod_max = i == 2 ? dod : std::max(dod_max, dod);
+      }
+      prev_delta = delta;
+    }
+
+    consider(Encoding::BITPACK, 1 + frame_size(min, max, count));
+    if (count >= 3) {
+      consider(Encoding::DELTA_DELTA, 1 + 2 * sizeof(int64_t) +
+                                          frame_size(dod_min, dod_max,
+                                                     count - 2));
+    }
+
+    // Runs only pay off when they are long; size the nested blocks exactly
+    if (allow_rle && runs * 4 <= count) {
+      Runs split;
+      build_runs(values, count, split);
+      size_t values_size = 0;
+      size_t lengths_size = 0;
+      choose_int_encoding(split.values.data(), runs, false, &values_size);
+      choose_int_encoding(split.lengths.data(), runs, false, &lengths_size);
+      consider(Encoding::RLE, 1 + 2 * sizeof(uint32_t) + values_size +
+                                  lengths_size);
+    }
+  }
+
+  if (size_out) {
+    *size_out = best_size;
+  }
+  return best;
+}
+
+Encoding write_ints(const int64_t *values, size_t count, bool allow_rle,
+                    std::vector<uint8_t> &out) {
+  Encoding encoding = choose_int_encoding(values, count, allow_rle, nullptr);
+  put(out, static_cast<uint8_t>(encoding));
+
+  std::vector<uint64_t> scratch;
+  switch (encoding) {
+  case Encoding::PLAIN: {
+    size_t at = out.size();
+    out.resize(at + count * sizeof(int64_t));
+    std::memcpy(out.data() + at, values, count * sizeof(int64_t));
+    break;
+  }
+  case Encoding::BITPACK:
+    write_frame(values, count, out, scratch);
+    break;
+  case Encoding::DELTA_DELTA: {
+    std::vector<int64_t> dods(count - 2);
+    for (size_t i = 2; i < count; ++i) {
+      uint64_t delta = static_cast<uint64_t>(values[i]) -
+                       static_cast<uint64_t>(values[i - 1]);
+      uint64_t prev = static_cast<uint64_t>(values[i - 1]) -
+                      static_cast<uint64_t>(values[i - 2]);
+      dods[i - 2] = static_cast<int64_t>(delta - prev);
+    }
+    put(out, values[0]);
+    put(out, static_cast<int64_t>(static_cast<uint64_t>(values[1]) -
+                                  static_cast<uint64_t>(values[0])));
+    write_frame(dods.data(), dods.size(), out, scratch);
+    break;
+  }
+  case Encoding::RLE: {
+    Runs runs;
+    build_runs(values, count, runs);
+    put(out, static_cast<uint32_t>(runs.values.size()));
+    size_t size_at = out.size();
+    put(out, uint32_t{0});
+    size_t values_at = out.size();
+    write_ints(runs.values.data(), runs.values.size(), false, out);
+    auto values_size = static_cast<uint32_t>(out.size() - values_at);
+    std::memcpy(out.data() + size_at, &values_size, sizeof(values_size));
+    write_ints(runs.lengths.data(), runs.lengths.size(), false, out);
+    break;
+  }
+  case Encoding::DICTIONARY:
+    break;
+  }
+
+  return encoding;
+}
+
+bool read_runs(Reader &in, std::vector<int64_t> &values,
+               std::vector<int64_t> &lengths) {
+  uint32_t runs;
+  uint32_t values_size;
+  if (!in.get(runs) || !in.get(values_size) || in.left() < values_size) {
+    return false;
+  }
+  values.resize(runs);
+  lengths.resize(runs);
+  return decode_ints(in.pos, values_size, runs, values.data()) &&
+         decode_ints(in.pos + values_size, in.left() - values_size, runs,
+                     lengths.data());
+}
+
+} // anonymous namespace
+
+const char *encoding_name(Encoding encoding) {
+  switch (encoding) {
+  case Encoding::PLAIN:
+    return "plain";
+  case Encoding::BITPACK:
+    return "bitpack";
+  case Encoding::DELTA_DELTA:
+    return "delta_delta";
+  case Encoding::RLE:
+    return "rle";
+  case Encoding::DICTIONARY:
+    return "dictionary";
+  }
+  return "unknown";
+}
+
+Encoding encode_ints(const int64_t *values, size_t count,
+                     std::vector<uint8_t> &out) {
+  return write_ints(values, count, true, out);
+}
+
+bool decode_ints(const uint8_t *data, size_t size, size_t count,
+                 int64_t *out) {
+  Reader in{data, data + size};
+  uint8_t tag;
+  if (!in.get(tag)) {
+    return false;
+  }
+
+  switch (static_cast<Encoding>(tag)) {
+  case Encoding::PLAIN:
+    if (in.left() < count * sizeof(int64_t)) {
+      return false;
+    }
+    std::memcpy(out, in.pos, count * sizeof(int64_t));
+    return true;
+
+  case Encoding::BITPACK:
+    return read_frame(in, count, out);
+
+  case Encoding::DELTA_DELTA: {
+    int64_t first;
+    int64_t first_delta;
+    if (count < 3 || !in.get(first) || !in.get(first_delta) ||
+        !read_frame(in, count - 2, out + 2)) {
+      return false;
+    }
+    // Second deltas were unpacked into out[2..]; integrate twice in place
+    auto value = static_cast<uint64_t>(first);
+    auto delta = static_cast<uint64_t>(first_delta);
+    out[0] = first;
+    value += delta;
+    out[1] = static_cast<int64_t>(value);
+    for (size_t i = 2; i < count; ++i) {
+      delta += static_cast<uint64_t>(out[i]);
+      value += delta;
+      out[i] = static_cast<int64_t>(value);
+    }
+    return true;
+  }
+
+  case Encoding::RLE: {
+    std::vector<int64_t> values;
+    std::vector<int64_t> lengths;
+    if (!read_runs(in, values, lengths)) {
+      return false;
+    }
+    size_t at = 0;
+    for (size_t r = 0; r < values.size(); ++r) {
+      auto length = static_cast<size_t>(lengths[r]);
+      if (length > count - at) {
+        return false;
+      }
+      std::fill(out + at, out + at + length, values[r]);
+      at += length;
+    }
+    return at == count;
+  }
+
+  case Encoding::DICTIONARY:
+    break;
+  }
+
+  return false;
+}
+
+size_t select_int_range(const uint8_t *data, size_t size, size_t count,
+                        int64_t lo, int64_t hi, uint8_t *selected) {
+  std::memset(selected, 0, count);
+  if (size == 0 || lo > hi) {
+    return 0;
+  }
+
+  Reader in{data + 1, data + size};
+  auto encoding = static_cast<Encoding>(data[0]);
+
+  if (encoding == Encoding::RLE) {
+    std::vector<int64_t> values;
+    std::vector<int64_t> lengths;
+    if (!read_runs(in, values, lengths)) {
+      return 0;
+    }
+    size_t at = 0;
+    size_t hits = 0;
+    for (size_t r = 0; r < values.size() && at < count; ++r) {
+      size_t length = std::min(static_cast<size_t>(lengths[r]), count - at);
+      if (values[r] >= lo && values[r] <= hi) {
+        std::memset(selected + at, 1, length);
+        hits += length;
+      }
+      at += length;
+    }
+    return hits;
+  }
+
+  std::vector<int64_t> values(count);
+  uint64_t low = static_cast<uint64_t>(lo);
+  uint64_t span = static_cast<uint64_t>(hi) - static_cast<uint64_t>(lo);
+
+  if (encoding == Encoding::BITPACK) {
+    int64_t reference;
+    uint8_t width;
+    if (!in.get(reference) || !in.get(width) || width > 64 ||
+        in.left() < packed_bytes(count, width)) {
+      return 0;
+    }
+    if (hi < reference) {
+      return 0; // Whole block is above the range
+    }
+
+    // Compare offsets from the reference instead of rebuilding values
+    uint64_t max_offset =
+        width == 64 ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+    low = lo <= reference
+              ? 0
+              : static_cast<uint64_t>(lo) - static_cast<uint64_t>(reference);
+    uint64_t high =
+        static_cast<uint64_t>(hi) - static_cast<uint64_t>(reference);
+    if (low > max_offset) {
+      return 0;
+    }
+    if (low == 0 && high >= max_offset) {
+      std::memset(selected, 1, count);
+      return count;
+    }
+    span = high - low;
+    unpack(in.pos, count, width, 0, values.data());
+  } else if (!decode_ints(data, size, count, values.data())) {
+    return 0;
+  }
+
+  // Branch-free so the compiler vectorizes it
+  size_t hits = 0;
+  for (size_t i = 0; i < count; ++i) {
+    uint8_t hit = static_cast<uint64_t>(values[i]) - low <= span;
+    selected[i] = hit;
+    hits += hit;
+  }
+  return hits;
+}
+
+Encoding encode_strings(const std::string_view *values, size_t count,
+                        std::vector<uint8_t> &out) {
+  // PLAIN: lengths block, then the bytes back to back
+  std::vector<uint8_t> plain;
+  put(plain, static_cast<uint8_t>(Encoding::PLAIN));
+  std::vector<int64_t> lengths(count);
+  for (size_t i = 0; i < count; ++i) {
+    lengths[i] = static_cast<int64_t>(values[i].size());
+  }
+  std::vector<uint8_t> block;
+  write_ints(lengths.data(), count, true, block);
+  put(plain, static_cast<uint32_t>(block.size()));
+  plain.insert(plain.end(), block.begin(), block.end());
+  for (size_t i = 0; i < count; ++i) {
+    plain.insert(plain.end(), values[i].begin(), values[i].end());
+  }
+
+  // DICTIONARY: distinct values in first-seen order, then the codes
+  std::unordered_map<std::string_view, int64_t> ids;
+  std::vector<std::string_view> dictionary;
+  std::vector<int64_t> codes(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto [it, inserted] =
+        ids.emplace(values[i], static_cast<int64_t>(dictionary.size()));
+    if (inserted) {
+      dictionary.push_back(values[i]);
+    }
+    codes[i] = it->second;
+  }
+
+  if (dictionary.size() * 2 <= count) {
+    std::vector<uint8_t> dict;
+    put(dict, static_cast<uint8_t>(Encoding::DICTIONARY));
+    put(dict, static_cast<uint32_t>(dictionary.size()));
+
+    lengths.resize(dictionary.size());
+    size_t bytes = 0;
+    for (size_t i = 0; i < dictionary.size(); ++i) {
+      lengths[i] = static_cast<int64_t>(dictionary[i].size());
+      bytes += dictionary[i].size();
+    }
+    block.clear();
+    write_ints(lengths.data(), lengths.size(), true, block);
+    put(dict, static_cast<uint32_t>(block.size()));
+    dict.insert(dict.end(), block.begin(), block.end());
+    put(dict, static_cast<uint32_t>(bytes));
+    for (const auto &value : dictionary) {
+      dict.insert(dict.end(), value.begin(), value.end());
+    }
+    write_ints(codes.data(), count, true, dict);
+
+    if (dict.size() < plain.size()) {
+      out.insert(out.end(), dict.begin(), dict.end());
+      return Encoding::DICTIONARY;
+    }
+  }
+
+  out.insert(out.end(), plain.begin(), plain.end());
+  return Encoding::PLAIN;
+}
+
+bool decode_strings(const uint8_t *data, size_t size, size_t count,
+                    std::string_view *out) {
+  Reader in{data, data + size};
+  uint8_t tag;
+  if (!in.get(tag)) {
+    return false;
+  }
+
+  // Lengths block followed by the string bytes
+  auto read_strings = [&in](size_t n, std::string_view *views) {
+    uint32_t block_size;
+    if (!in.get(block_size) || in.left() < block_size) {
+      return false;
+    }
+    std::vector<int64_t> lengths(n);
+    if (!decode_ints(in.pos, block_size, n, lengths.data())) {
+      return false;
+    }
+    in.pos += block_size;
+    for (size_t i = 0; i < n; ++i) {
+      auto length = static_cast<size_t>(lengths[i]);
+      if (in.left() < length) {
+        return false;
+      }
+      views[i] = std::string_view(reinterpret_cast<const char *>(in.pos),
+                                  length);
+      in.pos += length;
+    }
+    return true;
+  };
+
+  if (static_cast<Encoding>(tag) == Encoding::PLAIN) {
+    return read_strings(count, out);
+  }
+  if (static_cast<Encoding>(tag) != Encoding::DICTIONARY) {
+    return false;
+  }
+
+  uint32_t dict_count;
+  if (!in.get(dict_count)) {
+    return false;
+  }
+  std::vector<std::string_view> dictionary(dict_count);
+  uint32_t block_size;
+  if (!in.get(block_size) || in.left() < block_size) {
+    return false;
+  }
+  std::vector<int64_t> lengths(dict_count);
+  if (!decode_ints(in.pos, block_size, dict_count, lengths.data())) {
+    return false;
+  }
+  in.pos += block_size;
+
+  uint32_t bytes;
+  if (!in.get(bytes) || in.left() < bytes) {
+    return false;
+  }
+  const uint8_t *text = in.pos;
+  size_t offset = 0;
+  for (uint32_t i = 0; i < dict_count; ++i) {
+    auto length = static_cast<size_t>(lengths[i]);
+    if (bytes - offset < length) {
+      return false;
+    }
+    dictionary[i] = std::string_view(
+        reinterpret_cast<const char *>(text + offset), length);
+    offset += length;
+  }
+  in.pos += bytes;
+
+  std::vector<int64_t> codes(count);
+  if (!decode_ints(in.pos, in.left(), count, codes.data())) {
+    return false;
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (static_cast<uint64_t>(codes[i]) >= dict_count) {
+      return false;
+    }
+    out[i] = dictionary[static_cast<size_t>(codes[i])];
+  }
+  return true;
+}
+
+} // namespace storage
+} // namespace edgesql
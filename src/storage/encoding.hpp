@@ -0,0 +1,88 @@
+#pragma once
+
+/**
+ * @file encoding.hpp
+ * @brief Lightweight column encodings for sealed segments
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace edgesql {
+namespace storage {
+
+/**
+ * @brief Column block encoding
+ *
+ * Every encoded block starts with one Encoding byte.
+ */
+enum class Encoding : uint8_t {
+  PLAIN = 0,       // Raw 8-byte integers, or lengths plus bytes for strings
+  BITPACK = 1,     // Frame of reference: minimum plus fixed-width offsets
+  DELTA_DELTA = 2, // First value and delta, then bit-packed second deltas
+  RLE = 3,         // Run values and run lengths, each a nested block
+  DICTIONARY = 4   // Distinct strings plus an integer block of codes
+};
+
+/**
+ * @brief Get the name of an encoding
+ */
+const char *encoding_name(Encoding encoding);
+
+/**
+ * @brief Encode integers with the smallest applicable encoding
+ *
+ * Sizes every candidate from one pass of statistics and writes only the
+ * winner: monotonic timestamps end up delta-of-delta, repeated values
+ * RLE, and narrow ranges bit-packed.
+ *
+ * @param values Values to encode
+ * @param count Number of values
+ * @param out Block is appended here
+ * @return Encoding chosen
+ */
+Encoding encode_ints(const int64_t *values, size_t count,
+                     std::vector<uint8_t> &out);
+
+/**
+ * @brief Decode an integer block
+ * @param data Block start
+ * @param size Block size in bytes
+ * @param count Number of values in the block
+ * @param out Receives count values
+ * @return false if the block is malformed
+ */
+bool decode_ints(const uint8_t *data, size_t size, size_t count,
+                 int64_t *out);
+
+/**
+ * @brief Select the values of an integer block within [lo, hi]
+ *
+ * Works on the encoded form where it can: RLE tests each run once, and
+ * bit-packed blocks compare offsets from the reference without rebuilding
+ * values, skipping the block outright when the range misses it.
+ *
+ * @param selected Receives 1 for values in range, 0 otherwise
+ * @return Number of values selected
+ */
+size_t select_int_range(const uint8_t *data, size_t size, size_t count,
+                        int64_t lo, int64_t hi, uint8_t *selected);
+
+/**
+ * @brief Encode strings as PLAIN or DICTIONARY, whichever is smaller
+ */
+Encoding encode_strings(const std::string_view *values, size_t count,
+                        std::vector<uint8_t> &out);
+
+/**
+ * @brief Decode a string block
+ *
+ * Views point into the block, so the block must outlive them.
+ */
+bool decode_strings(const uint8_t *data, size_t size, size_t count,
+                    std::string_view *out);
+
+} // namespace storage
+} // namespace edgesql
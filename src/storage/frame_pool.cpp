@@ -0,0 +1,102 @@
+/**
+ * @file frame_pool.cpp
+ * @brief Page frame pool implementation
+ */
+
+#include "frame_pool.hpp"
+#include <new>
+#include <sys/mman.h>
+
+namespace edgesql {
+namespace storage {
+
+FramePool::FramePool(size_t frame_count) : frame_count_(frame_count) {
+  region_size_ = frame_count_ * PAGE_SIZE;
+
+  if (region_size_ > 0) {
+    void *addr = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    // Explicit huge pages only work if the admin reserved them
+    // (vm.nr_hugepages); the mapping length must be a huge page multiple
+    size_t huge_size =
+        (region_size_ + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    addr = mmap(nullptr, huge_size, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr != MAP_FAILED) {
+      region_size_ = huge_size;
+      backing_ = FrameBacking::HUGETLB;
+    }
+#endif
+
+    if (addr == MAP_FAILED) {
+      addr = mmap(nullptr, region_size_, PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (addr != MAP_FAILED) {
+        backing_ = FrameBacking::PAGES;
+#ifdef MADV_HUGEPAGE
+        // Best effort: fewer TLB entries for scans over the pool
+        if (madvise(addr, region_size_, MADV_HUGEPAGE) == 0) {
+          backing_ = FrameBacking::TRANSPARENT_HUGE;
+        }
+#endif
+      }
+    }
+
+    if (addr != MAP_FAILED) {
+      region_ = static_cast<uint8_t *>(addr);
+    } else {
+      // No mmap (e.g. restricted sandbox) - fall back to the heap
+      region_ = static_cast<uint8_t *>(
+          ::operator new(region_size_, std::align_val_t(PAGE_SIZE)));
+      backing_ = FrameBacking::HEAP;
+    }
+  }
+
+  // Hand out low frames first so the touched part of the region stays dense
+  free_.reserve(frame_count_);
+  for (size_t i = frame_count_; i > 0; --i) {
+    free_.push_back(static_cast<uint32_t>(i - 1));
+  }
+}
+
+FramePool::~FramePool() {
+  if (!region_) {
+    return;
+  }
+
+  if (backing_ == FrameBacking::HEAP) {
+    ::operator delete(region_, std::align_val_t(PAGE_SIZE));
+  } else {
+    munmap(region_, region_size_);
+  }
+}
+
+uint32_t FramePool::allocate() {
+  if (free_.empty()) {
+    return INVALID_SLOT;
+  }
+
+  uint32_t slot = free_.back();
+  free_.pop_back();
+  new (frame(slot)) Page;
+  return slot;
+}
+
+void FramePool::release(uint32_t slot, bool discard) {
+  if (slot == INVALID_SLOT) {
+    return;
+  }
+
+  // hugetlb memory is reserved up front and cannot be returned per frame
+  if (discard && (backing_ == FrameBacking::PAGES ||
+                  backing_ == FrameBacking::TRANSPARENT_HUGE)) {
+    // The range stays mapped; the next touch faults in a zero page
+    madvise(frame(slot), PAGE_SIZE, MADV_DONTNEED);
+  }
+
+  free_.push_back(slot);
+}
+
+} // namespace storage
+} // namespace edgesql
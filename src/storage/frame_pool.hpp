@@ -0,0 +1,113 @@
+#pragma once
+
+/**
+ * @file frame_pool.hpp
+ * @brief Fixed pool of page frames for the buffer pool
+ */
+
+#include "page.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace edgesql {
+namespace storage {
+
+// Slot value meaning "no frame"
+constexpr uint32_t INVALID_SLOT = UINT32_MAX;
+
+/**
+ * @brief How the frame region is backed
+ */
+enum class FrameBacking : uint8_t {
+  HUGETLB,          // Explicit huge pages (MAP_HUGETLB)
+  TRANSPARENT_HUGE, // Regular mapping with MADV_HUGEPAGE
+  PAGES,            // Regular mapping, base pages
+  HEAP              // mmap unavailable
+};
+
+/**
+ * @brief Page frame pool
+ *
+ * Allocates all frames for the buffer pool as one contiguous array when
+ * the pool is created and hands them out by slot index. The region is
+ * backed by explicit huge pages when the system has them reserved, then
+ * transparent huge pages, then base pages, so scans across the pool touch
+ * a handful of TLB entries. Loading or evicting a page never touches the
+ * heap, and slot-to-frame is array indexing.
+ *
+ * Not thread-safe; the owning PageManager serializes access.
+ */
+class FramePool {
+public:
+  /**
+   * @brief Constructor
+   * @param frame_count Number of PAGE_SIZE frames
+   */
+  explicit FramePool(size_t frame_count);
+
+  /**
+   * @brief Destructor - unmaps the frame region
+   */
+  ~FramePool();
+
+  // Non-copyable
+  FramePool(const FramePool &) = delete;
+  FramePool &operator=(const FramePool &) = delete;
+
+  /**
+   * @brief Take a free frame
+   * @return Slot index, or INVALID_SLOT if all frames are in use
+   */
+  uint32_t allocate();
+
+  /**
+   * @brief Return a frame to the pool
+   * @param slot Slot to return
+   * @param discard Also hand the frame's physical memory back to the OS
+   */
+  void release(uint32_t slot, bool discard = false);
+
+  /**
+   * @brief Get the frame for a slot
+   */
+  Page *frame(uint32_t slot) {
+    return reinterpret_cast<Page *>(region_ +
+                                    static_cast<size_t>(slot) * PAGE_SIZE);
+  }
+
+  /**
+   * @brief Get total number of frames
+   */
+  size_t capacity() const { return frame_count_; }
+
+  /**
+   * @brief Get number of frames in use
+   */
+  size_t in_use() const { return frame_count_ - free_.size(); }
+
+  /**
+   * @brief Get how the region is backed
+   */
+  FrameBacking backing() const { return backing_; }
+
+  /**
+   * @brief Check if the region is backed by huge pages
+   */
+  bool huge_pages() const {
+    return backing_ == FrameBacking::HUGETLB ||
+           backing_ == FrameBacking::TRANSPARENT_HUGE;
+  }
+
+private:
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  size_t frame_count_;
+  size_t region_size_{0};
+  uint8_t *region_{nullptr};
+  FrameBacking backing_{FrameBacking::HEAP};
+  std::vector<uint32_t> free_; // Free slots
+};
+
+} // namespace storage
+} // namespace edgesql
@@ -18,6 +18,38 @@ constexpr size_t PAGE_SIZE = 8192;
 // Magic number for page validation
 constexpr uint32_t PAGE_MAGIC = 0x45444247; // "EDBG"
 
+/**
+ * @brief How a table lays out rows within its pages
+ */
+enum class PageLayout : uint8_t {
+  ROW = 0, // Slotted pages of whole records
+  PAX = 1  // Column minipages within each page (see PaxPage)
+};
+
+/**
+ * @brief Time partitioning of a table's segments
+ *
+ * Rows are routed by an INTEGER time column: a segment is rotated out
+ * when a row arrives past the partition the segment started in, so each
+ * sealed segment covers about one partition and can be pruned or expired
+ * as a whole.
+ */
+struct TimePartitioning {
+  int32_t column = -1;   // Time column index, -1 if not partitioned
+  int64_t width = 0;     // Partition width in time column units
+  int64_t retention = 0; // Keep this much history, 0 = forever
+
+  bool enabled() const { return column >= 0 && width > 0; }
+
+  /**
+   * @brief Get the partition a time falls in
+   */
+  int64_t partition(int64_t time) const {
+    int64_t p = time / width;
+    return (time % width != 0 && time < 0) ? p - 1 : p;
+  }
+};
+
 /**
  * @brief Page header structure
  *
@@ -38,12 +70,15 @@ struct PageHeader {
   static constexpr uint16_t FLAG_INTERNAL = 0x0002;
   static constexpr uint16_t FLAG_OVERFLOW = 0x0004;
   static constexpr uint16_t FLAG_DIRTY = 0x0008;
+  static constexpr uint16_t FLAG_PAX = 0x0010; // Columnar layout (PaxPage)
+  static constexpr uint16_t FLAG_ENCODED = 0x0020; // Compressed (EncodedPage)
 
   bool is_valid() const { return magic == PAGE_MAGIC; }
   bool is_leaf() const { return flags & FLAG_LEAF; }
   bool is_internal() const { return flags & FLAG_INTERNAL; }
   bool is_overflow() const { return flags & FLAG_OVERFLOW; }
   bool is_dirty() const { return flags & FLAG_DIRTY; }
+  bool is_pax() const { return flags & FLAG_PAX; }
 
   void set_dirty(bool dirty) {
     if (dirty)
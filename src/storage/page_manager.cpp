@@ -4,6 +4,7 @@
  */
 
 #include "page_manager.hpp"
+#include "../memory/memory_tracker.hpp"
 #include <fcntl.h>
 #include <filesystem>
 #include <fstream>
@@ -15,9 +16,19 @@ namespace edgesql {
 namespace storage {
 
 PageManager::PageManager(const std::string &data_dir, size_t max_pages)
-    : data_dir_(data_dir), max_pages_(max_pages) {}
+    : data_dir_(data_dir), max_pages_(max_pages), frames_(max_pages),
+      frame_table_(max_pages),
+      latches_(std::make_unique<std::shared_mutex[]>(max_pages)) {
+  // Sized once so lookups never rehash while the pool is full
+  page_table_.reserve(max_pages);
+  reclaimer_id_ = memory::MemoryTracker::instance().add_reclaimer(
+      [this](size_t bytes) { return shrink(bytes); });
+}
 
-PageManager::~PageManager() { close(); }
+PageManager::~PageManager() {
+  memory::MemoryTracker::instance().remove_reclaimer(reclaimer_id_);
+  close();
+}
 
 bool PageManager::init() {
   std::lock_guard<std::mutex> lock(mutex_);
@@ -39,95 +50,172 @@ void PageManager::close() {
   std::lock_guard<std::mutex> lock(mutex_);
 
   // Flush all dirty pages
-  for (auto &[key, entry] : buffer_pool_) {
+  for (const auto &[key, slot] : page_table_) {
+    FrameEntry &entry = frame_table_[slot];
     if (entry.dirty) {
-      write_page(entry.table_id, entry.page_id, entry.page.get());
+      write_page(entry.table_id, entry.page_id, frames_.frame(slot));
     }
+    release_frame(slot);
   }
 
-  buffer_pool_.clear();
-  lru_list_.clear();
-  lru_map_.clear();
+  page_table_.clear();
+  lru_head_ = INVALID_SLOT;
+  lru_tail_ = INVALID_SLOT;
 }
 
 Page *PageManager::get_page(uint32_t table_id, uint32_t page_id) {
   std::lock_guard<std::mutex> lock(mutex_);
 
-  PageKey key{table_id, page_id};
+  uint32_t slot = find_page(table_id, page_id);
+  if (slot == INVALID_SLOT) {
+    return nullptr;
+  }
 
-  auto it = buffer_pool_.find(key);
-  if (it != buffer_pool_.end()) {
-    // Move to front of LRU list
-    auto lru_it = lru_map_.find(key);
-    if (lru_it != lru_map_.end()) {
-      lru_list_.erase(lru_it->second);
-      lru_list_.push_front(key);
-      lru_map_[key] = lru_list_.begin();
+  return frames_.frame(slot);
+}
+
+PageGuard PageManager::pin_page(uint32_t table_id, uint32_t page_id,
+                                PinStatus *status) {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  for (int attempt = 0;; ++attempt) {
+    bool no_frame = false;
+    uint32_t slot = find_page(table_id, page_id, &no_frame);
+    if (slot != INVALID_SLOT) {
+      frame_table_[slot].pins++;
+      if (status) {
+        *status = PinStatus::OK;
+      }
+      return PageGuard(this, slot, frames_.frame(slot));
+    }
+
+    if (!no_frame || attempt == FRAME_WAIT_ATTEMPTS) {
+      if (status) {
+        *status = no_frame ? PinStatus::NO_FRAME : PinStatus::NOT_FOUND;
+      }
+      return PageGuard();
     }
-    return it->second.page.get();
+    wait_for_frame(lock);
   }
+}
 
-  // Load from disk
-  if (!load_page(table_id, page_id)) {
-    return nullptr;
+void PageManager::wait_for_frame(std::unique_lock<std::mutex> &lock) {
+  // Other subsystems' reclaimers may take our own lock, so it is dropped
+  // while they run
+  lock.unlock();
+  memory::MemoryTracker::instance().reclaim(PAGE_SIZE);
+  lock.lock();
+  frame_released_.wait_for(lock, FRAME_WAIT);
+}
+
+uint32_t PageManager::find_page(uint32_t table_id, uint32_t page_id,
+                                bool *no_frame) {
+  // Note: mutex already held by caller
+  auto it = page_table_.find(PageKey{table_id, page_id});
+  if (it != page_table_.end()) {
+    // Move to front of LRU list
+    uint32_t slot = it->second;
+    if (slot != lru_head_) {
+      lru_unlink(slot);
+      lru_push_front(slot);
+    }
+    return slot;
   }
 
-  return buffer_pool_[key].page.get();
+  // Load from disk
+  bool unused;
+  return load_page(table_id, page_id, no_frame ? no_frame : &unused);
 }
 
-uint32_t PageManager::allocate_page(uint32_t table_id) {
+void PageManager::unpin(uint32_t slot) {
   std::lock_guard<std::mutex> lock(mutex_);
 
-  // Get next page ID for this table
-  uint32_t page_id = next_page_id_[table_id]++;
+  FrameEntry &entry = frame_table_[slot];
+  if (--entry.pins > 0) {
+    return;
+  }
+  if (entry.dropped) {
+    entry.dropped = false;
+    release_frame(slot, true);
+  }
+  frame_released_.notify_all();
+}
 
-  // Evict if necessary
-  while (buffer_pool_.size() >= max_pages_) {
-    evict_page();
+uint32_t PageManager::allocate_page(uint32_t table_id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  uint32_t slot = acquire_frame();
+  for (int attempt = 0; slot == INVALID_SLOT; ++attempt) {
+    if (attempt == FRAME_WAIT_ATTEMPTS) {
+      return UINT32_MAX;
+    }
+    wait_for_frame(lock);
+    slot = acquire_frame();
   }
 
+  // Get next page ID for this table
+  uint32_t page_id = next_page_id_locked(table_id)++;
+
   // Create new page
-  PageKey key{table_id, page_id};
-  BufferEntry entry;
+  frames_.frame(slot)->init(page_id);
+
+  FrameEntry &entry = frame_table_[slot];
   entry.table_id = table_id;
   entry.page_id = page_id;
-  entry.page = std::make_unique<Page>();
-  entry.page->init(page_id);
   entry.dirty = true;
 
-  buffer_pool_[key] = std::move(entry);
-  lru_list_.push_front(key);
-  lru_map_[key] = lru_list_.begin();
+  page_table_[PageKey{table_id, page_id}] = slot;
+  lru_push_front(slot);
 
   return page_id;
 }
 
+uint32_t PageManager::table_page_count(uint32_t table_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return next_page_id_locked(table_id);
+}
+
+uint32_t &PageManager::next_page_id_locked(uint32_t table_id) {
+  auto it = next_page_id_.find(table_id);
+  if (it != next_page_id_.end()) {
+    return it->second;
+  }
+
+  // First touch since startup: continue after the pages already on disk
+  std::error_code ec;
+  auto size = std::filesystem::file_size(table_file_path(table_id), ec);
+  uint32_t pages = ec ? 0 : static_cast<uint32_t>(size / PAGE_SIZE);
+  return next_page_id_.emplace(table_id, pages).first->second;
+}
+
 void PageManager::mark_dirty(uint32_t table_id, uint32_t page_id) {
   std::lock_guard<std::mutex> lock(mutex_);
 
-  PageKey key{table_id, page_id};
-  auto it = buffer_pool_.find(key);
-  if (it != buffer_pool_.end()) {
-    it->second.dirty = true;
-    it->second.page->header().set_dirty(true);
+  auto it = page_table_.find(PageKey{table_id, page_id});
+  if (it != page_table_.end()) {
+    frame_table_[it->second].dirty = true;
+    std::unique_lock<std::shared_mutex> latch(latches_[it->second]);
+    frames_.frame(it->second)->header().set_dirty(true);
   }
 }
 
 bool PageManager::flush_page(uint32_t table_id, uint32_t page_id) {
   std::lock_guard<std::mutex> lock(mutex_);
 
-  PageKey key{table_id, page_id};
-  auto it = buffer_pool_.find(key);
-  if (it == buffer_pool_.end() || !it->second.dirty) {
+  auto it = page_table_.find(PageKey{table_id, page_id});
+  if (it == page_table_.end() || !frame_table_[it->second].dirty) {
     return true; // Nothing to flush
   }
 
-  if (!write_page(table_id, page_id, it->second.page.get())) {
+  // A pinned page may be changing; its writer marks it dirty again after
+  Page *page = frames_.frame(it->second);
+  std::unique_lock<std::shared_mutex> latch(latches_[it->second]);
+  if (!write_page(table_id, page_id, page)) {
     return false;
   }
 
-  it->second.dirty = false;
-  it->second.page->header().set_dirty(false);
+  frame_table_[it->second].dirty = false;
+  page->header().set_dirty(false);
   return true;
 }
 
@@ -135,11 +223,14 @@ size_t PageManager::flush_all() {
   std::lock_guard<std::mutex> lock(mutex_);
 
   size_t count = 0;
-  for (auto &[key, entry] : buffer_pool_) {
+  for (const auto &[key, slot] : page_table_) {
+    FrameEntry &entry = frame_table_[slot];
     if (entry.dirty) {
-      if (write_page(entry.table_id, entry.page_id, entry.page.get())) {
+      Page *page = frames_.frame(slot);
+      std::unique_lock<std::shared_mutex> latch(latches_[slot]);
+      if (write_page(entry.table_id, entry.page_id, page)) {
         entry.dirty = false;
-        entry.page->header().set_dirty(false);
+        page->header().set_dirty(false);
         count++;
       }
     }
@@ -150,15 +241,15 @@ size_t PageManager::flush_all() {
 
 size_t PageManager::page_count() const {
   std::lock_guard<std::mutex> lock(mutex_);
-  return buffer_pool_.size();
+  return page_table_.size();
 }
 
 size_t PageManager::dirty_count() const {
   std::lock_guard<std::mutex> lock(mutex_);
 
   size_t count = 0;
-  for (const auto &[key, entry] : buffer_pool_) {
-    if (entry.dirty)
+  for (const auto &[key, slot] : page_table_) {
+    if (frame_table_[slot].dirty)
       count++;
   }
   return count;
@@ -182,21 +273,14 @@ bool PageManager::create_table_file(uint32_t table_id) {
 bool PageManager::delete_table_file(uint32_t table_id) {
   std::lock_guard<std::mutex> lock(mutex_);
 
-  // Remove all pages for this table from buffer pool
-  std::vector<PageKey> to_remove;
-  for (const auto &[key, entry] : buffer_pool_) {
-    if (key.first == table_id) {
-      to_remove.push_back(key);
+  // Remove all pages for this table from buffer pool; the frame table is
+  // walked directly so no temporary list is needed
+  for (uint32_t slot = lru_head_; slot != INVALID_SLOT;) {
+    uint32_t next = frame_table_[slot].lru_next;
+    if (frame_table_[slot].table_id == table_id) {
+      drop_page(slot, true);
     }
-  }
-
-  for (const auto &key : to_remove) {
-    auto lru_it = lru_map_.find(key);
-    if (lru_it != lru_map_.end()) {
-      lru_list_.erase(lru_it->second);
-      lru_map_.erase(lru_it);
-    }
-    buffer_pool_.erase(key);
+    slot = next;
   }
 
   // Delete the file
@@ -209,52 +293,64 @@ bool PageManager::delete_table_file(uint32_t table_id) {
   return !ec;
 }
 
-bool PageManager::load_page(uint32_t table_id, uint32_t page_id) {
-  // Evict if necessary
-  while (buffer_pool_.size() >= max_pages_) {
-    evict_page();
-  }
-
+uint32_t PageManager::load_page(uint32_t table_id, uint32_t page_id,
+                               bool *no_frame) {
+  *no_frame = false;
   std::string path = table_file_path(table_id);
   std::ifstream file(path, std::ios::binary);
 
   if (!file.is_open()) {
-    return false;
+    return INVALID_SLOT;
+  }
+
+  // A page past the end of the file is missing; no frame is needed to
+  // tell, so a scan ends cleanly even with every frame pinned
+  auto offset = static_cast<std::streamoff>(page_id) *
+                static_cast<std::streamoff>(PAGE_SIZE);
+  file.seekg(0, std::ios::end);
+  if (!file.good() ||
+      file.tellg() < offset + static_cast<std::streamoff>(PAGE_SIZE)) {
+    return INVALID_SLOT;
   }
 
   // Seek to page
-  file.seekg(static_cast<std::streamoff>(page_id * PAGE_SIZE));
+  file.seekg(offset);
 
   if (!file.good()) {
-    return false;
+    return INVALID_SLOT;
   }
 
-  // Read page
-  auto page = std::make_unique<Page>();
+  // Read page straight into a pool frame
+  uint32_t slot = acquire_frame();
+  if (slot == INVALID_SLOT) {
+    *no_frame = true;
+    return INVALID_SLOT;
+  }
+
+  Page *page = frames_.frame(slot);
   file.read(reinterpret_cast<char *>(page->data()), PAGE_SIZE);
 
   if (file.gcount() != static_cast<std::streamsize>(PAGE_SIZE)) {
-    return false;
+    release_frame(slot);
+    return INVALID_SLOT;
   }
 
   // Validate page
   if (!page->header().is_valid()) {
-    return false;
+    release_frame(slot);
+    return INVALID_SLOT;
   }
 
   // Add to buffer pool
-  PageKey key{table_id, page_id};
-  BufferEntry entry;
+  FrameEntry &entry = frame_table_[slot];
   entry.table_id = table_id;
   entry.page_id = page_id;
-  entry.page = std::move(page);
   entry.dirty = false;
 
-  buffer_pool_[key] = std::move(entry);
-  lru_list_.push_front(key);
-  lru_map_[key] = lru_list_.begin();
+  page_table_[PageKey{table_id, page_id}] = slot;
+  lru_push_front(slot);
 
-  return true;
+  return slot;
 }
 
 bool PageManager::write_page(uint32_t table_id, uint32_t page_id,
@@ -291,35 +387,152 @@ bool PageManager::write_page(uint32_t table_id, uint32_t page_id,
   return true;
 }
 
-void PageManager::evict_page() {
-  if (lru_list_.empty()) {
+uint32_t PageManager::acquire_frame() {
+  // Evict if necessary; with every frame pinned the pool stays full and
+  // the allocation below fails
+  while (page_table_.size() >= max_pages_ && evict_page()) {
+  }
+
+  // Under global memory pressure recycle a resident frame instead of
+  // growing the pool
+  auto &tracker = memory::MemoryTracker::instance();
+  while (!tracker.try_reserve(PAGE_SIZE, memory::MemoryCategory::BUFFER_POOL)) {
+    if (!evict_page()) {
+      return INVALID_SLOT;
+    }
+  }
+
+  uint32_t slot = frames_.allocate();
+  if (slot == INVALID_SLOT) {
+    tracker.release(PAGE_SIZE, memory::MemoryCategory::BUFFER_POOL);
+  }
+  return slot;
+}
+
+void PageManager::release_frame(uint32_t slot, bool discard) {
+  frames_.release(slot, discard);
+  memory::MemoryTracker::instance().release(
+      PAGE_SIZE, memory::MemoryCategory::BUFFER_POOL);
+}
+
+size_t PageManager::shrink(size_t bytes) {
+  std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    return 0;
+  }
+
+  size_t released = 0;
+  while (released < bytes && page_table_.size() > MIN_RESIDENT_PAGES &&
+         evict_page(true)) {
+    released += PAGE_SIZE;
+  }
+  return released;
+}
+
+bool PageManager::evict_page(bool discard) {
+  // The least recently used page no one has pinned
+  uint32_t slot = lru_tail_;
+  while (slot != INVALID_SLOT && frame_table_[slot].pins > 0) {
+    slot = frame_table_[slot].lru_prev;
+  }
+  if (slot == INVALID_SLOT) {
+    return false;
+  }
+
+  FrameEntry &entry = frame_table_[slot];
+  if (entry.dirty) {
+    // Write dirty page before evicting
+    write_page(entry.table_id, entry.page_id, frames_.frame(slot));
+  }
+
+  drop_page(slot, discard);
+  return true;
+}
+
+void PageManager::drop_page(uint32_t slot, bool discard) {
+  FrameEntry &entry = frame_table_[slot];
+  page_table_.erase(PageKey{entry.table_id, entry.page_id});
+  lru_unlink(slot);
+  entry.dirty = false;
+
+  // A pinned frame is released by its last unpin
+  if (entry.pins > 0) {
+    entry.dropped = true;
     return;
   }
+  release_frame(slot, discard);
+}
 
-  // Find a non-dirty page to evict from the back of LRU list
-  for (auto it = lru_list_.rbegin(); it != lru_list_.rend(); ++it) {
-    const PageKey &key = *it;
-    auto buf_it = buffer_pool_.find(key);
+void PageManager::lru_push_front(uint32_t slot) {
+  FrameEntry &entry = frame_table_[slot];
+  entry.lru_prev = INVALID_SLOT;
+  entry.lru_next = lru_head_;
 
-    if (buf_it != buffer_pool_.end()) {
-      if (buf_it->second.dirty) {
-        // Write dirty page before evicting
-        write_page(key.first, key.second, buf_it->second.page.get());
-      }
+  if (lru_head_ != INVALID_SLOT) {
+    frame_table_[lru_head_].lru_prev = slot;
+  }
+  lru_head_ = slot;
 
-      // Remove from buffer pool and LRU
-      buffer_pool_.erase(buf_it);
-      lru_map_.erase(key);
-      lru_list_.erase(std::next(it).base());
-      return;
-    }
+  if (lru_tail_ == INVALID_SLOT) {
+    lru_tail_ = slot;
   }
 }
 
+void PageManager::lru_unlink(uint32_t slot) {
+  FrameEntry &entry = frame_table_[slot];
+
+  if (entry.lru_prev != INVALID_SLOT) {
+    frame_table_[entry.lru_prev].lru_next = entry.lru_next;
+  } else {
+    lru_head_ = entry.lru_next;
+  }
+
+  if (entry.lru_next != INVALID_SLOT) {
+    frame_table_[entry.lru_next].lru_prev = entry.lru_prev;
+  } else {
+    lru_tail_ = entry.lru_prev;
+  }
+
+  entry.lru_prev = INVALID_SLOT;
+  entry.lru_next = INVALID_SLOT;
+}
+
 std::string PageManager::table_file_path(uint32_t table_id) const {
   return data_dir_ + "/table_" + std::to_string(table_id) + ".dat";
 }
 
+// PageGuard implementation
+
+PageGuard::PageGuard(PageGuard &&other) noexcept
+    : manager_(other.manager_), slot_(other.slot_), page_(other.page_) {
+  other.manager_ = nullptr;
+  other.page_ = nullptr;
+}
+
+PageGuard &PageGuard::operator=(PageGuard &&other) noexcept {
+  if (this != &other) {
+    release();
+    manager_ = other.manager_;
+    slot_ = other.slot_;
+    page_ = other.page_;
+    other.manager_ = nullptr;
+    other.page_ = nullptr;
+  }
+  return *this;
+}
+
+std::shared_mutex &PageGuard::latch() const {
+  return manager_->latches_[slot_];
+}
+
+void PageGuard::release() {
+  if (manager_) {
+    manager_->unpin(slot_);
+  }
+  manager_ = nullptr;
+  page_ = nullptr;
+}
+
 // Page implementation
 
 void Page::init(uint32_t page_id, uint16_t flags) {
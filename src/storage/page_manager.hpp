@@ -5,11 +5,14 @@
  * @brief Page management for EdgeSQL Lite storage
  */
 
+#include "frame_pool.hpp"
 #include "page.hpp"
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
-#include <list>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -17,10 +20,77 @@
 namespace edgesql {
 namespace storage {
 
+class PageManager;
+
+/**
+ * @brief Outcome of pinning a page
+ */
+enum class PinStatus : uint8_t {
+  OK,        // Pinned
+  NOT_FOUND, // The page does not exist
+  NO_FRAME   // No frame could be freed for it, even after waiting
+};
+
+/**
+ * @brief A page pinned in the buffer pool
+ *
+ * While the guard holds it, the page's frame is never evicted or reused,
+ * so the page can be read and written without the pool's lock. Others
+ * may hold the same page, so rows are read under the shared latch() and
+ * the page changed under the exclusive one. Released by the destructor,
+ * release(), or assigning another guard.
+ */
+class PageGuard {
+public:
+  PageGuard() = default;
+  PageGuard(PageGuard &&other) noexcept;
+  PageGuard &operator=(PageGuard &&other) noexcept;
+  ~PageGuard() { release(); }
+
+  // Non-copyable
+  PageGuard(const PageGuard &) = delete;
+  PageGuard &operator=(const PageGuard &) = delete;
+
+  Page *get() const { return page_; }
+  Page *operator->() const { return page_; }
+  Page &operator*() const { return *page_; }
+  explicit operator bool() const { return page_ != nullptr; }
+
+  /**
+   * @brief Get the page's latch
+   *
+   * The pool latches pages under its own lock, to mark and flush them,
+   * so never call into it while holding the latch: mark a page dirty
+   * after releasing it.
+   */
+  std::shared_mutex &latch() const;
+
+  /**
+   * @brief Unpin the page
+   */
+  void release();
+
+private:
+  friend class PageManager;
+  PageGuard(PageManager *manager, uint32_t slot, Page *page)
+      : manager_(manager), slot_(slot), page_(page) {}
+
+  PageManager *manager_{nullptr};
+  uint32_t slot_{INVALID_SLOT};
+  Page *page_{nullptr};
+};
+
 /**
  * @brief Page manager
  *
- * Manages pages in memory with a simple buffer pool.
+ * Manages pages in memory with a simple buffer pool. Page frames come from
+ * a FramePool sized to max_pages and allocated once up front. Resident
+ * frames are reserved in the global MemoryTracker; under memory pressure
+ * the pool recycles its own frames instead of growing, and shrink() is
+ * registered as a reclaimer so other subsystems can take memory back.
+ *
+ * Neither evicts a pinned page, so a reclaim run from any thread never
+ * pulls a page out from under a reader.
  */
 class PageManager {
 public:
@@ -53,19 +123,50 @@ public:
 
   /**
    * @brief Get a page by ID
+   *
+   * The page is not pinned, so any later call may evict it; only for use
+   * while nothing else touches the pool, as in recovery.
+   *
    * @param table_id Table identifier
    * @param page_id Page identifier
    * @return Pointer to page, or nullptr if not found
    */
   Page *get_page(uint32_t table_id, uint32_t page_id);
 
+  /**
+   * @brief Get a page by ID and pin it
+   *
+   * When no frame is free, asks the MemoryTracker's reclaimers for memory
+   * and waits for pages to be unpinned before giving up with NO_FRAME.
+   *
+   * @param table_id Table identifier
+   * @param page_id Page identifier
+   * @param status Set to why the guard is empty, if not null
+   * @return Guard holding the page, empty if not found or no frame
+   */
+  PageGuard pin_page(uint32_t table_id, uint32_t page_id,
+                     PinStatus *status = nullptr);
+
   /**
    * @brief Allocate a new page
+   *
+   * Reclaims and waits for a frame the way pin_page() does.
+   *
    * @param table_id Table identifier
-   * @return Page ID of new page, or UINT32_MAX on failure
+   * @return Page ID of new page, or UINT32_MAX if no frame could be had
    */
   uint32_t allocate_page(uint32_t table_id);
 
+  /**
+   * @brief Get the number of pages a table has
+   *
+   * Counts pages allocated in this process, or the pages in the table
+   * file for tables not yet written to since startup.
+   *
+   * @param table_id Table identifier
+   */
+  uint32_t table_page_count(uint32_t table_id);
+
   /**
    * @brief Mark a page as dirty
    * @param table_id Table identifier
@@ -97,6 +198,23 @@ public:
    */
   size_t dirty_count() const;
 
+  /**
+   * @brief Evict pages to free memory for other subsystems
+   *
+   * Never shrinks the pool below MIN_RESIDENT_PAGES and never evicts a
+   * pinned page. Skips the pass if the pool is busy rather than blocking
+   * the caller.
+   *
+   * @param bytes Bytes wanted
+   * @return Bytes released
+   */
+  size_t shrink(size_t bytes);
+
+  /**
+   * @brief Get the data directory
+   */
+  const std::string &data_dir() const { return data_dir_; }
+
   /**
    * @brief Create a new table file
    * @param table_id Table identifier
@@ -112,11 +230,22 @@ public:
   bool delete_table_file(uint32_t table_id);
 
 private:
-  struct BufferEntry {
-    uint32_t table_id;
-    uint32_t page_id;
-    std::unique_ptr<Page> page;
-    bool dirty;
+  friend class PageGuard;
+
+  /**
+   * @brief Per-frame metadata, indexed by frame slot
+   *
+   * The LRU list is threaded through the table by slot, so touching a
+   * page is a few index writes with no list node allocation.
+   */
+  struct FrameEntry {
+    uint32_t table_id{0};
+    uint32_t page_id{0};
+    uint32_t lru_prev{INVALID_SLOT}; // Towards most recently used
+    uint32_t lru_next{INVALID_SLOT}; // Towards least recently used
+    uint32_t pins{0};
+    bool dirty{false};
+    bool dropped{false}; // Table deleted while pinned; freed on last unpin
   };
 
   using PageKey = std::pair<uint32_t, uint32_t>; // (table_id, page_id)
@@ -128,22 +257,40 @@ private:
     }
   };
 
-  bool load_page(uint32_t table_id, uint32_t page_id);
+  static constexpr size_t MIN_RESIDENT_PAGES = 16;
+  static constexpr int FRAME_WAIT_ATTEMPTS = 20;
+  static constexpr std::chrono::milliseconds FRAME_WAIT{10};
+
+  uint32_t find_page(uint32_t table_id, uint32_t page_id,
+                     bool *no_frame = nullptr);
+  uint32_t load_page(uint32_t table_id, uint32_t page_id, bool *no_frame);
+  void wait_for_frame(std::unique_lock<std::mutex> &lock);
+  void unpin(uint32_t slot);
   bool write_page(uint32_t table_id, uint32_t page_id, const Page *page);
-  void evict_page();
+  uint32_t acquire_frame();
+  void release_frame(uint32_t slot, bool discard = false);
+  bool evict_page(bool discard = false);
+  void drop_page(uint32_t slot, bool discard);
+  void lru_push_front(uint32_t slot);
+  void lru_unlink(uint32_t slot);
+  uint32_t &next_page_id_locked(uint32_t table_id);
   std::string table_file_path(uint32_t table_id) const;
 
   std::string data_dir_;
   size_t max_pages_;
+  FramePool frames_;
 
   mutable std::mutex mutex_;
-  std::unordered_map<PageKey, BufferEntry, PageKeyHash> buffer_pool_;
-  std::list<PageKey> lru_list_; // For LRU eviction
-  std::unordered_map<PageKey, std::list<PageKey>::iterator, PageKeyHash>
-      lru_map_;
+  std::condition_variable frame_released_; // A pin dropped to zero
+  std::vector<FrameEntry> frame_table_;    // Indexed by frame slot
+  std::unique_ptr<std::shared_mutex[]> latches_; // By frame slot
+  std::unordered_map<PageKey, uint32_t, PageKeyHash> page_table_; // -> slot
+  uint32_t lru_head_{INVALID_SLOT}; // Most recently used
+  uint32_t lru_tail_{INVALID_SLOT}; // Least recently used
 
   std::unordered_map<uint32_t, uint32_t>
-      next_page_id_; // Per-table next page ID
+      next_page_id_;         // Per-table next page ID
+  uint64_t reclaimer_id_{0}; // MemoryTracker reclaimer handle
 };
 
 } // namespace storage
@@ -0,0 +1,219 @@
+/**
+ * @file pax_page.cpp
+ * @brief PAX page implementation
+ */
+
+#include "pax_page.hpp"
+#include <cstring>
+
+namespace edgesql {
+namespace storage {
+
+namespace {
+
+bool is_variable(ColumnType type) {
+  return type == ColumnType::TEXT || type == ColumnType::BLOB;
+}
+
+size_t value_width(ColumnType type) {
+  switch (type) {
+  case ColumnType::INTEGER:
+  case ColumnType::FLOAT:
+    return 8;
+  case ColumnType::TEXT:
+  case ColumnType::BLOB:
+    return sizeof(PaxVarEntry);
+  default:
+    return 1;
+  }
+}
+
+size_t align_up(size_t value, size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+PaxHeader &pax_header(Page &page) {
+  return *reinterpret_cast<PaxHeader *>(page.data() + sizeof(PageHeader));
+}
+
+PaxColumn *pax_columns(Page &page) {
+  return reinterpret_cast<PaxColumn *>(page.data() + sizeof(PageHeader) +
+                                       sizeof(PaxHeader));
+}
+
+} // anonymous namespace
+
+PaxPage::PaxPage(const Page &page)
+    : base_(page.data()),
+      header_(reinterpret_cast<const PaxHeader *>(base_ + sizeof(PageHeader))),
+      columns_(reinterpret_cast<const PaxColumn *>(
+          base_ + sizeof(PageHeader) + sizeof(PaxHeader))) {}
+
+bool PaxPage::init(Page &page, uint32_t page_id,
+                   const std::vector<ColumnType> &types) {
+  size_t column_count = types.size();
+  size_t directory_end = sizeof(PageHeader) + sizeof(PaxHeader) +
+                         column_count * sizeof(PaxColumn);
+  if (column_count == 0 || directory_end >= PAGE_SIZE) {
+    return false;
+  }
+
+  size_t fixed_bytes = 0;
+  size_t heap_bytes = 0;
+  for (ColumnType type : types) {
+    fixed_bytes += value_width(type);
+    if (is_variable(type)) {
+      heap_bytes += VAR_RESERVE_BYTES;
+    }
+  }
+
+  // First guess ignores alignment padding; shrink until the layout fits
+  size_t available = PAGE_SIZE - directory_end;
+  size_t capacity =
+      available * 8 / ((fixed_bytes + heap_bytes) * 8 + column_count);
+
+  size_t layout_end = 0;
+  while (capacity > 0) {
+    layout_end = directory_end;
+    for (ColumnType type : types) {
+      layout_end += (capacity + 7) / 8;
+      layout_end = align_up(layout_end, value_width(type));
+      layout_end += capacity * value_width(type);
+    }
+    if (layout_end + capacity * heap_bytes <= PAGE_SIZE) {
+      break;
+    }
+    capacity--;
+  }
+  if (capacity == 0) {
+    return false;
+  }
+
+  page.init(page_id, PageHeader::FLAG_LEAF | PageHeader::FLAG_PAX);
+
+  PaxHeader &header = pax_header(page);
+  header.column_count = static_cast<uint16_t>(column_count);
+  header.capacity = static_cast<uint16_t>(capacity);
+  header.row_count = 0;
+  header.heap_start = static_cast<uint16_t>(PAGE_SIZE);
+  header.minipage_end = static_cast<uint16_t>(layout_end);
+
+  // Bitmaps and values start zeroed by Page::init
+  PaxColumn *columns = pax_columns(page);
+  size_t offset = directory_end;
+  for (size_t i = 0; i < column_count; ++i) {
+    size_t width = value_width(types[i]);
+    columns[i].type = static_cast<uint8_t>(types[i]);
+    columns[i].width = static_cast<uint8_t>(width);
+    columns[i].nulls = static_cast<uint16_t>(offset);
+    offset = align_up(offset + (capacity + 7) / 8, width);
+    columns[i].values = static_cast<uint16_t>(offset);
+    offset += capacity * width;
+  }
+
+  page.header().data_start = header.heap_start;
+  page.header().free_space =
+      static_cast<uint16_t>(header.heap_start - header.minipage_end);
+  return true;
+}
+
+bool PaxPage::append(Page &page, const Record &record) {
+  PaxHeader &header = pax_header(page);
+  if (header.row_count >= header.capacity ||
+      record.column_count() != header.column_count) {
+    return false;
+  }
+
+  PaxColumn *columns = pax_columns(page);
+
+  // Variable-length values must fit between the minipages and the heap
+  size_t heap_needed = 0;
+  for (size_t i = 0; i < header.column_count; ++i) {
+    auto type = static_cast<ColumnType>(columns[i].type);
+    if (record.is_null(i)) {
+      continue;
+    }
+    if (type == ColumnType::TEXT) {
+      heap_needed += record.get_text(i).size();
+    } else if (type == ColumnType::BLOB) {
+      heap_needed += record.get_blob(i).size();
+    }
+  }
+  if (static_cast<size_t>(header.heap_start - header.minipage_end) <
+      heap_needed) {
+    return false;
+  }
+
+  uint16_t row = header.row_count;
+  uint8_t *base = page.data();
+
+  for (size_t i = 0; i < header.column_count; ++i) {
+    const PaxColumn &column = columns[i];
+    uint8_t *slot = base + column.values + row * column.width;
+
+    if (record.is_null(i)) {
+      base[column.nulls + row / 8] |= static_cast<uint8_t>(1u << (row % 8));
+      continue;
+    }
+
+    switch (static_cast<ColumnType>(column.type)) {
+    case ColumnType::INTEGER: {
+      int64_t v = record.get_integer(i);
+      std::memcpy(slot, &v, sizeof(v));
+      break;
+    }
+    case ColumnType::FLOAT: {
+      double v = record.get_float(i);
+      std::memcpy(slot, &v, sizeof(v));
+      break;
+    }
+    case ColumnType::BOOLEAN:
+      *slot = record.get_boolean(i) ? 1 : 0;
+      break;
+    case ColumnType::TEXT:
+    case ColumnType::BLOB: {
+      const uint8_t *data;
+      size_t length;
+      if (static_cast<ColumnType>(column.type) == ColumnType::TEXT) {
+        const std::string &text = record.get_text(i);
+        data = reinterpret_cast<const uint8_t *>(text.data());
+        length = text.size();
+      } else {
+        const std::vector<uint8_t> &blob = record.get_blob(i);
+        data = blob.data();
+        length = blob.size();
+      }
+
+      header.heap_start = static_cast<uint16_t>(header.heap_start - length);
+      std::memcpy(base + header.heap_start, data, length);
+
+      PaxVarEntry entry{header.heap_start, static_cast<uint16_t>(length)};
+      std::memcpy(slot, &entry, sizeof(entry));
+      break;
+    }
+    case ColumnType::NULLTYPE:
+      break;
+    }
+  }
+
+  header.row_count++;
+
+  PageHeader &page_header = page.header();
+  page_header.data_start = header.heap_start;
+  page_header.free_space =
+      static_cast<uint16_t>(header.heap_start - header.minipage_end);
+  page_header.set_dirty(true);
+  return true;
+}
+
+std::string_view PaxPage::text(size_t column, uint16_t row) const {
+  PaxVarEntry entry;
+  std::memcpy(&entry,
+              base_ + columns_[column].values + row * sizeof(PaxVarEntry),
+              sizeof(entry));
+  return std::string_view(reinterpret_cast<const char *>(base_) + entry.offset,
+                          entry.length);
+}
+
+} // namespace storage
+} // namespace edgesql
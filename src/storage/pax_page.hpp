@@ -0,0 +1,168 @@
+#pragma once
+
+/**
+ * @file pax_page.hpp
+ * @brief Columnar (PAX) page layout
+ */
+
+#include "page.hpp"
+#include "record.hpp"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace edgesql {
+namespace storage {
+
+/**
+ * @brief PAX page header, following the PageHeader
+ */
+struct PaxHeader {
+  uint16_t column_count; // Columns in the page
+  uint16_t capacity;     // Rows the minipages have room for
+  uint16_t row_count;    // Rows stored
+  uint16_t heap_start;   // Start of the variable-length heap (grows down)
+  uint16_t minipage_end; // End of the last minipage
+  uint16_t reserved[3];
+};
+
+static_assert(sizeof(PaxHeader) == 16, "PaxHeader must be 16 bytes");
+
+/**
+ * @brief Column directory entry
+ */
+struct PaxColumn {
+  uint8_t type;    // ColumnType
+  uint8_t width;   // Bytes per value in the minipage
+  uint16_t nulls;  // Offset of the null bitmap (bit set = NULL)
+  uint16_t values; // Offset of the value minipage
+  uint16_t reserved;
+};
+
+static_assert(sizeof(PaxColumn) == 8, "PaxColumn must be 8 bytes");
+
+/**
+ * @brief Text/blob minipage entry pointing into the heap
+ */
+struct PaxVarEntry {
+  uint16_t offset;
+  uint16_t length;
+};
+
+/**
+ * @brief Read-only view of a PAX page
+ *
+ * +------------------------+
+ * | PageHeader (FLAG_PAX)  |
+ * | PaxHeader              |
+ * | PaxColumn[n]           |
+ * +------------------------+
+ * | null bitmap 0          |
+ * | minipage 0 (values)    |
+ * | null bitmap 1          |
+ * | minipage 1 (values)    |
+ * | ...                    |
+ * +------------------------+
+ * | Free Space             |
+ * +------------------------+
+ * | Text/blob heap         |
+ * +------------------------+
+ *
+ * Each column's values are contiguous, so a scan that needs two columns
+ * of a wide table touches only their minipages, and fixed-width columns
+ * are dense arrays ready for vectorized filters. Fixed-width minipages
+ * are aligned to their value width.
+ */
+class PaxPage {
+public:
+  // Heap bytes budgeted per row for each text/blob column when sizing
+  static constexpr size_t VAR_RESERVE_BYTES = 16;
+
+  /**
+   * @brief Constructor
+   * @param page Page with FLAG_PAX set
+   */
+  explicit PaxPage(const Page &page);
+
+  /**
+   * @brief Format a page as an empty PAX page
+   * @param page Page to format
+   * @param page_id Page identifier
+   * @param types Column types in table order
+   * @return false if the columns do not fit in one page
+   */
+  static bool init(Page &page, uint32_t page_id,
+                   const std::vector<ColumnType> &types);
+
+  /**
+   * @brief Append a row
+   * @param page PAX page
+   * @param record Row with one value per column
+   * @return false if the page is full
+   */
+  static bool append(Page &page, const Record &record);
+
+  /**
+   * @brief Check if a page uses the PAX layout
+   */
+  static bool is_pax(const Page &page) { return page.header().is_pax(); }
+
+  uint16_t row_count() const { return header_->row_count; }
+  uint16_t capacity() const { return header_->capacity; }
+  uint16_t column_count() const { return header_->column_count; }
+
+  /**
+   * @brief Get the type of a column
+   */
+  ColumnType column_type(size_t column) const {
+    return static_cast<ColumnType>(columns_[column].type);
+  }
+
+  /**
+   * @brief Get a column's null bitmap (bit set = NULL)
+   */
+  const uint8_t *null_bitmap(size_t column) const {
+    return base_ + columns_[column].nulls;
+  }
+
+  /**
+   * @brief Check if a value is NULL
+   */
+  bool is_null(size_t column, uint16_t row) const {
+    return null_bitmap(column)[row / 8] & (1u << (row % 8));
+  }
+
+  /**
+   * @brief Get an INTEGER minipage
+   */
+  const int64_t *int_values(size_t column) const {
+    return reinterpret_cast<const int64_t *>(base_ + columns_[column].values);
+  }
+
+  /**
+   * @brief Get a FLOAT minipage
+   */
+  const double *float_values(size_t column) const {
+    return reinterpret_cast<const double *>(base_ + columns_[column].values);
+  }
+
+  /**
+   * @brief Get a BOOLEAN minipage (one byte per row)
+   */
+  const uint8_t *bool_values(size_t column) const {
+    return base_ + columns_[column].values;
+  }
+
+  /**
+   * @brief Get a TEXT or BLOB value
+   */
+  std::string_view text(size_t column, uint16_t row) const;
+
+private:
+  const uint8_t *base_;
+  const PaxHeader *header_;
+  const PaxColumn *columns_;
+};
+
+} // namespace storage
+} // namespace edgesql
@@ -0,0 +1,249 @@
+/**
+ * @file record.cpp
+ * @brief Record implementation
+ */
+
+#include "record.hpp"
+#include <cstddef>
+
+namespace edgesql {
+namespace storage {
+
+namespace {
+
+const std::string empty_text;
+const std::vector<uint8_t> empty_blob;
+
+// Encoded size of one column value, including its type byte
+size_t value_size(const ColumnValue &value) {
+  size_t size = 1;
+  switch (value.index()) {
+  case 1: // INTEGER
+    size += sizeof(int64_t);
+    break;
+  case 2: // FLOAT
+    size += sizeof(double);
+    break;
+  case 3: // TEXT
+    size += sizeof(uint32_t) + std::get<std::string>(value).size();
+    break;
+  case 4: // BLOB
+    size += sizeof(uint32_t) + std::get<std::vector<uint8_t>>(value).size();
+    break;
+  case 5: // BOOLEAN
+    size += 1;
+    break;
+  default:
+    break;
+  }
+  return size;
+}
+
+} // anonymous namespace
+
+Record::Record(size_t column_count) : values_(column_count) {}
+
+void Record::set_null(size_t index) { values_[index] = std::monostate{}; }
+
+void Record::set_integer(size_t index, int64_t value) {
+  values_[index] = value;
+}
+
+void Record::set_float(size_t index, double value) { values_[index] = value; }
+
+void Record::set_text(size_t index, const std::string &value) {
+  values_[index] = value;
+}
+
+void Record::set_blob(size_t index, const std::vector<uint8_t> &value) {
+  values_[index] = value;
+}
+
+void Record::set_boolean(size_t index, bool value) { values_[index] = value; }
+
+bool Record::is_null(size_t index) const {
+  return std::holds_alternative<std::monostate>(values_[index]);
+}
+
+int64_t Record::get_integer(size_t index) const {
+  const auto *value = std::get_if<int64_t>(&values_[index]);
+  return value ? *value : 0;
+}
+
+double Record::get_float(size_t index) const {
+  const auto *value = std::get_if<double>(&values_[index]);
+  return value ? *value : 0.0;
+}
+
+const std::string &Record::get_text(size_t index) const {
+  const auto *value = std::get_if<std::string>(&values_[index]);
+  return value ? *value : empty_text;
+}
+
+const std::vector<uint8_t> &Record::get_blob(size_t index) const {
+  const auto *value = std::get_if<std::vector<uint8_t>>(&values_[index]);
+  return value ? *value : empty_blob;
+}
+
+bool Record::get_boolean(size_t index) const {
+  const auto *value = std::get_if<bool>(&values_[index]);
+  return value ? *value : false;
+}
+
+ColumnType Record::get_type(size_t index) const {
+  switch (values_[index].index()) {
+  case 1:
+    return ColumnType::INTEGER;
+  case 2:
+    return ColumnType::FLOAT;
+  case 3:
+    return ColumnType::TEXT;
+  case 4:
+    return ColumnType::BLOB;
+  case 5:
+    return ColumnType::BOOLEAN;
+  default:
+    return ColumnType::NULLTYPE;
+  }
+}
+
+size_t Record::serialized_size() const {
+  size_t size = sizeof(RecordHeader);
+  for (const auto &value : values_) {
+    size += value_size(value);
+  }
+  return size;
+}
+
+size_t Record::serialize(uint8_t *buffer, size_t buffer_size) const {
+  size_t size = serialized_size();
+  if (size > buffer_size || values_.size() > UINT16_MAX) {
+    return 0;
+  }
+
+  RecordHeader header{};
+  header.size = static_cast<uint32_t>(size);
+  header.column_count = static_cast<uint16_t>(values_.size());
+  header.flags = RecordHeader::FLAG_NONE;
+  std::memcpy(buffer, &header, sizeof(header));
+
+  uint8_t *out = buffer + sizeof(header);
+  for (size_t i = 0; i < values_.size(); ++i) {
+    *out++ = static_cast<uint8_t>(get_type(i));
+
+    switch (get_type(i)) {
+    case ColumnType::INTEGER: {
+      int64_t v = get_integer(i);
+      std::memcpy(out, &v, sizeof(v));
+      out += sizeof(v);
+      break;
+    }
+    case ColumnType::FLOAT: {
+      double v = get_float(i);
+      std::memcpy(out, &v, sizeof(v));
+      out += sizeof(v);
+      break;
+    }
+    case ColumnType::TEXT: {
+      const std::string &v = get_text(i);
+      uint32_t length = static_cast<uint32_t>(v.size());
+      std::memcpy(out, &length, sizeof(length));
+      std::memcpy(out + sizeof(length), v.data(), length);
+      out += sizeof(length) + length;
+      break;
+    }
+    case ColumnType::BLOB: {
+      const std::vector<uint8_t> &v = get_blob(i);
+      uint32_t length = static_cast<uint32_t>(v.size());
+      std::memcpy(out, &length, sizeof(length));
+      std::memcpy(out + sizeof(length), v.data(), length);
+      out += sizeof(length) + length;
+      break;
+    }
+    case ColumnType::BOOLEAN:
+      *out++ = get_boolean(i) ? 1 : 0;
+      break;
+    case ColumnType::NULLTYPE:
+      break;
+    }
+  }
+
+  return size;
+}
+
+bool Record::deserialize(const uint8_t *data, size_t length) {
+  if (length < sizeof(RecordHeader)) {
+    return false;
+  }
+
+  RecordHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  if (header.size > length || header.is_deleted()) {
+    return false;
+  }
+
+  const uint8_t *in = data + sizeof(header);
+  const uint8_t *end = data + header.size;
+  values_.assign(header.column_count, std::monostate{});
+
+  for (size_t i = 0; i < values_.size(); ++i) {
+    if (in >= end) {
+      return false;
+    }
+    auto type = static_cast<ColumnType>(*in++);
+
+    switch (type) {
+    case ColumnType::INTEGER:
+    case ColumnType::FLOAT: {
+      if (end - in < 8) {
+        return false;
+      }
+      if (type == ColumnType::INTEGER) {
+        int64_t v;
+        std::memcpy(&v, in, sizeof(v));
+        values_[i] = v;
+      } else {
+        double v;
+        std::memcpy(&v, in, sizeof(v));
+        values_[i] = v;
+      }
+      in += 8;
+      break;
+    }
+    case ColumnType::TEXT:
+    case ColumnType::BLOB: {
+      uint32_t size;
+      if (end - in < static_cast<std::ptrdiff_t>(sizeof(size))) {
+        return false;
+      }
+      std::memcpy(&size, in, sizeof(size));
+      in += sizeof(size);
+      if (static_cast<size_t>(end - in) < size) {
+        return false;
+      }
+      if (type == ColumnType::TEXT) {
+        values_[i] = std::string(reinterpret_cast<const char *>(in), size);
+      } else {
+        values_[i] = std::vector<uint8_t>(in, in + size);
+      }
+      in += size;
+      break;
+    }
+    case ColumnType::BOOLEAN:
+      if (in >= end) {
+        return false;
+      }
+      values_[i] = *in++ != 0;
+      break;
+    case ColumnType::NULLTYPE:
+      break;
+    default:
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // namespace storage
+} // namespace edgesql
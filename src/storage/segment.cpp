@@ -4,10 +4,15 @@
  */
 
 #include "segment.hpp"
+#include "encoded_page.hpp"
+#include "pax_page.hpp"
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <fcntl.h>
 #include <filesystem>
 #include <iostream>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -36,8 +41,12 @@ bool Segment::create() {
   }
 
   page_count_ = 0;
+  tail_.reset();
+  tail_dirty_ = false;
   created_lsn_ = 0;
   max_lsn_ = 0;
+  min_time_ = INT64_MAX;
+  max_time_ = INT64_MIN;
 
   if (!write_header()) {
     ::close(fd_);
@@ -72,11 +81,19 @@ bool Segment::open() {
 void Segment::close() {
   std::lock_guard<std::mutex> lock(mutex_);
 
+  const uint8_t *mapping = mapping_.exchange(nullptr);
+  if (mapping) {
+    munmap(const_cast<uint8_t *>(mapping), mapping_size_);
+    mapping_size_ = 0;
+  }
+
   if (fd_ >= 0) {
+    flush_tail();
     fsync(fd_);
     ::close(fd_);
     fd_ = -1;
   }
+  tail_.reset();
 }
 
 bool Segment::read_page(uint32_t page_offset, Page *page) {
@@ -85,6 +102,10 @@ bool Segment::read_page(uint32_t page_offset, Page *page) {
   if (fd_ < 0 || page_offset >= page_count_) {
     return false;
   }
+  if (tail_ && page_offset + 1 == page_count_) {
+    std::memcpy(page->data(), tail_->data(), PAGE_SIZE);
+    return true;
+  }
 
   off_t offset =
       sizeof(SegmentHeader) + static_cast<off_t>(page_offset) * PAGE_SIZE;
@@ -96,7 +117,7 @@ bool Segment::read_page(uint32_t page_offset, Page *page) {
 bool Segment::write_page(uint32_t page_offset, const Page *page) {
   std::lock_guard<std::mutex> lock(mutex_);
 
-  if (fd_ < 0 || page_offset > page_count_) {
+  if (fd_ < 0 || is_sealed() || page_offset > page_count_) {
     return false;
   }
 
@@ -107,19 +128,28 @@ bool Segment::write_page(uint32_t page_offset, const Page *page) {
   if (bytes_written != static_cast<ssize_t>(PAGE_SIZE)) {
     return false;
   }
+  if (tail_ && page_offset + 1 == page_count_) {
+    std::memcpy(tail_->data(), page->data(), PAGE_SIZE);
+    tail_dirty_ = false;
+  }
 
   // Update max LSN
   if (page->header().lsn > max_lsn_) {
     max_lsn_ = page->header().lsn;
   }
 
+  // Rows on the page may have widened the time range
+  if (time_dirty_) {
+    write_header();
+  }
+
   return true;
 }
 
 uint32_t Segment::append_page(const Page *page) {
   std::lock_guard<std::mutex> lock(mutex_);
 
-  if (fd_ < 0) {
+  if (fd_ < 0 || is_sealed() || !flush_tail()) {
     return UINT32_MAX;
   }
 
@@ -132,7 +162,13 @@ uint32_t Segment::append_page(const Page *page) {
     return UINT32_MAX;
   }
 
-  page_count_++;
+  page_count_.store(page_offset + 1, std::memory_order_release);
+
+  // The new page is the one rows are added to next
+  if (!tail_) {
+    tail_ = std::make_unique<Page>();
+  }
+  std::memcpy(tail_->data(), page->data(), PAGE_SIZE);
 
   // Update max LSN
   if (page->header().lsn > max_lsn_) {
@@ -148,13 +184,103 @@ uint32_t Segment::append_page(const Page *page) {
 bool Segment::sync() {
   std::lock_guard<std::mutex> lock(mutex_);
 
-  if (fd_ < 0) {
+  if (fd_ < 0 || !flush_tail()) {
     return false;
   }
 
   return fsync(fd_) == 0;
 }
 
+bool Segment::seal() {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (fd_ < 0) {
+    return false;
+  }
+
+  // Header and pages must be durable before readers map the file
+  if (!flush_tail() || !write_header() || fsync(fd_) != 0) {
+    return false;
+  }
+
+  sealed_.store(true, std::memory_order_release);
+  tail_.reset(); // Reads go through the mapping from now on
+  return true;
+}
+
+bool Segment::map_readonly() {
+  if (mapping_.load(std::memory_order_acquire)) {
+    return true;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (mapping_.load(std::memory_order_acquire)) {
+    return true;
+  }
+  if (fd_ < 0 || !is_sealed() || page_count_ == 0) {
+    return false;
+  }
+
+  size_t size = sizeof(SegmentHeader) + static_cast<size_t>(page_count_) *
+                                            PAGE_SIZE;
+  void *addr = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd_, 0);
+  if (addr == MAP_FAILED) {
+    return false;
+  }
+
+  // Scans walk the file front to back; start read-ahead now
+  madvise(addr, size, MADV_SEQUENTIAL);
+  madvise(addr, size, MADV_WILLNEED);
+
+  mapping_size_ = size;
+  mapping_.store(static_cast<const uint8_t *>(addr),
+                 std::memory_order_release);
+  return true;
+}
+
+const Page *Segment::mapped_page(uint32_t page_offset) const {
+  const uint8_t *mapping = mapping_.load(std::memory_order_acquire);
+  if (!mapping || page_offset >= page_count()) {
+    return nullptr;
+  }
+
+  // Pages follow the 48-byte header, so they stay 8-byte aligned
+  return reinterpret_cast<const Page *>(
+      mapping + sizeof(SegmentHeader) +
+      static_cast<size_t>(page_offset) * PAGE_SIZE);
+}
+
+const Page *Segment::scan_page(uint32_t page_offset, Page &scratch) {
+  if (is_sealed() && map_readonly()) {
+    return mapped_page(page_offset);
+  }
+  return read_page(page_offset, &scratch) ? &scratch : nullptr;
+}
+
+void Segment::extend_time_range(int64_t time) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (time < min_time_.load(std::memory_order_relaxed)) {
+    min_time_.store(time, std::memory_order_release);
+    time_dirty_ = true;
+  }
+  if (time > max_time_.load(std::memory_order_relaxed)) {
+    max_time_.store(time, std::memory_order_release);
+    time_dirty_ = true;
+  }
+}
+
+bool Segment::rename_to(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (::rename(path_.c_str(), path.c_str()) != 0) {
+    return false;
+  }
+  path_ = path;
+  return true;
+}
+
 bool Segment::write_header() {
   SegmentHeader header{};
   header.magic = SegmentHeader::SEGMENT_MAGIC;
@@ -163,9 +289,56 @@ bool Segment::write_header() {
   header.page_count = page_count_;
   header.created_lsn = created_lsn_;
   header.max_lsn = max_lsn_;
+  header.min_time = min_time_.load(std::memory_order_relaxed);
+  header.max_time = max_time_.load(std::memory_order_relaxed);
 
   ssize_t bytes_written = pwrite(fd_, &header, sizeof(header), 0);
-  return bytes_written == static_cast<ssize_t>(sizeof(header));
+  if (bytes_written != static_cast<ssize_t>(sizeof(header))) {
+    return false;
+  }
+  time_dirty_ = false;
+  return true;
+}
+
+Page *Segment::tail_page() {
+  if (fd_ < 0 || is_sealed() || page_count_ == 0) {
+    return nullptr;
+  }
+  if (tail_) {
+    return tail_.get();
+  }
+
+  auto page = std::make_unique<Page>();
+  off_t offset = sizeof(SegmentHeader) +
+                 static_cast<off_t>(page_count_ - 1) * PAGE_SIZE;
+  if (pread(fd_, page->data(), PAGE_SIZE, offset) !=
+      static_cast<ssize_t>(PAGE_SIZE)) {
+    return nullptr;
+  }
+  tail_ = std::move(page);
+  tail_dirty_ = false;
+  return tail_.get();
+}
+
+bool Segment::flush_tail() {
+  if (!tail_dirty_) {
+    return true;
+  }
+
+  off_t offset = sizeof(SegmentHeader) +
+                 static_cast<off_t>(page_count_ - 1) * PAGE_SIZE;
+  if (pwrite(fd_, tail_->data(), PAGE_SIZE, offset) !=
+      static_cast<ssize_t>(PAGE_SIZE)) {
+    return false;
+  }
+  tail_dirty_ = false;
+
+  if (tail_->header().lsn > max_lsn_) {
+    max_lsn_ = tail_->header().lsn;
+  }
+
+  // Rows on the page may have widened the time range
+  return !time_dirty_ || write_header();
 }
 
 bool Segment::read_header() {
@@ -187,20 +360,221 @@ bool Segment::read_header() {
   page_count_ = header.page_count;
   created_lsn_ = header.created_lsn;
   max_lsn_ = header.max_lsn;
+  min_time_ = header.min_time;
+  max_time_ = header.max_time;
 
   return true;
 }
 
 // SegmentManager implementation
 
+namespace {
+
+constexpr uint32_t MANIFEST_MAGIC = 0x4E414D53; // "SMAN"
+constexpr uint32_t MANIFEST_VERSION = 2;
+
+uint64_t usage_key(uint32_t table_id, uint32_t segment_id) {
+  return static_cast<uint64_t>(table_id) << 32 | segment_id;
+}
+
+bool is_columnar(const Page &page) {
+  return PaxPage::is_pax(page) || EncodedPage::is_encoded(page);
+}
+
+ZoneMap zone_map_of(const std::vector<ColumnVector> &columns) {
+  ZoneMap zones(columns.size());
+  for (size_t c = 0; c < columns.size(); ++c) {
+    const ColumnVector &column = columns[c];
+    if (column.type != ColumnType::INTEGER) {
+      zones[c].integer = false;
+      continue;
+    }
+    for (size_t r = 0; r < column.size(); ++r) {
+      if (!column.nulls[r]) {
+        zones[c].extend(column.ints[r]);
+      }
+    }
+  }
+  return zones;
+}
+
+void extend_zone_map(ZoneMap &zones, const Record &record) {
+  if (zones.size() < record.column_count()) {
+    zones.resize(record.column_count());
+  }
+  for (size_t c = 0; c < record.column_count(); ++c) {
+    if (record.is_null(c)) {
+      continue;
+    }
+    if (record.get_type(c) == ColumnType::INTEGER) {
+      zones[c].extend(record.get_integer(c));
+    } else {
+      zones[c].integer = false;
+    }
+  }
+}
+
+/**
+ * @brief Gather every row of a segment of PAX or encoded pages
+ * @return false if the segment holds row pages or differing schemas
+ */
+bool gather_segment(Segment &segment, std::vector<ColumnVector> &columns,
+                    uint64_t &max_lsn, bool &all_encoded) {
+  all_encoded = true;
+  for (uint32_t offset = 0; offset < segment.page_count(); ++offset) {
+    const Page *page = segment.mapped_page(offset);
+    if (!page || !page->header().is_valid()) {
+      continue;
+    }
+    if (!EncodedPage::gather(*page, columns)) {
+      return false;
+    }
+    all_encoded = all_encoded && EncodedPage::is_encoded(*page);
+    max_lsn = std::max(max_lsn, page->header().lsn);
+  }
+  return !columns.empty();
+}
+
+/**
+ * @brief Spreads page writes out to a target rate
+ */
+class Throttle {
+public:
+  explicit Throttle(size_t pages_per_second)
+      : pages_per_second_(pages_per_second),
+        start_(std::chrono::steady_clock::now()) {}
+
+  void page_written() {
+    if (pages_per_second_ == 0) {
+      return;
+    }
+    pages_++;
+    std::this_thread::sleep_until(
+        start_ + std::chrono::microseconds(pages_ * 1000000 /
+                                           pages_per_second_));
+  }
+
+private:
+  size_t pages_per_second_;
+  size_t pages_{0};
+  std::chrono::steady_clock::time_point start_;
+};
+
+bool write_encoded(Segment &out, const std::vector<ColumnVector> &columns,
+                   uint64_t lsn, Throttle *throttle) {
+  Page page;
+  size_t rows = columns[0].size();
+  size_t hint = EncodedPage::MAX_ROWS;
+  uint32_t page_id = 0;
+  for (size_t begin = 0; begin < rows;) {
+    size_t packed = EncodedPage::pack(page, page_id++, columns, begin, hint);
+    if (packed == 0) {
+      return false;
+    }
+    page.header().lsn = lsn;
+    if (out.append_page(&page) == UINT32_MAX) {
+      return false;
+    }
+    if (throttle) {
+      throttle->page_written();
+    }
+    begin += packed;
+    hint = packed;
+  }
+  return true;
+}
+
+/**
+ * @brief Copy the live records of row pages densely into a segment
+ */
+bool write_live_records(Segment &out, const std::vector<Segment *> &sources,
+                        ZoneMap &zones, Throttle &throttle) {
+  Page page;
+  uint32_t page_id = 0;
+  uint64_t lsn = 0;
+  bool pending = false;
+  Record record;
+
+  auto flush = [&]() {
+    page.header().lsn = lsn;
+    if (out.append_page(&page) == UINT32_MAX) {
+      return false;
+    }
+    throttle.page_written();
+    pending = false;
+    return true;
+  };
+
+  for (Segment *source : sources) {
+    for (uint32_t offset = 0; offset < source->page_count(); ++offset) {
+      const Page *src = source->mapped_page(offset);
+      if (!src || !src->header().is_valid()) {
+        continue;
+      }
+
+      for (uint16_t slot = 0; slot < src->slot_count(); ++slot) {
+        const uint8_t *data;
+        uint16_t length;
+        if (!src->get_record(slot, &data, &length)) {
+          continue; // Deleted
+        }
+        if (record.deserialize(data, length)) {
+          extend_zone_map(zones, record);
+        }
+
+        uint16_t slot_index;
+        if (!pending) {
+          page.init(page_id++);
+          lsn = 0;
+          pending = true;
+        }
+        if (!page.insert_record(data, length, &slot_index)) {
+          if (!flush()) {
+            return false;
+          }
+          page.init(page_id++);
+          lsn = 0;
+          pending = true;
+          if (!page.insert_record(data, length, &slot_index)) {
+            return false;
+          }
+        }
+        lsn = std::max(lsn, src->header().lsn);
+      }
+    }
+  }
+
+  return !pending || flush();
+}
+
+template <typename T> void put(std::vector<uint8_t> &out, T value) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(value));
+}
+
+template <typename T>
+bool get(const std::vector<uint8_t> &in, size_t &at, T &value) {
+  if (in.size() - at < sizeof(value)) {
+    return false;
+  }
+  std::memcpy(&value, in.data() + at, sizeof(value));
+  at += sizeof(value);
+  return true;
+}
+
+} // anonymous namespace
+
 SegmentManager::SegmentManager(const std::string &data_dir,
                                const SegmentConfig &config)
     : data_dir_(data_dir), config_(config) {}
 
-SegmentManager::~SegmentManager() { flush_all(); }
+SegmentManager::~SegmentManager() {
+  stop_compactor();
+  flush_all();
+}
 
 bool SegmentManager::init() {
-  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_lock<std::mutex> lock(mutex_);
 
   // Create data directory if it doesn't exist
   std::error_code ec;
@@ -211,10 +585,25 @@ bool SegmentManager::init() {
     }
   }
 
+  bool has_manifest = std::filesystem::exists(manifest_path());
+  if (has_manifest && !load_manifest()) {
+    std::cerr << "Failed to read segment manifest: " << manifest_path()
+              << "\n";
+    return false;
+  }
+
   // Scan for existing segment files
   for (const auto &entry : std::filesystem::directory_iterator(data_dir_)) {
     if (entry.is_regular_file()) {
       std::string filename = entry.path().filename().string();
+
+      // Leftover of an encoding rewrite that never got renamed into place
+      if (filename.size() > 4 &&
+          filename.substr(filename.length() - 4) == ".enc") {
+        std::filesystem::remove(entry.path(), ec);
+        continue;
+      }
+
       // Parse segment filename: segment_<table_id>_<segment_id>.seg
       if (filename.substr(0, 8) == "segment_" &&
           filename.substr(filename.length() - 4) == ".seg") {
@@ -230,6 +619,15 @@ bool SegmentManager::init() {
               filename.substr(second_underscore + 1,
                               filename.length() - second_underscore - 5));
 
+          // With a manifest, unlisted files are from a compaction or
+          // rotation that never committed
+          if (has_manifest) {
+            if (!find_segment(table_id, segment_id)) {
+              std::filesystem::remove(entry.path(), ec);
+            }
+            continue;
+          }
+
           auto segment = std::make_unique<Segment>(entry.path().string(),
                                                    table_id, segment_id);
 
@@ -240,6 +638,7 @@ bool SegmentManager::init() {
             if (active_segment_.find(table_id) == active_segment_.end() ||
                 segment_id > active_segment_[table_id]) {
               active_segment_[table_id] = segment_id;
+              next_segment_id_[table_id] = segment_id + 1;
             }
           }
         }
@@ -247,69 +646,117 @@ bool SegmentManager::init() {
     }
   }
 
-  return true;
+  // Directory order is arbitrary; segments were created in ID order
+  if (!has_manifest) {
+    for (auto &[table_id, segs] : segments_) {
+      std::sort(segs.begin(), segs.end(), [](const auto &a, const auto &b) {
+        return a->segment_id() < b->segment_id();
+      });
+    }
+  }
+
+  // Every segment but the newest of each table is immutable
+  std::vector<std::pair<uint32_t, uint32_t>> unsealed;
+  for (auto &[table_id, segs] : segments_) {
+    for (auto &segment : segs) {
+      if (segment->segment_id() != active_segment_[table_id] &&
+          (!segment->is_sealed() || segment->zone_map().empty())) {
+        unsealed.emplace_back(table_id, segment->segment_id());
+      }
+    }
+  }
+  lock.unlock();
+  for (const auto &[table_id, segment_id] : unsealed) {
+    seal_segment(table_id, segment_id);
+  }
+
+  lock.lock();
+  uint64_t sequence = manifest_changed();
+  lock.unlock();
+  return sync_manifest(sequence);
 }
 
-bool SegmentManager::create_table(uint32_t table_id) {
-  std::lock_guard<std::mutex> lock(mutex_);
+bool SegmentManager::create_table(uint32_t table_id,
+                                  const TimePartitioning &partitioning) {
+  std::unique_lock<std::mutex> lock(mutex_);
 
   if (segments_.find(table_id) != segments_.end()) {
     return true; // Already exists
   }
+  if (partitioning.enabled()) {
+    partitioning_[table_id] = partitioning;
+  }
+
+  // Segment IDs are never reused, even across a drop and re-create
+  uint32_t segment_id = next_segment_id_[table_id]++;
 
   // Create first segment
-  auto segment =
-      std::make_unique<Segment>(segment_path(table_id, 0), table_id, 0);
+  auto segment = std::make_unique<Segment>(segment_path(table_id, segment_id),
+                                           table_id, segment_id);
 
   if (!segment->create()) {
     return false;
   }
 
   segments_[table_id].push_back(std::move(segment));
-  active_segment_[table_id] = 0;
+  active_segment_[table_id] = segment_id;
 
-  return true;
+  uint64_t sequence = manifest_changed();
+  lock.unlock();
+  return sync_manifest(sequence);
 }
 
 bool SegmentManager::drop_table(uint32_t table_id) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_lock<std::mutex> lock(mutex_);
 
   auto it = segments_.find(table_id);
   if (it == segments_.end()) {
     return true; // Doesn't exist
   }
 
-  // Close and delete all segments
-  for (auto &segment : it->second) {
-    std::string path = segment->path();
-    segment->close();
-    std::filesystem::remove(path);
-  }
-
+  std::vector<std::unique_ptr<Segment>> segments = std::move(it->second);
   segments_.erase(it);
   active_segment_.erase(table_id);
-
-  return true;
+  partitioning_.erase(table_id);
+  newest_time_.erase(table_id);
+  uint64_t sequence = manifest_changed();
+  lock.unlock();
+
+  // Scans or a compaction may still read the segments, so they are
+  // closed once those finish
+  bool committed = sync_manifest(sequence);
+  discard(std::move(segments), committed);
+  return committed;
 }
 
 Segment *SegmentManager::get_active_segment(uint32_t table_id) {
-  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_lock<std::mutex> lock(mutex_);
 
   auto it = active_segment_.find(table_id);
   if (it == active_segment_.end()) {
     return nullptr;
   }
 
-  auto seg_it = segments_.find(table_id);
-  if (seg_it == segments_.end() || it->second >= seg_it->second.size()) {
+  Segment *segment = find_segment(table_id, it->second);
+  if (!segment) {
     return nullptr;
   }
 
-  Segment *segment = seg_it->second[it->second].get();
-
   // Check if segment is full and needs rotation
   if (segment->is_full(config_)) {
-    return rotate_segment(table_id);
+    uint32_t outgoing = it->second;
+    segment = rotate_segment(table_id);
+    bool rotated = active_segment_[table_id] != outgoing;
+    uint64_t sequence = manifest_sequence_;
+    lock.unlock();
+    if (rotated) {
+      // Pages appended before the manifest names the segment would be
+      // lost
+      if (!sync_manifest(sequence)) {
+        segment = nullptr;
+      }
+      seal_segment(table_id, outgoing);
+    }
   }
 
   return segment;
@@ -317,24 +764,76 @@ Segment *SegmentManager::get_active_segment(uint32_t table_id) {
 
 Segment *SegmentManager::get_segment(uint32_t table_id, uint32_t segment_id) {
   std::lock_guard<std::mutex> lock(mutex_);
+  return find_segment(table_id, segment_id);
+}
 
-  auto it = segments_.find(table_id);
-  if (it == segments_.end() || segment_id >= it->second.size()) {
+Segment *SegmentManager::segment_for_time(uint32_t table_id, int64_t time) {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  auto it = active_segment_.find(table_id);
+  if (it == active_segment_.end()) {
+    return nullptr;
+  }
+
+  Segment *segment = find_segment(table_id, it->second);
+  if (!segment) {
     return nullptr;
   }
 
-  return it->second[segment_id].get();
+  // A row the retention already dropped would widen the active segment's
+  // range back over the expired partitions
+  auto spec = partitioning_.find(table_id);
+  if (spec != partitioning_.end()) {
+    if (time < retention_horizon(table_id)) {
+      return nullptr;
+    }
+    int64_t &newest = newest_time(table_id);
+    newest = std::max(newest, time);
+  }
+
+  bool next_partition =
+      spec != partitioning_.end() && segment->has_time_range() &&
+      time > segment->max_time() &&
+      spec->second.partition(time) >
+          spec->second.partition(segment->min_time());
+  if (!next_partition && !segment->is_full(config_)) {
+    return segment;
+  }
+
+  uint32_t outgoing = it->second;
+  segment = rotate_segment(table_id);
+  bool rotated = active_segment_[table_id] != outgoing;
+  std::vector<std::unique_ptr<Segment>> expired;
+  if (segment && next_partition) {
+    expired = expire_segments(table_id);
+  }
+  uint64_t sequence = manifest_sequence_;
+  lock.unlock();
+
+  // Pages appended before the manifest names the segment would be lost
+  bool committed = (!rotated && expired.empty()) || sync_manifest(sequence);
+  if (!expired.empty()) {
+    discard(std::move(expired), committed);
+  }
+
+  // Sealed without the lock, so inserts and scans of every table go on
+  // while the outgoing segment is rewritten
+  if (rotated) {
+    seal_segment(table_id, outgoing);
+  }
+  return committed ? segment : nullptr;
 }
 
 Segment *SegmentManager::rotate_segment(uint32_t table_id) {
-  // Note: mutex already held by caller
+  // Note: mutex already held by caller, who syncs the manifest and seals
+  // the outgoing segment once it has released it
 
   auto it = active_segment_.find(table_id);
   if (it == active_segment_.end()) {
     return nullptr;
   }
 
-  uint32_t new_segment_id = it->second + 1;
+  uint32_t new_segment_id = next_segment_id_[table_id]++;
 
   auto segment = std::make_unique<Segment>(
       segment_path(table_id, new_segment_id), table_id, new_segment_id);
@@ -346,6 +845,7 @@ Segment *SegmentManager::rotate_segment(uint32_t table_id) {
   Segment *result = segment.get();
   segments_[table_id].push_back(std::move(segment));
   active_segment_[table_id] = new_segment_id;
+  manifest_changed();
 
   return result;
 }
@@ -360,6 +860,741 @@ void SegmentManager::flush_all() {
   }
 }
 
+size_t SegmentManager::apply_retention(uint32_t table_id) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  std::vector<std::unique_ptr<Segment>> expired = expire_segments(table_id);
+  if (expired.empty()) {
+    return 0;
+  }
+  uint64_t sequence = manifest_sequence_;
+  lock.unlock();
+
+  size_t count = expired.size();
+  discard(std::move(expired), sync_manifest(sequence));
+  return count;
+}
+
+SegmentManager::Snapshot::Snapshot(Snapshot &&other) noexcept
+    : manager_(other.manager_), segments_(std::move(other.segments_)),
+      epoch_(other.epoch_) {
+  other.manager_ = nullptr;
+}
+
+SegmentManager::Snapshot &
+SegmentManager::Snapshot::operator=(Snapshot &&other) noexcept {
+  if (this != &other) {
+    release();
+    manager_ = other.manager_;
+    segments_ = std::move(other.segments_);
+    epoch_ = other.epoch_;
+    other.manager_ = nullptr;
+  }
+  return *this;
+}
+
+SegmentManager::Snapshot::~Snapshot() { release(); }
+
+void SegmentManager::Snapshot::release() {
+  if (!manager_) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(manager_->mutex_);
+  auto it = manager_->snapshots_.find(epoch_);
+  if (--it->second == 0) {
+    manager_->snapshots_.erase(it);
+    manager_->release_retired();
+  }
+  manager_ = nullptr;
+  segments_.clear();
+}
+
+SegmentManager::Snapshot
+SegmentManager::snapshot(uint32_t table_id, const ColumnRange *range) {
+  // Segments replaced while the snapshot lives are retired rather than
+  // closed, so it stays readable until it is released
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  Snapshot snapshot;
+  snapshot.manager_ = this;
+  snapshot.epoch_ = epoch_;
+  snapshots_[epoch_]++;
+
+  auto it = segments_.find(table_id);
+  if (it != segments_.end()) {
+    snapshot.segments_.reserve(it->second.size());
+    for (auto &segment : it->second) {
+      if (!range || may_contain(table_id, *segment, *range)) {
+        snapshot.segments_.push_back(segment.get());
+      }
+    }
+  }
+  return snapshot;
+}
+
+std::vector<uint32_t> SegmentManager::segment_ids(uint32_t table_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::vector<uint32_t> ids;
+  auto it = segments_.find(table_id);
+  if (it != segments_.end()) {
+    for (auto &segment : it->second) {
+      ids.push_back(segment->segment_id());
+    }
+  }
+  return ids;
+}
+
+size_t SegmentManager::compact_table(uint32_t table_id) {
+  std::lock_guard<std::mutex> compaction_lock(compaction_mutex_);
+
+  // Pin the segments like a scan does
+  Snapshot pinned = snapshot(table_id);
+  TimePartitioning spec;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = partitioning_.find(table_id);
+    if (it != partitioning_.end()) {
+      spec = it->second;
+    }
+  }
+
+  size_t small_pages = config_.max_pages / 2;
+  size_t budget = config_.max_pages;
+  size_t replaced = 0;
+
+  // Group consecutive candidates of one page kind into runs that fit one
+  // output segment. A run is worth rewriting if it merges segments or
+  // drops dead records.
+  std::vector<Segment *> run;
+  size_t run_pages = 0;
+  bool run_dead = false;
+  bool run_columnar = false;
+  int64_t run_partition = 0;
+
+  auto finish_run = [&]() {
+    if (run.size() > 1 || run_dead) {
+      if (compact_run(table_id, run)) {
+        replaced += run.size();
+      }
+    }
+    run.clear();
+    run_pages = 0;
+    run_dead = false;
+  };
+
+  for (Segment *segment : pinned.segments()) {
+    if (!segment->is_sealed() || !segment->map_readonly()) {
+      finish_run();
+      continue;
+    }
+
+    SegmentUsage use = usage(*segment);
+    uint64_t bytes = static_cast<uint64_t>(segment->page_count()) * PAGE_SIZE;
+    bool dead = !use.columnar &&
+                use.live_bytes < config_.compact_live_ratio * bytes;
+    size_t pages = use.columnar
+                       ? segment->page_count()
+                       : (use.live_bytes + PAGE_SIZE - 1) / PAGE_SIZE;
+
+    if (!dead && segment->page_count() >= small_pages) {
+      finish_run();
+      continue;
+    }
+    // Partitions are never merged, so they can still be pruned and
+    // expired one segment at a time
+    int64_t partition = spec.enabled() && segment->has_time_range()
+                            ? spec.partition(segment->min_time())
+                            : 0;
+    if (!run.empty() &&
+        (use.columnar != run_columnar || run_pages + pages > budget ||
+         partition != run_partition)) {
+      finish_run();
+    }
+
+    run.push_back(segment);
+    run_pages += pages;
+    run_dead = run_dead || dead;
+    run_columnar = use.columnar;
+    run_partition = partition;
+  }
+  finish_run();
+
+  return replaced;
+}
+
+void SegmentManager::start_compactor() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (compactor_.joinable()) {
+    return;
+  }
+  compactor_stop_ = false;
+  compactor_ = std::thread(&SegmentManager::compactor_loop, this);
+}
+
+void SegmentManager::stop_compactor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    compactor_stop_ = true;
+  }
+  compactor_cv_.notify_all();
+  if (compactor_.joinable()) {
+    compactor_.join();
+  }
+}
+
+void SegmentManager::compactor_loop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!compactor_cv_.wait_for(
+      lock, std::chrono::milliseconds(config_.compact_interval_ms),
+      [this] { return compactor_stop_; })) {
+    std::vector<uint32_t> tables;
+    for (auto &[table_id, segs] : segments_) {
+      tables.push_back(table_id);
+    }
+
+    lock.unlock();
+    for (uint32_t table_id : tables) {
+      apply_retention(table_id);
+      compact_table(table_id);
+    }
+    lock.lock();
+  }
+}
+
+SegmentManager::SegmentUsage SegmentManager::usage(Segment &segment) {
+  // Note: compaction_mutex_ held by caller. Sealed segments never change,
+  // so usage is computed once per segment.
+  uint64_t key = usage_key(segment.table_id(), segment.segment_id());
+  auto it = usage_.find(key);
+  if (it != usage_.end()) {
+    return it->second;
+  }
+
+  SegmentUsage use{0, true};
+  for (uint32_t offset = 0; offset < segment.page_count(); ++offset) {
+    const Page *page = segment.mapped_page(offset);
+    if (!page || !page->header().is_valid()) {
+      continue;
+    }
+    if (is_columnar(*page)) {
+      use.live_bytes += PAGE_SIZE;
+      continue;
+    }
+
+    use.columnar = false;
+    use.live_bytes += sizeof(PageHeader);
+    for (uint16_t slot = 0; slot < page->slot_count(); ++slot) {
+      const uint8_t *data;
+      uint16_t length;
+      if (page->get_record(slot, &data, &length)) {
+        use.live_bytes += sizeof(SlotEntry) + length;
+      }
+    }
+  }
+
+  usage_[key] = use;
+  return use;
+}
+
+bool SegmentManager::compact_run(uint32_t table_id,
+                                 const std::vector<Segment *> &run) {
+  // Note: compaction_mutex_ held and run segments pinned by caller
+  uint32_t segment_id;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    segment_id = next_segment_id_[table_id]++;
+  }
+
+  auto output = std::make_unique<Segment>(segment_path(table_id, segment_id),
+                                          table_id, segment_id);
+  if (!output->create()) {
+    return false;
+  }
+  for (Segment *segment : run) {
+    if (segment->has_time_range()) {
+      output->extend_time_range(segment->min_time());
+      output->extend_time_range(segment->max_time());
+    }
+  }
+
+  Throttle throttle(config_.compact_pages_per_second);
+  ZoneMap zones;
+  bool ok = true;
+  if (usage(*run[0]).columnar) {
+    // Merged columnar segments are re-encoded as one batch; runs whose
+    // schemas differ are left alone
+    std::vector<ColumnVector> columns;
+    uint64_t max_lsn = 0;
+    bool encoded;
+    for (Segment *segment : run) {
+      ok = ok && gather_segment(*segment, columns, max_lsn, encoded);
+    }
+    ok = ok && write_encoded(*output, columns, max_lsn, &throttle);
+    zones = zone_map_of(columns);
+  } else {
+    ok = write_live_records(*output, run, zones, throttle);
+  }
+  ok = ok && output->seal();
+
+  std::string path = output->path();
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  // The table may have been dropped while the run was rewritten
+  auto it = segments_.find(table_id);
+  std::vector<std::unique_ptr<Segment>>::iterator first;
+  if (ok && it != segments_.end()) {
+    first = std::find_if(
+        it->second.begin(), it->second.end(),
+        [&run](const auto &segment) { return segment.get() == run[0]; });
+    ok = static_cast<size_t>(it->second.end() - first) >= run.size();
+    for (size_t i = 0; ok && i < run.size(); ++i) {
+      ok = first[i].get() == run[i];
+    }
+  } else {
+    ok = false;
+  }
+
+  if (!ok) {
+    lock.unlock();
+    output.reset();
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    return false;
+  }
+
+  // Swap the run for its replacement; an empty output (every record
+  // deleted) just drops the run
+  std::vector<std::unique_ptr<Segment>> old(
+      std::make_move_iterator(first),
+      std::make_move_iterator(first + run.size()));
+  auto at = it->second.erase(first, first + run.size());
+  bool listed = output->page_count() > 0;
+  if (listed) {
+    output->set_zone_map(std::move(zones));
+    it->second.insert(at, std::move(output));
+  }
+  for (auto &segment : old) {
+    usage_.erase(usage_key(table_id, segment->segment_id()));
+  }
+  uint64_t sequence = manifest_changed();
+  lock.unlock();
+
+  // The manifest rename is the commit point; until then the replaced
+  // files are kept
+  bool committed = sync_manifest(sequence);
+  discard(std::move(old), committed);
+  if (!listed) {
+    output.reset();
+    std::error_code ec;
+    std::filesystem::remove(path, ec); // Empty output was never listed
+  }
+  return committed;
+}
+
+void SegmentManager::seal_segment(uint32_t table_id, uint32_t segment_id) {
+  // Note: called without mutex_, which is only taken to swap the result
+  // in. The segment is no longer active, so nothing writes it, and the
+  // snapshot keeps it open if it is dropped meanwhile.
+  Snapshot pinned = snapshot(table_id);
+  Segment *segment = nullptr;
+  for (Segment *candidate : pinned.segments()) {
+    if (candidate->segment_id() == segment_id) {
+      segment = candidate;
+    }
+  }
+  if (!segment || !segment->seal() || !segment->map_readonly()) {
+    return;
+  }
+
+  ZoneMap zones;
+  std::unique_ptr<Segment> encoded;
+  std::vector<ColumnVector> columns;
+  uint64_t max_lsn = 0;
+  bool all_encoded;
+  if (!gather_segment(*segment, columns, max_lsn, all_encoded)) {
+    // Row pages: build the zone map from the records
+    Record record;
+    for (uint32_t offset = 0; offset < segment->page_count(); ++offset) {
+      const Page *page = segment->mapped_page(offset);
+      if (!page || !page->header().is_valid() || is_columnar(*page)) {
+        continue;
+      }
+      for (uint16_t slot = 0; slot < page->slot_count(); ++slot) {
+        const uint8_t *data;
+        uint16_t length;
+        if (page->get_record(slot, &data, &length) &&
+            record.deserialize(data, length)) {
+          extend_zone_map(zones, record);
+        }
+      }
+    }
+  } else {
+    zones = zone_map_of(columns);
+  }
+
+  // Rewrite beside the segment; renamed over it once swapped in
+  if (!columns.empty() && config_.encode_sealed && !all_encoded) {
+    encoded = std::make_unique<Segment>(segment->path() + ".enc", table_id,
+                                        segment_id);
+    bool created = encoded->create();
+    if (created && segment->has_time_range()) {
+      encoded->extend_time_range(segment->min_time());
+      encoded->extend_time_range(segment->max_time());
+    }
+    if (!created || !write_encoded(*encoded, columns, max_lsn, nullptr) ||
+        !encoded->seal()) {
+      std::string path = encoded->path();
+      encoded.reset();
+      std::error_code ec;
+      std::filesystem::remove(path, ec);
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  // Compaction or a drop may have replaced the segment meanwhile
+  std::unique_ptr<Segment> *slot = nullptr;
+  auto it = segments_.find(table_id);
+  if (it != segments_.end()) {
+    for (auto &listed : it->second) {
+      if (listed.get() == segment) {
+        slot = &listed;
+      }
+    }
+  }
+
+  if (slot && encoded && encoded->rename_to(segment->path())) {
+    // Scans may still hold the old segment's mapping
+    encoded->set_zone_map(std::move(zones));
+    retire(std::move(*slot));
+    *slot = std::move(encoded);
+    release_retired();
+  } else {
+    if (encoded) {
+      std::string path = encoded->path();
+      encoded.reset();
+      std::error_code ec;
+      std::filesystem::remove(path, ec);
+    }
+    if (!slot) {
+      return;
+    }
+    segment->set_zone_map(std::move(zones));
+  }
+
+  // The zone map is kept in the manifest
+  uint64_t sequence = manifest_changed();
+  lock.unlock();
+  sync_manifest(sequence);
+}
+
+bool SegmentManager::may_contain(uint32_t table_id, const Segment &segment,
+                                 const ColumnRange &range) const {
+  // Note: mutex already held by caller
+
+  // The header range covers the active segment too
+  auto spec = partitioning_.find(table_id);
+  if (spec != partitioning_.end() &&
+      range.column == static_cast<size_t>(spec->second.column)) {
+    return segment.has_time_range() && range.lo <= segment.max_time() &&
+           range.hi >= segment.min_time();
+  }
+
+  const ZoneMap &zones = segment.zone_map();
+  return !segment.is_sealed() || range.column >= zones.size() ||
+         zones[range.column].overlaps(range.lo, range.hi);
+}
+
+bool SegmentManager::is_expired(uint32_t table_id, int64_t time) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return time < retention_horizon(table_id);
+}
+
+int64_t SegmentManager::retention_horizon(uint32_t table_id) {
+  // Note: mutex already held by caller
+  auto spec = partitioning_.find(table_id);
+  if (spec == partitioning_.end() || spec->second.retention <= 0) {
+    return INT64_MIN;
+  }
+  int64_t newest = newest_time(table_id);
+  if (newest < INT64_MIN + spec->second.retention) {
+    return INT64_MIN;
+  }
+  return newest - spec->second.retention;
+}
+
+int64_t &SegmentManager::newest_time(uint32_t table_id) {
+  // Note: mutex already held by caller. Read from the segment headers
+  // once, then kept up by segment_for_time()
+  auto cached = newest_time_.find(table_id);
+  if (cached != newest_time_.end()) {
+    return cached->second;
+  }
+  int64_t newest = INT64_MIN;
+  auto it = segments_.find(table_id);
+  if (it != segments_.end()) {
+    for (auto &segment : it->second) {
+      if (segment->has_time_range()) {
+        newest = std::max(newest, segment->max_time());
+      }
+    }
+  }
+  return newest_time_[table_id] = newest;
+}
+
+std::vector<std::unique_ptr<Segment>>
+SegmentManager::expire_segments(uint32_t table_id) {
+  // Note: mutex already held by caller, who syncs the manifest and then
+  // discards the expired segments. segment_for_time() has counted the
+  // row being added in the newest time.
+  std::vector<std::unique_ptr<Segment>> expired;
+  auto it = segments_.find(table_id);
+  int64_t horizon = retention_horizon(table_id);
+  if (it == segments_.end() || horizon == INT64_MIN) {
+    return expired;
+  }
+
+  // Any segment but the active one, including one rotated out and not
+  // yet sealed; seal_segment() skips a segment that is gone
+  auto active = active_segment_.find(table_id);
+  auto &segs = it->second;
+  for (auto seg = segs.begin(); seg != segs.end();) {
+    bool is_active = active != active_segment_.end() &&
+                     (*seg)->segment_id() == active->second;
+    if (!is_active && (*seg)->has_time_range() &&
+        (*seg)->max_time() < horizon) {
+      expired.push_back(std::move(*seg));
+      seg = segs.erase(seg);
+    } else {
+      ++seg;
+    }
+  }
+  if (!expired.empty()) {
+    manifest_changed();
+  }
+  return expired;
+}
+
+Segment *SegmentManager::find_segment(uint32_t table_id,
+                                      uint32_t segment_id) {
+  // Note: mutex already held by caller
+  auto it = segments_.find(table_id);
+  if (it == segments_.end()) {
+    return nullptr;
+  }
+  for (auto &segment : it->second) {
+    if (segment->segment_id() == segment_id) {
+      return segment.get();
+    }
+  }
+  return nullptr;
+}
+
+void SegmentManager::discard(std::vector<std::unique_ptr<Segment>> segments,
+                             bool committed) {
+  // Note: called without mutex_. Files are deleted only once a durable
+  // manifest stops naming them, so a crash never lists a missing file;
+  // if the manifest could not be written, init() removes them later.
+  if (committed) {
+    for (auto &segment : segments) {
+      std::error_code ec;
+      std::filesystem::remove(segment->path(), ec);
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto &segment : segments) {
+    retire(std::move(segment));
+  }
+  release_retired();
+}
+
+void SegmentManager::retire(std::unique_ptr<Segment> segment) {
+  // Note: mutex already held by caller. Snapshots taken from now on
+  // belong to a later epoch and cannot see the segment.
+  retired_.push_back({std::move(segment), epoch_++});
+}
+
+void SegmentManager::release_retired() {
+  // Note: mutex already held by caller
+  uint64_t oldest = snapshots_.empty() ? UINT64_MAX : snapshots_.begin()->first;
+  auto unread = std::find_if(
+      retired_.begin(), retired_.end(),
+      [oldest](const Retired &retired) { return retired.epoch >= oldest; });
+  retired_.erase(retired_.begin(), unread);
+}
+
+bool SegmentManager::load_manifest() {
+  // Note: mutex already held by caller
+  int fd = ::open(manifest_path().c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  std::vector<uint8_t> in;
+  if (fstat(fd, &st) == 0) {
+    in.resize(static_cast<size_t>(st.st_size));
+  }
+  ssize_t bytes_read = pread(fd, in.data(), in.size(), 0);
+  ::close(fd);
+  if (bytes_read != static_cast<ssize_t>(in.size())) {
+    return false;
+  }
+
+  size_t at = 0;
+  uint32_t magic, version, table_count;
+  if (!get(in, at, magic) || !get(in, at, version) ||
+      !get(in, at, table_count) || magic != MANIFEST_MAGIC ||
+      version > MANIFEST_VERSION) {
+    return false;
+  }
+
+  for (uint32_t t = 0; t < table_count; ++t) {
+    uint32_t table_id, active_id, next_id, segment_count;
+    if (!get(in, at, table_id) || !get(in, at, active_id) ||
+        !get(in, at, next_id)) {
+      return false;
+    }
+
+    // Version 2 added time partitioning
+    TimePartitioning spec;
+    if (version >= 2 &&
+        (!get(in, at, spec.column) || !get(in, at, spec.width) ||
+         !get(in, at, spec.retention))) {
+      return false;
+    }
+    if (!get(in, at, segment_count)) {
+      return false;
+    }
+    next_segment_id_[table_id] = next_id;
+    if (spec.enabled()) {
+      partitioning_[table_id] = spec;
+    }
+
+    for (uint32_t s = 0; s < segment_count; ++s) {
+      uint32_t segment_id;
+      uint16_t zone_count;
+      if (!get(in, at, segment_id) || !get(in, at, zone_count)) {
+        return false;
+      }
+      ZoneMap zones(zone_count);
+      for (ColumnZone &zone : zones) {
+        uint8_t flags;
+        if (!get(in, at, flags) || !get(in, at, zone.min) ||
+            !get(in, at, zone.max)) {
+          return false;
+        }
+        zone.integer = flags & 1;
+        zone.empty = flags & 2;
+      }
+
+      auto segment = std::make_unique<Segment>(
+          segment_path(table_id, segment_id), table_id, segment_id);
+      if (!segment->open()) {
+        std::cerr << "Missing segment file: " << segment->path() << "\n";
+        continue;
+      }
+      if (segment_id != active_id) {
+        segment->seal();
+        segment->set_zone_map(std::move(zones));
+      }
+      segments_[table_id].push_back(std::move(segment));
+    }
+
+    if (segments_.count(table_id)) {
+      active_segment_[table_id] = active_id;
+    }
+  }
+  return true;
+}
+
+std::vector<uint8_t> SegmentManager::manifest_bytes() {
+  // Note: mutex already held by caller
+  std::vector<uint8_t> out;
+  put(out, MANIFEST_MAGIC);
+  put(out, MANIFEST_VERSION);
+  put(out, static_cast<uint32_t>(segments_.size()));
+
+  for (auto &[table_id, segs] : segments_) {
+    TimePartitioning spec;
+    auto it = partitioning_.find(table_id);
+    if (it != partitioning_.end()) {
+      spec = it->second;
+    }
+
+    put(out, table_id);
+    put(out, active_segment_[table_id]);
+    put(out, next_segment_id_[table_id]);
+    put(out, spec.column);
+    put(out, spec.width);
+    put(out, spec.retention);
+    put(out, static_cast<uint32_t>(segs.size()));
+
+    for (auto &segment : segs) {
+      const ZoneMap &zones = segment->zone_map();
+      put(out, segment->segment_id());
+      put(out, static_cast<uint16_t>(zones.size()));
+      for (const ColumnZone &zone : zones) {
+        put(out, static_cast<uint8_t>((zone.integer ? 1 : 0) |
+                                      (zone.empty ? 2 : 0)));
+        put(out, zone.min);
+        put(out, zone.max);
+      }
+    }
+  }
+  return out;
+}
+
+uint64_t SegmentManager::manifest_changed() {
+  // Note: mutex already held by caller
+  return ++manifest_sequence_;
+}
+
+bool SegmentManager::sync_manifest(uint64_t sequence) {
+  // Note: called without mutex_, which is only taken to build the bytes
+  std::lock_guard<std::mutex> manifest_lock(manifest_mutex_);
+  if (manifest_synced_ >= sequence) {
+    return true; // A later write already covered the change
+  }
+
+  std::vector<uint8_t> out;
+  uint64_t latest;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out = manifest_bytes();
+    latest = manifest_sequence_;
+  }
+
+  // Write aside, then rename over the old manifest
+  std::string tmp = manifest_path() + ".tmp";
+  int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  bool ok = ::write(fd, out.data(), out.size()) ==
+                static_cast<ssize_t>(out.size()) &&
+            fsync(fd) == 0;
+  ::close(fd);
+  if (!ok || ::rename(tmp.c_str(), manifest_path().c_str()) != 0) {
+    std::cerr << "Failed to write segment manifest: " << manifest_path()
+              << "\n";
+    return false;
+  }
+
+  // Make the rename itself durable
+  int dir = ::open(data_dir_.c_str(), O_RDONLY | O_DIRECTORY);
+  if (dir >= 0) {
+    fsync(dir);
+    ::close(dir);
+  }
+  manifest_synced_ = latest;
+  return true;
+}
+
+std::string SegmentManager::manifest_path() const {
+  return data_dir_ + "/MANIFEST";
+}
+
 std::string SegmentManager::segment_path(uint32_t table_id,
                                          uint32_t segment_id) const {
   return data_dir_ + "/segment_" + std::to_string(table_id) + "_" +
@@ -6,10 +6,15 @@
  */
 
 #include "page.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -26,24 +31,69 @@ struct SegmentHeader {
   uint32_t page_count;
   uint64_t created_lsn;
   uint64_t max_lsn;
+  int64_t min_time; // Partition column range; min > max if no rows
+  int64_t max_time;
 
-  static constexpr uint32_t SEGMENT_MAGIC = 0x53454745; // "SEGE"
+  static constexpr uint32_t SEGMENT_MAGIC = 0x32474553; // "SEG2"
 
   bool is_valid() const { return magic == SEGMENT_MAGIC; }
 };
 
+/**
+ * @brief Value range of one column within a segment
+ *
+ * Only INTEGER values are tracked; a column that holds anything else is
+ * never pruned.
+ */
+struct ColumnZone {
+  bool integer = true; // Every non-NULL value was an INTEGER
+  bool empty = true;   // No non-NULL value seen
+  int64_t min = 0;
+  int64_t max = 0;
+
+  void extend(int64_t value) {
+    min = empty ? value : std::min(min, value);
+    max = empty ? value : std::max(max, value);
+    empty = false;
+  }
+
+  /**
+   * @brief Check if any value may fall within [lo, hi]
+   */
+  bool overlaps(int64_t lo, int64_t hi) const {
+    return !integer || (!empty && lo <= max && hi >= min);
+  }
+};
+
+/**
+ * @brief Per-column value ranges of a segment, empty if unknown
+ */
+using ZoneMap = std::vector<ColumnZone>;
+
 /**
  * @brief Segment configuration
  */
 struct SegmentConfig {
   size_t max_pages = 1024;                    // Max pages per segment
   size_t target_size_bytes = 8 * 1024 * 1024; // 8MB target size
+  bool encode_sealed = true; // Rewrite sealed PAX segments as EncodedPages
+
+  // Background compaction
+  double compact_live_ratio = 0.5;        // Rewrite segments less live
+  size_t compact_pages_per_second = 4096; // Write throttle, 0 = unlimited
+  uint32_t compact_interval_ms = 10000;   // Pause between passes
 };
 
 /**
  * @brief Segment file
  *
- * Represents a single segment file containing multiple pages.
+ * Represents a single segment file containing multiple pages. Once a
+ * segment is sealed (rotated away from) it is immutable and can be read
+ * through a read-only memory mapping instead of pread.
+ *
+ * Until then its last page is kept in a write buffer: rows are added to
+ * it in memory, and it is written when the next page is appended, or by
+ * sync(), seal() and close().
  */
 class Segment {
 public:
@@ -97,16 +147,84 @@ public:
 
   /**
    * @brief Append a new page to the segment
+   *
+   * Writes the previous last page if it was changed in the buffer.
+   *
    * @param page Page to append
    * @return Page offset, or UINT32_MAX on failure
    */
   uint32_t append_page(const Page *page);
 
   /**
-   * @brief Sync segment to disk
+   * @brief Add to the last page in its write buffer
+   *
+   * Reads see the change at once; it reaches the file when the page is
+   * next written.
+   *
+   * @param fill Adds to the page; returns false, leaving it unchanged, if
+   *             there is no room
+   * @return false if fill failed, or there is no unsealed last page
+   */
+  template <typename Fill> bool append_to_tail(Fill &&fill) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Page *tail = tail_page();
+    if (!tail || !fill(*tail)) {
+      return false;
+    }
+    tail_dirty_ = true;
+    return true;
+  }
+
+  /**
+   * @brief Write the buffered last page and sync segment to disk
    */
   bool sync();
 
+  /**
+   * @brief Mark the segment immutable
+   *
+   * Writes the buffered last page and syncs the file; later writes and
+   * appends fail.
+   */
+  bool seal();
+
+  /**
+   * @brief Check if the segment is sealed
+   */
+  bool is_sealed() const { return sealed_.load(std::memory_order_acquire); }
+
+  /**
+   * @brief Map a sealed segment read-only
+   *
+   * Advises the kernel the mapping is read sequentially and to start
+   * read-ahead. Idempotent; the mapping lives until close().
+   *
+   * @return true if the segment is mapped
+   */
+  bool map_readonly();
+
+  /**
+   * @brief Get a page straight from the mapping
+   *
+   * Takes no lock; only valid after map_readonly() succeeded.
+   *
+   * @param page_offset Page offset within segment
+   * @return Page, or nullptr if unmapped or out of range
+   */
+  const Page *mapped_page(uint32_t page_offset) const;
+
+  /**
+   * @brief Get a page for a scan
+   *
+   * A sealed segment's page comes from the mapping, never through the
+   * buffer pool or a copy; the active segment's is read into scratch.
+   *
+   * @param page_offset Page offset within segment
+   * @param scratch Buffer for a page that is not mapped
+   * @return Page, or nullptr if it could not be read
+   */
+  const Page *scan_page(uint32_t page_offset, Page &scratch);
+
   /**
    * @brief Get segment ID
    */
@@ -120,13 +238,15 @@ public:
   /**
    * @brief Get page count
    */
-  uint32_t page_count() const { return page_count_; }
+  uint32_t page_count() const {
+    return page_count_.load(std::memory_order_acquire);
+  }
 
   /**
    * @brief Check if segment is full
    */
   bool is_full(const SegmentConfig &config) const {
-    return page_count_ >= config.max_pages;
+    return page_count() >= config.max_pages;
   }
 
   /**
@@ -134,28 +254,127 @@ public:
    */
   const std::string &path() const { return path_; }
 
+  /**
+   * @brief Rename the segment file, replacing any file at the new path
+   * @return true on success
+   */
+  bool rename_to(const std::string &path);
+
+  /**
+   * @brief Widen the partition column range to include a time
+   *
+   * Persisted with the next page write or append.
+   */
+  void extend_time_range(int64_t time);
+
+  /**
+   * @brief Check if any row has a time yet
+   */
+  bool has_time_range() const {
+    return min_time_.load(std::memory_order_acquire) <=
+           max_time_.load(std::memory_order_acquire);
+  }
+
+  int64_t min_time() const {
+    return min_time_.load(std::memory_order_acquire);
+  }
+  int64_t max_time() const {
+    return max_time_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * @brief Get the per-column value ranges (empty if unknown)
+   */
+  const ZoneMap &zone_map() const { return zone_map_; }
+
+  /**
+   * @brief Set the per-column value ranges
+   */
+  void set_zone_map(ZoneMap zone_map) { zone_map_ = std::move(zone_map); }
+
 private:
   bool write_header();
   bool read_header();
+  Page *tail_page();
+  bool flush_tail();
 
   std::string path_;
   uint32_t table_id_;
   uint32_t segment_id_;
-  uint32_t page_count_{0};
+  std::atomic<uint32_t> page_count_{0}; // Scans read it during appends
   uint64_t created_lsn_{0};
   uint64_t max_lsn_{0};
+  std::atomic<int64_t> min_time_{INT64_MAX};
+  std::atomic<int64_t> max_time_{INT64_MIN};
+  bool time_dirty_{false};
+
+  // Last page while unsealed, loaded on first use; guarded by mutex_
+  std::unique_ptr<Page> tail_;
+  bool tail_dirty_{false}; // Changed since last written
 
   int fd_{-1};
   std::mutex mutex_;
+
+  std::atomic<bool> sealed_{false};
+  std::atomic<const uint8_t *> mapping_{nullptr};
+  size_t mapping_size_{0};
+
+  ZoneMap zone_map_;
 };
 
 /**
  * @brief Segment manager
  *
- * Manages multiple segments for a table.
+ * Manages multiple segments for a table. When a segment of PAX pages is
+ * sealed it is rewritten as EncodedPages, each column compressed with
+ * the encoding that suits its data; the rewrite replaces the file by
+ * rename, so a crash leaves either the old or the new segment.
+ *
+ * The MANIFEST file lists each table's live segments in scan order with
+ * their zone maps. It is replaced atomically on every change, so segment
+ * files it does not name are leftovers and are removed at init. It is
+ * written and synced outside the manager's lock, and files it stops
+ * naming are deleted only once it is durable.
+ *
+ * A background compactor merges runs of small sealed segments and
+ * rewrites segments with little live data, dropping deleted records, so
+ * scan cost tracks live data rather than history.
  */
 class SegmentManager {
 public:
+  /**
+   * @brief Range predicate on an INTEGER column, used to prune segments
+   */
+  struct ColumnRange {
+    size_t column;
+    int64_t lo;
+    int64_t hi;
+  };
+
+  /**
+   * @brief Pinned list of a table's segments, for pull-based scans
+   *
+   * The segments stay readable until the snapshot is destroyed, even if
+   * compaction or retention replaces them meanwhile.
+   */
+  class Snapshot {
+  public:
+    Snapshot() = default;
+    Snapshot(Snapshot &&other) noexcept;
+    Snapshot &operator=(Snapshot &&other) noexcept;
+    ~Snapshot();
+
+    const std::vector<Segment *> &segments() const { return segments_; }
+
+  private:
+    friend class SegmentManager;
+    void release();
+
+    SegmentManager *manager_{nullptr};
+    std::vector<Segment *> segments_;
+    uint64_t epoch_{0}; // Manager's retire epoch when taken
+  };
+
   /**
    * @brief Constructor
    * @param data_dir Data directory path
@@ -176,8 +395,10 @@ public:
   /**
    * @brief Create segments for a new table
    * @param table_id Table identifier
+   * @param partitioning Time partitioning, if any
    */
-  bool create_table(uint32_t table_id);
+  bool create_table(uint32_t table_id,
+                    const TimePartitioning &partitioning = {});
 
   /**
    * @brief Drop a table and its segments
@@ -200,21 +421,116 @@ public:
    */
   Segment *get_segment(uint32_t table_id, uint32_t segment_id);
 
+  /**
+   * @brief Get the segment a row with this time is appended to
+   *
+   * On a time-partitioned table, rotates when the time is past the
+   * partition the active segment started in, then expires segments older
+   * than the retention. Late rows go to the active segment, widening its
+   * range, unless they are already past the retention window.
+   *
+   * @return Pointer to segment, or nullptr on failure or for a row past
+   *         the retention window (see is_expired())
+   */
+  Segment *segment_for_time(uint32_t table_id, int64_t time);
+
+  /**
+   * @brief Check whether a time is before a table's retention window,
+   *        which ends at the newest time the table has taken
+   */
+  bool is_expired(uint32_t table_id, int64_t time);
+
   /**
    * @brief Rotate to a new segment
+   *
+   * The caller holds the mutex and, once it has released it, writes the
+   * manifest with sync_manifest() before appending to the new segment,
+   * and seals the outgoing segment with seal_segment().
+   *
    * @param table_id Table identifier
    * @return New segment, or nullptr on failure
    */
   Segment *rotate_segment(uint32_t table_id);
 
+  /**
+   * @brief Drop segments that ended before the retention window
+   *
+   * The window ends at the newest time in the table. Every segment but
+   * the active one may expire. Each expired segment
+   * is one file unlink, however many rows it holds.
+   *
+   * @return Number of segments dropped
+   */
+  size_t apply_retention(uint32_t table_id);
+
   /**
    * @brief Flush all segments
    */
   void flush_all();
 
+  /**
+   * @brief Pin a table's segments for scanning
+   * @param range If set, leave out segments that cannot hold it
+   */
+  Snapshot snapshot(uint32_t table_id, const ColumnRange *range = nullptr);
+
+  /**
+   * @brief Get a table's segment IDs in scan order
+   */
+  std::vector<uint32_t> segment_ids(uint32_t table_id);
+
+  /**
+   * @brief Run one compaction pass over a table
+   *
+   * Rewrites runs of sealed segments that are small or mostly dead into
+   * one segment each, then swaps them in through the manifest. Writes are
+   * throttled to compact_pages_per_second.
+   *
+   * @return Number of segments replaced
+   */
+  size_t compact_table(uint32_t table_id);
+
+  /**
+   * @brief Start the background compactor thread
+   */
+  void start_compactor();
+
+  /**
+   * @brief Stop the background compactor thread and wait for it
+   */
+  void stop_compactor();
+
 private:
+  struct Retired {
+    std::unique_ptr<Segment> segment;
+    uint64_t epoch; // Only snapshots from this epoch or older can read it
+  };
+
+  struct SegmentUsage {
+    uint64_t live_bytes; // Header, slot and record bytes of live records
+    bool columnar;       // PAX or encoded pages
+  };
+
   std::string segment_path(uint32_t table_id, uint32_t segment_id) const;
-  bool load_table_segments(uint32_t table_id);
+  std::string manifest_path() const;
+  bool may_contain(uint32_t table_id, const Segment &segment,
+                   const ColumnRange &range) const;
+  int64_t retention_horizon(uint32_t table_id);
+  int64_t &newest_time(uint32_t table_id);
+  std::vector<std::unique_ptr<Segment>> expire_segments(uint32_t table_id);
+  bool load_manifest();
+  std::vector<uint8_t> manifest_bytes();
+  uint64_t manifest_changed();
+  bool sync_manifest(uint64_t sequence);
+  void discard(std::vector<std::unique_ptr<Segment>> segments,
+               bool committed);
+  Segment *find_segment(uint32_t table_id, uint32_t segment_id);
+  void seal_segment(uint32_t table_id, uint32_t segment_id);
+  void retire(std::unique_ptr<Segment> segment);
+  void release_retired();
+  SegmentUsage usage(Segment &segment);
+  bool compact_run(uint32_t table_id, const std::vector<Segment *> &run);
+  void compactor_loop();
 
   std::string data_dir_;
   SegmentConfig config_;
@@ -223,6 +539,33 @@ private:
   std::unordered_map<uint32_t, std::vector<std::unique_ptr<Segment>>> segments_;
   std::unordered_map<uint32_t, uint32_t>
       active_segment_; // table_id -> segment_id
+  std::unordered_map<uint32_t, uint32_t>
+      next_segment_id_; // table_id -> next unused segment_id
+  std::unordered_map<uint32_t, TimePartitioning> partitioning_;
+  std::unordered_map<uint32_t, int64_t>
+      newest_time_; // table_id -> newest time added, INT64_MIN if none
+
+  // Each change to the manifest's contents takes a sequence number under
+  // mutex_; sync_manifest() writes it outside mutex_, unless a later write
+  // already covered it. manifest_mutex_ is taken before mutex_.
+  uint64_t manifest_sequence_{0}; // Guarded by mutex_
+  std::mutex manifest_mutex_;
+  uint64_t manifest_synced_{0}; // Guarded by manifest_mutex_
+
+  // Segments replaced while snapshots may still read them, oldest first.
+  // Each retirement ends an epoch; a segment is closed once no snapshot
+  // from its epoch or before is alive.
+  std::vector<Retired> retired_;
+  uint64_t epoch_{0};
+  std::map<uint64_t, uint32_t> snapshots_; // Live snapshots per epoch
+
+  // Compaction; usage_ is keyed by table_id << 32 | segment_id and guarded
+  // by compaction_mutex_, which also serializes compaction passes
+  std::mutex compaction_mutex_;
+  std::unordered_map<uint64_t, SegmentUsage> usage_;
+  std::thread compactor_;
+  std::condition_variable compactor_cv_;
+  bool compactor_stop_{false};
 };
 
 } // namespace storage
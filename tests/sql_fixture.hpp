@@ -0,0 +1,220 @@
+#pragma once
+
+/**
+ * @file sql_fixture.hpp
+ * @brief Test fixture running SQL against a scratch data directory
+ */
+
+#include "executor/executor.hpp"
+#include "memory/arena.hpp"
+#include "planner/planner.hpp"
+#include "server/query_handler.hpp"
+#include "sql/parser.hpp"
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace edgesql {
+namespace test {
+
+/**
+ * @brief A statement's outcome, with values rendered as text
+ *
+ * NULL renders as "NULL"; other values as the JSON responses show them,
+ * without quotes.
+ */
+struct QueryResult {
+  bool success{false};
+  std::string error;
+  std::vector<std::string> columns;
+  std::vector<std::vector<std::string>> rows;
+  uint64_t rows_affected{0};
+};
+
+/**
+ * @brief Fixture with a fresh catalog, buffer pool and executor per test
+ */
+class SqlTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    const auto *info = ::testing::UnitTest::GetInstance()->current_test_info();
+    dir_ = std::filesystem::temp_directory_path() /
+           (std::string("edgesql_") + info->test_suite_name() + "_" +
+            info->name() + "_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(dir_);
+    std::filesystem::create_directories(dir_);
+
+    planner::Catalog::instance().clear();
+    pages_ = std::make_unique<storage::PageManager>(dir_.string(), 256);
+    ASSERT_TRUE(pages_->init());
+    executor_ = std::make_unique<executor::Executor>(
+        *pages_, planner::Catalog::instance());
+    planner_ = std::make_unique<planner::Planner>(planner::Catalog::instance());
+  }
+
+  void TearDown() override {
+    handler_.reset();
+    executor_.reset();
+    planner_.reset();
+    pages_.reset();
+    planner::Catalog::instance().clear();
+    std::filesystem::remove_all(dir_);
+  }
+
+  /**
+   * @brief Parse, plan and execute one statement
+   */
+  QueryResult run(const std::string &sql,
+                  const executor::QueryBudget &budget = {}) {
+    QueryResult out;
+    memory::Arena arena;
+    sql::Parser parser(sql, arena);
+    auto stmt = parser.parse();
+    if (!stmt) {
+      out.error = parser.error().to_string();
+      return out;
+    }
+
+    planner_->set_work_memory(budget.work_memory());
+    auto plan = planner_->plan(*stmt, arena);
+    if (!plan) {
+      out.error = planner_->error().to_string();
+      return out;
+    }
+
+    memory::QueryAllocator allocator(budget.max_memory_bytes, arena);
+    executor::ExecutionContext ctx(budget, allocator);
+    auto result = executor_->execute(**plan, ctx);
+
+    out.success = result.success;
+    out.error = result.error;
+    out.columns = result.column_names;
+    out.rows_affected = result.rows_affected;
+    for (const auto &row : result.rows) {
+      std::vector<std::string> values;
+      for (const auto &value : row.values) {
+        values.push_back(render(value));
+      }
+      out.rows.push_back(std::move(values));
+    }
+    return out;
+  }
+
+  /**
+   * @brief Run a statement that must succeed
+   */
+  QueryResult must(const std::string &sql) {
+    QueryResult result = run(sql);
+    EXPECT_TRUE(result.success) << sql << ": " << result.error;
+    return result;
+  }
+
+  /**
+   * @brief Render a VALUES tuple: tuple(1, "'a'") is "(1, 'a')"
+   */
+  template <typename... Values>
+  static std::string tuple(const Values &...values) {
+    std::ostringstream out;
+    const char *separator = "";
+    out << '(';
+    ((out << separator << values, separator = ", "), ...);
+    out << ')';
+    return out.str();
+  }
+
+  /**
+   * @brief Insert rows in batches
+   * @param row Renders row i as a VALUES tuple
+   */
+  template <typename Row>
+  void insert_rows(const std::string &table, size_t rows, Row row) {
+    constexpr size_t BATCH = 500;
+    for (size_t start = 0; start < rows; start += BATCH) {
+      std::ostringstream sql;
+      sql << "INSERT INTO " << table << " VALUES ";
+      for (size_t i = start; i < std::min(rows, start + BATCH); ++i) {
+        sql << (i > start ? ", " : "") << row(i);
+      }
+      must(sql.str());
+    }
+  }
+
+  /**
+   * @brief Whether the statement's plan has a node of the type, looking
+   *        down each node's child, or a join's left input
+   */
+  bool plans(const std::string &sql, planner::PlanNodeType type) {
+    memory::Arena arena;
+    sql::Parser parser(sql, arena);
+    auto stmt = parser.parse();
+    auto plan = stmt ? planner_->plan(*stmt, arena) : std::nullopt;
+    EXPECT_TRUE(plan) << sql;
+    const planner::PlanNode *node = plan ? plan->get() : nullptr;
+    while (node && node->type != type) {
+      node = std::visit(
+          [](const auto &n) -> const planner::PlanNode * {
+            if constexpr (requires { n.child; }) {
+              return n.child.get();
+            } else if constexpr (requires { n.left; }) {
+              return n.left.get();
+            } else {
+              return nullptr;
+            }
+          },
+          node->node);
+    }
+    return node != nullptr;
+  }
+
+  /**
+   * @brief The query handler, built on first use over the same executor
+   */
+  server::QueryHandler &handler() {
+    if (!handler_) {
+      handler_ = std::make_unique<server::QueryHandler>(*executor_, *planner_);
+    }
+    return *handler_;
+  }
+
+  /**
+   * @brief Send a statement to the query handler as an HTTP body
+   */
+  server::HttpResponse request(const std::string &sql) {
+    server::HttpRequest req{};
+    req.method = server::HttpMethod::POST;
+    req.path = "/query";
+    req.body = sql;
+    return handler().handle(req);
+  }
+
+  static std::string render(const sql::Literal &value) {
+    switch (value.type) {
+    case sql::Literal::Type::NULL_VAL:
+      return "NULL";
+    case sql::Literal::Type::INTEGER:
+      return std::to_string(value.int_value);
+    case sql::Literal::Type::FLOAT: {
+      std::ostringstream out;
+      out << value.float_value;
+      return out.str();
+    }
+    case sql::Literal::Type::STRING:
+      return std::string(value.string_value);
+    case sql::Literal::Type::BOOLEAN:
+      return value.bool_value ? "true" : "false";
+    }
+    return "";
+  }
+
+  std::filesystem::path dir_;
+  std::unique_ptr<storage::PageManager> pages_;
+  std::unique_ptr<executor::Executor> executor_;
+  std::unique_ptr<planner::Planner> planner_;
+  std::unique_ptr<server::QueryHandler> handler_;
+};
+
+} // namespace test
+} // namespace edgesql
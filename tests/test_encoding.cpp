@@ -0,0 +1,290 @@
+/**
+ * @file test_encoding.cpp
+ * @brief Column encodings and encoded pages: round trips and range selects;
+ *        PAX pages
+ */
+
+#include "sql_fixture.hpp"
+#include "storage/encoded_page.hpp"
+#include "storage/encoding.hpp"
+#include "storage/pax_page.hpp"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+
+namespace edgesql {
+namespace storage {
+namespace {
+
+struct IntCase {
+  const char *name;
+  Encoding expected;
+  std::vector<int64_t> values;
+};
+
+std::vector<IntCase> int_cases() {
+  std::vector<IntCase> cases;
+  std::mt19937_64 rng(42);
+
+  IntCase timestamps{"timestamps", Encoding::DELTA_DELTA, {}};
+  for (int64_t i = 0; i < 2000; ++i) {
+    timestamps.values.push_back(1700000000000 + i * 1000);
+  }
+  cases.push_back(std::move(timestamps));
+
+  IntCase runs{"runs", Encoding::RLE, {}};
+  for (int64_t i = 0; i < 2000; ++i) {
+    runs.values.push_back(i / 250 * 7 - 20);
+  }
+  cases.push_back(std::move(runs));
+
+  IntCase narrow{"narrow", Encoding::BITPACK, {}};
+  for (int i = 0; i < 2000; ++i) {
+    narrow.values.push_back(1000 + static_cast<int64_t>(rng() % 100));
+  }
+  cases.push_back(std::move(narrow));
+
+  IntCase wide{"wide", Encoding::PLAIN, {}};
+  for (int i = 0; i < 2000; ++i) {
+    wide.values.push_back(static_cast<int64_t>(rng()));
+  }
+  wide.values[0] = INT64_MIN;
+  wide.values[1] = INT64_MAX;
+  cases.push_back(std::move(wide));
+  return cases;
+}
+
+TEST(EncodingTest, IntegersRoundTrip) {
+  for (const IntCase &c : int_cases()) {
+    std::vector<uint8_t> block;
+    EXPECT_EQ(encode_ints(c.values.data(), c.values.size(), block), c.expected)
+        << c.name;
+
+    std::vector<int64_t> decoded(c.values.size());
+    ASSERT_TRUE(decode_ints(block.data(), block.size(), decoded.size(),
+                            decoded.data()))
+        << c.name;
+    EXPECT_EQ(decoded, c.values) << c.name;
+  }
+}
+
+TEST(EncodingTest, RangeSelectMatchesDecodedValues) {
+  for (const IntCase &c : int_cases()) {
+    std::vector<uint8_t> block;
+    encode_ints(c.values.data(), c.values.size(), block);
+
+    int64_t mid = c.values[c.values.size() / 2];
+    std::vector<std::pair<int64_t, int64_t>> ranges = {
+        {INT64_MIN, INT64_MAX}, {mid, mid},         {mid - 50, mid + 50},
+        {INT64_MIN, mid},       {mid, INT64_MAX},   {mid + 1, mid - 1},
+        {INT64_MIN, INT64_MIN}, {INT64_MAX, INT64_MAX}};
+    for (auto [lo, hi] : ranges) {
+      std::vector<uint8_t> selected(c.values.size(), 2);
+      size_t hits = select_int_range(block.data(), block.size(),
+                                     c.values.size(), lo, hi, selected.data());
+      size_t expected_hits = 0;
+      for (size_t i = 0; i < c.values.size(); ++i) {
+        bool in_range = c.values[i] >= lo && c.values[i] <= hi;
+        expected_hits += in_range;
+        ASSERT_EQ(selected[i], in_range ? 1 : 0)
+            << c.name << " [" << lo << ", " << hi << "] row " << i;
+      }
+      EXPECT_EQ(hits, expected_hits) << c.name;
+    }
+  }
+}
+
+TEST(EncodingTest, StringsRoundTrip) {
+  std::vector<std::string> repeated;
+  std::vector<std::string> distinct;
+  for (int i = 0; i < 1000; ++i) {
+    repeated.push_back("status_" + std::to_string(i % 4));
+    distinct.push_back("row " + std::to_string(i * 7919));
+  }
+  distinct[3].clear();
+
+  for (const auto *strings : {&repeated, &distinct}) {
+    std::vector<std::string_view> views(strings->begin(), strings->end());
+    std::vector<uint8_t> block;
+    Encoding encoding = encode_strings(views.data(), views.size(), block);
+    EXPECT_EQ(encoding, strings == &repeated ? Encoding::DICTIONARY
+                                             : Encoding::PLAIN);
+
+    std::vector<std::string_view> decoded(views.size());
+    ASSERT_TRUE(decode_strings(block.data(), block.size(), decoded.size(),
+                               decoded.data()));
+    EXPECT_EQ(decoded, views);
+  }
+}
+
+TEST(EncodingTest, TruncatedBlockIsRejected) {
+  std::vector<int64_t> values(100);
+  for (size_t i = 0; i < values.size(); ++i) {
+    values[i] = static_cast<int64_t>(i * i);
+  }
+  std::vector<uint8_t> block;
+  encode_ints(values.data(), values.size(), block);
+
+  std::vector<int64_t> decoded(values.size());
+  EXPECT_FALSE(decode_ints(block.data(), block.size() / 2, values.size(),
+                           decoded.data()));
+}
+
+// A page packs every column, and range selects skip NULL placeholders
+TEST(EncodedPageTest, PackDecodeAndSelect) {
+  std::vector<std::string> texts;
+  std::vector<ColumnVector> columns(2);
+  columns[0].type = ColumnType::INTEGER;
+  columns[1].type = ColumnType::TEXT;
+  for (int64_t i = 0; i < 1000; ++i) {
+    bool null = i % 10 == 0;
+    columns[0].ints.push_back(null ? 0 : i - 500);
+    columns[0].nulls.push_back(null);
+    texts.push_back(std::string(1, static_cast<char>('a' + i % 3)));
+  }
+  for (const auto &text : texts) {
+    columns[1].texts.push_back(text);
+    columns[1].nulls.push_back(0);
+  }
+
+  Page page;
+  size_t packed = EncodedPage::pack(page, 7, columns, 0, EncodedPage::MAX_ROWS);
+  ASSERT_EQ(packed, 1000u);
+  ASSERT_TRUE(EncodedPage::is_encoded(page));
+
+  EncodedPage encoded(page);
+  ASSERT_EQ(encoded.row_count(), 1000u);
+  ASSERT_EQ(encoded.column_count(), 2u);
+
+  std::vector<int64_t> ints(encoded.row_count());
+  std::vector<std::string_view> strings(encoded.row_count());
+  ASSERT_TRUE(encoded.decode_ints(0, ints.data()));
+  ASSERT_TRUE(encoded.decode_strings(1, strings.data()));
+  for (uint32_t r = 0; r < encoded.row_count(); ++r) {
+    EXPECT_EQ(encoded.is_null(0, r), r % 10 == 0);
+    if (!encoded.is_null(0, r)) {
+      EXPECT_EQ(ints[r], static_cast<int64_t>(r) - 500);
+    }
+    EXPECT_EQ(strings[r], texts[r]);
+  }
+
+  // 0 is the NULL placeholder, so [-5, 5] matches 10 rows, not 12
+  std::vector<uint8_t> selected(encoded.row_count());
+  EXPECT_EQ(encoded.select_range(0, -5, 5, selected.data()), 10u);
+  EXPECT_FALSE(selected[0]);
+  EXPECT_TRUE(selected[495]);
+  EXPECT_FALSE(selected[500]);
+}
+
+// A PAX page takes rows until it is full and gives back each value,
+// NULLs included
+TEST(PaxPageTest, AppendUntilFull) {
+  const std::vector<ColumnType> types = {
+      ColumnType::INTEGER, ColumnType::TEXT, ColumnType::FLOAT,
+      ColumnType::BOOLEAN};
+  auto text_of = [](uint16_t r) {
+    return std::string(r % 20, static_cast<char>('a' + r % 26));
+  };
+
+  Page page;
+  ASSERT_TRUE(PaxPage::init(page, 7, types));
+  ASSERT_TRUE(PaxPage::is_pax(page));
+  uint16_t rows = 0;
+  for (;; ++rows) {
+    Record record(types.size());
+    if (rows % 5 == 0) {
+      record.set_null(0);
+    } else {
+      record.set_integer(0, rows * 3 - 100);
+    }
+    record.set_text(1, text_of(rows));
+    record.set_float(2, rows * 0.5);
+    record.set_boolean(3, rows % 2 == 1);
+    if (!PaxPage::append(page, record)) {
+      break;
+    }
+  }
+
+  PaxPage pax(page);
+  ASSERT_GT(rows, 100);
+  EXPECT_EQ(pax.row_count(), rows);
+  EXPECT_LE(rows, pax.capacity());
+  EXPECT_EQ(pax.column_count(), types.size());
+  for (uint16_t r = 0; r < rows; ++r) {
+    ASSERT_EQ(pax.is_null(0, r), r % 5 == 0) << r;
+    if (r % 5 != 0) {
+      EXPECT_EQ(pax.int_values(0)[r], r * 3 - 100);
+    }
+    EXPECT_EQ(pax.text(1, r), text_of(r));
+    EXPECT_EQ(pax.float_values(2)[r], r * 0.5);
+    EXPECT_EQ(pax.bool_values(3)[r] != 0, r % 2 == 1);
+  }
+}
+
+class PaxLayoutTest : public test::SqlTest {};
+
+// A columnar table answers like a row table holding the same rows, over
+// many pages, with NULLs and text of every length
+TEST_F(PaxLayoutTest, ColumnarTableMatchesRowTable) {
+  must("CREATE TABLE r (id INTEGER, s TEXT, f FLOAT, b BOOLEAN)");
+  must("CREATE TABLE c (id INTEGER, s TEXT, f FLOAT, b BOOLEAN) "
+       "USING COLUMNAR");
+  ASSERT_EQ(planner::Catalog::instance().get_table("c")->layout,
+            PageLayout::PAX);
+  auto row = [](size_t i) {
+    std::string s = std::string(i % 90, 't').insert(0, 1, '\'') + '\'';
+    if (i % 7 == 0) {
+      s = "NULL";
+    }
+    return tuple(i, s, i * 0.25, i % 3 == 0 ? "TRUE" : "FALSE");
+  };
+  insert_rows("r", 3000, row);
+  insert_rows("c", 3000, row);
+
+  for (const std::string where :
+       {"", " WHERE id >= 100 AND id < 2000", " WHERE id = 1234"}) {
+    for (const std::string select :
+         {"SELECT id, s, f, b FROM ", "SELECT COUNT(*), COUNT(s), SUM(id), "
+                                      "MAX(f), MIN(s) FROM "}) {
+      test::QueryResult rows = must(select + "r" + where);
+      ASSERT_FALSE(rows.rows.empty());
+      EXPECT_EQ(must(select + "c" + where).rows, rows.rows) << select << where;
+    }
+  }
+}
+
+class EncodedScanTest : public test::SqlTest {};
+
+// Sealed partitions are encoded; a time range inside one of them is
+// selected on the encoded block, and partitions outside it are skipped
+TEST_F(EncodedScanTest, TimeRangeSelectsEncodedRows) {
+  must("CREATE TABLE m (ts INTEGER, v INTEGER) USING COLUMNAR "
+       "PARTITION BY ts EVERY 100");
+  insert_rows("m", 1000, [](size_t i) { return tuple(i, i % 3); });
+
+  auto count = [&](const std::string &where) {
+    test::QueryResult result = must("SELECT COUNT(*) FROM m WHERE " + where);
+    return result.rows.empty() ? std::string() : result.rows[0][0];
+  };
+  EXPECT_EQ(count("ts >= 150 AND ts <= 349"), "200");
+  EXPECT_EQ(count("ts > 120 AND ts < 125"), "4");
+  EXPECT_EQ(count("ts >= 990"), "10");
+  EXPECT_EQ(count("ts > 5000"), "0");
+  EXPECT_EQ(count("ts >= 150 AND ts <= 349 AND v = 0"), "67");
+}
+
+// Layout words are keywords in any case
+TEST_F(EncodedScanTest, LayoutClauseInAnyCase) {
+  must("create table c (v integer) using columnar");
+  must("Create Table r (v Integer) Using Row");
+  auto &catalog = planner::Catalog::instance();
+  ASSERT_TRUE(catalog.get_table("c") && catalog.get_table("r"));
+  EXPECT_EQ(catalog.get_table("c")->layout, PageLayout::PAX);
+  EXPECT_EQ(catalog.get_table("r")->layout, PageLayout::ROW);
+
+  EXPECT_FALSE(run("CREATE TABLE x (v INTEGER) USING pax").success);
+}
+
+} // anonymous namespace
+} // namespace storage
+} // namespace edgesql
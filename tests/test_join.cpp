@@ -0,0 +1,193 @@
+/**
+ * @file test_join.cpp
+ * @brief Hash joins in memory and spilled to disk, and primary key
+ *        lookup joins
+ */
+
+#include "observability/metrics.hpp"
+#include "sql_fixture.hpp"
+#include <algorithm>
+
+namespace edgesql {
+namespace test {
+namespace {
+
+class HashJoinTest : public SqlTest {
+protected:
+  // a: ids 0..4999 with wide rows; b: every id not divisible by 3, twice,
+  // and rows with a NULL id
+  void SetUp() override {
+    SqlTest::SetUp();
+    must("CREATE TABLE a (id INTEGER, g INTEGER, pad TEXT)");
+    must("CREATE TABLE b (id INTEGER, w INTEGER)");
+    insert_rows("a", 5000, [](size_t i) {
+      return tuple(i, i % 7, "'" + std::string(60, 'p') + "'");
+    });
+    insert_rows("b", 7000, [](size_t i) {
+      size_t id = i % 3500 * 3 / 2 + 1; // Skips multiples of 3
+      return i % 500 == 0 ? tuple("NULL", i) : tuple(id, i % 11);
+    });
+  }
+
+  uint64_t spills() {
+    return observability::Metrics::instance().get_counter("join_spills");
+  }
+
+  // The query's rows with the default budget, and with a budget so small
+  // that the join must spill
+  void expect_spill_matches(const std::string &sql) {
+    uint64_t before = spills();
+    QueryResult in_memory = must(sql);
+    ASSERT_FALSE(in_memory.rows.empty());
+    EXPECT_EQ(spills(), before) << sql;
+
+    executor::QueryBudget small;
+    small.max_memory_bytes = 256 * 1024;
+    QueryResult spilled = run(sql, small);
+    ASSERT_TRUE(spilled.success) << sql << ": " << spilled.error;
+    EXPECT_GT(spills(), before) << sql;
+    EXPECT_EQ(spilled.rows, in_memory.rows) << sql;
+  }
+
+  // Whether the query spills under a budget of the given size, checking
+  // its rows against the default budget's
+  bool spills_under(const std::string &sql, size_t budget_kb) {
+    executor::QueryBudget budget;
+    budget.max_memory_bytes = budget_kb * 1024;
+    uint64_t before = spills();
+    QueryResult result = run(sql, budget);
+    EXPECT_TRUE(result.success) << sql << ": " << result.error;
+    bool spilled = spills() > before;
+    EXPECT_EQ(result.rows, must(sql).rows) << sql << " in " << budget_kb;
+    return spilled;
+  }
+};
+
+TEST_F(HashJoinTest, SpilledInnerJoinMatchesInMemory) {
+  expect_spill_matches("SELECT a.g, COUNT(*), SUM(b.w) FROM a JOIN b "
+                       "ON a.id = b.id GROUP BY a.g ORDER BY a.g");
+
+  QueryResult total = must("SELECT COUNT(*) FROM a JOIN b ON a.id = b.id");
+  ASSERT_EQ(total.rows.size(), 1u);
+  EXPECT_EQ(total.rows[0][0], "6652"); // Less 14 NULL ids and 334 past 4999
+}
+
+// Unmatched and NULL-keyed probe rows are padded in whichever partition
+// they land
+TEST_F(HashJoinTest, SpilledLeftJoinPadsUnmatchedRows) {
+  expect_spill_matches("SELECT a.g, COUNT(*), COUNT(b.w), SUM(b.w) FROM a "
+                       "LEFT JOIN b ON a.id = b.id GROUP BY a.g ORDER BY a.g");
+  expect_spill_matches("SELECT COUNT(*), COUNT(a.id) FROM b LEFT JOIN a "
+                       "ON b.id = a.id AND a.g < 3");
+}
+
+// The build side spills once it outgrows a quarter of the budget: all of
+// b takes over 1MB and under 1.5MB of rows, arrays and index
+TEST_F(HashJoinTest, SpillFollowsWorkMemory) {
+  const std::string sql = "SELECT a.g, COUNT(*), SUM(b.w) FROM a JOIN b "
+                          "ON a.id = b.id GROUP BY a.g ORDER BY a.g";
+  EXPECT_FALSE(spills_under(sql, 8192));
+  EXPECT_TRUE(spills_under(sql, 4096));
+  EXPECT_TRUE(spills_under(sql, 1024));
+}
+
+// Work memory never drops below 256KB while the query has it to spare:
+// b's rows with w = 0 fit there though a quarter of 200KB is far less,
+// and spill only once the budget itself cannot hold them
+TEST_F(HashJoinTest, SmallBudgetKeepsMinimumWorkMemory) {
+  const std::string sql = "SELECT a.g, COUNT(*) FROM a JOIN b "
+                          "ON a.id = b.id AND b.w < 1 GROUP BY a.g "
+                          "ORDER BY a.g";
+  EXPECT_FALSE(spills_under(sql, 400));
+  EXPECT_FALSE(spills_under(sql, 200));
+  EXPECT_TRUE(spills_under(sql, 100));
+}
+
+// Join words are keywords in any case, never taken for a table alias
+TEST_F(HashJoinTest, JoinKeywordsInAnyCase) {
+  QueryResult inner = must("SELECT COUNT(*) FROM a JOIN b ON a.id = b.id");
+  EXPECT_EQ(must("select count(*) from a join b on a.id = b.id").rows,
+            inner.rows);
+  EXPECT_EQ(must("SELECT COUNT(*) FROM a x Inner Join b y oN x.id = y.id")
+                .rows,
+            inner.rows);
+
+  QueryResult left =
+      must("SELECT COUNT(*) FROM a LEFT OUTER JOIN b ON a.id = b.id");
+  EXPECT_EQ(must("select count(*) from a left outer join b on a.id = b.id")
+                .rows,
+            left.rows);
+  EXPECT_FALSE(run("SELECT COUNT(*) FROM a left b ON a.id = b.id").success);
+}
+
+// d and h hold the same rows, with the even ids below 40,000, but only
+// d's id is a primary key; f's keys are spread past that range in no
+// order, some NULL
+class IndexJoinTest : public SqlTest {
+protected:
+  void SetUp() override {
+    SqlTest::SetUp();
+    must("CREATE TABLE d (id INTEGER PRIMARY KEY, v INTEGER, pad TEXT)");
+    must("CREATE TABLE h (id INTEGER, v INTEGER, pad TEXT)");
+    must("CREATE TABLE f (k INTEGER, n INTEGER)");
+    auto row = [](size_t i) {
+      return tuple(i * 2, i % 13, "'" + std::string(400, 'd') + "'");
+    };
+    insert_rows("d", 20000, row);
+    insert_rows("h", 20000, row);
+    insert_rows("f", 300, [](size_t i) {
+      return i % 100 == 0 ? tuple("NULL", i) : tuple(i * 7919 % 45000, i);
+    });
+    must("ANALYZE d");
+    must("ANALYZE h");
+    must("ANALYZE f");
+  }
+
+  // The query, written with @ for the joined table, plans key lookups
+  // into d and returns the rows a hash join of h does
+  void expect_index_join_matches(const std::string &sql) {
+    std::string keyed = sql;
+    std::string hashed = sql;
+    std::replace(keyed.begin(), keyed.end(), '@', 'd');
+    std::replace(hashed.begin(), hashed.end(), '@', 'h');
+    EXPECT_TRUE(plans(keyed, planner::PlanNodeType::INDEX_JOIN)) << keyed;
+    EXPECT_FALSE(plans(hashed, planner::PlanNodeType::INDEX_JOIN)) << hashed;
+
+    QueryResult looked_up = must(keyed);
+    ASSERT_FALSE(looked_up.rows.empty()) << keyed;
+    EXPECT_EQ(looked_up.rows, must(hashed).rows) << keyed;
+  }
+};
+
+// Left rows are looked up a batch at a time; unmatched and NULL keys find
+// nothing, and are padded by a LEFT join
+TEST_F(IndexJoinTest, LookupsMatchHashJoin) {
+  expect_index_join_matches("SELECT f.n, f.k, @.v FROM f JOIN @ "
+                            "ON f.k = @.id ORDER BY f.n");
+  expect_index_join_matches("SELECT f.n, @.id, @.v FROM f LEFT JOIN @ "
+                            "ON f.k = @.id ORDER BY f.n");
+
+  QueryResult matched = must("SELECT COUNT(*) FROM f JOIN d ON f.k = d.id");
+  ASSERT_EQ(matched.rows.size(), 1u);
+  size_t expected = 0;
+  for (size_t i = 0; i < 300; ++i) {
+    size_t k = i * 7919 % 45000;
+    expected += i % 100 != 0 && k % 2 == 0 && k < 40000;
+  }
+  EXPECT_EQ(matched.rows[0][0], std::to_string(expected));
+}
+
+// Conditions on d's row are checked after the lookup, and the rest once
+// both rows are joined
+TEST_F(IndexJoinTest, FiltersApplyToLookedUpRows) {
+  expect_index_join_matches("SELECT f.n, @.v FROM f JOIN @ "
+                            "ON f.k = @.id AND @.v < 5 ORDER BY f.n");
+  expect_index_join_matches("SELECT f.n, @.v FROM f LEFT JOIN @ "
+                            "ON f.k = @.id AND @.v < 5 ORDER BY f.n");
+  expect_index_join_matches("SELECT f.n, @.v FROM f JOIN @ "
+                            "ON @.id = f.k AND f.n % 13 < @.v ORDER BY f.n");
+}
+
+} // anonymous namespace
+} // namespace test
+} // namespace edgesql
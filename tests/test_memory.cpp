@@ -0,0 +1,199 @@
+/**
+ * @file test_memory.cpp
+ * @brief Query arenas, their pool, containers drawing from them, and the
+ *        slab allocator
+ */
+
+#include "memory/arena_pool.hpp"
+#include "memory/query_resource.hpp"
+#include "memory/slab_allocator.hpp"
+#include "sql_fixture.hpp"
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace edgesql {
+namespace memory {
+namespace {
+
+// A returned arena is reset, trimmed to the retention and handed out
+// again; the pool keeps at most max_idle_arenas
+TEST(ArenaPoolTest, ReturnedArenaIsReused) {
+  ArenaPoolConfig config;
+  config.max_idle_arenas = 2;
+  config.block_size = 4096;
+  config.retain_bytes = 8192;
+  ArenaPool pool(config);
+
+  Arena *first = nullptr;
+  {
+    PooledArena arena = pool.acquire();
+    first = arena.get();
+    for (int i = 0; i < 8; ++i) {
+      arena->allocate(3000);
+    }
+    arena->allocate(64 * 1024);
+    EXPECT_GT(arena->capacity(), config.retain_bytes);
+  }
+  EXPECT_EQ(pool.idle_count(), 1u);
+  EXPECT_GT(pool.retained_bytes(), 0u);
+  EXPECT_LE(pool.retained_bytes(), config.retain_bytes);
+
+  {
+    PooledArena again = pool.acquire();
+    EXPECT_EQ(again.get(), first);
+    EXPECT_EQ(again->bytes_allocated(), 0u);
+    EXPECT_EQ(pool.idle_count(), 0u);
+    EXPECT_EQ(pool.retained_bytes(), 0u);
+  }
+
+  {
+    PooledArena a = pool.acquire();
+    PooledArena b = pool.acquire();
+    PooledArena c = pool.acquire();
+  }
+  EXPECT_EQ(pool.idle_count(), 2u);
+  EXPECT_GT(pool.drop_idle(), 0u);
+  EXPECT_EQ(pool.idle_count(), 0u);
+}
+
+class PooledQueryTest : public test::SqlTest {};
+
+// Each request borrows the worker's arena and gives it back
+TEST_F(PooledQueryTest, RequestsReuseWorkerArena) {
+  must("CREATE TABLE t (a INTEGER)");
+  ArenaPool &pool = ArenaPool::local();
+  pool.drop_idle();
+
+  ASSERT_EQ(request("SELECT a FROM t").status_code, 200);
+  EXPECT_EQ(pool.idle_count(), 1u);
+  ASSERT_EQ(request("SELECT COUNT(*) FROM t").status_code, 200);
+  EXPECT_EQ(pool.idle_count(), 1u);
+}
+
+// pmr containers on the query resource count against the budget, and
+// throw once past it
+TEST(QueryMemoryResourceTest, ContainersChargeTheBudget) {
+  Arena arena;
+  QueryAllocator allocator(64 * 1024, arena);
+  QueryMemoryResource resource(allocator);
+
+  std::pmr::vector<int64_t> values(&resource);
+  values.resize(1000);
+  EXPECT_GE(allocator.bytes_used(), 1000 * sizeof(int64_t));
+  EXPECT_THROW(values.resize(100000), MemoryBudgetExceeded);
+}
+
+// Moving constructs onto the source's resource without allocating;
+// assigning onto another resource copies, so it may throw
+TEST(QueryMemoryResourceTest, MoveAssignmentCopiesAcrossResources) {
+  static_assert(std::is_nothrow_move_constructible_v<sql::Literal>);
+  static_assert(std::is_nothrow_move_constructible_v<executor::ResultRow>);
+  static_assert(!std::is_nothrow_move_assignable_v<sql::Literal>);
+  static_assert(!std::is_nothrow_move_assignable_v<executor::ResultRow>);
+
+  Arena arena;
+  QueryAllocator allocator(64 * 1024, arena);
+  QueryMemoryResource resource(allocator);
+  const std::string text(100, 'x');
+
+  executor::ResultRow row(&resource);
+  row.values.emplace_back();
+  row.values[0].type = sql::Literal::Type::STRING;
+  row.values[0].string_value = text;
+  EXPECT_EQ(row.values[0].string_value.get_allocator().resource(),
+            &resource);
+
+  executor::ResultRow moved(std::move(row));
+  EXPECT_EQ(moved.values.get_allocator().resource(), &resource);
+
+  executor::ResultRow on_heap;
+  on_heap = std::move(moved);
+  ASSERT_EQ(on_heap.values.size(), 1u);
+  EXPECT_EQ(std::string_view(on_heap.values[0].string_value), text);
+  EXPECT_EQ(on_heap.values.get_allocator().resource(),
+            std::pmr::get_default_resource());
+  EXPECT_EQ(on_heap.values[0].string_value.get_allocator().resource(),
+            std::pmr::get_default_resource());
+}
+
+// Result rows are drawn from the query's budget
+TEST_F(PooledQueryTest, ResultRowsChargeTheBudget) {
+  must("CREATE TABLE t (a INTEGER, pad TEXT)");
+  insert_rows("t", 2000, [](size_t i) {
+    return tuple(i, "'" + std::string(100, 'p') + "'");
+  });
+
+  executor::QueryBudget budget;
+  budget.max_memory_bytes = 128 * 1024;
+  test::QueryResult result = run("SELECT a, pad FROM t", budget);
+  EXPECT_FALSE(result.success);
+  EXPECT_EQ(result.error.rfind("Memory budget exceeded", 0), 0u)
+      << result.error;
+  EXPECT_TRUE(run("SELECT COUNT(*) FROM t WHERE a >= 0", budget).success);
+}
+
+// A request takes the smallest class that holds it; past the largest it
+// goes to the heap
+TEST(SlabAllocatorTest, RequestsTakeSmallestClass) {
+  for (size_t size = 1; size <= SlabAllocator::MAX_SIZE; ++size) {
+    size_t index = SlabAllocator::size_class(size);
+    ASSERT_LT(index, SlabAllocator::NUM_CLASSES) << size;
+    ASSERT_GE(SlabAllocator::class_size(index), size);
+    if (index > 0) {
+      ASSERT_LT(SlabAllocator::class_size(index - 1), size);
+    }
+  }
+  EXPECT_EQ(SlabAllocator::size_class(SlabAllocator::MAX_SIZE + 1),
+            SlabAllocator::NUM_CLASSES);
+}
+
+// Live objects never overlap; a freed object is handed out again before
+// the slabs grow, whichever thread freed it
+TEST(SlabAllocatorTest, FreedObjectsAreReused) {
+  SlabAllocator &slab = SlabAllocator::instance();
+  constexpr size_t SIZE = 200;
+  constexpr size_t COUNT = 2000;
+
+  auto fill = [&](std::vector<uint8_t *> &objects) {
+    for (size_t i = 0; i < COUNT; ++i) {
+      objects.push_back(static_cast<uint8_t *>(slab.allocate(SIZE)));
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(objects.back()) % 16, 0u);
+      std::memset(objects.back(), static_cast<int>(i % 251), SIZE);
+    }
+    for (size_t i = 0; i < COUNT; ++i) {
+      ASSERT_EQ(objects[i][0], i % 251);
+      ASSERT_EQ(objects[i][SIZE - 1], i % 251);
+    }
+  };
+
+  std::vector<uint8_t *> objects;
+  fill(objects);
+  std::thread([&] {
+    for (uint8_t *object : objects) {
+      slab.deallocate(object, SIZE);
+    }
+  }).join();
+
+  size_t held = slab.slab_bytes();
+  objects.clear();
+  fill(objects);
+  EXPECT_EQ(slab.slab_bytes(), held);
+  for (uint8_t *object : objects) {
+    slab.deallocate(object, SIZE);
+  }
+
+  void *object = slab.allocate(SIZE);
+  slab.deallocate(object, SIZE);
+  EXPECT_EQ(slab.allocate(SIZE), object);
+  slab.deallocate(object, SIZE);
+
+  uint64_t large = slab.large_allocations();
+  void *big = slab.allocate(SlabAllocator::MAX_SIZE + 1);
+  EXPECT_EQ(slab.large_allocations(), large + 1);
+  slab.deallocate(big, SlabAllocator::MAX_SIZE + 1);
+}
+
+} // anonymous namespace
+} // namespace memory
+} // namespace edgesql
@@ -0,0 +1,154 @@
+/**
+ * @file test_page_manager.cpp
+ * @brief Buffer pool pinning under frame exhaustion, and the frame pool
+ */
+
+#include "storage/frame_pool.hpp"
+#include "storage/page_manager.hpp"
+#include <cstring>
+#include <filesystem>
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace edgesql {
+namespace storage {
+namespace {
+
+class PageManagerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    dir_ = std::filesystem::temp_directory_path() /
+           ("edgesql_page_manager_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(dir_);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir_); }
+
+  std::filesystem::path dir_;
+};
+
+TEST_F(PageManagerTest, MissingPageIsNotFound) {
+  PageManager pages(dir_.string(), 2);
+  ASSERT_TRUE(pages.init());
+  ASSERT_TRUE(pages.create_table_file(1));
+
+  PinStatus status = PinStatus::OK;
+  EXPECT_FALSE(pages.pin_page(1, 0, &status));
+  EXPECT_EQ(status, PinStatus::NOT_FOUND);
+}
+
+TEST_F(PageManagerTest, PinnedPoolReportsNoFrame) {
+  PageManager pages(dir_.string(), 2);
+  ASSERT_TRUE(pages.init());
+  ASSERT_TRUE(pages.create_table_file(1));
+
+  // Three pages on disk, two frames
+  for (uint32_t i = 0; i < 3; ++i) {
+    ASSERT_EQ(pages.allocate_page(1), i);
+  }
+  pages.flush_all();
+
+  PageGuard first = pages.pin_page(1, 0);
+  PageGuard second = pages.pin_page(1, 1);
+  ASSERT_TRUE(first);
+  ASSERT_TRUE(second);
+
+  // The page exists but no frame is free for it
+  PinStatus status = PinStatus::OK;
+  EXPECT_FALSE(pages.pin_page(1, 2, &status));
+  EXPECT_EQ(status, PinStatus::NO_FRAME);
+  EXPECT_EQ(pages.allocate_page(1), UINT32_MAX);
+
+  // Past the end of the table is still just missing
+  EXPECT_FALSE(pages.pin_page(1, 3, &status));
+  EXPECT_EQ(status, PinStatus::NOT_FOUND);
+
+  // Unpinning lets the waiting pin go ahead
+  second.release();
+  PageGuard third = pages.pin_page(1, 2, &status);
+  EXPECT_TRUE(third);
+  EXPECT_EQ(status, PinStatus::OK);
+}
+
+// Pages cycle through a pool smaller than their table and keep their
+// contents; dropping a table frees its frames at once
+TEST_F(PageManagerTest, FramesRecycleAcrossEviction) {
+  PageManager pages(dir_.string(), 4);
+  ASSERT_TRUE(pages.init());
+  ASSERT_TRUE(pages.create_table_file(1));
+  ASSERT_TRUE(pages.create_table_file(2));
+
+  for (uint32_t i = 0; i < 12; ++i) {
+    ASSERT_EQ(pages.allocate_page(1), i);
+    PageGuard page = pages.pin_page(1, i);
+    ASSERT_TRUE(page);
+    uint16_t slot;
+    ASSERT_TRUE(page->insert_record(reinterpret_cast<const uint8_t *>(&i),
+                                    sizeof(i), &slot));
+    pages.mark_dirty(1, i);
+    EXPECT_LE(pages.page_count(), 4u);
+  }
+  for (int round = 0; round < 2; ++round) {
+    for (uint32_t i = 0; i < 12; ++i) {
+      PageGuard page = pages.pin_page(1, i);
+      ASSERT_TRUE(page) << i;
+      const uint8_t *data;
+      uint16_t length;
+      ASSERT_TRUE(page->get_record(0, &data, &length)) << i;
+      uint32_t stored;
+      ASSERT_EQ(length, sizeof(stored));
+      std::memcpy(&stored, data, sizeof(stored));
+      EXPECT_EQ(stored, i);
+    }
+  }
+
+  ASSERT_TRUE(pages.delete_table_file(1));
+  EXPECT_EQ(pages.page_count(), 0u);
+  std::vector<PageGuard> pinned;
+  for (uint32_t i = 0; i < 4; ++i) {
+    ASSERT_EQ(pages.allocate_page(2), i);
+    pinned.push_back(pages.pin_page(2, i));
+    ASSERT_TRUE(pinned.back());
+  }
+}
+
+// Frames are one array indexed by slot
+TEST(FramePoolTest, SlotsIndexOneRegion) {
+  FramePool pool(16);
+  const uint8_t *base = reinterpret_cast<const uint8_t *>(pool.frame(0));
+  for (uint32_t slot = 0; slot < 16; ++slot) {
+    EXPECT_EQ(reinterpret_cast<const uint8_t *>(pool.frame(slot)) - base,
+              static_cast<ptrdiff_t>(slot * PAGE_SIZE));
+  }
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(base) % 4096, 0u);
+}
+
+// Every frame is handed out once until it is returned
+TEST(FramePoolTest, FramesAreHandedOutOnce) {
+  FramePool pool(8);
+  std::vector<Page *> frames;
+  std::vector<uint32_t> slots;
+  for (uint32_t slot = pool.allocate(); slot != INVALID_SLOT;
+       slot = pool.allocate()) {
+    slots.push_back(slot);
+    frames.push_back(pool.frame(slot));
+    frames.back()->init(static_cast<uint32_t>(slots.size()));
+    std::memset(frames.back()->data() + sizeof(PageHeader),
+                static_cast<int>(slots.size()), PAGE_SIZE - sizeof(PageHeader));
+  }
+  ASSERT_EQ(slots.size(), 8u);
+  EXPECT_EQ(pool.in_use(), 8u);
+  for (size_t i = 0; i < frames.size(); ++i) {
+    EXPECT_EQ(frames[i]->header().page_id, i + 1);
+    EXPECT_EQ(frames[i]->data()[PAGE_SIZE - 1], i + 1);
+  }
+
+  pool.release(slots[5], true);
+  EXPECT_EQ(pool.in_use(), 7u);
+  EXPECT_EQ(pool.allocate(), slots[5]);
+  EXPECT_EQ(pool.allocate(), INVALID_SLOT);
+}
+
+} // anonymous namespace
+} // namespace storage
+} // namespace edgesql
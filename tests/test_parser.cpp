@@ -0,0 +1,105 @@
+/**
+ * @file test_parser.cpp
+ * @brief Statements parsed into the query arena
+ */
+
+#include "memory/arena.hpp"
+#include "memory/memory_tracker.hpp"
+#include "sql/parser.hpp"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace edgesql {
+namespace sql {
+namespace {
+
+// INSERT INTO t VALUES (0, 'v0', 0.5), (1, 'v1', 1.5), ...
+std::string insert_sql(size_t rows) {
+  std::string sql = "INSERT INTO t VALUES ";
+  for (size_t i = 0; i < rows; ++i) {
+    std::string n = std::to_string(i);
+    sql.append(i ? ", (" : "(").append(n).append(", 'v").append(n);
+    sql.append("', ").append(n).append(".5)");
+  }
+  return sql;
+}
+
+bool within(std::string_view part, const std::string &text) {
+  return part.data() >= text.data() &&
+         part.data() + part.size() <= text.data() + text.size();
+}
+
+// A 1,000-row INSERT takes a handful of arena blocks, not a node per
+// allocation, and its rows hold every value in order
+TEST(ParserTest, InsertRowsLiveInArena) {
+  const std::string sql = insert_sql(1000);
+  memory::Arena arena;
+  Parser parser(sql, arena);
+  auto stmt = parser.parse();
+  ASSERT_TRUE(stmt) << parser.error().to_string();
+  ASSERT_EQ(stmt->type, StmtType::INSERT);
+  EXPECT_LE(arena.block_count(), 8u);
+
+  const InsertStmt *insert = std::get<const InsertStmt *>(stmt->stmt);
+  EXPECT_EQ(insert->table_name, "t");
+  ASSERT_EQ(insert->values.size(), 1000u);
+  for (size_t i = 0; i < insert->values.size(); ++i) {
+    const ExprList &row = insert->values[i];
+    ASSERT_EQ(row.size(), 3u);
+    EXPECT_EQ(row[0]->int_value, static_cast<int64_t>(i));
+    std::string text = std::string("v").append(std::to_string(i));
+    EXPECT_EQ(row[1]->string_value, text);
+    EXPECT_EQ(row[2]->float_value, static_cast<double>(i) + 0.5);
+  }
+}
+
+// Names and string literals view the query text rather than copying it
+TEST(ParserTest, NamesViewQueryText) {
+  const std::string sql =
+      "SELECT x.a, UPPER(b) FROM t AS x WHERE x.b = 'text' ORDER BY a";
+  memory::Arena arena;
+  Parser parser(sql, arena);
+  auto stmt = parser.parse();
+  ASSERT_TRUE(stmt) << parser.error().to_string();
+
+  const SelectStmt *select = std::get<const SelectStmt *>(stmt->stmt);
+  ASSERT_EQ(select->columns.size(), 2u);
+  const Expression *column = select->columns[0];
+  EXPECT_EQ(column->table_name, "x");
+  EXPECT_EQ(column->name, "a");
+  EXPECT_TRUE(within(column->name, sql));
+  EXPECT_TRUE(within(select->columns[1]->name, sql));
+  EXPECT_TRUE(within(select->table_name, sql));
+  EXPECT_TRUE(within(select->table_alias, sql));
+
+  ASSERT_NE(select->where_clause, nullptr);
+  const Expression *literal = select->where_clause->right;
+  ASSERT_NE(literal, nullptr);
+  EXPECT_EQ(literal->string_value, "text");
+  EXPECT_TRUE(within(literal->string_value, sql));
+}
+
+// An arena the global limit will not grow fails the parse with an error
+// instead of throwing out of it
+TEST(ParserTest, ExhaustedArenaIsParseError) {
+  const std::string sql = insert_sql(1000);
+  memory::MemoryTracker &tracker = memory::MemoryTracker::instance();
+  size_t limit = tracker.limit();
+  memory::Arena arena(4096);
+  tracker.set_limit(tracker.used() + 8192);
+
+  Parser parser(sql, arena);
+  auto stmt = parser.parse();
+  tracker.set_limit(limit);
+  EXPECT_FALSE(stmt);
+  EXPECT_TRUE(parser.has_error());
+  EXPECT_EQ(parser.error().message, "Out of memory");
+
+  arena.reset();
+  Parser retry(sql, arena);
+  EXPECT_TRUE(retry.parse()) << retry.error().to_string();
+}
+
+} // anonymous namespace
+} // namespace sql
+} // namespace edgesql
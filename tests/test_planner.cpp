@@ -0,0 +1,290 @@
+/**
+ * @file test_planner.cpp
+ * @brief Planner choices under the query budget, late column reads,
+ *        replanning, predicate simplification, filter order and table
+ *        summaries
+ */
+
+#include "sql_fixture.hpp"
+
+namespace edgesql {
+namespace test {
+namespace {
+
+class PlannerTest : public SqlTest {
+protected:
+  // Whether the statement's plan reads some columns after its sort,
+  // limit or filter
+  bool fetches_late(const std::string &sql) {
+    return plans(sql, planner::PlanNodeType::FETCH);
+  }
+};
+
+// 20,000 groups do not fit a 256KB budget's work memory, so the
+// aggregation sorts and spills instead of hashing every group. The result
+// rows count against the budget too, so only a few are returned.
+TEST_F(PlannerTest, GroupByUnderSmallBudgetSorts) {
+  must("CREATE TABLE t (k INTEGER, v INTEGER)");
+  insert_rows("t", 20000, [](size_t i) { return tuple(19999 - i, i % 7); });
+
+  executor::QueryBudget budget;
+  budget.max_memory_bytes = 256 * 1024;
+  for (bool analyzed : {false, true}) {
+    if (analyzed) {
+      must("ANALYZE t");
+    }
+    QueryResult result = run(
+        "SELECT k, COUNT(*) FROM t GROUP BY k ORDER BY k DESC LIMIT 3", budget);
+    ASSERT_TRUE(result.success) << result.error;
+    ASSERT_EQ(result.rows.size(), 3u);
+    EXPECT_EQ(result.rows[0][0], "19999");
+    EXPECT_EQ(result.rows[2][0], "19997");
+    EXPECT_EQ(result.rows[2][1], "1");
+  }
+}
+
+// ANALYZE and GROUP are keywords in any case; GROUP after a table name
+// is never taken for its alias
+TEST_F(PlannerTest, GroupAndAnalyzeInAnyCase) {
+  must("CREATE TABLE t (k INTEGER, v INTEGER)");
+  insert_rows("t", 100, [](size_t i) { return tuple(i % 4, i); });
+  must("analyze t");
+  must("Analyze");
+
+  QueryResult grouped = must("SELECT k, SUM(v) FROM t GROUP BY k ORDER BY k");
+  ASSERT_EQ(grouped.rows.size(), 4u);
+  EXPECT_EQ(must("select k, sum(v) from t group by k order by k").rows,
+            grouped.rows);
+  EXPECT_EQ(must("select x.k, sum(x.v) from t x Group By x.k order by x.k")
+                .rows,
+            grouped.rows);
+}
+
+// Statement and column options are keywords in any case
+TEST_F(PlannerTest, OptionsInAnyCase) {
+  must("create table if not exists p (id integer primary key, "
+       "v integer default 5)");
+  must("Create Table If Not Exists p (id Integer)");
+  const planner::TableInfo *table = planner::Catalog::instance().get_table("p");
+  ASSERT_TRUE(table);
+  EXPECT_EQ(table->primary_key_column(), 0);
+
+  QueryResult distinct = run("select count(distinct id) from p");
+  EXPECT_FALSE(distinct.success);
+  EXPECT_NE(distinct.error.find("DISTINCT"), std::string::npos)
+      << distinct.error;
+  must("drop table if exists p");
+  must("Drop Table If Exists p");
+}
+
+// The handler plans with its own budget's work memory
+TEST_F(PlannerTest, HandlerPlansWithItsBudget) {
+  must("CREATE TABLE t (k INTEGER)");
+  insert_rows("t", 20000, [](size_t i) { return tuple(i); });
+
+  executor::QueryBudget budget;
+  budget.max_memory_bytes = 256 * 1024;
+  handler().set_budget(budget);
+  server::HttpResponse response =
+      request("SELECT k, COUNT(*) FROM t GROUP BY k ORDER BY k LIMIT 3");
+  EXPECT_EQ(response.status_code, 200) << response.body;
+}
+
+// Bindings are kept with the plan, not in the statement, so a parsed
+// statement can be planned again: here with ample and with scant work
+// memory, both plans executed after both were built
+TEST_F(PlannerTest, StatementCanBePlannedTwice) {
+  must("CREATE TABLE a (id INTEGER, g INTEGER)");
+  must("CREATE TABLE b (id INTEGER, w INTEGER)");
+  insert_rows("a", 2000, [](size_t i) { return tuple(i, i % 5); });
+  insert_rows("b", 2000, [](size_t i) { return tuple(i, i % 3); });
+
+  memory::Arena arena;
+  sql::Parser parser("SELECT a.g, SUM(b.w) FROM a JOIN b ON a.id = b.id "
+                     "WHERE b.w > 0 GROUP BY a.g ORDER BY a.g",
+                     arena);
+  auto stmt = parser.parse();
+  ASSERT_TRUE(stmt);
+
+  planner_->set_work_memory(64 * 1024 * 1024);
+  auto hashed = planner_->plan(*stmt, arena);
+  ASSERT_TRUE(hashed) << planner_->error().to_string();
+  planner_->set_work_memory(1024);
+  auto sorted = planner_->plan(*stmt, arena);
+  ASSERT_TRUE(sorted) << planner_->error().to_string();
+  ASSERT_NE((*hashed)->bindings, (*sorted)->bindings);
+
+  for (const planner::PlanNode *plan : {hashed->get(), sorted->get()}) {
+    executor::QueryBudget budget;
+    memory::QueryAllocator allocator(budget.max_memory_bytes, arena);
+    executor::ExecutionContext ctx(budget, allocator);
+    auto result = executor_->execute(*plan, ctx);
+    ASSERT_TRUE(result.success) << result.error;
+    ASSERT_EQ(result.rows.size(), 5u);
+    for (size_t g = 0; g < 5; ++g) {
+      EXPECT_EQ(render(result.rows[g].values[0]), std::to_string(g));
+      int64_t sum = 0;
+      for (int64_t id = static_cast<int64_t>(g); id < 2000; id += 5) {
+        sum += id % 3;
+      }
+      EXPECT_EQ(render(result.rows[g].values[1]), std::to_string(sum));
+    }
+  }
+}
+
+// Wide text is read only for the rows a top-N sort or a selective filter
+// keeps, and the rows come back as a full read returns them
+TEST_F(PlannerTest, WideColumnsReadLate) {
+  must("CREATE TABLE t (k INTEGER, body TEXT, tag TEXT)");
+  auto quoted = [](std::string text) { return text.insert(0, 1, '\'') + '\''; };
+  insert_rows("t", 4000, [&](size_t i) {
+    std::string body = std::string(200, 'b').append(std::to_string(i));
+    return tuple((i * 7919) % 4000, i % 100 == 7 ? "NULL" : quoted(body),
+                 i % 2 ? "'odd'" : "'even'");
+  });
+  must("ANALYZE t");
+
+  const std::string top = "SELECT k, body, tag FROM t ORDER BY k DESC";
+  ASSERT_TRUE(fetches_late(top + " LIMIT 10"));
+  ASSERT_FALSE(fetches_late(top));
+  QueryResult late = must(top + " LIMIT 10");
+  QueryResult full = must(top);
+  ASSERT_EQ(late.rows.size(), 10u);
+  EXPECT_EQ(late.rows,
+            decltype(full.rows)(full.rows.begin(), full.rows.begin() + 10));
+
+  const std::string filtered = "SELECT body, k FROM t WHERE k < 40";
+  ASSERT_TRUE(fetches_late(filtered));
+  QueryResult rows = must(filtered + " ORDER BY k");
+  QueryResult all = must("SELECT body, k FROM t ORDER BY k");
+  EXPECT_EQ(rows.rows,
+            decltype(all.rows)(all.rows.begin(), all.rows.begin() + 40));
+
+  // Segment rows cannot be fetched again by RowId
+  must("CREATE TABLE m (k INTEGER, body TEXT) PARTITION BY k EVERY 1000");
+  insert_rows("m", 2000, [&](size_t i) {
+    return tuple(i, quoted(std::string(200, 'm')));
+  });
+  EXPECT_FALSE(fetches_late("SELECT k, body FROM m ORDER BY k LIMIT 5"));
+}
+
+// A predicate no row can satisfy plans an EMPTY node instead of a scan;
+// aggregates over it still return their one row
+TEST_F(PlannerTest, ContradictionPlansEmpty) {
+  must("CREATE TABLE t (k INTEGER, v INTEGER)");
+  insert_rows("t", 100, [](size_t i) { return tuple(i, i % 7); });
+
+  for (const std::string where :
+       {"1 = 0", "NULL", "k > 10 AND k < 5", "NOT (k >= 0 OR k < 0)",
+        "k = 3 AND 2 + 2 = 5", "v < 3 AND k + 1 < 1 AND k > -1"}) {
+    std::string sql = std::string("SELECT k FROM t WHERE ").append(where);
+    EXPECT_TRUE(plans(sql, planner::PlanNodeType::EMPTY)) << where;
+    EXPECT_TRUE(must(sql).rows.empty()) << where;
+
+    QueryResult count =
+        must(std::string("SELECT COUNT(*) FROM t WHERE ").append(where));
+    ASSERT_EQ(count.rows.size(), 1u) << where;
+    EXPECT_EQ(count.rows[0][0], "0") << where;
+  }
+  EXPECT_FALSE(plans("SELECT k FROM t WHERE k > 5 AND k < 10",
+                     planner::PlanNodeType::EMPTY));
+}
+
+// Folded, normalized and NOT-pushed predicates keep the rows as written
+TEST_F(PlannerTest, RewrittenPredicatesKeepRows) {
+  must("CREATE TABLE t (k INTEGER, v INTEGER)");
+  insert_rows("t", 100, [](size_t i) {
+    return i % 10 == 0 ? tuple(i, "NULL") : tuple(i, i % 7);
+  });
+
+  const std::pair<const char *, const char *> cases[] = {
+      {"5 < k + 1", "95"},
+      {"k > 40 + 2 * 5", "49"},
+      {"-k < -90", "9"},
+      {"TRUE AND k < 7", "7"},
+      {"k < 7 OR 1 = 0", "7"},
+      {"NOT (k < 10 OR v = 3)", "70"}, // NULL v is neither 3 nor not
+      {"NOT NOT (k <> 50)", "99"},
+  };
+  for (const auto &[where, expected] : cases) {
+    QueryResult count =
+        must(std::string("SELECT COUNT(*) FROM t WHERE ").append(where));
+    ASSERT_EQ(count.rows.size(), 1u) << where;
+    EXPECT_EQ(count.rows[0][0], expected) << where;
+  }
+}
+
+// A division by zero is not folded away: it fails only once a row
+// reaches it
+TEST_F(PlannerTest, FailingFoldErrorsPerRow) {
+  must("CREATE TABLE t (k INTEGER)");
+  must("CREATE TABLE e (k INTEGER)");
+  insert_rows("t", 10, [](size_t i) { return tuple(i); });
+
+  EXPECT_FALSE(run("SELECT k FROM t WHERE 1 / 0 = 1").success);
+  EXPECT_TRUE(must("SELECT k FROM e WHERE 1 / 0 = 1").rows.empty());
+  EXPECT_TRUE(must("SELECT k FROM t WHERE k < 0 AND 1 / 0 = 1").rows.empty());
+}
+
+// Conjuncts are re-ranked as the data shifts across several reorder
+// intervals; the rows kept do not change, and a division stays behind the
+// guard that protects it wherever either is written
+TEST_F(PlannerTest, ReorderedConjunctsKeepRowsAndGuards) {
+  const size_t n = 10 * executor::FilterOperator::REORDER_INTERVAL;
+  auto x_of = [](size_t i) { return i % 5; };
+  auto y_of = [n](size_t i) { return i < n / 2 ? i % 100 : i % 3; };
+  must("CREATE TABLE t (x INTEGER, y INTEGER)");
+  insert_rows("t", n, [&](size_t i) { return tuple(x_of(i), y_of(i)); });
+
+  size_t expected = 0;
+  for (size_t i = 0; i < n; ++i) {
+    size_t x = x_of(i);
+    expected += y_of(i) < 10 && x != 0 && 100 / x > 30;
+  }
+  for (const char *where : {"y < 10 AND x <> 0 AND 100 / x > 30",
+                            "x <> 0 AND 100 / x > 30 AND y < 10",
+                            "100 / x > 30 AND y < 10 AND x <> 0"}) {
+    QueryResult count =
+        must(std::string("SELECT COUNT(*) FROM t WHERE ").append(where));
+    ASSERT_EQ(count.rows.size(), 1u) << where;
+    EXPECT_EQ(count.rows[0][0], std::to_string(expected)) << where;
+  }
+  EXPECT_FALSE(run("SELECT COUNT(*) FROM t WHERE y < 10 AND 100 / x > 30")
+                   .success);
+}
+
+// Whole-table counts and extremes come from the table's summary, kept
+// exact as batches with NULLs and new extremes arrive
+TEST_F(PlannerTest, SummariesMatchScans) {
+  must("CREATE TABLE t (k INTEGER, f FLOAT, s TEXT)");
+  const std::string aggregates =
+      "SELECT COUNT(*), COUNT(k), COUNT(s), MIN(k), MAX(k), MIN(f), MAX(f) "
+      "FROM t";
+  ASSERT_TRUE(plans(aggregates, planner::PlanNodeType::METADATA_AGGREGATE));
+  ASSERT_FALSE(plans(aggregates + " WHERE s <> ''",
+                     planner::PlanNodeType::METADATA_AGGREGATE));
+  ASSERT_FALSE(plans("SELECT SUM(k) FROM t",
+                     planner::PlanNodeType::METADATA_AGGREGATE));
+
+  QueryResult empty = must(aggregates);
+  ASSERT_EQ(empty.rows.size(), 1u);
+  EXPECT_EQ(empty.rows[0],
+            (std::vector<std::string>{"0", "0", "0", "NULL", "NULL", "NULL",
+                                      "NULL"}));
+
+  for (int batch = 0; batch < 3; ++batch) {
+    insert_rows("t", 700, [batch](size_t i) {
+      int64_t k = static_cast<int64_t>(i * 31 % 900) - 300 * batch;
+      std::string key = i % 9 == 0 ? "NULL" : std::to_string(k);
+      std::string f = i % 4 == 0 ? "NULL" : std::to_string(k * 0.5 + batch);
+      return tuple(key, f, "'s'");
+    });
+    QueryResult summarized = must(aggregates);
+    EXPECT_EQ(summarized.rows, must(aggregates + " WHERE s <> ''").rows)
+        << batch;
+  }
+}
+
+} // anonymous namespace
+} // namespace test
+} // namespace edgesql
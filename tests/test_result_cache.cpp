@@ -0,0 +1,134 @@
+/**
+ * @file test_result_cache.cpp
+ * @brief Result cache keys, invalidation and configuration
+ */
+
+#include "server/result_cache.hpp"
+#include "sql_fixture.hpp"
+
+namespace edgesql {
+namespace server {
+namespace {
+
+using namespace std::chrono_literals;
+
+TEST(ResultCacheKeyTest, SameTokensShareKey) {
+  std::string key = ResultCache::make_key("SELECT a FROM t WHERE a = 1");
+  ASSERT_FALSE(key.empty());
+  EXPECT_EQ(ResultCache::make_key("select  a\nfrom t -- note\nwhere a=1;"),
+            key);
+  EXPECT_NE(ResultCache::make_key("SELECT a FROM t WHERE a = 2"), key);
+  EXPECT_NE(ResultCache::make_key("SELECT A FROM t WHERE a = 1"), key);
+}
+
+class ResultCacheTest : public test::SqlTest {
+protected:
+  bool hit(const HttpResponse &response) {
+    auto it = response.headers.find("X-Cache");
+    return it != response.headers.end() && it->second == "HIT";
+  }
+
+  // The body up to the stats, which each response makes afresh
+  std::string rows(const HttpResponse &response) {
+    return response.body.substr(0, response.body.find("\"stats\""));
+  }
+
+  HttpResponse query(QueryHandler &handler, const std::string &sql) {
+    HttpRequest req{};
+    req.method = HttpMethod::POST;
+    req.path = "/query";
+    req.body = sql;
+    return handler.handle(req);
+  }
+};
+
+// The handler caches by default, per the memory configuration; a change
+// to a table the query read makes the next run miss
+TEST_F(ResultCacheTest, ChangedTableInvalidates) {
+  must("CREATE TABLE t (a INTEGER)");
+  must("CREATE TABLE u (a INTEGER)");
+  insert_rows("t", 10, [](size_t i) { return tuple(i); });
+
+  const std::string sql = "SELECT COUNT(*) FROM t";
+  HttpResponse first = request(sql);
+  ASSERT_EQ(first.status_code, 200) << first.body;
+  EXPECT_FALSE(hit(first));
+
+  HttpResponse second = request("select count(*) from t;");
+  EXPECT_TRUE(hit(second));
+  EXPECT_EQ(rows(second), rows(first));
+
+  // Another table's change leaves the entry valid
+  must("INSERT INTO u VALUES (1)");
+  EXPECT_TRUE(hit(request(sql)));
+
+  must("INSERT INTO t VALUES (10)");
+  HttpResponse changed = request(sql);
+  EXPECT_FALSE(hit(changed));
+  EXPECT_NE(rows(changed), rows(first));
+  EXPECT_TRUE(hit(request(sql)));
+
+  // A table dropped and created again is a new table
+  must("DROP TABLE t");
+  must("CREATE TABLE t (a INTEGER)");
+  EXPECT_FALSE(hit(request(sql)));
+}
+
+// A hit's stats are its own: nothing scanned, and flagged as a hit
+TEST_F(ResultCacheTest, HitReportsItsOwnStats) {
+  must("CREATE TABLE t (a INTEGER)");
+  insert_rows("t", 100, [](size_t i) { return tuple(i); });
+
+  const std::string sql = "SELECT a FROM t WHERE a < 5";
+  HttpResponse first = request(sql);
+  ASSERT_EQ(first.status_code, 200) << first.body;
+  HttpResponse second = request(sql);
+  ASSERT_TRUE(hit(second));
+
+  auto stat = [](const std::string &body, const std::string &name) {
+    size_t at = body.find("\"" + name + "\": ");
+    return at == std::string::npos
+               ? std::string()
+               : body.substr(at, body.find_first_of(",\n", at) - at);
+  };
+  EXPECT_EQ(stat(first.body, "cache_hit"), "\"cache_hit\": false");
+  EXPECT_EQ(stat(first.body, "rows_scanned"), "\"rows_scanned\": 100");
+  EXPECT_EQ(stat(second.body, "cache_hit"), "\"cache_hit\": true");
+  EXPECT_EQ(stat(second.body, "rows_scanned"), "\"rows_scanned\": 0");
+  EXPECT_EQ(stat(second.body, "rows_returned"),
+            stat(first.body, "rows_returned"));
+  EXPECT_EQ(rows(second), rows(first));
+}
+
+TEST_F(ResultCacheTest, ZeroCapacityDisables) {
+  must("CREATE TABLE t (a INTEGER)");
+  MemoryConfig memory;
+  memory.result_cache_bytes = 0;
+  QueryHandler handler(*executor_, *planner_, memory);
+
+  EXPECT_EQ(query(handler, "SELECT a FROM t").status_code, 200);
+  EXPECT_FALSE(hit(query(handler, "SELECT a FROM t")));
+}
+
+// With a max staleness, an entry outlives changes to its table, but not
+// the table itself
+TEST_F(ResultCacheTest, StaleEntryServedUntilDrop) {
+  must("CREATE TABLE t (a INTEGER)");
+  MemoryConfig memory;
+  memory.result_cache_max_staleness = 1h;
+  QueryHandler handler(*executor_, *planner_, memory);
+
+  const std::string sql = "SELECT COUNT(*) FROM t";
+  HttpResponse first = query(handler, sql);
+  must("INSERT INTO t VALUES (1)");
+  HttpResponse stale = query(handler, sql);
+  EXPECT_TRUE(hit(stale));
+  EXPECT_EQ(rows(stale), rows(first));
+
+  must("DROP TABLE t");
+  EXPECT_FALSE(hit(query(handler, sql)));
+}
+
+} // anonymous namespace
+} // namespace server
+} // namespace edgesql
@@ -0,0 +1,120 @@
+/**
+ * @file test_sample.cpp
+ * @brief Sampled scans with TABLESAMPLE
+ */
+
+#include "sql_fixture.hpp"
+#include <string>
+#include <vector>
+
+namespace edgesql {
+namespace test {
+namespace {
+
+class TableSampleTest : public SqlTest {
+protected:
+  void SetUp() override {
+    SqlTest::SetUp();
+    must("CREATE TABLE t (id INTEGER, pad TEXT)");
+    insert_rows("t", 5000, [](size_t i) {
+      return tuple(i, "'" + std::string(40, 'p') + "'");
+    });
+  }
+
+  // The sample's rows' ids, in id order
+  std::vector<std::string> ids(const std::string &sample) {
+    QueryResult rows = must("SELECT id FROM t " + sample + " ORDER BY id");
+    std::vector<std::string> out;
+    for (const auto &row : rows.rows) {
+      out.push_back(row[0]);
+    }
+    return out;
+  }
+};
+
+// Sampling words are keywords in any case, never taken for an alias
+TEST_F(TableSampleTest, SampleClauseInAnyCase) {
+  QueryResult seeded = must("SELECT COUNT(*), SUM(id) FROM t "
+                            "TABLESAMPLE BERNOULLI (30) REPEATABLE (7)");
+  EXPECT_EQ(must("select count(*), sum(id) from t s "
+                 "tablesample bernoulli (30) repeatable (7)")
+                .rows,
+            seeded.rows);
+  EXPECT_EQ(must("Select Count(*) From t TableSample System (100)").rows,
+            must("SELECT COUNT(*) FROM t").rows);
+  EXPECT_FALSE(run("SELECT COUNT(*) FROM t tablesample (30)").success);
+}
+
+// BERNOULLI keeps each row with the given chance: 30% of 5,000 rows is
+// 1,500 give or take 32, so each seed lands within five deviations. A
+// seed draws the same rows every time; another seed draws others.
+TEST_F(TableSampleTest, BernoulliKeepsFraction) {
+  for (int seed = 1; seed <= 5; ++seed) {
+    std::string sample = std::string("TABLESAMPLE BERNOULLI (30) REPEATABLE (")
+                             .append(std::to_string(seed))
+                             .append(")");
+    std::vector<std::string> drawn = ids(sample);
+    EXPECT_NEAR(static_cast<double>(drawn.size()), 1500.0, 160.0) << seed;
+    EXPECT_EQ(ids(sample), drawn) << seed;
+    EXPECT_NE(ids("TABLESAMPLE BERNOULLI (30) REPEATABLE (99)"), drawn);
+  }
+
+  EXPECT_TRUE(ids("TABLESAMPLE BERNOULLI (0)").empty());
+  EXPECT_EQ(ids("TABLESAMPLE BERNOULLI (100)").size(), 5000u);
+}
+
+// SYSTEM keeps or skips whole pages; the ends of its range keep nothing
+// or everything
+TEST_F(TableSampleTest, SystemKeepsWholePages) {
+  EXPECT_TRUE(ids("TABLESAMPLE SYSTEM (0)").empty());
+  EXPECT_EQ(ids("TABLESAMPLE SYSTEM (100)"), ids(""));
+
+  const std::string sample = "TABLESAMPLE SYSTEM (50) REPEATABLE (4)";
+  std::vector<std::string> drawn = ids(sample);
+  EXPECT_GT(drawn.size(), 0u);
+  EXPECT_LT(drawn.size(), 5000u);
+  EXPECT_EQ(ids(sample), drawn);
+
+  // Rows are stored in id order, so the sample is a few long runs of
+  // consecutive ids rather than scattered ones
+  size_t runs = 0;
+  for (size_t i = 0; i < drawn.size(); ++i) {
+    runs += i == 0 || std::stoll(drawn[i]) != std::stoll(drawn[i - 1]) + 1;
+  }
+  EXPECT_LT(runs, drawn.size() / 20);
+}
+
+// A sampled table is scanned even where its summary or a key lookup
+// could answer, and samples the same way when joined
+TEST_F(TableSampleTest, SampledTableIsScanned) {
+  const std::string count =
+      "SELECT COUNT(*) FROM t TABLESAMPLE BERNOULLI (30) REPEATABLE (3)";
+  EXPECT_FALSE(plans(count, planner::PlanNodeType::METADATA_AGGREGATE));
+  QueryResult sampled = must(count);
+  ASSERT_EQ(sampled.rows.size(), 1u);
+  EXPECT_NE(sampled.rows[0][0], "5000");
+
+  must("CREATE TABLE u (id INTEGER)");
+  insert_rows("u", 5000, [](size_t i) { return tuple(i); });
+  EXPECT_EQ(must("SELECT COUNT(*) FROM u JOIN t TABLESAMPLE BERNOULLI (30) "
+                 "REPEATABLE (3) ON u.id = t.id")
+                .rows,
+            sampled.rows);
+}
+
+TEST_F(TableSampleTest, PercentageOutOfRangeIsRejected) {
+  for (const char *percent : {"101", "100.5", "-1", "'30'"}) {
+    QueryResult result = run(
+        std::string("SELECT COUNT(*) FROM t TABLESAMPLE SYSTEM (")
+            .append(percent)
+            .append(")"));
+    EXPECT_FALSE(result.success) << percent;
+  }
+  must("SELECT COUNT(*) FROM t TABLESAMPLE SYSTEM (0.5)");
+  EXPECT_FALSE(
+      run("SELECT COUNT(*) FROM t TABLESAMPLE SYSTEM (30) REPEATABLE").success);
+}
+
+} // anonymous namespace
+} // namespace test
+} // namespace edgesql
@@ -0,0 +1,315 @@
+/**
+ * @file test_segment.cpp
+ * @brief Segment write buffering, the segment manifest, and partitioned
+ *        tables through SQL
+ */
+
+#include "sql_fixture.hpp"
+#include "storage/segment.hpp"
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <thread>
+
+namespace edgesql {
+namespace storage {
+namespace {
+
+class SegmentTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    dir_ = std::filesystem::temp_directory_path() /
+           ("edgesql_segment_" + std::to_string(::getpid()));
+    std::filesystem::remove_all(dir_);
+    std::filesystem::create_directories(dir_);
+    path_ = (dir_ / "1_1.seg").string();
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir_); }
+
+  // Segment files deleted while still open
+  size_t deleted_open_files() {
+    size_t count = 0;
+    std::filesystem::path fds = "/proc/self/fd";
+    for (const auto &fd : std::filesystem::directory_iterator(fds)) {
+      std::error_code ec;
+      std::string target = std::filesystem::read_symlink(fd, ec).string();
+      count += target.find(dir_.string()) == 0 &&
+               target.find("(deleted)") != std::string::npos;
+    }
+    return count;
+  }
+
+  // Slot count of a page as the file holds it
+  uint16_t slots_on_disk(uint32_t page_offset) {
+    Page page;
+    std::ifstream file(path_, std::ios::binary);
+    file.seekg(static_cast<std::streamoff>(sizeof(SegmentHeader) +
+                                           page_offset * PAGE_SIZE));
+    file.read(reinterpret_cast<char *>(page.data()), PAGE_SIZE);
+    return file ? page.slot_count() : 0;
+  }
+
+  static bool add_record(Page &page) {
+    const uint8_t record[16] = {1, 2, 3};
+    uint16_t slot;
+    return page.insert_record(record, sizeof(record), &slot);
+  }
+
+  std::filesystem::path dir_;
+  std::string path_;
+};
+
+// Rows added to the last page are read back at once, but reach the file
+// only when the page is written
+TEST_F(SegmentTest, TailPageIsBuffered) {
+  Segment segment(path_, 1, 1);
+  ASSERT_TRUE(segment.create());
+  EXPECT_FALSE(segment.append_to_tail(add_record)); // No page yet
+
+  Page page;
+  page.init(0);
+  ASSERT_EQ(segment.append_page(&page), 0u);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(segment.append_to_tail(add_record));
+  }
+
+  ASSERT_TRUE(segment.read_page(0, &page));
+  EXPECT_EQ(page.slot_count(), 10u);
+  EXPECT_EQ(slots_on_disk(0), 0u);
+
+  // Appending the next page writes the full one
+  page.init(1);
+  ASSERT_EQ(segment.append_page(&page), 1u);
+  ASSERT_TRUE(segment.append_to_tail(add_record));
+  EXPECT_EQ(slots_on_disk(0), 10u);
+  EXPECT_EQ(slots_on_disk(1), 0u);
+
+  ASSERT_TRUE(segment.seal());
+  EXPECT_EQ(slots_on_disk(1), 1u);
+  EXPECT_FALSE(segment.append_to_tail(add_record));
+}
+
+// An unsealed segment reopened after close() continues its last page
+TEST_F(SegmentTest, ReopenedSegmentContinuesTailPage) {
+  {
+    Segment segment(path_, 1, 1);
+    ASSERT_TRUE(segment.create());
+    Page page;
+    page.init(0);
+    ASSERT_EQ(segment.append_page(&page), 0u);
+    ASSERT_TRUE(segment.append_to_tail(add_record));
+  }
+
+  Segment segment(path_, 1, 1);
+  ASSERT_TRUE(segment.open());
+  ASSERT_TRUE(segment.append_to_tail(add_record));
+  Page page;
+  ASSERT_TRUE(segment.read_page(0, &page));
+  EXPECT_EQ(page.slot_count(), 2u);
+  ASSERT_TRUE(segment.sync());
+  EXPECT_EQ(slots_on_disk(0), 2u);
+}
+
+// Tables rotate and expire partitions concurrently, each change writing
+// the manifest outside the manager's lock. The manifest on disk ends up
+// naming exactly the live segments, and only their files remain.
+TEST_F(SegmentTest, ManifestMatchesConcurrentRotations) {
+  constexpr uint32_t TABLES = 4;
+  TimePartitioning spec{0, 10, 100};
+  std::vector<std::vector<uint32_t>> live(TABLES);
+  {
+    SegmentManager manager(dir_.string());
+    ASSERT_TRUE(manager.init());
+    for (uint32_t table = 1; table <= TABLES; ++table) {
+      ASSERT_TRUE(manager.create_table(table, spec));
+    }
+
+    std::vector<std::thread> writers;
+    for (uint32_t table = 1; table <= TABLES; ++table) {
+      writers.emplace_back([&manager, table]() {
+        for (int64_t time = 0; time < 500; time += 5) {
+          Segment *segment = manager.segment_for_time(table, time);
+          ASSERT_TRUE(segment);
+          segment->extend_time_range(time);
+          Page page;
+          page.init(segment->page_count());
+          ASSERT_NE(segment->append_page(&page), UINT32_MAX);
+        }
+      });
+    }
+    for (std::thread &writer : writers) {
+      writer.join();
+    }
+
+    for (uint32_t table = 1; table <= TABLES; ++table) {
+      live[table - 1] = manager.segment_ids(table);
+      // 50 partitions of 10, of which those past the retention expired
+      EXPECT_GE(live[table - 1].size(), 10u);
+      EXPECT_LE(live[table - 1].size(), 12u);
+    }
+  }
+
+  size_t files = 0;
+  for (const auto &entry : std::filesystem::directory_iterator(dir_)) {
+    files += entry.path().extension() == ".seg";
+  }
+  size_t listed = 0;
+  for (const auto &ids : live) {
+    listed += ids.size();
+  }
+  EXPECT_EQ(files, listed);
+
+  SegmentManager reopened(dir_.string());
+  ASSERT_TRUE(reopened.init());
+  for (uint32_t table = 1; table <= TABLES; ++table) {
+    EXPECT_EQ(reopened.segment_ids(table), live[table - 1]) << table;
+  }
+}
+
+// A dropped segment is closed once the snapshots that could read it are
+// gone, even while later snapshots are still alive
+TEST_F(SegmentTest, RetiredSegmentOutlivesOnlyOlderSnapshots) {
+  SegmentManager manager(dir_.string());
+  ASSERT_TRUE(manager.init());
+  ASSERT_TRUE(manager.create_table(1));
+  ASSERT_TRUE(manager.create_table(2));
+
+  auto older = std::make_unique<SegmentManager::Snapshot>(manager.snapshot(1));
+  ASSERT_EQ(older->segments().size(), 1u);
+  ASSERT_TRUE(manager.drop_table(1));
+  SegmentManager::Snapshot newer = manager.snapshot(2);
+  EXPECT_EQ(deleted_open_files(), 1u);
+
+  older.reset();
+  EXPECT_EQ(deleted_open_files(), 0u);
+  EXPECT_EQ(newer.segments().size(), 1u);
+}
+
+class PartitionedInsertTest : public test::SqlTest {};
+
+// Scans see rows still in the active segment's buffer, and rows of the
+// segments sealed behind it
+TEST_F(PartitionedInsertTest, ScansSeeBufferedRows) {
+  must("CREATE TABLE m (ts INTEGER, v TEXT) PARTITION BY ts EVERY 1000");
+  insert_rows("m", 2500, [](size_t i) {
+    return test::SqlTest::tuple(i, "'row " + std::to_string(i) + "'");
+  });
+
+  test::QueryResult all = must("SELECT COUNT(*), MAX(ts) FROM m");
+  ASSERT_EQ(all.rows.size(), 1u);
+  EXPECT_EQ(all.rows[0][0], "2500");
+  EXPECT_EQ(all.rows[0][1], "2499");
+
+  test::QueryResult active = must("SELECT v FROM m WHERE ts = 2499");
+  ASSERT_EQ(active.rows.size(), 1u);
+  EXPECT_EQ(active.rows[0][0], "row 2499");
+}
+
+// Sealed segments are read from their mapping, so a scan of them needs
+// no buffer pool frame: it runs with every frame pinned, where a scan of
+// an ordinary table cannot
+TEST_F(PartitionedInsertTest, SealedScanPinsNoFrames) {
+  must("CREATE TABLE o (v INTEGER)");
+  must("INSERT INTO o VALUES (1)");
+  must("CREATE TABLE m (ts INTEGER, v INTEGER) PARTITION BY ts EVERY 100");
+  insert_rows("m", 1000, [](size_t i) { return test::SqlTest::tuple(i, i); });
+  const std::string sealed = "SELECT COUNT(*), SUM(v) FROM m WHERE ts < 900";
+  test::QueryResult expected = must(sealed);
+
+  constexpr uint32_t FILLER = 1000;
+  ASSERT_TRUE(pages_->create_table_file(FILLER));
+  std::vector<PageGuard> pinned;
+  // Another table's pages fill every frame, and stay pinned
+  for (;;) {
+    uint32_t page_id = pages_->allocate_page(FILLER);
+    if (page_id == UINT32_MAX) {
+      break;
+    }
+    pinned.push_back(pages_->pin_page(FILLER, page_id));
+    ASSERT_TRUE(pinned.back());
+  }
+  ASSERT_EQ(pinned.size(), 256u);
+
+  test::QueryResult scanned = must(sealed);
+  EXPECT_EQ(scanned.rows, expected.rows);
+  ASSERT_EQ(scanned.rows.size(), 1u);
+  EXPECT_EQ(scanned.rows[0][0], "900");
+  EXPECT_FALSE(run("SELECT COUNT(*) FROM o WHERE v >= 0").success);
+}
+
+// The row starting a partition moves the retention window at once: the
+// partitions it leaves behind expire, the one just rotated out included
+TEST_F(PartitionedInsertTest, RetentionCountsTheNewRow) {
+  must("CREATE TABLE m (ts INTEGER, v INTEGER) PARTITION BY ts EVERY 100 "
+       "RETENTION 300");
+  insert_rows("m", 43, [](size_t i) { return tuple(i * 10, i); });
+  must("INSERT INTO m VALUES (1000, 0)");
+
+  test::QueryResult rows = must("SELECT COUNT(*), MIN(ts) FROM m WHERE v >= 0");
+  ASSERT_EQ(rows.rows.size(), 1u);
+  EXPECT_EQ(rows.rows[0][0], "1");
+  EXPECT_EQ(rows.rows[0][1], "1000");
+}
+
+// A row already past the retention window is refused rather than
+// stored in the active segment; late rows inside the window are kept
+TEST_F(PartitionedInsertTest, RowPastRetentionIsRejected) {
+  must("CREATE TABLE m (ts INTEGER, v INTEGER) PARTITION BY ts EVERY 100 "
+       "RETENTION 300");
+  must("INSERT INTO m VALUES (0, 0), (1000, 1)");
+
+  test::QueryResult late = run("INSERT INTO m VALUES (800, 2), (3, 3)");
+  EXPECT_FALSE(late.success);
+  EXPECT_EQ(late.error, "Row is older than the retention window: ts");
+  EXPECT_EQ(late.rows_affected, 1u);
+  must("INSERT INTO m VALUES (700, 4)");
+
+  test::QueryResult rows =
+      must("SELECT COUNT(*), MIN(ts), MAX(ts) FROM m WHERE v >= 0");
+  ASSERT_EQ(rows.rows.size(), 1u);
+  EXPECT_EQ(rows.rows[0][0], "3");
+  EXPECT_EQ(rows.rows[0][1], "700");
+  EXPECT_EQ(rows.rows[0][2], "1000");
+}
+
+// Partitioning words are keywords in any case
+TEST_F(PartitionedInsertTest, PartitionClauseInAnyCase) {
+  must("create table m (ts integer, v text) partition by ts every 100 "
+       "retention 300");
+  const planner::TableInfo *table = planner::Catalog::instance().get_table("m");
+  ASSERT_TRUE(table);
+  EXPECT_TRUE(table->partitioning.enabled());
+  EXPECT_EQ(table->partitioning.width, 100);
+  EXPECT_EQ(table->partitioning.retention, 300);
+
+  EXPECT_FALSE(run("CREATE TABLE r (ts INTEGER) Retention 300").success);
+}
+
+// A partitioned table's counts and extremes are summed over its live
+// segments, so partitions dropped by retention leave them at once
+TEST_F(PartitionedInsertTest, SummariesFollowRetention) {
+  must("CREATE TABLE m (ts INTEGER, v INTEGER) PARTITION BY ts EVERY 100 "
+       "RETENTION 300");
+  const std::string aggregates =
+      "SELECT COUNT(*), COUNT(v), MIN(ts), MAX(ts), MIN(v), MAX(v) FROM m";
+  ASSERT_TRUE(plans(aggregates, planner::PlanNodeType::METADATA_AGGREGATE));
+
+  for (int batch = 0; batch < 4; ++batch) {
+    insert_rows("m", 60, [batch](size_t i) {
+      size_t ts = static_cast<size_t>(batch) * 150 + i * 3;
+      return i % 7 == 0 ? tuple(ts, "NULL") : tuple(ts, (i * 13 % 50) + ts);
+    });
+    test::QueryResult summarized = must(aggregates);
+    EXPECT_EQ(summarized.rows, must(aggregates + " WHERE ts >= 0").rows)
+        << batch;
+  }
+
+  test::QueryResult rows = must(aggregates);
+  ASSERT_EQ(rows.rows.size(), 1u);
+  EXPECT_EQ(rows.rows[0][2], "300"); // Partitions below 300 expired
+}
+
+} // anonymous namespace
+} // namespace storage
+} // namespace edgesql
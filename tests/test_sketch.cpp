@@ -0,0 +1,163 @@
+/**
+ * @file test_sketch.cpp
+ * @brief Error bounds of the approximate aggregates' sketches
+ */
+
+#include "executor/sketch.hpp"
+#include "sql_fixture.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace edgesql {
+namespace executor {
+namespace {
+
+uint64_t mix(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ull;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+
+// HyperLogLog's standard error with 4096 registers is 1.04 / 64, about
+// 1.6%; estimates stay within three of it, sparse or dense
+TEST(DistinctSketchTest, EstimateWithinErrorBound) {
+  for (uint64_t n : {1ull, 10ull, 200ull, 300ull, 5000ull, 200000ull}) {
+    std::pmr::string state;
+    DistinctSketch sketch(state);
+    for (uint64_t i = 0; i < n; ++i) {
+      sketch.add(mix(i));
+      sketch.add(mix(i)); // Repeats do not count
+    }
+    EXPECT_NEAR(sketch.estimate(), static_cast<double>(n),
+                0.05 * static_cast<double>(n))
+        << n;
+    EXPECT_LE(state.size(), DistinctSketch::MAX_BYTES) << n;
+  }
+}
+
+// Merging sketches of overlapping sets, sparse into dense and back,
+// estimates their union
+TEST(DistinctSketchTest, MergeEstimatesUnion) {
+  std::pmr::string small;
+  std::pmr::string large;
+  std::pmr::string other;
+  for (uint64_t i = 0; i < 100; ++i) {
+    DistinctSketch(small).add(mix(i));
+  }
+  for (uint64_t i = 50; i < 20050; ++i) {
+    DistinctSketch(large).add(mix(i));
+  }
+  for (uint64_t i = 60; i < 160; ++i) {
+    DistinctSketch(other).add(mix(i));
+  }
+
+  std::pmr::string sparse = small;
+  DistinctSketch(sparse).merge(other);
+  EXPECT_NEAR(DistinctSketch(sparse).estimate(), 160.0, 8.0);
+
+  std::pmr::string into_dense = large;
+  DistinctSketch(into_dense).merge(small);
+  std::pmr::string into_sparse = small;
+  DistinctSketch(into_sparse).merge(large);
+  EXPECT_NEAR(DistinctSketch(into_dense).estimate(), 20050.0, 1000.0);
+  EXPECT_EQ(DistinctSketch(into_sparse).estimate(),
+            DistinctSketch(into_dense).estimate());
+
+  std::pmr::string empty;
+  DistinctSketch(into_dense).merge(empty);
+  EXPECT_NEAR(DistinctSketch(into_dense).estimate(), 20050.0, 1000.0);
+}
+
+// Fraction of the sorted values at or below an estimate
+double rank_of(const std::vector<double> &sorted, double value) {
+  auto end = std::upper_bound(sorted.begin(), sorted.end(), value);
+  return static_cast<double>(end - sorted.begin()) /
+         static_cast<double>(sorted.size());
+}
+
+// A t-digest's rank error is smallest at the tails: within 0.2% of the
+// values at the 1st and 99th percentiles and 1% in the middle, for
+// uniform and skewed inputs in random order
+TEST(QuantileSketchTest, RankErrorWithinBound) {
+  std::mt19937_64 rng(11);
+  std::uniform_real_distribution<double> uniform(-1000.0, 1000.0);
+  std::exponential_distribution<double> skewed(0.01);
+
+  for (bool exponential : {false, true}) {
+    std::vector<double> values(100000);
+    for (double &value : values) {
+      value = exponential ? skewed(rng) : uniform(rng);
+    }
+
+    std::pmr::string state;
+    QuantileSketch::Scratch scratch;
+    QuantileSketch sketch(state, scratch);
+    for (double value : values) {
+      sketch.add(value);
+    }
+    sketch.add(std::nan(""));
+    EXPECT_LE(state.size(), QuantileSketch::MAX_BYTES);
+
+    std::sort(values.begin(), values.end());
+    EXPECT_EQ(sketch.quantile(0.0), values.front());
+    EXPECT_EQ(sketch.quantile(1.0), values.back());
+    for (double q : {0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99}) {
+      double bound = q < 0.05 || q > 0.95 ? 0.002 : 0.01;
+      EXPECT_NEAR(rank_of(values, sketch.quantile(q)), q, bound)
+          << (exponential ? "exponential " : "uniform ") << q;
+    }
+  }
+}
+
+TEST(QuantileSketchTest, MergeMatchesOneSketch) {
+  std::pmr::string low;
+  std::pmr::string high;
+  QuantileSketch::Scratch scratch;
+  for (int i = 0; i < 10000; ++i) {
+    QuantileSketch(low, scratch).add(i);
+    QuantileSketch(high, scratch).add(10000 + i);
+  }
+
+  QuantileSketch merged(low, scratch);
+  merged.merge(high);
+  EXPECT_EQ(merged.quantile(0.0), 0.0);
+  EXPECT_EQ(merged.quantile(1.0), 19999.0);
+  EXPECT_NEAR(merged.quantile(0.5), 10000.0, 200.0);
+  EXPECT_NEAR(merged.quantile(0.99), 19800.0, 40.0);
+
+  std::pmr::string empty;
+  EXPECT_TRUE(QuantileSketch(empty, scratch).empty());
+  merged.merge(empty);
+  EXPECT_NEAR(merged.quantile(0.5), 10000.0, 200.0);
+}
+
+class ApproxAggregateTest : public test::SqlTest {};
+
+// Per group and over the table, text and integer arguments
+TEST_F(ApproxAggregateTest, GroupedEstimatesWithinBound) {
+  must("CREATE TABLE t (g INTEGER, v INTEGER, s TEXT)");
+  insert_rows("t", 20000, [](size_t i) {
+    std::string s = std::string("'s").append(std::to_string(i % 3000));
+    return tuple(i % 2, i, s.append("'"));
+  });
+
+  test::QueryResult result =
+      must("SELECT g, APPROX_COUNT_DISTINCT(v), APPROX_COUNT_DISTINCT(s), "
+           "APPROX_PERCENTILE(v, 0.5) FROM t GROUP BY g ORDER BY g");
+  ASSERT_EQ(result.rows.size(), 2u);
+  for (const auto &row : result.rows) {
+    EXPECT_NEAR(std::stod(row[1]), 10000.0, 500.0);
+    EXPECT_NEAR(std::stod(row[2]), 1500.0, 75.0);
+    EXPECT_NEAR(std::stod(row[3]), 10000.0, 200.0);
+  }
+
+  result = must("SELECT APPROX_COUNT_DISTINCT(s) FROM t WHERE v < 0");
+  ASSERT_EQ(result.rows.size(), 1u);
+  EXPECT_EQ(result.rows[0][0], "0");
+}
+
+} // anonymous namespace
+} // namespace executor
+} // namespace edgesql
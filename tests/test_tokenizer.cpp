@@ -0,0 +1,285 @@
+/**
+ * @file test_tokenizer.cpp
+ * @brief Keyword lookup, and vector scans against their scalar tails
+ */
+
+#include "sql/tokenizer.hpp"
+#include <cctype>
+#include <gtest/gtest.h>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace edgesql {
+namespace sql {
+namespace {
+
+const std::unordered_map<std::string, TokenType> &keywords() {
+  static const std::unordered_map<std::string, TokenType> map = {
+      {"SELECT", TokenType::SELECT},
+      {"FROM", TokenType::FROM},
+      {"WHERE", TokenType::WHERE},
+      {"ORDER", TokenType::ORDER},
+      {"BY", TokenType::BY},
+      {"ASC", TokenType::ASC},
+      {"DESC", TokenType::DESC},
+      {"LIMIT", TokenType::LIMIT},
+      {"OFFSET", TokenType::OFFSET},
+      {"INSERT", TokenType::INSERT},
+      {"INTO", TokenType::INTO},
+      {"VALUES", TokenType::VALUES},
+      {"CREATE", TokenType::CREATE},
+      {"TABLE", TokenType::TABLE},
+      {"DROP", TokenType::DROP},
+      {"AND", TokenType::AND},
+      {"OR", TokenType::OR},
+      {"NOT", TokenType::NOT},
+      {"NULL", TokenType::NULL_KEYWORD},
+      {"TRUE", TokenType::TRUE_KEYWORD},
+      {"FALSE", TokenType::FALSE_KEYWORD},
+      {"JOIN", TokenType::JOIN},
+      {"INNER", TokenType::INNER},
+      {"LEFT", TokenType::LEFT},
+      {"OUTER", TokenType::OUTER},
+      {"ON", TokenType::ON},
+      {"PARTITION", TokenType::PARTITION},
+      {"EVERY", TokenType::EVERY},
+      {"RETENTION", TokenType::RETENTION},
+      {"USING", TokenType::USING},
+      {"COLUMNAR", TokenType::COLUMNAR},
+      {"ROW", TokenType::ROW},
+      {"TABLESAMPLE", TokenType::TABLESAMPLE},
+      {"SYSTEM", TokenType::SYSTEM},
+      {"BERNOULLI", TokenType::BERNOULLI},
+      {"REPEATABLE", TokenType::REPEATABLE},
+      {"GROUP", TokenType::GROUP},
+      {"ANALYZE", TokenType::ANALYZE},
+      {"MATERIALIZED", TokenType::MATERIALIZED},
+      {"VIEW", TokenType::VIEW},
+      {"AS", TokenType::AS},
+      {"IF", TokenType::IF},
+      {"EXISTS", TokenType::EXISTS},
+      {"PRIMARY", TokenType::PRIMARY},
+      {"KEY", TokenType::KEY},
+      {"DEFAULT", TokenType::DEFAULT},
+      {"DISTINCT", TokenType::DISTINCT},
+      {"COUNT", TokenType::COUNT},
+      {"SUM", TokenType::SUM},
+      {"MIN", TokenType::MIN},
+      {"MAX", TokenType::MAX},
+      {"AVG", TokenType::AVG},
+      {"INT", TokenType::INT},
+      {"INTEGER", TokenType::INTEGER_TYPE},
+      {"TEXT", TokenType::TEXT},
+      {"FLOAT", TokenType::FLOAT_TYPE},
+      {"BOOLEAN", TokenType::BOOLEAN},
+      {"BOOL", TokenType::BOOLEAN},
+      {"BLOB", TokenType::BLOB}};
+  return map;
+}
+
+std::vector<Token> tokenize(std::string_view input) {
+  std::vector<Token> tokens;
+  Tokenizer tokenizer(input);
+  for (Token token = tokenizer.next_token();
+       token.type != TokenType::END_OF_INPUT;
+       token = tokenizer.next_token()) {
+    tokens.push_back(token);
+    if (token.type == TokenType::ERROR) {
+      break;
+    }
+  }
+  return tokens;
+}
+
+TokenType keyword_or_identifier(std::string text) {
+  for (char &c : text) {
+    c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+  }
+  auto it = keywords().find(text);
+  return it == keywords().end() ? TokenType::IDENTIFIER : it->second;
+}
+
+TokenType single_type(const std::string &text) {
+  std::vector<Token> tokens = tokenize(text);
+  return tokens.size() == 1 && tokens[0].text == text ? tokens[0].type
+                                                      : TokenType::ERROR;
+}
+
+TEST(TokenizerTest, KeywordsInAnyCase) {
+  for (const auto &[text, type] : keywords()) {
+    std::string lower = text;
+    std::string mixed = text;
+    for (size_t i = 0; i < text.size(); ++i) {
+      lower[i] = static_cast<char>(text[i] - 'A' + 'a');
+      mixed[i] = i % 2 ? lower[i] : text[i];
+    }
+    EXPECT_EQ(single_type(text), type) << text;
+    EXPECT_EQ(single_type(lower), type) << lower;
+    EXPECT_EQ(single_type(mixed), type) << mixed;
+
+    // Near misses are identifiers
+    EXPECT_EQ(single_type(text + "S"), TokenType::IDENTIFIER) << text;
+    EXPECT_EQ(single_type(std::string("_").append(text)),
+              TokenType::IDENTIFIER)
+        << text;
+    std::string tail = text.substr(1);
+    EXPECT_EQ(single_type(tail), keyword_or_identifier(tail)) << text;
+  }
+  EXPECT_EQ(single_type("SELECTSELECTSELECT"), TokenType::IDENTIFIER);
+}
+
+// Every keyword type is listed above, so each is checked in any case
+TEST(TokenizerTest, EveryKeywordIsListed) {
+  std::set<TokenType> listed;
+  for (const auto &[text, type] : keywords()) {
+    listed.insert(type);
+  }
+  for (int type = static_cast<int>(TokenType::SELECT);
+       type <= static_cast<int>(TokenType::BLOB); ++type) {
+    EXPECT_TRUE(listed.count(static_cast<TokenType>(type))) << type;
+  }
+}
+
+// Every word of up to three letters is a keyword exactly if listed: the
+// perfect hash never maps another word onto a keyword's slot
+TEST(TokenizerTest, ShortWordsAreKeywordsOnlyIfListed) {
+  std::string word;
+  auto check = [&](auto &&self, size_t length) -> void {
+    if (word.size() == length) {
+      ASSERT_EQ(single_type(word), keyword_or_identifier(word)) << word;
+      return;
+    }
+    for (char c = 'A'; c <= 'Z'; ++c) {
+      word.push_back(c);
+      self(self, length);
+      word.pop_back();
+    }
+  };
+  for (size_t length = 1; length <= 3; ++length) {
+    check(check, length);
+  }
+}
+
+// A run ends at the same byte whether it is found by a 32- or 16-byte
+// vector test or by the scalar loop over the last bytes. Runs of 3 and
+// of 40 bytes put the byte after them in the tail and in a vector.
+TEST(TokenizerTest, RunEndsMatchScalarTail) {
+  for (size_t run : {3u, 40u}) {
+    for (int byte = 1; byte < 256; ++byte) {
+      char c = static_cast<char>(byte);
+      std::string after(1, c);
+      after += std::string(40, 'x');
+
+      // Identifier: stops at anything but a letter, digit or '_'
+      bool word = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                  (c >= '0' && c <= '9') || c == '_';
+      std::vector<Token> tokens = tokenize(std::string(run, 'a') + after);
+      ASSERT_FALSE(tokens.empty());
+      EXPECT_EQ(tokens[0].text.size(), word ? run + 41 : run)
+          << "run " << run << " byte " << byte;
+
+      // Whitespace: the next token starts after it
+      bool space = c == ' ' || c == '\t' || c == '\r' || c == '\n';
+      tokens = tokenize(std::string(run, ' ') + after);
+      ASSERT_FALSE(tokens.empty());
+      EXPECT_EQ(tokens[0].offset, space ? run + 1 : run)
+          << "run " << run << " byte " << byte;
+
+      // Digits
+      bool digit = c >= '0' && c <= '9';
+      tokens = tokenize(std::string("0.").append(run, '1').append(after));
+      ASSERT_FALSE(tokens.empty());
+      EXPECT_EQ(tokens[0].type, TokenType::FLOAT);
+      EXPECT_EQ(tokens[0].text.size(), 2 + (digit ? run + 1 : run))
+          << "run " << run << " byte " << byte;
+
+      // String bodies: only the quote, '\\' and '\n' stop the scan
+      if (c != '\'' && c != '\\' && c != '\n') {
+        std::string body = std::string(run, 'b') + c + std::string(run, 'b');
+        tokens = tokenize(std::string(1, '\'').append(body).append(1, '\''));
+        ASSERT_EQ(tokens.size(), 1u) << "run " << run << " byte " << byte;
+        EXPECT_EQ(tokens[0].type, TokenType::STRING);
+        EXPECT_EQ(tokens[0].text.size(), body.size() + 2);
+      }
+    }
+  }
+}
+
+// Random token streams, with runs of every length up to past two vector
+// widths, tokenize back to the tokens they were built from
+TEST(TokenizerTest, RandomStreamsRoundTrip) {
+  std::mt19937 rng(7);
+  auto pick = [&rng](size_t n) {
+    return static_cast<size_t>(rng() % n);
+  };
+  const std::string word_chars =
+      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_";
+  const std::string spaces = " \t\r\n";
+
+  for (int round = 0; round < 300; ++round) {
+    std::string input;
+    std::vector<std::pair<TokenType, std::string>> expected;
+    size_t lines = 1;
+    for (int t = 0; t < 20; ++t) {
+      size_t length = 1 + pick(80);
+      std::string text;
+      TokenType type;
+      switch (pick(4)) {
+      case 0:
+        text += 'w';
+        for (size_t i = 1; i < length; ++i) {
+          text += word_chars[pick(word_chars.size())];
+        }
+        type = keyword_or_identifier(text);
+        break;
+      case 1:
+        text += "0.";
+        for (size_t i = 0; i < length; ++i) {
+          text += static_cast<char>('0' + pick(10));
+        }
+        type = TokenType::FLOAT;
+        break;
+      case 2:
+        text += '\'';
+        for (size_t i = 0; i < length; ++i) {
+          char c = static_cast<char>(' ' + pick(95));
+          if (c == '\\' || c == '\'') {
+            text += '\\'; // Escaped, so it does not end the literal
+          }
+          text += c;
+        }
+        text += "'";
+        type = TokenType::STRING;
+        break;
+      default:
+        text += '(';
+        type = TokenType::LPAREN;
+        break;
+      }
+      input += text;
+      expected.emplace_back(type, text);
+
+      size_t gap = 1 + pick(70);
+      for (size_t i = 0; i < gap; ++i) {
+        input += spaces[pick(spaces.size())];
+        lines += input.back() == '\n';
+      }
+    }
+
+    Tokenizer tokenizer(input);
+    for (const auto &[type, text] : expected) {
+      Token token = tokenizer.next_token();
+      ASSERT_EQ(token.text, text) << "round " << round;
+      ASSERT_EQ(token.type, type) << "round " << round;
+    }
+    EXPECT_EQ(tokenizer.next_token().type, TokenType::END_OF_INPUT);
+    EXPECT_EQ(tokenizer.location(input.size()).line, lines);
+  }
+}
+
+} // anonymous namespace
+} // namespace sql
+} // namespace edgesql
@@ -0,0 +1,104 @@
+/**
+ * @file test_view.cpp
+ * @brief Materialized views kept current by inserts into their table
+ */
+
+#include "sql_fixture.hpp"
+
+namespace edgesql {
+namespace test {
+namespace {
+
+class MaterializedViewTest : public SqlTest {
+protected:
+  void SetUp() override {
+    SqlTest::SetUp();
+    must("CREATE TABLE t (id INTEGER, g INTEGER, h TEXT, v INTEGER)");
+    must("CREATE MATERIALIZED VIEW by_g AS SELECT g, h, COUNT(*) AS n, "
+         "SUM(v) AS total, MIN(v) AS low, MAX(v) AS high, AVG(v) AS mean "
+         "FROM t GROUP BY g, h");
+  }
+
+  // Aggregates answered from the view, and from the table: id is not a
+  // view key, so a filter on it makes the query scan the table
+  void expect_view_matches_table() {
+    const std::string select =
+        "SELECT g, COUNT(*), SUM(v), MIN(v), MAX(v), AVG(v) FROM t ";
+    const std::string grouped = "GROUP BY g ORDER BY g";
+    QueryResult from_view = must(select + grouped);
+    QueryResult from_table = must(select + "WHERE id >= 0 " + grouped);
+    EXPECT_EQ(from_view.rows, from_table.rows);
+
+    from_view = must("SELECT COUNT(*), SUM(v) FROM t WHERE h = 'b'");
+    from_table = must("SELECT COUNT(*), SUM(v) FROM t "
+                      "WHERE h = 'b' AND id >= 0");
+    EXPECT_EQ(from_view.rows, from_table.rows);
+  }
+};
+
+// Each insert folds its rows into the groups' stored rows, new groups
+// included, so the view answers like the table after every statement
+TEST_F(MaterializedViewTest, InsertsKeepViewCurrent) {
+  QueryResult empty = must("SELECT COUNT(*), SUM(v) FROM t");
+  ASSERT_EQ(empty.rows.size(), 1u);
+  EXPECT_EQ(empty.rows[0][0], "0");
+  EXPECT_EQ(empty.rows[0][1], "NULL");
+
+  for (int batch = 0; batch < 4; ++batch) {
+    insert_rows("t", 600, [batch](size_t i) {
+      int64_t v = static_cast<int64_t>(i * 37 % 1000) - 500 + batch;
+      std::string value = i % 11 == 0 ? "NULL" : std::to_string(v);
+      return tuple(i, i % (5 + batch), i % 3 ? "'b'" : "'a'", value);
+    });
+    expect_view_matches_table();
+  }
+
+  QueryResult stored = must("SELECT COUNT(*) FROM by_g");
+  ASSERT_EQ(stored.rows.size(), 1u);
+  EXPECT_EQ(stored.rows[0][0], "16"); // 8 values of g, 2 of h
+}
+
+// A row overflowing a view's sum ends the insert before it is stored;
+// the view keeps the rows stored before it, like the table
+TEST_F(MaterializedViewTest, OverflowingRowIsNotStored) {
+  must("INSERT INTO t VALUES (0, 1, 'a', 9223372036854775000)");
+  QueryResult failed = run("INSERT INTO t VALUES (1, 2, 'a', 5), "
+                           "(2, 1, 'a', 1000), (3, 2, 'a', 6)");
+  EXPECT_FALSE(failed.success);
+  EXPECT_EQ(failed.rows_affected, 1u);
+
+  QueryResult rows = must("SELECT COUNT(*) FROM t WHERE id >= 0");
+  ASSERT_EQ(rows.rows.size(), 1u);
+  EXPECT_EQ(rows.rows[0][0], "2");
+  expect_view_matches_table();
+}
+
+TEST_F(MaterializedViewTest, ViewOutlivesNoTable) {
+  EXPECT_FALSE(run("INSERT INTO by_g VALUES (1, 'a', 1, 1, 1, 1, 1, 1)")
+                   .success);
+  EXPECT_FALSE(run("DROP TABLE t").success);
+  must("DROP MATERIALIZED VIEW by_g");
+  must("DROP TABLE t");
+}
+
+// View words and AS are keywords in any case, in the view's SELECT too
+TEST_F(MaterializedViewTest, ViewWordsInAnyCase) {
+  must("create materialized view by_h as select h, count(*) as n, "
+       "sum(v) As total from t group by h");
+  insert_rows("t", 50, [](size_t i) {
+    return tuple(i, i % 3, i % 2 ? "'b'" : "'a'", i);
+  });
+
+  QueryResult stored = must("SELECT h, n, total FROM by_h ORDER BY h");
+  EXPECT_EQ(must("select x.h, count(*) as n, sum(x.v) as total from t as x "
+                 "where x.id >= 0 group by x.h order by x.h")
+                .rows,
+            stored.rows);
+  EXPECT_EQ(stored.columns, (std::vector<std::string>{"h", "n", "total"}));
+  must("Drop Materialized View by_h");
+  EXPECT_FALSE(run("DROP MATERIALIZED by_g").success);
+}
+
+} // anonymous namespace
+} // namespace test
+} // namespace edgesql